@@ -0,0 +1,242 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file Backend.cpp
+
+ HPCG routine
+ */
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/hpx_fwd.hpp>
+#endif
+
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include "Backend.hpp"
+
+KernelBackends HPCG_backends = {BACKEND_REF, BACKEND_REF, BACKEND_REF, BACKEND_REF};
+int HPCG_dotReduction = REDUCTION_FAST;
+
+/*!
+  Returns the name of a backend as used on the command line.
+
+  @param[in] backend the backend, one of KernelBackend
+*/
+const char * BackendName(int backend) {
+  switch (backend) {
+    case BACKEND_OPENMP: return "openmp";
+    case BACKEND_HPX: return "hpx";
+    case BACKEND_THREADS: return "threads";
+    default: return "ref";
+  }
+}
+
+/*!
+  Returns the backend of the given name.
+
+  @param[in] name the name of the backend as returned by BackendName
+
+  @return the backend, or -1 if the name is unknown
+*/
+int ParseBackend(const char * name) {
+  for (int backend=BACKEND_REF; backend<=BACKEND_THREADS; ++backend)
+    if (strcmp(name, BackendName(backend))==0) return(backend);
+  return(-1);
+}
+
+/*!
+  Returns the name of a summation order as used on the command line.
+
+  @param[in] mode the summation order, one of ReductionMode
+*/
+const char * ReductionName(int mode) {
+  switch (mode) {
+    case REDUCTION_DETERMINISTIC: return "deterministic";
+    case REDUCTION_COMPENSATED: return "compensated";
+    default: return "fast";
+  }
+}
+
+/*!
+  Returns the summation order of the given name.
+
+  @param[in] name the name of the summation order as returned by ReductionName
+
+  @return the summation order, or -1 if the name is unknown
+*/
+int ParseReduction(const char * name) {
+  for (int mode=REDUCTION_FAST; mode<=REDUCTION_COMPENSATED; ++mode)
+    if (strcmp(name, ReductionName(mode))==0) return(mode);
+  return(-1);
+}
+
+/*!
+  Returns true if the backend is compiled into this binary.
+
+  @param[in] backend the backend, one of KernelBackend
+*/
+bool BackendAvailable(int backend) {
+  switch (backend) {
+    case BACKEND_REF:
+    case BACKEND_THREADS:
+      return(true);
+#ifndef HPCG_NOOPENMP
+    case BACKEND_OPENMP:
+      return(true);
+#endif
+#if !defined(HPCG_NOHPX)
+    case BACKEND_HPX:
+      return(true);
+#endif
+    default:
+      return(false);
+  }
+}
+
+/*!
+  Returns the backend used when none is selected on the command line: HPX in
+  HPX builds, OpenMP in OpenMP builds and the reference kernels otherwise.
+*/
+int DefaultBackend() {
+#if !defined(HPCG_NOHPX)
+  return(BACKEND_HPX);
+#elif !defined(HPCG_NOOPENMP)
+  return(BACKEND_OPENMP);
+#else
+  return(BACKEND_REF);
+#endif
+}
+
+/*!
+  Selects the same backend for all kernels.
+
+  @param[in]  backend the backend, one of KernelBackend
+  @param[out] backends the backends of all kernels
+*/
+void SetKernelBackends(int backend, KernelBackends & backends) {
+  backends.spmv = backends.dot = backends.waxpby = backends.mg = backend;
+}
+
+/*!
+  A fixed set of std::thread workers. The thread calling ThreadPoolRun works
+  as thread 0, the workers wait for the next task between runs.
+*/
+struct ThreadPool_STRUCT {
+  std::vector<std::thread> workers; //!< threads 1 to size-1
+  std::mutex mutex; //!< protects all members below
+  std::condition_variable start; //!< signals a new task or the end of the pool
+  std::condition_variable done; //!< signals the completion of the task by all workers
+  std::mutex run; //!< held by the thread running a task, nested or concurrent runs are serialized
+  const std::function<void(int)> * task; //!< the current task
+  unsigned long generation; //!< number of tasks started
+  int pending; //!< number of workers that have not completed the current task
+  bool stop; //!< true if the workers shall exit
+  int size; //!< number of threads including the calling thread
+};
+typedef struct ThreadPool_STRUCT ThreadPool;
+
+static ThreadPool * pool = 0;
+
+/*!
+  Main loop of a worker thread of the pool.
+
+  @param[in] id the index of the thread in the range [1, size-1]
+*/
+static void ThreadPoolWorker(int id) {
+  unsigned long seen = 0;
+  std::unique_lock<std::mutex> lock(pool->mutex);
+  for (;;) {
+    pool->start.wait(lock, [&seen]() { return pool->stop || pool->generation!=seen; });
+    if (pool->stop) return;
+    seen = pool->generation;
+    const std::function<void(int)> * task = pool->task;
+    lock.unlock();
+    (*task)(id);
+    lock.lock();
+    if (--pool->pending==0) pool->done.notify_one();
+  }
+}
+
+/*!
+  Starts the thread pool used by BACKEND_THREADS.
+
+  @param[in] numberOfThreads the number of threads including the calling thread, the hardware concurrency if less than 1
+*/
+void InitializeThreadPool(int numberOfThreads) {
+  if (pool!=0) FinalizeThreadPool();
+  if (numberOfThreads<1) numberOfThreads = (int)std::thread::hardware_concurrency();
+  if (numberOfThreads<1) numberOfThreads = 1;
+  pool = new ThreadPool;
+  pool->task = 0;
+  pool->generation = 0;
+  pool->pending = 0;
+  pool->stop = false;
+  pool->size = numberOfThreads;
+  for (int id=1; id<numberOfThreads; ++id) pool->workers.push_back(std::thread(ThreadPoolWorker, id));
+}
+
+/*!
+  Stops the thread pool started by InitializeThreadPool.
+*/
+void FinalizeThreadPool() {
+  if (pool==0) return;
+  {
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    pool->stop = true;
+  }
+  pool->start.notify_all();
+  for (size_t i=0; i<pool->workers.size(); ++i) pool->workers[i].join();
+  delete pool;
+  pool = 0;
+}
+
+/*!
+  Returns the number of threads of the pool, 1 if it was not started.
+*/
+int ThreadPoolSize() {
+  return (pool!=0) ? pool->size : 1;
+}
+
+/*!
+  Runs task(t) for t = 0, ..., ThreadPoolSize()-1, each on its own thread
+  of the pool, and returns when all calls have completed. If the pool is
+  busy, e.g. for a call from inside a task, all calls are made by the
+  calling thread.
+
+  @param[in] task the task
+*/
+void ThreadPoolRun(const std::function<void(int)> & task) {
+  if (pool==0 || pool->size==1 || !pool->run.try_lock()) {
+    for (int t=0; t<ThreadPoolSize(); ++t) task(t);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    pool->task = &task;
+    pool->pending = pool->size-1;
+    ++pool->generation;
+  }
+  pool->start.notify_all();
+  task(0);
+  {
+    std::unique_lock<std::mutex> lock(pool->mutex);
+    pool->done.wait(lock, []() { return pool->pending==0; });
+  }
+  pool->run.unlock();
+}
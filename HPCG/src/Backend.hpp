@@ -0,0 +1,334 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file Backend.hpp
+
+ HPCG kernel backends selectable at run time
+ */
+
+#ifndef BACKEND_HPP
+#define BACKEND_HPP
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/hpx_fwd.hpp>
+#include <hpx/include/parallel_for_each.hpp>
+#include <hpx/include/parallel_transform_reduce.hpp>
+
+#include <boost/iterator/counting_iterator.hpp>
+#endif
+
+#ifndef HPCG_NOOPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+#include "Geometry.hpp"
+#include "Trace.hpp"
+
+/*!
+  The implementations of the parallel loops of the kernels.
+*/
+enum KernelBackend {
+  BACKEND_REF = 0, //!< the reference kernels
+  BACKEND_OPENMP = 1, //!< OpenMP parallel loops, requires a build without HPCG_NOOPENMP
+  BACKEND_HPX = 2, //!< HPX parallel algorithms, requires a build without HPCG_NOHPX
+  BACKEND_THREADS = 3 //!< a pool of std::thread workers
+};
+
+/*!
+  The backend used by each group of kernels.
+*/
+struct KernelBackends_STRUCT {
+  int spmv; //!< backend of ComputeSPMV
+  int dot; //!< backend of ComputeDotProduct
+  int waxpby; //!< backend of ComputeWAXPBY
+  int mg; //!< backend of ComputeMG, ComputeRestriction and ComputeProlongation
+};
+typedef struct KernelBackends_STRUCT KernelBackends;
+
+extern KernelBackends HPCG_backends; //!< the backends of the kernels, set by HPCG_Init
+
+/*!
+  The summation orders of the parallel dot product.
+*/
+enum ReductionMode {
+  REDUCTION_FAST = 0, //!< the order of the backend, which depends on the number of threads and the scheduling
+  REDUCTION_DETERMINISTIC = 1, //!< fixed-size blocks reduced in a fixed tree order
+  REDUCTION_COMPENSATED = 2 //!< as REDUCTION_DETERMINISTIC with compensated summation
+};
+
+#define HPCG_REDUCTION_BLOCK_SIZE 2048 //!< number of terms of a block of the deterministic sum
+#define HPCG_REDUCTION_ROUND_BLOCKS 256 //!< number of blocks of the deterministic sum summed in parallel at a time, a power of two
+
+#ifndef HPCG_NOOPENMP
+#define HPCG_REFERENCE_BACKEND BACKEND_OPENMP //!< backend of the deterministic sums of the reference kernels
+#else
+#define HPCG_REFERENCE_BACKEND BACKEND_REF //!< backend of the deterministic sums of the reference kernels
+#endif
+
+extern int HPCG_dotReduction; //!< the summation order of ComputeDotProduct, one of ReductionMode, set by HPCG_Init
+
+extern const char * ReductionName(int mode);
+extern int ParseReduction(const char * name);
+
+extern const char * BackendName(int backend);
+extern int ParseBackend(const char * name);
+extern bool BackendAvailable(int backend);
+extern int DefaultBackend();
+extern void SetKernelBackends(int backend, KernelBackends & backends);
+
+extern void InitializeThreadPool(int numberOfThreads);
+extern void FinalizeThreadPool();
+extern int ThreadPoolSize();
+extern void ThreadPoolRun(const std::function<void(int)> & task);
+
+/*!
+  Calls f(i) for i = 0, ..., n-1 in parallel with the given backend. The
+  calls must be independent of each other.
+
+  If the trace is enabled, the OpenMP and std::thread backends record the
+  share of every thread as a worker event of the enclosing kernel call.
+
+  @param[in] backend the backend, one of KernelBackend
+  @param[in] n the number of iterations
+  @param[in] f the loop body
+*/
+template <typename F>
+inline void BackendParallelFor(int backend, local_int_t n, const F & f) {
+  const TraceRegion region = HPCG_traceEnabled ? CurrentTraceRegion() : TraceRegion();
+  switch (backend) {
+#ifndef HPCG_NOOPENMP
+    case BACKEND_OPENMP:
+      if (HPCG_traceEnabled) {
+        #pragma omp parallel
+        {
+          const long long begin = TraceTime();
+          #pragma omp for nowait
+          for (local_int_t i=0; i<n; ++i) f(i);
+          RecordTraceEvent("worker", region.name, region.level, begin, TraceTime());
+        }
+        return;
+      }
+      #pragma omp parallel for
+      for (local_int_t i=0; i<n; ++i) f(i);
+      return;
+#endif
+#if !defined(HPCG_NOHPX)
+    case BACKEND_HPX: {
+      typedef boost::counting_iterator<local_int_t> iterator;
+      hpx::parallel::for_each(hpx::parallel::par, iterator(0), iterator(n), f);
+      return;
+    }
+#endif
+    case BACKEND_THREADS: {
+      const int numberOfThreads = ThreadPoolSize();
+      ThreadPoolRun([&f, &region, n, numberOfThreads](int t) {
+        const long long begin = HPCG_traceEnabled ? TraceTime() : 0;
+        const local_int_t first = (local_int_t)(((long long)n*t)/numberOfThreads);
+        const local_int_t last = (local_int_t)(((long long)n*(t+1))/numberOfThreads);
+        for (local_int_t i=first; i<last; ++i) f(i);
+        if (HPCG_traceEnabled) RecordTraceEvent("worker", region.name, region.level, begin, TraceTime());
+      });
+      return;
+    }
+    default:
+      for (local_int_t i=0; i<n; ++i) f(i);
+      return;
+  }
+}
+
+/*!
+  Returns the sum of f(i) for i = 0, ..., n-1 computed in parallel with the
+  given backend.
+
+  @param[in] backend the backend, one of KernelBackend
+  @param[in] n the number of terms
+  @param[in] f the function computing a term
+
+  @return the sum of all terms
+
+  @see BackendParallelFor
+*/
+template <typename F>
+inline double BackendParallelSum(int backend, local_int_t n, const F & f) {
+  const TraceRegion region = HPCG_traceEnabled ? CurrentTraceRegion() : TraceRegion();
+  double sum = 0.0;
+  switch (backend) {
+#ifndef HPCG_NOOPENMP
+    case BACKEND_OPENMP:
+      if (HPCG_traceEnabled) {
+        #pragma omp parallel reduction (+:sum)
+        {
+          const long long begin = TraceTime();
+          #pragma omp for nowait
+          for (local_int_t i=0; i<n; ++i) sum += f(i);
+          RecordTraceEvent("worker", region.name, region.level, begin, TraceTime());
+        }
+        return(sum);
+      }
+      #pragma omp parallel for reduction (+:sum)
+      for (local_int_t i=0; i<n; ++i) sum += f(i);
+      return(sum);
+#endif
+#if !defined(HPCG_NOHPX)
+    case BACKEND_HPX: {
+      typedef boost::counting_iterator<local_int_t> iterator;
+      return(hpx::parallel::transform_reduce(hpx::parallel::par, iterator(0), iterator(n), 0.0, std::plus<double>(), f));
+    }
+#endif
+    case BACKEND_THREADS: {
+      const int numberOfThreads = ThreadPoolSize();
+      std::vector<double> partial(numberOfThreads, 0.0);
+      double * const partialv = &partial[0];
+      ThreadPoolRun([&f, &region, n, numberOfThreads, partialv](int t) {
+        const long long begin = HPCG_traceEnabled ? TraceTime() : 0;
+        const local_int_t first = (local_int_t)(((long long)n*t)/numberOfThreads);
+        const local_int_t last = (local_int_t)(((long long)n*(t+1))/numberOfThreads);
+        double localSum = 0.0;
+        for (local_int_t i=first; i<last; ++i) localSum += f(i);
+        partialv[t] = localSum;
+        if (HPCG_traceEnabled) RecordTraceEvent("worker", region.name, region.level, begin, TraceTime());
+      });
+      for (int t=0; t<numberOfThreads; ++t) sum += partial[t]; // Fixed order, independent of the timing of the threads
+      return(sum);
+    }
+    default:
+      for (local_int_t i=0; i<n; ++i) sum += f(i);
+      return(sum);
+  }
+}
+
+/*!
+  Adds the partial sum on the right to the partial sum on the left. With
+  compensated summation the rounding error of the addition and the error of
+  the right operand are added to the error of the left operand.
+
+  @param[inout] sum, error the left partial sum and its rounding error, on exit the combined values
+  @param[in]    rightSum, rightError the right partial sum and its rounding error
+  @param[in]    compensated if false the errors are ignored
+*/
+inline void CombinePartialSums(double & sum, double & error, double rightSum, double rightError, bool compensated) {
+  const double left = sum;
+  sum = left+rightSum;
+  if (compensated)
+    error += rightError + ((std::fabs(left)>=std::fabs(rightSum)) ? (left-sum)+rightSum : (rightSum-sum)+left);
+}
+
+/*!
+  Returns the sum of f(i) for i = 0, ..., n-1 in an order that does not depend
+  on the backend or the number of threads.
+
+  The terms are split into blocks of HPCG_REDUCTION_BLOCK_SIZE consecutive
+  terms. The blocks are summed in parallel, each one from left to right, and
+  the block sums are then added pairwise in a fixed binary tree. With
+  compensated summation each block and each node of the tree also carries the
+  rounding error of its additions (Neumaier's variant of Kahan summation);
+  the sum of these errors is returned separately, so that the caller can
+  reduce both across processes before adding them.
+
+  The blocks are processed in rounds of HPCG_REDUCTION_ROUND_BLOCKS, so the
+  block sums are kept on the stack instead of being allocated on every call.
+  The number of blocks of a round is a power of two, so each round forms a
+  complete subtree; the sums of the rounds are combined like the digits of a
+  binary counter, which gives the same tree as reducing all blocks at once.
+
+  @param[in]  backend the backend, one of KernelBackend
+  @param[in]  n the number of terms
+  @param[in]  f the function computing a term
+  @param[in]  compensated if true the rounding errors are accumulated in correction
+  @param[out] correction the accumulated rounding errors, zero if compensated is false
+
+  @return the sum of all terms, without the correction
+
+  @see BackendParallelSum
+*/
+template <typename F>
+inline double BackendBlockedSum(int backend, local_int_t n, const F & f, bool compensated, double & correction) {
+  correction = 0.0;
+  const local_int_t numberOfBlocks = (n+HPCG_REDUCTION_BLOCK_SIZE-1)/HPCG_REDUCTION_BLOCK_SIZE;
+  if (numberOfBlocks==0) return(0.0);
+  double sums[HPCG_REDUCTION_ROUND_BLOCKS], errors[HPCG_REDUCTION_ROUND_BLOCKS]; // block sums of the current round
+  const int maxHeight = 8*sizeof(local_int_t); // a subtree of each height can be pending
+  double pendingSums[maxHeight], pendingErrors[maxHeight]; // completed subtrees of 2^height rounds
+  bool pending[maxHeight];
+  for (int h=0; h<maxHeight; ++h) pending[h] = false;
+
+  for (local_int_t firstBlock=0; firstBlock<numberOfBlocks; firstBlock+=HPCG_REDUCTION_ROUND_BLOCKS) {
+    const local_int_t numberOfRoundBlocks = std::min((local_int_t) HPCG_REDUCTION_ROUND_BLOCKS, numberOfBlocks-firstBlock);
+    double * const sumsv = sums;
+    double * const errorsv = errors;
+    BackendParallelFor(backend, numberOfRoundBlocks, [&f, n, firstBlock, sumsv, errorsv, compensated](local_int_t k) {
+      const local_int_t first = (firstBlock+k)*HPCG_REDUCTION_BLOCK_SIZE;
+      const local_int_t last = std::min(n, first+HPCG_REDUCTION_BLOCK_SIZE);
+      double sum = 0.0;
+      double error = 0.0;
+      if (!compensated) {
+        for (local_int_t i=first; i<last; ++i) sum += f(i);
+      } else {
+        for (local_int_t i=first; i<last; ++i) {
+          const double term = f(i);
+          const double t = sum+term;
+          error += (std::fabs(sum)>=std::fabs(term)) ? (sum-t)+term : (term-t)+sum;
+          sum = t;
+        }
+      }
+      sumsv[k] = sum;
+      errorsv[k] = error;
+    });
+
+    for (local_int_t stride=1; stride<numberOfRoundBlocks; stride*=2)
+      for (local_int_t k=0; k+stride<numberOfRoundBlocks; k+=2*stride)
+        CombinePartialSums(sums[k], errors[k], sums[k+stride], errors[k+stride], compensated);
+
+    // Carry the sum of the round into the pending subtrees; it is the right operand of every combination
+    double sum = sums[0], error = errors[0];
+    int h = 0;
+    for (; pending[h]; ++h) {
+      CombinePartialSums(pendingSums[h], pendingErrors[h], sum, error, compensated);
+      sum = pendingSums[h];
+      error = pendingErrors[h];
+      pending[h] = false;
+    }
+    pending[h] = true;
+    pendingSums[h] = sum;
+    pendingErrors[h] = error;
+  }
+
+  // The remaining subtrees are combined from the lowest, which is the rightmost, upwards
+  double sum = 0.0, error = 0.0;
+  bool first = true;
+  for (int h=0; h<maxHeight; ++h) {
+    if (!pending[h]) continue;
+    if (first) {
+      sum = pendingSums[h];
+      error = pendingErrors[h];
+      first = false;
+    } else {
+      double left = pendingSums[h], leftError = pendingErrors[h];
+      CombinePartialSums(left, leftError, sum, error, compensated);
+      sum = left;
+      error = leftError;
+    }
+  }
+  if (compensated) correction = error;
+  return(sum);
+}
+
+#endif // BACKEND_HPP
@@ -0,0 +1,203 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file BenchmarkEnsemble.cpp
+
+ HPCG routine
+ */
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/hpx_fwd.hpp>
+#include <hpx/include/async.hpp>
+#include <hpx/include/lcos.hpp>
+#endif
+
+#ifndef HPCG_NOMPI
+#include <mpi.h>
+#endif
+
+#ifndef HPCG_NOOPENMP
+#include <omp.h>
+#endif
+
+#include <fstream>
+#include <vector>
+using std::endl;
+
+#include "BenchmarkEnsemble.hpp"
+#include "GenerateProblemHierarchy.hpp"
+#include "SetupSmoother.hpp"
+#include "OptimizeProblem.hpp"
+#include "SparseMatrix.hpp"
+#include "Vector.hpp"
+#include "CGData.hpp"
+#include "CG.hpp"
+#include "mytimer.hpp"
+
+/*!
+  One member of the ensemble: a complete problem with its own matrix
+  hierarchy, vectors and CG workspace.
+*/
+struct EnsembleInstance_STRUCT {
+  SparseMatrix A; //!< the system matrix including its multigrid hierarchy
+  CGData data; //!< the CG vectors
+  Vector b; //!< the right hand side
+  Vector x; //!< the solution
+  Vector xexact; //!< the exact solution
+};
+typedef struct EnsembleInstance_STRUCT EnsembleInstance;
+
+/*!
+  Builds one problem instance in the same way as the benchmark problem.
+
+  @param[in]  params the parameters of the run
+  @param[in]  numberOfMgLevels the number of multigrid levels of the benchmark problem
+  @param[out] instance the problem instance
+*/
+static void GenerateInstance(const HPCG_Params & params, int numberOfMgLevels, EnsembleInstance & instance) {
+
+  // The instances are never cached, they may be generated concurrently
+  GenerateProblemHierarchy(params, numberOfMgLevels, 0, instance.A, instance.b, instance.x, instance.xexact, 0);
+  InitializeSparseCGData(instance.A, instance.data);
+  SetupSmoother(instance.A, params.smootherType, params.smootherDegree, params.smootherBlocks);
+  SetupCoarseSolver(instance.A, params.coarseDirectSolve!=0, params.coarseAgglomerate!=0);
+  OptimizeProblem(instance.A, instance.data, instance.b, instance.x, instance.xexact);
+}
+
+/*!
+  Solves one problem instance with a fixed number of optimized CG iterations.
+
+  @param[inout] instance the problem instance
+  @param[in]    niters the number of iterations
+  @param[out]   time the time of the solve
+  @param[out]   scaledResidual the scaled residual reached
+
+  @return Returns zero on success and a non-zero value otherwise.
+*/
+static int SolveInstance(EnsembleInstance & instance, int niters, double & time, double & scaledResidual) {
+
+  std::vector< double > times(9,0.0);
+  int numberOfIterations = 0;
+  double normr = 0.0;
+  double normr0 = 0.0;
+  ZeroVector(instance.x);
+  double t0 = mytimer();
+  int ierr = CG(instance.A, instance.data, instance.b, instance.x, niters, 0.0, numberOfIterations, normr, normr0, &times[0], true);
+  time = mytimer() - t0;
+  scaledResidual = normr/normr0;
+  return(ierr);
+}
+
+/*!
+  Builds numberOfInstances independent copies of the benchmark problem and
+  solves them concurrently, each with a fixed number of optimized CG
+  iterations, to measure the throughput of filling the node with several
+  problems instead of solving a single one.
+
+  With OpenMP every instance is solved by its own team of threads of the
+  size numThreads/numberOfInstances, the placement of the teams follows
+  OMP_PLACES and OMP_PROC_BIND. With HPX every instance is solved by its own
+  task. The kernels of an instance communicate on MPI_COMM_WORLD from the
+  calling thread, so with MPI the instances are solved one after another.
+
+  @param[in]  params the parameters of the run, params.numberOfInstances is the size of the ensemble
+  @param[in]  numberOfMgLevels the number of multigrid levels of the benchmark problem
+  @param[in]  niters the number of CG iterations of each solve
+  @param[out] ensemble_data the times of all instances, to be released with DeleteEnsembleData
+
+  @return Returns zero on success and a non-zero value otherwise.
+
+  @see ReportResults
+*/
+int BenchmarkEnsemble(const HPCG_Params & params, int numberOfMgLevels, int niters, EnsembleData & ensemble_data) {
+
+  const int numberOfInstances = params.numberOfInstances;
+  ensemble_data.numberOfInstances = (numberOfInstances>0) ? numberOfInstances : 0;
+  ensemble_data.numberOfConcurrentInstances = 1;
+  ensemble_data.threadsPerInstance = params.numThreads;
+  ensemble_data.niters = niters;
+  ensemble_data.wallTime = 0.0;
+  ensemble_data.time = 0;
+  ensemble_data.scaledResidual = 0;
+  if (numberOfInstances<=0) return(0);
+
+  ensemble_data.time = new double[numberOfInstances];
+  ensemble_data.scaledResidual = new double[numberOfInstances];
+  EnsembleInstance * instances = new EnsembleInstance[numberOfInstances];
+  for (int i=0; i<numberOfInstances; ++i) GenerateInstance(params, numberOfMgLevels, instances[i]);
+
+  int ierr = 0;
+  double * const time = ensemble_data.time;
+  double * const scaledResidual = ensemble_data.scaledResidual;
+#ifndef HPCG_NOMPI
+  MPI_Barrier(MPI_COMM_WORLD);
+#endif
+  double t0 = mytimer();
+#if !defined(HPCG_NOMPI)
+  for (int i=0; i<numberOfInstances; ++i)
+    ierr += SolveInstance(instances[i], niters, time[i], scaledResidual[i]);
+#elif defined(HPCG_NOHPX)
+#ifdef HPCG_NOOPENMP
+  for (int i=0; i<numberOfInstances; ++i)
+    ierr += SolveInstance(instances[i], niters, time[i], scaledResidual[i]);
+#else
+  const int numberOfTeams = (numberOfInstances<params.numThreads) ? numberOfInstances : params.numThreads;
+  const int threadsPerTeam = params.numThreads/numberOfTeams;
+  const int maxActiveLevels = omp_get_max_active_levels();
+  omp_set_max_active_levels(2); // The kernels of each instance run on the threads of its team
+  ensemble_data.numberOfConcurrentInstances = numberOfTeams;
+  ensemble_data.threadsPerInstance = threadsPerTeam;
+  #pragma omp parallel for num_threads(numberOfTeams) schedule(static,1) reduction(+:ierr)
+  for (int i=0; i<numberOfInstances; ++i) {
+    omp_set_num_threads(threadsPerTeam);
+    ierr += SolveInstance(instances[i], niters, time[i], scaledResidual[i]);
+  }
+  omp_set_max_active_levels(maxActiveLevels);
+#endif
+#else
+  ensemble_data.numberOfConcurrentInstances = numberOfInstances;
+  std::vector< hpx::future<int> > solves;
+  solves.reserve(numberOfInstances);
+  for (int i=0; i<numberOfInstances; ++i) {
+    EnsembleInstance * instance = instances+i;
+    double * instanceTime = time+i;
+    double * instanceResidual = scaledResidual+i;
+    solves.push_back(hpx::async([instance, niters, instanceTime, instanceResidual]() {
+      return SolveInstance(*instance, niters, *instanceTime, *instanceResidual);
+    }));
+  }
+  hpx::wait_all(solves);
+  for (int i=0; i<numberOfInstances; ++i) ierr += solves[i].get();
+#endif
+  ensemble_data.wallTime = mytimer() - t0;
+#ifndef HPCG_NOMPI
+  double localWallTime = ensemble_data.wallTime;
+  MPI_Allreduce(&localWallTime, &ensemble_data.wallTime, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+#endif
+
+  for (int i=0; i<numberOfInstances; ++i) {
+    if (params.comm_rank==0)
+      HPCG_fout << "Ensemble instance [" << i << "] Time [" << time[i] << "] Scaled Residual [" << scaledResidual[i] << "]" << endl;
+    DeleteMatrix(instances[i].A);
+    DeleteCGData(instances[i].data);
+    DeleteVector(instances[i].b);
+    DeleteVector(instances[i].x);
+    DeleteVector(instances[i].xexact);
+  }
+  delete [] instances;
+
+  return(ierr);
+}
@@ -0,0 +1,55 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file BenchmarkEnsemble.hpp
+
+ HPCG data structure
+ */
+
+#ifndef BENCHMARKENSEMBLE_HPP
+#define BENCHMARKENSEMBLE_HPP
+
+#include "hpcg.hpp"
+
+struct EnsembleData_STRUCT {
+  int numberOfInstances; //!< number of independent problem instances, 0 if the ensemble was not run
+  int numberOfConcurrentInstances; //!< number of instances that were solved at the same time
+  int threadsPerInstance; //!< number of threads working on each instance
+  int niters; //!< number of CG iterations of each solve
+  double wallTime; //!< time from the start of the first solve to the end of the last solve
+  double * time; //!< time of the solve of each instance
+  double * scaledResidual; //!< scaled residual reached by each instance
+};
+typedef struct EnsembleData_STRUCT EnsembleData;
+
+extern int BenchmarkEnsemble(const HPCG_Params & params, int numberOfMgLevels, int niters, EnsembleData & ensemble_data);
+
+/*!
+ Deallocates the per-instance results of the ensemble.
+
+ @param[inout] data the ensemble results whose storage is deallocated
+ */
+inline void DeleteEnsembleData(EnsembleData & data) {
+
+  delete [] data.time;
+  delete [] data.scaledResidual;
+  data.time = 0;
+  data.scaledResidual = 0;
+  data.numberOfInstances = 0;
+  return;
+}
+
+#endif  // BENCHMARKENSEMBLE_HPP
@@ -0,0 +1,139 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file BenchmarkExternal.cpp
+
+ HPCG routine
+ */
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/hpx_fwd.hpp>
+#endif
+
+#include <iostream>
+
+#include "BenchmarkExternal.hpp"
+#include "Backend.hpp"
+#include "CG.hpp"
+#include "YAML_Doc.hpp"
+
+/*!
+  Solves Ax = b with CG, preconditioned by one application of the smoother
+  selected with SetupSmoother, or without preconditioner. The matrix has a
+  single level, so ComputeMG reduces to the smoother.
+
+  @param[in]    A the known system matrix, read by ReadProblem or generated
+  @param[inout] data the CG work vectors
+  @param[in]    b the right hand side
+  @param[inout] x on entry the initial guess, on exit the approximate solution
+  @param[inout] external_data on entry the preconditioner, the largest number of iterations and the tolerance, on exit the results
+
+  @return returns 0 upon success and non-zero otherwise
+*/
+int BenchmarkExternal(const SparseMatrix & A, CGData & data, const Vector & b, Vector & x, ExternalBenchmarkData & external_data) {
+
+  for (int i=0; i<9; ++i) external_data.times[i] = 0.0;
+  external_data.niters = 0;
+  const bool doPreconditioning = external_data.preconditioner>=0;
+  int ierr = CG(A, data, b, x, external_data.maxIters, external_data.tolerance, external_data.niters,
+      external_data.normr, external_data.normr0, external_data.times, doPreconditioning);
+
+  // Initial residual, then per iteration: SpMV, 2 dot products and the residual norm, 3 vector updates and the preconditioner
+  const double nrow = A.localNumberOfRows, nnz = A.localNumberOfNonzeros;
+  double preconditionerFlops = 0.0;
+  if (external_data.preconditioner==SMOOTHER_JACOBI) preconditionerFlops = 2.0*nnz + 2.0*nrow;
+  else if (external_data.preconditioner==SMOOTHER_SYMGS) preconditionerFlops = 4.0*nnz;
+  else if (external_data.preconditioner==SMOOTHER_CHEBYSHEV) preconditionerFlops = A.smootherData->degree*(2.0*nnz + 6.0*nrow);
+  external_data.flops = 2.0*nnz + 4.0*nrow + external_data.niters*(2.0*nnz + 6.0*nrow + 6.0*nrow + preconditionerFlops);
+  return(ierr);
+}
+
+/*!
+  Creates a YAML file with the throughput of reading and writing the matrix
+  and the results of the solve, and writes it to the standard output.
+
+  @param[in] A the known system matrix
+  @param[in] external_data the results of ReadProblem, WriteMatrix and BenchmarkExternal
+*/
+void ReportExternalBenchmark(const SparseMatrix & A, const ExternalBenchmarkData & external_data) {
+
+  if (A.geom->rank!=0) return;
+
+  YAML_Doc doc("HPCG-External", "2.4");
+
+  doc.add("Machine Summary","");
+  doc.get("Machine Summary")->add("Distributed Processes",A.geom->size);
+  doc.get("Machine Summary")->add("Threads per processes",A.geom->numThreads);
+
+  doc.add("Matrix","");
+  doc.get("Matrix")->add("File",external_data.matrixFile[0] ? external_data.matrixFile : "synthetic 27-point problem");
+  doc.get("Matrix")->add("Rows",A.totalNumberOfRows);
+  doc.get("Matrix")->add("Nonzeros",A.totalNumberOfNonzeros);
+
+  const ReadProblemData & read = external_data.read;
+  if (external_data.matrixFile[0]) {
+    const double readParseTime = read.readTime + read.parseTime;
+    doc.add("Reading the matrix","");
+    doc.get("Reading the matrix")->add("Format",read.format==PROBLEM_FILE_MATRIX_MARKET ? "MatrixMarket" : "binary CSR");
+    doc.get("Reading the matrix")->add("Symmetric storage",read.symmetric);
+    doc.get("Reading the matrix")->add("File size (MB)",read.fileSize/1.0E6);
+    doc.get("Reading the matrix")->add("Entries in the file",read.numberOfEntries);
+    doc.get("Reading the matrix")->add("Read time (sec)",read.readTime);
+    doc.get("Reading the matrix")->add("Parse time (sec)",read.parseTime);
+    doc.get("Reading the matrix")->add("Assembly time (sec)",read.assembleTime);
+    doc.get("Reading the matrix")->add("Read bandwidth (MB/s)",read.readTime>0.0 ? read.fileSize/read.readTime/1.0E6 : 0.0);
+    doc.get("Reading the matrix")->add("Parse throughput (MB/s)",readParseTime>0.0 ? read.fileSize/readParseTime/1.0E6 : 0.0);
+    doc.get("Reading the matrix")->add("Parse throughput (Mentries/s)",readParseTime>0.0 ? read.numberOfEntries/readParseTime/1.0E6 : 0.0);
+  }
+
+  if (external_data.writeFile[0]) {
+    doc.add("Writing the matrix","");
+    doc.get("Writing the matrix")->add("File",external_data.writeFile);
+    doc.get("Writing the matrix")->add("File size (MB)",external_data.writeSize/1.0E6);
+    doc.get("Writing the matrix")->add("Write time (sec)",external_data.writeTime);
+    doc.get("Writing the matrix")->add("Write throughput (MB/s)",external_data.writeTime>0.0 ? external_data.writeSize/external_data.writeTime/1.0E6 : 0.0);
+  }
+
+  doc.add("Kernel Backends","");
+  doc.get("Kernel Backends")->add("SpMV",BackendName(HPCG_backends.spmv));
+  doc.get("Kernel Backends")->add("DDOT",BackendName(HPCG_backends.dot));
+  doc.get("Kernel Backends")->add("DDOT reduction",ReductionName(HPCG_dotReduction));
+  doc.get("Kernel Backends")->add("CG",HPCG_cgDataflow ? "dataflow" : "synchronous");
+  doc.get("Kernel Backends")->add("WAXPBY",BackendName(HPCG_backends.waxpby));
+  doc.get("Kernel Backends")->add("MG",BackendName(HPCG_backends.mg));
+
+  const double totalTime = external_data.times[0];
+  doc.add("Conjugate Gradient","");
+  doc.get("Conjugate Gradient")->add("Preconditioner",external_data.preconditioner>=0 ? SmootherName(external_data.preconditioner) : "none");
+  doc.get("Conjugate Gradient")->add("Maximum iterations",external_data.maxIters);
+  doc.get("Conjugate Gradient")->add("Tolerance",external_data.tolerance);
+  doc.get("Conjugate Gradient")->add("Iterations",external_data.niters);
+  doc.get("Conjugate Gradient")->add("Initial residual",external_data.normr0);
+  doc.get("Conjugate Gradient")->add("Final residual",external_data.normr);
+  doc.get("Conjugate Gradient")->add("Scaled residual",external_data.normr0>0.0 ? external_data.normr/external_data.normr0 : 0.0);
+  doc.get("Conjugate Gradient")->add("Converged",external_data.normr<=external_data.tolerance*external_data.normr0 ? 1 : 0);
+  doc.get("Conjugate Gradient")->add("Total time (sec)",totalTime);
+  doc.get("Conjugate Gradient")->add("DDOT time (sec)",external_data.times[1]);
+  doc.get("Conjugate Gradient")->add("WAXPBY time (sec)",external_data.times[2]);
+  doc.get("Conjugate Gradient")->add("SpMV time (sec)",external_data.times[3]);
+  doc.get("Conjugate Gradient")->add("Preconditioner time (sec)",external_data.times[5]);
+  doc.get("Conjugate Gradient")->add("GFLOP/s",totalTime>0.0 ? external_data.flops/totalTime/1.0E9 : 0.0);
+
+  std::string yaml = doc.generateYAML();
+  doc.generateJSON();
+  std::cout << yaml;
+  return;
+}
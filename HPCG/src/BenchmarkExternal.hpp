@@ -0,0 +1,49 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file BenchmarkExternal.hpp
+
+ HPCG data structure
+ */
+
+#ifndef BENCHMARKEXTERNAL_HPP
+#define BENCHMARKEXTERNAL_HPP
+
+#include "hpcg.hpp"
+#include "SparseMatrix.hpp"
+#include "CGData.hpp"
+#include "ReadProblem.hpp"
+
+struct ExternalBenchmarkData_STRUCT {
+  char matrixFile[256]; //!< file the matrix was read from, empty for the synthetic problem
+  ReadProblemData read; //!< statistics of ReadProblem
+  char writeFile[256]; //!< file the matrix was written to, empty if it was not written
+  double writeSize; //!< size of the written file in bytes
+  double writeTime; //!< time to write the file
+  int preconditioner; //!< smoother applied as the preconditioner, one of SmootherType, or -1 for none
+  int maxIters; //!< largest number of CG iterations
+  double tolerance; //!< relative residual at which CG stops
+  int niters; //!< number of CG iterations performed
+  double normr0; //!< initial residual norm
+  double normr; //!< final residual norm
+  double times[9]; //!< times of CG as in the benchmark: total, dot products, WAXPBY, SpMV, (unused), preconditioner
+  double flops; //!< floating point operations of the solve
+};
+typedef struct ExternalBenchmarkData_STRUCT ExternalBenchmarkData;
+
+extern int BenchmarkExternal(const SparseMatrix & A, CGData & data, const Vector & b, Vector & x, ExternalBenchmarkData & external_data);
+extern void ReportExternalBenchmark(const SparseMatrix & A, const ExternalBenchmarkData & external_data);
+
+#endif  // BENCHMARKEXTERNAL_HPP
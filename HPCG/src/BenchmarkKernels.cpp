@@ -0,0 +1,413 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file BenchmarkKernels.cpp
+
+ HPCG routine
+ */
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/hpx_fwd.hpp>
+#endif
+
+#ifndef HPCG_NOMPI
+#include <mpi.h>
+#endif
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "BenchmarkKernels.hpp"
+#include "Backend.hpp"
+#include "ComputeSPMV.hpp"
+#include "ComputeSYMGS.hpp"
+#include "ComputeDotProduct.hpp"
+#include "ComputeWAXPBY.hpp"
+#include "ComputeRestriction.hpp"
+#include "ComputeProlongation.hpp"
+#include "ComputeMG.hpp"
+#include "ExchangeHalo.hpp"
+#include "MatrixFormat.hpp"
+#include "Vector.hpp"
+#include "YAML_Doc.hpp"
+#include "mytimer.hpp"
+
+static const double valueBytes = sizeof(double); //!< bytes of a matrix or vector value
+static const double indexBytes = sizeof(local_int_t); //!< bytes of a column index
+static const double countBytes = sizeof(char); //!< bytes of the number of nonzeros of a row
+
+/*!
+  Returns a printable name for a kernel.
+
+  @param[in] kernel the kernel, one of BenchmarkKernel
+*/
+const char * KernelName(int kernel) {
+  switch (kernel) {
+    case KERNEL_SPMV: return "SpMV";
+    case KERNEL_SYMGS: return "SYMGS";
+    case KERNEL_DOT: return "DDOT";
+    case KERNEL_WAXPBY: return "WAXPBY";
+    case KERNEL_RESTRICTION: return "Restriction";
+    case KERNEL_PROLONGATION: return "Prolongation";
+    case KERNEL_MG: return "MG";
+    case KERNEL_HALO: return "Halo";
+  }
+  return "Unknown";
+}
+
+/*!
+  Returns the value below which the fraction p of the sorted values lies,
+  interpolating linearly between neighbouring values.
+
+  @param[in] sorted the values in increasing order, not empty
+  @param[in] p the fraction in [0,1]
+*/
+static double Percentile(const std::vector<double> & sorted, double p) {
+  const double position = p*(sorted.size()-1);
+  const size_t i = (size_t)position;
+  if (i+1>=sorted.size()) return sorted.back();
+  return sorted[i] + (position-i)*(sorted[i+1]-sorted[i]);
+}
+
+/*!
+  Applies a kernel warmups times without and repetitions times with timing
+  and summarizes the timed applications. The time of an application is the
+  largest time over all processes.
+
+  @param[in]  warmups the number of untimed applications
+  @param[in]  repetitions the number of timed applications, at least 1
+  @param[in]  kernel the kernel, a function object returning zero on success
+  @param[out] timing the minimum, median and percentiles of the times
+
+  @return returns 0 upon success and non-zero otherwise
+*/
+template <typename F>
+static int TimeKernel(int warmups, int repetitions, const F & kernel, KernelTimingData & timing) {
+
+  int ierr = 0;
+  for (int i=0; i<warmups; ++i) ierr += kernel();
+
+  std::vector<double> times(repetitions, 0.0);
+  for (int i=0; i<repetitions; ++i) {
+#ifndef HPCG_NOMPI
+    MPI_Barrier(MPI_COMM_WORLD);
+#endif
+    double t0 = mytimer();
+    ierr += kernel();
+    times[i] = mytimer() - t0;
+  }
+#ifndef HPCG_NOMPI
+  MPI_Allreduce(MPI_IN_PLACE, &times[0], repetitions, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+#endif
+  std::sort(times.begin(), times.end());
+
+  timing.enabled = 1;
+  timing.minimum = times[0];
+  timing.median = Percentile(times, 0.5);
+  timing.percentile10 = Percentile(times, 0.1);
+  timing.percentile90 = Percentile(times, 0.9);
+  return(ierr);
+}
+
+/*!
+  Adds the floating point operations and the minimum memory traffic of one
+  sparse matrix-vector product with A: every nonzero with its column index
+  is read once, as well as x and the row lengths, and y is written once.
+*/
+static void SpmvCost(const SparseMatrix & A, double & flops, double & bytes) {
+  const double fnnz = (double)A.totalNumberOfNonzeros;
+  const double fnrow = (double)A.totalNumberOfRows;
+  flops += 2.0*fnnz;
+  bytes += fnnz*(valueBytes+indexBytes) + fnrow*(2.0*valueBytes+countBytes);
+}
+
+/*!
+  Adds the floating point operations and the minimum memory traffic of one
+  application of the smoother of A, modelled as a symmetric Gauss-Seidel
+  step: two sweeps that each read the matrix, the right hand side and x and
+  write x.
+*/
+static void SymgsCost(const SparseMatrix & A, double & flops, double & bytes) {
+  const double fnnz = (double)A.totalNumberOfNonzeros;
+  const double fnrow = (double)A.totalNumberOfRows;
+  flops += 4.0*fnnz;
+  bytes += 2.0*(fnnz*(valueBytes+indexBytes) + fnrow*(3.0*valueBytes+countBytes));
+}
+
+/*!
+  Adds the floating point operations and the minimum memory traffic of the
+  restriction from A to its coarse grid, the prolongation has the same
+  cost: each coarse point reads its fine grid index and two values and
+  writes one.
+*/
+static void TransferCost(const SparseMatrix & A, double & flops, double & bytes) {
+  const double fnc = (double)A.Ac->totalNumberOfRows;
+  flops += fnc;
+  bytes += fnc*(indexBytes+3.0*valueBytes);
+}
+
+#ifndef HPCG_NOMPI
+/*!
+  Adds the traffic of one halo exchange of A: the values sent and received
+  by all processes. The exchange does no floating point operations.
+*/
+static void HaloCost(const SparseMatrix & A, double & bytes) {
+  const double localValues = (double)A.totalToBeSent + (double)A.numberOfExternalValues;
+  double totalValues = 0.0;
+  MPI_Allreduce(&localValues, &totalValues, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  bytes += totalValues*valueBytes;
+}
+#endif
+
+/*!
+  Adds the floating point operations and the minimum memory traffic of one
+  multigrid cycle starting at A, following the recursion of ComputeMG.
+*/
+static void MGCost(const SparseMatrix & A, int cycleType, double & flops, double & bytes) {
+  bytes += valueBytes*A.totalNumberOfRows; // Zero initial guess
+  if (A.mgData==0) {
+    SymgsCost(A, flops, bytes);
+    return;
+  }
+  const int numberOfSteps = A.mgData->numberOfPresmootherSteps + A.mgData->numberOfPostsmootherSteps;
+  for (int i=0; i<numberOfSteps; ++i) SymgsCost(A, flops, bytes);
+  SpmvCost(A, flops, bytes);
+  TransferCost(A, flops, bytes);
+  MGCost(*A.Ac, cycleType, flops, bytes);
+  if (cycleType!=MG_CYCLE_V) MGCost(*A.Ac, (cycleType==MG_CYCLE_W) ? MG_CYCLE_W : MG_CYCLE_V, flops, bytes);
+  TransferCost(A, flops, bytes);
+}
+
+/*!
+  Measures the sustainable memory bandwidth with the STREAM triad
+  a = b + s*c, run with the backend of the vector updates.
+
+  @param[in]  n the length of the vectors on each process
+  @param[in]  warmups the number of untimed repetitions
+  @param[in]  repetitions the number of timed repetitions
+  @param[out] bandwidth the median bandwidth summed over all processes (bytes/sec)
+
+  @return returns 0 upon success and non-zero otherwise
+*/
+int BenchmarkStreamTriad(local_int_t n, int warmups, int repetitions, double & bandwidth) {
+
+  Vector a, b, c;
+  InitializeVector(a, n);
+  InitializeVector(b, n);
+  InitializeVector(c, n);
+  ZeroVector(a);
+  FillRandomVector(b);
+  FillRandomVector(c);
+  double * const av = a.values;
+  const double * const bv = b.values;
+  const double * const cv = c.values;
+  const double scalar = 3.0;
+
+  KernelTimingData timing;
+  int ierr = TimeKernel(warmups, repetitions, [n, av, bv, cv, scalar]() {
+      BackendParallelFor(HPCG_backends.waxpby, n, [av, bv, cv, scalar](local_int_t i) { av[i] = bv[i] + scalar*cv[i]; });
+      return 0;
+    }, timing);
+
+  int size = 1;
+#ifndef HPCG_NOMPI
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+#endif
+  bandwidth = 3.0*valueBytes*n*size/timing.median;
+
+  DeleteVector(a);
+  DeleteVector(b);
+  DeleteVector(c);
+  return(ierr);
+}
+
+/*!
+  Times each kernel of the optimized CG in isolation on every level of the
+  multigrid hierarchy and records the cost of one application, so that the
+  achieved FLOP/s and bytes/s can be derived. The MG kernel is one complete
+  multigrid cycle starting at the level.
+
+  The STREAM triad bandwidth must be measured separately with
+  BenchmarkStreamTriad.
+
+  @param[in]  A the known system matrix, also contains the MG hierarchy in attributes Ac and mgData.
+  @param[in]  warmups the number of untimed applications of each kernel
+  @param[in]  repetitions the number of timed applications of each kernel
+  @param[out] benchmark_data the timings of all kernels on all levels
+
+  @return returns 0 upon success and non-zero otherwise
+
+  @see BenchmarkStreamTriad
+*/
+int BenchmarkKernels(const SparseMatrix & A, int warmups, int repetitions, KernelBenchmarkData & benchmark_data) {
+
+  if (repetitions<1) repetitions = 1;
+  if (warmups<0) warmups = 0;
+  benchmark_data.warmups = warmups;
+  benchmark_data.repetitions = repetitions;
+
+  int ierr = 0;
+  int level = 0;
+  for (const SparseMatrix * Al = &A; Al!=0 && level<HPCG_MAX_MG_LEVELS; Al = Al->Ac, ++level) {
+    const SparseMatrix & curLevelMatrix = *Al;
+    const local_int_t nrow = curLevelMatrix.localNumberOfRows;
+    const local_int_t ncol = curLevelMatrix.localNumberOfColumns;
+    const double fnrow = (double)curLevelMatrix.totalNumberOfRows;
+    const int cycleType = (curLevelMatrix.mgData!=0) ? curLevelMatrix.mgData->cycleType : MG_CYCLE_V;
+
+    Vector r, x, y;
+    InitializeVector(r, nrow);
+    InitializeVector(x, ncol);
+    InitializeVector(y, ncol);
+    FillRandomVector(r);
+    FillRandomVector(x);
+    ZeroVector(y);
+
+    KernelTimingData * timings = benchmark_data.timings[level];
+    for (int kernel=0; kernel<HPCG_NUMBER_OF_KERNELS; ++kernel) {
+      timings[kernel].enabled = 0;
+      timings[kernel].flops = timings[kernel].bytes = 0.0;
+    }
+
+    ierr += TimeKernel(warmups, repetitions, [&curLevelMatrix, &x, &y]() {
+        return ComputeSPMV(curLevelMatrix, x, y);
+      }, timings[KERNEL_SPMV]);
+    SpmvCost(curLevelMatrix, timings[KERNEL_SPMV].flops, timings[KERNEL_SPMV].bytes);
+
+    ierr += TimeKernel(warmups, repetitions, [&curLevelMatrix, &r, &x]() {
+        return ComputeSYMGS(curLevelMatrix, r, x);
+      }, timings[KERNEL_SYMGS]);
+    SymgsCost(curLevelMatrix, timings[KERNEL_SYMGS].flops, timings[KERNEL_SYMGS].bytes);
+
+    ierr += TimeKernel(warmups, repetitions, [nrow, &r, &x]() {
+        double result = 0.0, t4 = 0.0;
+        bool isOptimized = true;
+        return ComputeDotProduct(nrow, r, x, result, t4, isOptimized);
+      }, timings[KERNEL_DOT]);
+    timings[KERNEL_DOT].flops = 2.0*fnrow;
+    timings[KERNEL_DOT].bytes = 2.0*valueBytes*fnrow;
+
+    ierr += TimeKernel(warmups, repetitions, [nrow, &r, &x, &y]() {
+        bool isOptimized = true;
+        return ComputeWAXPBY(nrow, 0.5, r, 1.5, x, y, isOptimized);
+      }, timings[KERNEL_WAXPBY]);
+    timings[KERNEL_WAXPBY].flops = 3.0*fnrow;
+    timings[KERNEL_WAXPBY].bytes = 3.0*valueBytes*fnrow;
+
+    if (curLevelMatrix.mgData!=0) {
+      ierr += TimeKernel(warmups, repetitions, [&curLevelMatrix, &r]() {
+          return ComputeRestriction(curLevelMatrix, r);
+        }, timings[KERNEL_RESTRICTION]);
+      TransferCost(curLevelMatrix, timings[KERNEL_RESTRICTION].flops, timings[KERNEL_RESTRICTION].bytes);
+
+      ierr += TimeKernel(warmups, repetitions, [&curLevelMatrix, &x]() {
+          return ComputeProlongation(curLevelMatrix, x);
+        }, timings[KERNEL_PROLONGATION]);
+      TransferCost(curLevelMatrix, timings[KERNEL_PROLONGATION].flops, timings[KERNEL_PROLONGATION].bytes);
+    }
+
+    ierr += TimeKernel(warmups, repetitions, [&curLevelMatrix, &r, &x]() {
+        return ComputeMG(curLevelMatrix, r, x);
+      }, timings[KERNEL_MG]);
+    MGCost(curLevelMatrix, cycleType, timings[KERNEL_MG].flops, timings[KERNEL_MG].bytes);
+
+#ifndef HPCG_NOMPI
+    ierr += TimeKernel(warmups, repetitions, [&curLevelMatrix, &x]() {
+        ExchangeHalo(curLevelMatrix, x);
+        return 0;
+      }, timings[KERNEL_HALO]);
+    HaloCost(curLevelMatrix, timings[KERNEL_HALO].bytes);
+#endif
+
+    DeleteVector(r);
+    DeleteVector(x);
+    DeleteVector(y);
+  }
+  benchmark_data.numberOfLevels = level;
+
+  return(ierr);
+}
+
+/*!
+  Creates a YAML file with the results of the kernel benchmark and writes it
+  to the standard output. Only rank 0 reports.
+
+  @param[in] A the known system matrix
+  @param[in] benchmark_data the results of BenchmarkKernels and BenchmarkStreamTriad
+*/
+void ReportKernelBenchmark(const SparseMatrix & A, const KernelBenchmarkData & benchmark_data) {
+
+  if (A.geom->rank!=0) return;
+
+  YAML_Doc doc("HPCG-Kernels", "2.4");
+
+  doc.add("Machine Summary","");
+  doc.get("Machine Summary")->add("Distributed Processes",A.geom->size);
+  doc.get("Machine Summary")->add("Threads per processes",A.geom->numThreads);
+
+  doc.add("Global Problem Dimensions","");
+  doc.get("Global Problem Dimensions")->add("Global nx",A.geom->gnx);
+  doc.get("Global Problem Dimensions")->add("Global ny",A.geom->gny);
+  doc.get("Global Problem Dimensions")->add("Global nz",A.geom->gnz);
+  doc.get("Global Problem Dimensions")->add("Scaling",(A.geom->strongScaling ? "strong" : "weak"));
+
+  doc.add("Kernel Backends","");
+  doc.get("Kernel Backends")->add("SpMV",BackendName(HPCG_backends.spmv));
+  doc.get("Kernel Backends")->add("DDOT",BackendName(HPCG_backends.dot));
+  doc.get("Kernel Backends")->add("DDOT reduction",ReductionName(HPCG_dotReduction));
+  doc.get("Kernel Backends")->add("WAXPBY",BackendName(HPCG_backends.waxpby));
+  doc.get("Kernel Backends")->add("MG",BackendName(HPCG_backends.mg));
+
+  doc.add("Benchmark Parameters","");
+  doc.get("Benchmark Parameters")->add("Warmup applications",benchmark_data.warmups);
+  doc.get("Benchmark Parameters")->add("Timed applications",benchmark_data.repetitions);
+
+  const double triadBandwidth = benchmark_data.triadBandwidth;
+  doc.add("STREAM Triad","");
+  doc.get("STREAM Triad")->add("Vector length per process",benchmark_data.triadLength);
+  doc.get("STREAM Triad")->add("GB/s",triadBandwidth/1.0E9);
+
+  const SparseMatrix * levelMatrix = &A;
+  for (int level=0; level<benchmark_data.numberOfLevels && levelMatrix!=0; ++level, levelMatrix = levelMatrix->Ac) {
+    std::stringstream levelName;
+    levelName << "Level " << level;
+    YAML_Element * levelElement = doc.add(levelName.str(),"");
+    levelElement->add("Matrix format",MatrixFormatName(LevelMatrixFormat(*levelMatrix)));
+    for (int kernel=0; kernel<HPCG_NUMBER_OF_KERNELS; ++kernel) {
+      const KernelTimingData & timing = benchmark_data.timings[level][kernel];
+      if (!timing.enabled) continue;
+      YAML_Element * kernelElement = levelElement->add(KernelName(kernel),"");
+      kernelElement->add("Median time (sec)",timing.median);
+      kernelElement->add("Minimum time (sec)",timing.minimum);
+      kernelElement->add("10th percentile time (sec)",timing.percentile10);
+      kernelElement->add("90th percentile time (sec)",timing.percentile90);
+      if (kernel==KERNEL_HALO) { // Network traffic, not memory traffic
+        kernelElement->add("Message GB/s",timing.bytes/timing.median/1.0E9);
+        continue;
+      }
+      kernelElement->add("GFLOP/s",timing.flops/timing.median/1.0E9);
+      kernelElement->add("GB/s",timing.bytes/timing.median/1.0E9);
+      kernelElement->add("Fraction of triad bandwidth",timing.bytes/timing.median/triadBandwidth);
+    }
+  }
+
+  std::string yaml = doc.generateYAML();
+  doc.generateJSON();
+  std::cout << yaml;
+  return;
+}
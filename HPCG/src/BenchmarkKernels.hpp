@@ -0,0 +1,69 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file BenchmarkKernels.hpp
+
+ HPCG data structure
+ */
+
+#ifndef BENCHMARKKERNELS_HPP
+#define BENCHMARKKERNELS_HPP
+
+#include "hpcg.hpp"
+#include "SparseMatrix.hpp"
+
+/*!
+  The kernels timed in isolation on each multigrid level.
+*/
+enum BenchmarkKernel_ENUM {
+  KERNEL_SPMV = 0,
+  KERNEL_SYMGS = 1,
+  KERNEL_DOT = 2,
+  KERNEL_WAXPBY = 3,
+  KERNEL_RESTRICTION = 4,
+  KERNEL_PROLONGATION = 5,
+  KERNEL_MG = 6,
+  KERNEL_HALO = 7,
+  HPCG_NUMBER_OF_KERNELS = 8
+};
+
+struct KernelTimingData_STRUCT {
+  int enabled; //!< 1 if the kernel was timed, restriction and prolongation are not defined on the coarsest level
+  double minimum; //!< shortest time of one application (sec)
+  double median; //!< median time of one application (sec)
+  double percentile10; //!< 10th percentile of the time of one application (sec)
+  double percentile90; //!< 90th percentile of the time of one application (sec)
+  double flops; //!< floating point operations of one application, summed over all processes
+  double bytes; //!< minimum memory traffic of one application, summed over all processes
+};
+typedef struct KernelTimingData_STRUCT KernelTimingData;
+
+struct KernelBenchmarkData_STRUCT {
+  int numberOfLevels; //!< number of multigrid levels timed
+  int warmups; //!< number of untimed applications before the timed ones
+  int repetitions; //!< number of timed applications
+  local_int_t triadLength; //!< length of the vectors of the STREAM triad on each process
+  double triadBandwidth; //!< median bandwidth of the STREAM triad summed over all processes (bytes/sec)
+  KernelTimingData timings[HPCG_MAX_MG_LEVELS][HPCG_NUMBER_OF_KERNELS]; //!< timings[level][kernel]
+};
+typedef struct KernelBenchmarkData_STRUCT KernelBenchmarkData;
+
+extern const char * KernelName(int kernel);
+extern int BenchmarkStreamTriad(local_int_t n, int warmups, int repetitions, double & bandwidth);
+extern int BenchmarkKernels(const SparseMatrix & A, int warmups, int repetitions, KernelBenchmarkData & benchmark_data);
+extern void ReportKernelBenchmark(const SparseMatrix & A, const KernelBenchmarkData & benchmark_data);
+
+#endif  // BENCHMARKKERNELS_HPP
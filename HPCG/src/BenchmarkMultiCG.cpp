@@ -0,0 +1,118 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file BenchmarkMultiCG.cpp
+
+ HPCG routine
+ */
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/hpx_fwd.hpp>
+#endif
+
+#ifndef HPCG_NOMPI
+#include <mpi.h>
+#endif
+
+#include <fstream>
+#include <vector>
+using std::endl;
+
+#include "BenchmarkMultiCG.hpp"
+#include "MultiCG.hpp"
+#ifndef HPCG_NOMPI
+#include "ExchangeHalo.hpp"
+#endif
+#include "mytimer.hpp"
+
+/*!
+  Measures the throughput of MultiCG: for k = 1, ..., maxNumberOfVectors
+  solves k right-hand sides together with a fixed number of iterations and
+  records the number of right-hand sides solved per second. The first
+  right-hand side is b, the others are random.
+
+  @param[in]  A the known system matrix
+  @param[in]  b the known right hand side vector
+  @param[in]  maxNumberOfVectors the largest number of right-hand sides, nothing is done if it is 0
+  @param[in]  niters the number of iterations of each solve
+  @param[out] benchmark_data the times and throughputs for all k
+
+  @return Returns zero on success and a non-zero value otherwise.
+
+  @see MultiCG
+*/
+int BenchmarkMultiCG(const SparseMatrix & A, const Vector & b, int maxNumberOfVectors, int niters,
+    MultiCGBenchmarkData & benchmark_data) {
+
+  if (maxNumberOfVectors>HPCG_MAX_RHS) maxNumberOfVectors = HPCG_MAX_RHS;
+  benchmark_data.maxNumberOfVectors = (maxNumberOfVectors>0) ? maxNumberOfVectors : 0;
+  benchmark_data.niters = niters;
+  if (maxNumberOfVectors<=0) return(0);
+
+#ifndef HPCG_NOMPI
+  // The halo buffers of all levels are allocated once, for the largest block
+  for (const SparseMatrix * curLevelMatrix = &A; curLevelMatrix!=0; curLevelMatrix = curLevelMatrix->Ac)
+    SetupMultiHalo(*curLevelMatrix, maxNumberOfVectors);
+#endif
+
+  int ierr = 0;
+  std::vector< double > times(9,0.0);
+  Vector randomRhs;
+  InitializeVector(randomRhs, A.localNumberOfRows);
+  for (int k=1; k<=maxNumberOfVectors; ++k) {
+    MultiCGData data;
+    MultiVector B, X;
+    InitializeMultiCGData(A, k, data);
+    InitializeMultiVector(B, A.localNumberOfRows, k);
+    InitializeMultiVector(X, A.localNumberOfColumns, k);
+    SetMultiVectorColumn(b, B, 0);
+    for (int j=1; j<k; ++j) {
+      FillRandomVector(randomRhs);
+      SetMultiVectorColumn(randomRhs, B, j);
+    }
+    ZeroMultiVector(X);
+
+    int numberOfIterations = 0;
+    double normr[HPCG_MAX_RHS], normr0[HPCG_MAX_RHS];
+#ifndef HPCG_NOMPI
+    MPI_Barrier(MPI_COMM_WORLD);
+#endif
+    double t0 = mytimer();
+    ierr += MultiCG(A, data, B, X, niters, 0.0, numberOfIterations, normr, normr0, &times[0], true);
+    double time = mytimer() - t0;
+#ifndef HPCG_NOMPI
+    double localTime = time;
+    MPI_Allreduce(&localTime, &time, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+#endif
+
+    double scaledResidual = 0.0;
+    for (int j=0; j<k; ++j)
+      if (normr0[j]>0.0 && normr[j]/normr0[j]>scaledResidual) scaledResidual = normr[j]/normr0[j];
+    benchmark_data.time[k-1] = time;
+    benchmark_data.solvesPerSecond[k-1] = (time>0.0) ? k/time : 0.0;
+    benchmark_data.scaledResidual[k-1] = scaledResidual;
+    if (A.geom->rank==0)
+      HPCG_fout << "Multiple right-hand sides [" << k << "] Time [" << time << "] Solves per second ["
+          << benchmark_data.solvesPerSecond[k-1] << "] Maximum scaled residual [" << scaledResidual << "]" << endl;
+
+    DeleteMultiVector(X);
+    DeleteMultiVector(B);
+    DeleteMultiCGData(data);
+  }
+  DeleteVector(randomRhs);
+
+  return(ierr);
+}
@@ -0,0 +1,42 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file BenchmarkMultiCG.hpp
+
+ HPCG data structure
+ */
+
+#ifndef BENCHMARKMULTICG_HPP
+#define BENCHMARKMULTICG_HPP
+
+#include "hpcg.hpp"
+#include "SparseMatrix.hpp"
+#include "Vector.hpp"
+#include "MultiVector.hpp"
+
+struct MultiCGBenchmarkData_STRUCT {
+  int maxNumberOfVectors; //!< largest number of right-hand sides solved together, 0 if the benchmark was not performed
+  int niters; //!< number of MultiCG iterations of each solve
+  double time[HPCG_MAX_RHS]; //!< time[k-1] is the time of the solve of k right-hand sides together
+  double solvesPerSecond[HPCG_MAX_RHS]; //!< solvesPerSecond[k-1] is the number of right-hand sides solved per second with k together
+  double scaledResidual[HPCG_MAX_RHS]; //!< scaledResidual[k-1] is the largest scaled residual of the k right-hand sides
+};
+typedef struct MultiCGBenchmarkData_STRUCT MultiCGBenchmarkData;
+
+extern int BenchmarkMultiCG(const SparseMatrix & A, const Vector & b, int maxNumberOfVectors, int niters,
+    MultiCGBenchmarkData & benchmark_data);
+
+#endif  // BENCHMARKMULTICG_HPP
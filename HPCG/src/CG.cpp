@@ -34,12 +34,216 @@
 #include "ComputeMG.hpp"
 #include "ComputeDotProduct.hpp"
 #include "ComputeWAXPBY.hpp"
+#include "KernelCounters.hpp"
+#include "Trace.hpp"
 
 
 // Use TICK and TOCK to time a code section in MATLAB-like fashion
 #define TICK()  t0 = mytimer() //!< record current time in 't0'
 #define TOCK(t) t += mytimer() - t0 //!< store time difference in 't' using time in 't0'
 
+bool HPCG_cgDataflow = false;
+
+#if !defined(HPCG_NOHPX)
+
+#include <hpx/include/lcos.hpp>
+
+/*!
+  Attaches a timer to an asynchronous kernel: when the kernel completes, the
+  time since start is added to t and recorded as a call of the kernel in the
+  kernel counters.
+
+  @param[in]  f the future of the kernel
+  @param[in]  kernel the kernel, one of BenchmarkKernel
+  @param[in]  A the matrix of the level the kernel is applied on, 0 for the vector kernels
+  @param[in]  n the number of vector elements, for the counted memory traffic of the vector kernels
+  @param[in]  start the time the kernel was started
+  @param[out] t the accumulated time of the kernel, must not be updated by a concurrent continuation
+
+  @return the future of the kernel result, ready after the timer was updated
+*/
+template <typename T>
+static hpx::future<T> TimeKernel(hpx::future<T> && f, int kernel, const SparseMatrix * A, local_int_t n,
+    double start, double & t) {
+  return f.then([kernel, A, n, start, &t](hpx::future<T> done) {
+    const double elapsed = mytimer() - start;
+    t += elapsed;
+    if (HPCG_kernelCountersEnabled) RecordKernelCall(kernel, A, n, (long long)(elapsed*1.0e9));
+    return done.get();
+  });
+}
+
+/*!
+  Routine to compute an approximate solution to Ax = b with the iterations
+  built as a dataflow graph of the asynchronous kernels.
+
+  Each kernel is started as soon as the vectors and scalars it reads are
+  available and the vectors it overwrites are no longer read by a previous
+  kernel. Only the residual norm is waited for, by the convergence test at
+  the end of each iteration. The update of x is not on that path, so it
+  runs concurrently with the update of the residual, its norm and the
+  preconditioner of the next iteration; it is waited for before returning.
+
+  The time of a kernel is measured from its start to the continuation
+  attached to its future, so the times of overlapping kernels add up to more
+  than the elapsed time.
+
+  @param[in]    A    The known system matrix
+  @param[inout] data The data structure with all necessary CG vectors preallocated
+  @param[in]    b    The known right hand side vector
+  @param[inout] x    On entry: the initial guess; on exit: the new approximate solution
+  @param[in]    max_iter  The maximum number of iterations to perform, even if tolerance is not met.
+  @param[in]    tolerance The stopping criterion to assert convergence: if norm of residual is <= to tolerance.
+  @param[out]   niters    The number of iterations actually performed.
+  @param[out]   normr     The 2-norm of the residual vector after the last iteration.
+  @param[out]   normr0    The 2-norm of the residual vector before the first iteration.
+  @param[out]   times     The 7-element vector of the timing information accumulated during all of the iterations.
+  @param[in]    doPreconditioning The flag to indicate whether the preconditioner should be invoked at each iteration.
+
+  @return Returns zero on success and a non-zero value otherwise.
+
+  @see CG()
+*/
+int CG_async(const SparseMatrix & A, CGData & data, const Vector & b, Vector & x,
+    const int max_iter, const double tolerance, int & niters, double & normr, double & normr0,
+    double * times, bool doPreconditioning) {
+
+  double t_begin = mytimer();  // Start timing right away
+  normr = 0.0;
+  int ierr = 0; // Sum of the error codes of the preconditioner applications
+
+  // The update of x runs concurrently with the other vector updates and has its own timer
+  double t1 = 0.0, t2 = 0.0, t2x = 0.0, t3 = 0.0, t4 = 0.0, t5 = 0.0;
+  const local_int_t nrow = A.localNumberOfRows;
+  Vector & r = data.r; // Residual vector
+  Vector & z = data.z; // Preconditioned residual vector
+  Vector & p = data.p; // Direction vector
+  Vector & Ap = data.Ap;
+
+  if (!doPreconditioning && A.geom->rank==0) HPCG_fout << "WARNING: PERFORMING UNPRECONDITIONED ITERATIONS" << std::endl;
+
+#ifdef HPCG_DEBUG
+  int print_freq = 1;
+  if (print_freq>50) print_freq=50;
+  if (print_freq<1)  print_freq=1;
+#endif
+  // p is of length ncols, copy x to p for sparse MV operation
+  CopyVector(x, p);
+  double t0 = mytimer();
+  hpx::future<void> fAp = TimeKernel(ComputeSPMV_async(A, p, Ap), KERNEL_SPMV, &A, nrow, t0, t3); // Ap = A*p
+  hpx::future<void> fr(hpx::dataflow([&](hpx::future<void> ready) { // r = b - Ax (x stored in p)
+    ready.get();
+    const double start = mytimer();
+    return TimeKernel(ComputeWAXPBY_async(nrow, 1.0, b, -1.0, Ap, r), KERNEL_WAXPBY, 0, nrow, start, t2);
+  }, std::move(fAp)));
+  hpx::future<double> fnormr(hpx::dataflow([&](hpx::future<void> ready) { // normr = r'*r
+    ready.get();
+    const double start = mytimer();
+    return TimeKernel(ComputeDotProduct_async(nrow, r, r, t4), KERNEL_DOT, 0, nrow, start, t1);
+  }, std::move(fr)));
+  normr = sqrt(fnormr.get());
+#ifdef HPCG_DEBUG
+  if (A.geom->rank==0) HPCG_fout << "Initial Residual = "<< normr << std::endl;
+#endif
+
+  // Record initial residual for convergence testing
+  normr0 = normr;
+
+  hpx::shared_future<void> fx = hpx::make_ready_future(); // x is no longer read or written by the previous iteration
+  hpx::shared_future<double> oldrtz;
+
+  // Start iterations
+
+  for (int k=1; k<=max_iter && normr/normr0 > tolerance; k++ ) {
+    const long long traceBegin = HPCG_traceEnabled ? TraceTime() : 0;
+
+    // r is complete since its norm is known
+    hpx::future<int> fz;
+    t0 = mytimer();
+    if (doPreconditioning)
+      fz = TimeKernel(ComputeMG_async(A, r, z), KERNEL_MG, &A, 0, t0, t5); // Apply preconditioner
+    else {
+      CopyVector (r, z); // copy r to z (no preconditioning)
+      t5 += mytimer() - t0;
+      fz = hpx::make_ready_future(0);
+    }
+
+    hpx::future<double> fr_z(hpx::dataflow([&](hpx::future<int> ready) { // rtz = r'*z
+      ierr += ready.get(); // The error code of the preconditioner, the only task writing ierr in this iteration
+      const double start = mytimer();
+      return TimeKernel(ComputeDotProduct_async(nrow, r, z, t4), KERNEL_DOT, 0, nrow, start, t1);
+    }, std::move(fz)));
+    hpx::shared_future<double> rtz = fr_z.share();
+
+    // p is overwritten once the previous update of x has read it
+    hpx::future<void> fp;
+    if (k == 1)
+      fp = hpx::future<void>(hpx::dataflow([&](hpx::shared_future<double> ready, hpx::shared_future<void> xready) { // Copy Mr to p
+        ready.get();
+        const double start = mytimer();
+        return TimeKernel(ComputeWAXPBY_async(nrow, 1.0, z, 0.0, z, p), KERNEL_WAXPBY, 0, nrow, start, t2);
+      }, rtz, fx));
+    else
+      fp = hpx::future<void>(hpx::dataflow([&](hpx::shared_future<double> current, hpx::shared_future<double> previous,
+          hpx::shared_future<void> xready) { // p = beta*p + z
+        const double beta = current.get()/previous.get();
+        const double start = mytimer();
+        return TimeKernel(ComputeWAXPBY_async(nrow, 1.0, z, beta, p, p), KERNEL_WAXPBY, 0, nrow, start, t2);
+      }, rtz, oldrtz, fx));
+    hpx::shared_future<void> pready = fp.share();
+
+    fAp = hpx::future<void>(hpx::dataflow([&](hpx::shared_future<void> ready) { // Ap = A*p
+      ready.get();
+      const double start = mytimer();
+      return TimeKernel(ComputeSPMV_async(A, p, Ap), KERNEL_SPMV, &A, nrow, start, t3);
+    }, pready));
+    hpx::future<double> fpAp(hpx::dataflow([&](hpx::future<void> ready) { // pAp = p'*Ap
+      ready.get();
+      const double start = mytimer();
+      return TimeKernel(ComputeDotProduct_async(nrow, p, Ap, t4), KERNEL_DOT, 0, nrow, start, t1);
+    }, std::move(fAp)));
+    hpx::shared_future<double> alpha = hpx::dataflow([](hpx::shared_future<double> current, hpx::future<double> pAp) {
+      return current.get()/pAp.get();
+    }, rtz, std::move(fpAp)).share();
+
+    fx = hpx::future<void>(hpx::dataflow([&](hpx::shared_future<double> scale, hpx::shared_future<void> xready,
+        hpx::shared_future<void> ready) { // x = x + alpha*p
+      const double start = mytimer();
+      return TimeKernel(ComputeWAXPBY_async(nrow, 1.0, x, scale.get(), p, x), KERNEL_WAXPBY, 0, nrow, start, t2x);
+    }, alpha, fx, pready)).share();
+    fr = hpx::future<void>(hpx::dataflow([&](hpx::shared_future<double> scale) { // r = r - alpha*Ap
+      const double start = mytimer();
+      return TimeKernel(ComputeWAXPBY_async(nrow, 1.0, r, -scale.get(), Ap, r), KERNEL_WAXPBY, 0, nrow, start, t2);
+    }, alpha));
+    fnormr = hpx::future<double>(hpx::dataflow([&](hpx::future<void> ready) { // normr = r'*r
+      ready.get();
+      const double start = mytimer();
+      return TimeKernel(ComputeDotProduct_async(nrow, r, r, t4), KERNEL_DOT, 0, nrow, start, t1);
+    }, std::move(fr)));
+    oldrtz = rtz;
+
+    normr = sqrt(fnormr.get()); // The only wait of the iteration, for the convergence test
+#ifdef HPCG_DEBUG
+    if (A.geom->rank==0 && (k%print_freq == 0 || k == max_iter))
+      HPCG_fout << "Iteration = "<< k << "   Scaled Residual = "<< normr/normr0 << std::endl;
+#endif
+    if (HPCG_traceEnabled) RecordTraceEvent("cg", "CG iteration", -1, traceBegin, TraceTime());
+    niters = k;
+  }
+  fx.get();
+
+  // Store times
+  times[1] += t1; // dot-product time
+  times[2] += t2 + t2x; // WAXPBY time
+  times[3] += t3; // SPMV time
+  times[4] += t4; // AllReduce time
+  times[5] += t5; // preconditioner apply time
+  times[0] += mytimer() - t_begin;  // Total time. All done...
+  return(ierr);
+}
+
+#endif
+
 /*!
   Routine to compute an approximate solution to Ax = b
 
@@ -59,15 +263,20 @@
   @return Returns zero on success and a non-zero value otherwise.
 
   @see CG_ref()
+  @see CG_async()
 */
 int CG(const SparseMatrix & A, CGData & data, const Vector & b, Vector & x,
     const int max_iter, const double tolerance, int & niters, double & normr, double & normr0,
     double * times, bool doPreconditioning) {
 
+#if !defined(HPCG_NOHPX)
+  if (HPCG_cgDataflow) return(CG_async(A, data, b, x, max_iter, tolerance, niters, normr, normr0, times, doPreconditioning));
+#endif
+
   double t_begin = mytimer();  // Start timing right away
   normr = 0.0;
   double rtz = 0.0, oldrtz = 0.0, alpha = 0.0, beta = 0.0, pAp = 0.0;
-
+  int ierr = 0; // Sum of the error codes of the preconditioner applications
 
   double t0 = 0.0, t1 = 0.0, t2 = 0.0, t3 = 0.0, t4 = 0.0, t5 = 0.0;
 //#ifndef HPCG_NOMPI
@@ -102,9 +311,10 @@ int CG(const SparseMatrix & A, CGData & data, const Vector & b, Vector & x,
   // Start iterations
 
   for (int k=1; k<=max_iter && normr/normr0 > tolerance; k++ ) {
+    const long long traceBegin = HPCG_traceEnabled ? TraceTime() : 0;
     TICK();
     if (doPreconditioning)
-      ComputeMG(A, r, z); // Apply preconditioner
+      ierr += ComputeMG(A, r, z); // Apply preconditioner
     else
       CopyVector (r, z); // copy r to z (no preconditioning)
     TOCK(t5); // Preconditioner apply time
@@ -130,6 +340,7 @@ int CG(const SparseMatrix & A, CGData & data, const Vector & b, Vector & x,
     if (A.geom->rank==0 && (k%print_freq == 0 || k == max_iter))
       HPCG_fout << "Iteration = "<< k << "   Scaled Residual = "<< normr/normr0 << std::endl;
 #endif
+    if (HPCG_traceEnabled) RecordTraceEvent("cg", "CG iteration", -1, traceBegin, TraceTime());
     niters = k;
   }
 
@@ -143,5 +354,5 @@ int CG(const SparseMatrix & A, CGData & data, const Vector & b, Vector & x,
 //  times[6] += t6; // exchange halo time
 //#endif
   times[0] += mytimer() - t_begin;  // Total time. All done...
-  return(0);
+  return(ierr);
 }
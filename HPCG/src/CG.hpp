@@ -22,6 +22,13 @@
 int CG(const SparseMatrix & A, CGData & data, const Vector & b, Vector & x,
     const int max_iter, const double tolerance, int & niters, double & normr,  double & normr0,
     double * times, bool doPreconditioning);
+#if !defined(HPCG_NOHPX)
+int CG_async(const SparseMatrix & A, CGData & data, const Vector & b, Vector & x,
+    const int max_iter, const double tolerance, int & niters, double & normr,  double & normr0,
+    double * times, bool doPreconditioning);
+#endif
+
+extern bool HPCG_cgDataflow; //!< true if CG runs as a dataflow graph of the asynchronous kernels, set by HPCG_Init
 
 // this function will compute the Conjugate Gradient iterations.
 // geom - Domain and processor topology information
@@ -0,0 +1,90 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file CompareCoarseSolvers.cpp
+
+ HPCG routine
+ */
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/hpx_fwd.hpp>
+#endif
+
+#ifndef HPCG_NOMPI
+#include <mpi.h>
+#endif
+
+#include <fstream>
+#include <vector>
+using std::endl;
+
+#include "CompareCoarseSolvers.hpp"
+#include "CG.hpp"
+#include "mytimer.hpp"
+
+/*!
+  Compares the smoother and the direct solver on the coarsest grid: solves
+  the problem with the optimized CG to the given tolerance once with each
+  variant and records the number of iterations and the time.
+
+  Nothing is done unless the direct solver was selected by SetupCoarseSolver.
+
+  @param[in]    A the known system matrix
+  @param[inout] data the data structure with all necessary CG vectors preallocated
+  @param[in]    b the known right hand side vector
+  @param[inout] x the solution vector, overwritten
+  @param[in]    maxIters the maximum number of CG iterations
+  @param[in]    tolerance the scaled residual to reach
+  @param[out]   comparison_data the number of iterations and times of both variants
+
+  @return Returns zero on success and a non-zero value otherwise.
+
+  @see SetupCoarseSolver
+*/
+int CompareCoarseSolvers(const SparseMatrix & A, CGData & data, const Vector & b, Vector & x, int maxIters,
+    double tolerance, CoarseSolverComparisonData & comparison_data) {
+
+  comparison_data.enabled = 0;
+  const SparseMatrix * coarsestMatrix = &A;
+  while (coarsestMatrix->Ac) coarsestMatrix = coarsestMatrix->Ac;
+  SmootherData * coarseData = coarsestMatrix->smootherData;
+  if (coarseData==0 || coarseData->type!=SMOOTHER_CHOLESKY) return(0);
+
+  comparison_data.enabled = 1;
+  int ierr = 0;
+  std::vector< double > times(9,0.0);
+  const int types[2] = {coarseData->baseType, SMOOTHER_CHOLESKY};
+  for (int k=0; k<2; ++k) {
+    coarseData->type = types[k];
+    int niters = 0;
+    double normr = 0.0;
+    double normr0 = 0.0;
+    ZeroVector(x);
+#ifndef HPCG_NOMPI
+    MPI_Barrier(MPI_COMM_WORLD);
+#endif
+    double t0 = mytimer();
+    ierr += CG(A, data, b, x, maxIters, tolerance, niters, normr, normr0, &times[0], true);
+    comparison_data.time[k] = mytimer() - t0;
+    comparison_data.niters[k] = niters;
+    comparison_data.scaledResidual[k] = normr/normr0;
+    if (A.geom->rank==0)
+      HPCG_fout << "Coarse grid solver [" << SmootherName(types[k]) << "] Number of Iterations [" << niters
+          << "] Time [" << comparison_data.time[k] << "]" << endl;
+  }
+  coarseData->type = SMOOTHER_CHOLESKY;
+
+  return(ierr);
+}
@@ -0,0 +1,40 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file CompareCoarseSolvers.hpp
+
+ HPCG data structure
+ */
+
+#ifndef COMPARECOARSESOLVERS_HPP
+#define COMPARECOARSESOLVERS_HPP
+
+#include "hpcg.hpp"
+#include "SparseMatrix.hpp"
+#include "Vector.hpp"
+#include "CGData.hpp"
+
+struct CoarseSolverComparisonData_STRUCT {
+  int enabled; //!< 1 if the comparison was performed, i.e. the direct coarse grid solver is used
+  int niters[2]; //!< number of CG iterations to reach the tolerance with the smoother [0] and the direct solver [1]
+  double time[2]; //!< time of the CG solve with the smoother [0] and the direct solver [1]
+  double scaledResidual[2]; //!< scaled residual reached with the smoother [0] and the direct solver [1]
+};
+typedef struct CoarseSolverComparisonData_STRUCT CoarseSolverComparisonData;
+
+extern int CompareCoarseSolvers(const SparseMatrix & A, CGData & data, const Vector & b, Vector & x, int maxIters,
+    double tolerance, CoarseSolverComparisonData & comparison_data);
+
+#endif  // COMPARECOARSESOLVERS_HPP
@@ -0,0 +1,214 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file ComputeBlockSYMGS.cpp
+
+ HPCG routine
+ */
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/hpx_fwd.hpp>
+#endif
+
+#ifndef HPCG_NOMPI
+#include "ExchangeHalo.hpp"
+#endif
+
+#ifndef HPCG_NOOPENMP
+#include <omp.h>
+#endif
+
+#include <cassert>
+#include <cmath>
+
+#include "ComputeBlockSYMGS.hpp"
+#include "GenerateGeometry.hpp"
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/include/lcos.hpp>
+#include <hpx/include/parallel_for_each.hpp>
+
+#include <boost/iterator/counting_iterator.hpp>
+#endif
+
+/*!
+  Prepares the block smoother for a given matrix: partitions the local grid
+  points of the matrix geometry into data.numberOfBlocks compact subcubes and
+  computes the L1 corrected inverse diagonal.
+
+  The L1 correction adds the absolute values of all couplings of a row to
+  other blocks (and to other processors) to the diagonal, which guarantees
+  convergence of the Jacobi iteration across block boundaries.
+
+  @param[in]    A the known system matrix
+  @param[inout] data the smoother data of the matrix, on exit the blocks and work vectors are defined
+
+  @return returns 0 upon success and non-zero otherwise
+
+  @see ComputeBlockSYMGS
+*/
+int SetupBlockSYMGS(const SparseMatrix & A, SmootherData & data) {
+
+  const local_int_t nrow = A.localNumberOfRows;
+  const local_int_t ncol = A.localNumberOfColumns;
+  const int nx = A.geom->nx;
+  const int ny = A.geom->ny;
+  const int nz = A.geom->nz;
+  assert(nrow==((local_int_t)nx)*ny*nz);
+
+  DeleteSmootherWorkspace(data);
+  int bx, by, bz;
+  GenerateBlockGrid(data.numberOfBlocks, nx, ny, nz, &bx, &by, &bz);
+  const int numberOfBlocks = bx*by*bz;
+  data.numberOfBlocks = numberOfBlocks;
+  data.blocksX = bx;
+  data.blocksY = by;
+  data.blocksZ = bz;
+
+  data.blockStart = new local_int_t[numberOfBlocks+1];
+  data.blockRows = new local_int_t[nrow];
+  data.rowBlock = new int[nrow];
+  data.invDiagonal = new Vector;
+  data.previous = new Vector;
+  InitializeVector(*data.invDiagonal, nrow);
+  InitializeVector(*data.previous, ncol);
+
+  // Rows of each block in the natural (lexicographic) order of the grid points
+  int * const rowBlock = data.rowBlock;
+  GenerateBlockRows(nx, ny, nz, bx, by, bz, data.blockStart, data.blockRows, rowBlock);
+  assert(data.blockStart[numberOfBlocks]==nrow);
+
+  // L1 corrected diagonal
+  double * const invdv = data.invDiagonal->values;
+  for (local_int_t i=0; i<nrow; ++i) {
+    const double * const currentValues = A.matrixValues[i];
+    const local_int_t * const currentColIndices = A.mtxIndL[i];
+    const int currentNumberOfNonzeros = A.nonzerosInRow[i];
+    double diagonal = *(A.matrixDiagonal[i]);
+    for (int j=0; j<currentNumberOfNonzeros; ++j) {
+      local_int_t curCol = currentColIndices[j];
+      if (curCol>=nrow || rowBlock[curCol]!=rowBlock[i]) diagonal += std::fabs(currentValues[j]);
+    }
+    if (diagonal==0.0) return(-1);
+    invdv[i] = 1.0/diagonal;
+  }
+
+  return(0);
+}
+
+/*!
+  Computes one Gauss-Seidel sweep over the rows of one block.
+
+  Values inside the block are taken from x, so they are updated in place,
+  values outside of the block are taken from the copy of x made at the start
+  of the sweep, so they are treated as in a Jacobi iteration.
+
+  @param[in]    A the known system matrix
+  @param[in]    data the smoother data of the matrix
+  @param[in]    block the block to update
+  @param[in]    forward true for a forward sweep, false for a backward sweep
+  @param[in]    rv the right hand side values
+  @param[inout] xv the values to be updated
+*/
+static void ComputeBlockSweep(const SparseMatrix & A, const SmootherData & data, const int block, const bool forward,
+    const double * const rv, double * const xv) {
+
+  const local_int_t nrow = A.localNumberOfRows;
+  const double * const pv = data.previous->values;
+  const double * const invdv = data.invDiagonal->values;
+  const int * const rowBlock = data.rowBlock;
+  const local_int_t first = data.blockStart[block];
+  const local_int_t last = data.blockStart[block+1];
+
+  for (local_int_t k=first; k<last; ++k) {
+    const local_int_t i = data.blockRows[forward ? k : first+last-1-k];
+    const double * const currentValues = A.matrixValues[i];
+    const local_int_t * const currentColIndices = A.mtxIndL[i];
+    const int currentNumberOfNonzeros = A.nonzerosInRow[i];
+    double sum = rv[i]; // RHS value
+
+    for (int j=0; j<currentNumberOfNonzeros; ++j) {
+      local_int_t curCol = currentColIndices[j];
+      if (curCol<nrow && rowBlock[curCol]==block)
+        sum -= currentValues[j]*xv[curCol];
+      else
+        sum -= currentValues[j]*pv[curCol];
+    }
+
+    xv[i] += sum*invdv[i];
+  }
+  return;
+}
+
+/*!
+  Computes one step of the hybrid block symmetric Gauss-Seidel smoother:
+
+  The rows are partitioned into compact subcubes of the local grid (see
+  SetupBlockSYMGS). A forward and a backward Gauss-Seidel sweep is performed
+  inside each block, all blocks are updated concurrently. Couplings across
+  block boundaries use the values from the start of the sweep (Jacobi) and
+  are accounted for by the L1 corrected diagonal. With a single block on a
+  single processor this is identical to ComputeSYMGS_ref.
+
+  The backward sweep is the transpose of the forward sweep, so the multigrid
+  preconditioner remains symmetric.
+
+  @param[in] A the known system matrix, A.smootherData must have been set up by SetupBlockSYMGS
+  @param[in] r the input vector
+  @param[inout] x On entry, x should contain relevant values, on exit x contains the result of one symmetric sweep with r as the RHS.
+
+  @return returns 0 upon success and non-zero otherwise
+
+  @see SetupBlockSYMGS
+  @see ComputeSYMGS_ref
+*/
+int ComputeBlockSYMGS(const SparseMatrix & A, const Vector & r, Vector & x) {
+
+  assert(x.localLength==A.localNumberOfColumns); // Make sure x contain space for halo values
+  assert(A.smootherData!=0 && A.smootherData->blockStart!=0);
+
+#ifndef HPCG_NOMPI
+  ExchangeHalo(A,x);
+#endif
+
+  const SmootherData & data = *A.smootherData;
+  const int numberOfBlocks = data.numberOfBlocks;
+  const double * const rv = r.values;
+  double * const xv = x.values;
+
+  for (int sweep=0; sweep<2; ++sweep) {
+    const bool forward = (sweep==0);
+    CopyVector(x, *data.previous);
+
+#if defined(HPCG_NOHPX)
+#ifndef HPCG_NOOPENMP
+    #pragma omp parallel for schedule(static,1)
+#endif
+    for (int block=0; block<numberOfBlocks; ++block)
+      ComputeBlockSweep(A, data, block, forward, rv, xv);
+#else
+    typedef boost::counting_iterator<int> iterator;
+
+    hpx::parallel::for_each(
+      hpx::parallel::par, iterator(0), iterator(numberOfBlocks),
+      [&A, &data, forward, rv, xv](int block)
+      {
+        ComputeBlockSweep(A, data, block, forward, rv, xv);
+      });
+#endif
+  }
+
+  return(0);
+}
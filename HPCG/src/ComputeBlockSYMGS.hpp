@@ -0,0 +1,24 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+#ifndef COMPUTEBLOCKSYMGS_HPP
+#define COMPUTEBLOCKSYMGS_HPP
+
+#include "SparseMatrix.hpp"
+#include "Vector.hpp"
+
+int SetupBlockSYMGS(const SparseMatrix & A, SmootherData & data);
+int ComputeBlockSYMGS(const SparseMatrix & A, const Vector & r, Vector & x);
+
+#endif // COMPUTEBLOCKSYMGS_HPP
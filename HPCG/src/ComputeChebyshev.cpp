@@ -0,0 +1,250 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file ComputeChebyshev.cpp
+
+ HPCG routine
+ */
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/hpx_fwd.hpp>
+#endif
+
+#ifndef HPCG_NOMPI
+#include <mpi.h>
+#endif
+
+#ifndef HPCG_NOOPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "ComputeChebyshev.hpp"
+#include "ComputeSPMV.hpp"
+#include "ComputeWAXPBY.hpp"
+#include "ComputeDotProduct.hpp"
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/include/lcos.hpp>
+#include <hpx/include/parallel_for_each.hpp>
+
+#include <boost/iterator/counting_iterator.hpp>
+#endif
+
+/*!
+  Computes the fused Chebyshev vector update:
+
+    d = alpha*d + beta*D^{-1}*res, and if x is given: x = x + d
+
+  d is not read if alpha is zero, so it may be uninitialized on the first step.
+
+  @param[in]    n the number of vector elements (on this processor)
+  @param[in]    alpha the scalar applied to the previous direction
+  @param[inout] d the update direction
+  @param[in]    beta the scalar applied to the scaled residual
+  @param[in]    invDiagonal the inverse of the matrix diagonal
+  @param[in]    res the current residual
+  @param[inout] x the vector to be updated, may be 0
+
+  @return returns 0 upon success and non-zero otherwise
+*/
+static int ComputeChebyshevUpdate(const local_int_t n, const double alpha, Vector & d,
+    const double beta, const Vector & invDiagonal, const Vector & res, Vector * x) {
+
+  double * const dv = d.values;
+  const double * const invdv = invDiagonal.values;
+  const double * const resv = res.values;
+  double * const xv = x ? x->values : 0;
+
+#if defined(HPCG_NOHPX)
+  if (alpha==0.0) {
+#ifndef HPCG_NOOPENMP
+    #pragma omp parallel for
+#endif
+    for (local_int_t i=0; i<n; i++) dv[i] = beta * invdv[i] * resv[i];
+  } else {
+#ifndef HPCG_NOOPENMP
+    #pragma omp parallel for
+#endif
+    for (local_int_t i=0; i<n; i++) dv[i] = alpha * dv[i] + beta * invdv[i] * resv[i];
+  }
+  if (xv!=0) {
+#ifndef HPCG_NOOPENMP
+    #pragma omp parallel for
+#endif
+    for (local_int_t i=0; i<n; i++) xv[i] += dv[i];
+  }
+#else
+  typedef boost::counting_iterator<local_int_t> iterator;
+
+  if (alpha==0.0) {
+    hpx::parallel::for_each(
+      hpx::parallel::par, iterator(0), iterator(n),
+      [dv, invdv, resv, beta, xv](local_int_t i)
+      {
+        dv[i] = beta * invdv[i] * resv[i];
+        if (xv) xv[i] += dv[i];
+      });
+  } else {
+    hpx::parallel::for_each(
+      hpx::parallel::par, iterator(0), iterator(n),
+      [dv, invdv, resv, alpha, beta, xv](local_int_t i)
+      {
+        dv[i] = alpha * dv[i] + beta * invdv[i] * resv[i];
+        if (xv) xv[i] += dv[i];
+      });
+  }
+#endif
+
+  return(0);
+}
+
+/*!
+  Prepares the Chebyshev smoother for a given matrix: allocates the work
+  vectors and estimates the largest eigenvalue of D^{-1}A with a few power
+  iterations.
+
+  The upper bound of the smoothing interval is the estimate increased by 10%,
+  the lower bound is a fixed fraction of the upper bound, so that the
+  smoother damps the upper part of the spectrum and leaves the smooth error
+  components to the coarse grid correction. Both bounds are clipped to the
+  Gershgorin interval of D^{-1}A, which narrows the smoothing interval for
+  strongly diagonally dominant matrices.
+
+  @param[in]    A the known system matrix
+  @param[inout] data the smoother data of the matrix, on exit the eigenvalue bounds and work vectors are defined
+
+  @return returns 0 upon success and non-zero otherwise
+
+  @see ComputeChebyshev
+*/
+int SetupChebyshev(const SparseMatrix & A, SmootherData & data) {
+
+  const int numberOfPowerIterations = 10;
+  const double lambdaMaxSafetyFactor = 1.1;
+  const double eigenvalueRatio = 30.0; // lambdaMax/lambdaMin of the smoothing interval
+
+  const local_int_t nrow = A.localNumberOfRows;
+  const local_int_t ncol = A.localNumberOfColumns;
+
+  DeleteSmootherWorkspace(data);
+  data.invDiagonal = new Vector;
+  data.residual = new Vector;
+  data.direction = new Vector;
+  data.Ad = new Vector;
+  InitializeVector(*data.invDiagonal, nrow);
+  InitializeVector(*data.residual, nrow);
+  InitializeVector(*data.direction, ncol);
+  InitializeVector(*data.Ad, nrow);
+
+  double * const invdv = data.invDiagonal->values;
+  double localRadius = 0.0; // Largest Gershgorin radius of D^{-1}A on this processor
+  for (local_int_t i=0; i<nrow; ++i) {
+    const double diagonal = *(A.matrixDiagonal[i]);
+    const double * const currentValues = A.matrixValues[i];
+    double rowSum = 0.0;
+    for (int j=0; j<A.nonzerosInRow[i]; ++j) rowSum += std::fabs(currentValues[j]);
+    invdv[i] = 1.0/diagonal;
+    double radius = (rowSum - std::fabs(diagonal))/std::fabs(diagonal);
+    if (radius>localRadius) localRadius = radius;
+  }
+  double radius = localRadius;
+#ifndef HPCG_NOMPI
+  MPI_Allreduce(&localRadius, &radius, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+#endif
+
+  // Power iterations on D^{-1}A, v is stored in the direction vector since it needs space for halo values
+  Vector & v = *data.direction;
+  Vector & Av = *data.Ad;
+  Vector & w = *data.residual;
+  double t4 = 0.0; // Needed for dot-product call, otherwise unused
+  bool isOptimized = true;
+  double normv = 0.0, lambda = 0.0;
+  int ierr = 0;
+
+  FillRandomVector(v);
+  ierr += ComputeDotProduct(nrow, v, v, normv, t4, isOptimized);
+  normv = std::sqrt(normv);
+  for (int k=0; k<numberOfPowerIterations; ++k) {
+    ierr += ComputeSPMV(A, v, Av);
+    ierr += ComputeChebyshevUpdate(nrow, 0.0, w, 1.0/normv, *data.invDiagonal, Av, 0); // w = D^{-1}*A*v/||v||
+    ierr += ComputeDotProduct(nrow, w, w, lambda, t4, isOptimized);
+    lambda = std::sqrt(lambda);
+    normv = lambda;
+    CopyVector(w, v);
+  }
+  if (ierr!=0 || !(lambda>0.0)) return(-1);
+
+  data.lambdaMax = std::min(lambdaMaxSafetyFactor*lambda, 1.0+radius);
+  data.lambdaMin = std::max(data.lambdaMax/eigenvalueRatio, 1.0-radius);
+  if (!(data.lambdaMin<data.lambdaMax)) data.lambdaMin = data.lambdaMax/eigenvalueRatio; // Degenerate interval, e.g. a diagonal matrix
+
+  return(0);
+}
+
+/*!
+  Applies a Jacobi preconditioned Chebyshev polynomial smoother of degree
+  data.degree to the system Ax = r.
+
+  The smoother only needs sparse matrix-vector products and vector updates,
+  which have no sequential dependencies and are all executed in parallel. The
+  polynomial is a symmetric function of A, so the multigrid preconditioner
+  remains symmetric as long as the same degree is used for the pre- and
+  post-smoothing steps.
+
+  @param[in] A the known system matrix, A.smootherData must have been set up by SetupChebyshev
+  @param[in] r the input vector
+  @param[inout] x On entry, x should contain relevant values, on exit x contains the result of the Chebyshev smoother with r as the RHS.
+
+  @return returns 0 upon success and non-zero otherwise
+
+  @see SetupChebyshev
+  @see ComputeSYMGS
+*/
+int ComputeChebyshev(const SparseMatrix & A, const Vector & r, Vector & x) {
+
+  assert(x.localLength==A.localNumberOfColumns); // Make sure x contain space for halo values
+  assert(A.smootherData!=0 && A.smootherData->direction!=0);
+
+  const SmootherData & data = *A.smootherData;
+  const local_int_t nrow = A.localNumberOfRows;
+  Vector & res = *data.residual;
+  Vector & d = *data.direction;
+  Vector & Ad = *data.Ad;
+  bool isOptimized = true;
+
+  const double theta = 0.5*(data.lambdaMax + data.lambdaMin); // center of the smoothing interval
+  const double delta = 0.5*(data.lambdaMax - data.lambdaMin); // half width of the smoothing interval
+  const double sigma = theta/delta;
+  double rho = 1.0/sigma;
+
+  int ierr = 0;
+  ierr += ComputeSPMV(A, x, Ad);
+  ierr += ComputeWAXPBY(nrow, 1.0, r, -1.0, Ad, res, isOptimized); // res = r - A*x
+  ierr += ComputeChebyshevUpdate(nrow, 0.0, d, 1.0/theta, *data.invDiagonal, res, &x); // d = D^{-1}*res/theta, x += d
+
+  for (int k=1; k<data.degree; ++k) {
+    double rhoNew = 1.0/(2.0*sigma - rho);
+    ierr += ComputeSPMV(A, d, Ad);
+    ierr += ComputeWAXPBY(nrow, 1.0, res, -1.0, Ad, res, isOptimized); // res = res - A*d
+    ierr += ComputeChebyshevUpdate(nrow, rhoNew*rho, d, 2.0*rhoNew/delta, *data.invDiagonal, res, &x);
+    rho = rhoNew;
+  }
+
+  return(ierr);
+}
@@ -0,0 +1,336 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file ComputeCholesky.cpp
+
+ HPCG routine
+ */
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/hpx_fwd.hpp>
+#endif
+
+#ifndef HPCG_NOMPI
+#include <mpi.h>
+#include "ExchangeHalo.hpp"
+#endif
+
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include "ComputeCholesky.hpp"
+
+/*!
+  Computes the banded Cholesky factorization A = L*L^T in place.
+
+  Row i of the band holds the entries L(i,i-bandwidth) to L(i,i), the entries
+  left of the first column are unused.
+
+  @param[in]    n the number of rows
+  @param[in]    bandwidth the number of subdiagonals
+  @param[inout] factor on entry the lower band of A, on exit the lower band of L
+
+  @return returns 0 upon success and non-zero if the matrix is not positive definite
+*/
+static int FactorBand(const local_int_t n, const local_int_t bandwidth, double * const factor) {
+
+  const local_int_t w = bandwidth+1;
+  for (local_int_t i=0; i<n; ++i) {
+    double * const Li = factor + i*w + bandwidth - i; // Li[j] = L(i,j)
+    const local_int_t jmin = (i>bandwidth) ? i-bandwidth : 0;
+    for (local_int_t j=jmin; j<=i; ++j) {
+      const double * const Lj = factor + j*w + bandwidth - j; // Lj[k] = L(j,k)
+      double sum = Li[j];
+      for (local_int_t k=jmin; k<j; ++k) sum -= Li[k]*Lj[k];
+      if (j<i) {
+        Li[j] = sum/Lj[j];
+      } else {
+        if (!(sum>0.0)) return(-1);
+        Li[i] = std::sqrt(sum);
+      }
+    }
+  }
+  return(0);
+}
+
+/*!
+  Solves L*L^T x = b with the banded Cholesky factor, in place.
+
+  @param[in]    n the number of rows
+  @param[in]    bandwidth the number of subdiagonals
+  @param[in]    factor the lower band of L
+  @param[inout] xv on entry the right hand side, on exit the solution
+*/
+static void SolveBand(const local_int_t n, const local_int_t bandwidth, const double * const factor, double * const xv) {
+
+  const local_int_t w = bandwidth+1;
+  // Forward substitution with L, row by row
+  for (local_int_t i=0; i<n; ++i) {
+    const double * const Li = factor + i*w + bandwidth - i;
+    const local_int_t jmin = (i>bandwidth) ? i-bandwidth : 0;
+    double sum = xv[i];
+    for (local_int_t j=jmin; j<i; ++j) sum -= Li[j]*xv[j];
+    xv[i] = sum/Li[i];
+  }
+  // Backward substitution with L^T, column by column so that L is still accessed by rows
+  for (local_int_t i=n-1; i>=0; --i) {
+    const double * const Li = factor + i*w + bandwidth - i;
+    const local_int_t jmin = (i>bandwidth) ? i-bandwidth : 0;
+    const double xi = xv[i]/Li[i];
+    xv[i] = xi;
+    for (local_int_t j=jmin; j<i; ++j) xv[j] -= Li[j]*xi;
+  }
+  return;
+}
+
+/*!
+  Builds and factors the band of a matrix given by its entries.
+
+  @param[in]    n the number of rows
+  @param[in]    rows, cols, values the entries of the matrix, only the lower triangle is used
+  @param[inout] data the smoother data, on exit the factor is defined
+
+  @return returns 0 upon success and non-zero otherwise
+*/
+static int BuildFactor(const local_int_t n, const std::vector<local_int_t> & rows, const std::vector<local_int_t> & cols,
+    const std::vector<double> & values, SmootherData & data) {
+
+  local_int_t bandwidth = 0;
+  for (size_t k=0; k<rows.size(); ++k)
+    if (rows[k]-cols[k]>bandwidth) bandwidth = rows[k]-cols[k];
+
+  const local_int_t w = bandwidth+1;
+  data.factorRows = n;
+  data.factorBandwidth = bandwidth;
+  data.factor = new double[((size_t)n)*w];
+  data.factorWork = new double[n];
+  for (size_t k=0; k<((size_t)n)*w; ++k) data.factor[k] = 0.0;
+  for (size_t k=0; k<rows.size(); ++k)
+    if (cols[k]<=rows[k]) data.factor[rows[k]*w + bandwidth - rows[k] + cols[k]] += values[k];
+
+  return(FactorBand(n, bandwidth, data.factor));
+}
+
+/*!
+  Returns the size of the banded Cholesky factor that SetupCholesky would
+  build for A, without building it: the largest factor of any process, i.e.
+  the factor of rank 0 with agglomeration. The bandwidth is taken from the
+  entries of the matrix, in local row ids without agglomeration and in
+  global row ids with it.
+
+  @param[in] A the coarsest grid matrix
+  @param[in] agglomerate gather the coarse grid problem on rank 0
+
+  @return the size of the factor and its work vector in bytes, the same on all processes
+*/
+double CholeskyFactorBytes(const SparseMatrix & A, bool agglomerate) {
+
+  const local_int_t nrow = A.localNumberOfRows;
+  const bool agglomerated = agglomerate && A.geom->size>1;
+  global_int_t bandwidth = 0;
+  for (local_int_t i=0; i<nrow; ++i) {
+    for (int j=0; j<A.nonzerosInRow[i]; ++j) {
+      global_int_t distance = 0;
+      if (!agglomerated) {
+        if (A.mtxIndL[i][j]<nrow) distance = i-A.mtxIndL[i][j];
+      } else {
+        distance = A.localToGlobalMap[i]-A.mtxIndG[i][j];
+      }
+      if (distance>bandwidth) bandwidth = distance;
+    }
+  }
+  const double rows = agglomerated ? (double)A.totalNumberOfRows : (double)nrow;
+  double bytes = rows*((double)bandwidth+2.0)*sizeof(double); // the band and the work vector
+#ifndef HPCG_NOMPI
+  double maxBytes = 0.0;
+  MPI_Allreduce(&bytes, &maxBytes, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  bytes = maxBytes;
+#endif
+  return(bytes);
+}
+
+/*!
+  Prepares the direct solver for the coarsest grid: computes the banded
+  Cholesky factorization of the matrix once.
+
+  The rows are factored in their natural (lexicographic) order, so the
+  bandwidth of the 27-point stencil is nx*ny+nx+1 and the factorization costs
+  about n*(nx*ny)^2 operations, far less than a dense factorization.
+
+  Without agglomeration each process factors its local part of the matrix
+  and couplings to other processes are treated as in a Jacobi iteration.
+  With agglomeration the matrix of all processes is gathered and factored
+  on rank 0, so the coarse grid problem is solved exactly by a single thread.
+
+  @param[in]    A the coarsest grid matrix
+  @param[inout] data the smoother data of the matrix, on exit the factor is defined
+  @param[in]    agglomerate gather the coarse grid problem on rank 0
+
+  @return returns 0 upon success and non-zero otherwise, the result is the same on all processes
+
+  @see ComputeCholesky
+*/
+int SetupCholesky(const SparseMatrix & A, SmootherData & data, bool agglomerate) {
+
+  const local_int_t nrow = A.localNumberOfRows;
+  DeleteSmootherFactor(data);
+  data.agglomerated = (agglomerate && A.geom->size>1) ? 1 : 0;
+
+  std::vector<local_int_t> rows, cols;
+  std::vector<double> values;
+  int ierr = 0;
+
+  if (!data.agglomerated) {
+    for (local_int_t i=0; i<nrow; ++i) {
+      for (int j=0; j<A.nonzerosInRow[i]; ++j) {
+        local_int_t curCol = A.mtxIndL[i][j];
+        if (curCol<nrow) { // Couplings to other processes are not part of the local factor
+          rows.push_back(i);
+          cols.push_back(curCol);
+          values.push_back(A.matrixValues[i][j]);
+        }
+      }
+    }
+    ierr = BuildFactor(nrow, rows, cols, values, data);
+  }
+#ifndef HPCG_NOMPI
+  else {
+    const int size = A.geom->size;
+    const int rank = A.geom->rank;
+
+    // Number of rows and offsets of all processes
+    int localRows = (int)nrow;
+    data.gatherCounts = new int[size];
+    data.gatherOffsets = new int[size+1];
+    MPI_Allgather(&localRows, 1, MPI_INT, data.gatherCounts, 1, MPI_INT, MPI_COMM_WORLD);
+    data.gatherOffsets[0] = 0;
+    for (int p=0; p<size; ++p) data.gatherOffsets[p+1] = data.gatherOffsets[p] + data.gatherCounts[p];
+    const int totalRows = data.gatherOffsets[size];
+
+    // The global row ids are the rows of the factor
+    std::vector<long long> localIds(nrow), localEntries;
+    std::vector<double> localValues;
+    for (local_int_t i=0; i<nrow; ++i) {
+      localIds[i] = A.localToGlobalMap[i];
+      for (int j=0; j<A.nonzerosInRow[i]; ++j) {
+        localEntries.push_back(A.localToGlobalMap[i]);
+        localEntries.push_back(A.mtxIndG[i][j]);
+        localValues.push_back(A.matrixValues[i][j]);
+      }
+    }
+    std::vector<long long> ids(rank==0 ? totalRows : 1);
+    MPI_Gatherv(&localIds[0], localRows, MPI_LONG_LONG_INT, &ids[0], data.gatherCounts, data.gatherOffsets,
+        MPI_LONG_LONG_INT, 0, MPI_COMM_WORLD);
+
+    int localNonzeros = (int)localValues.size();
+    std::vector<int> nonzeroCounts(size), nonzeroOffsets(size+1), entryCounts(size), entryOffsets(size+1);
+    MPI_Gather(&localNonzeros, 1, MPI_INT, &nonzeroCounts[0], 1, MPI_INT, 0, MPI_COMM_WORLD);
+    nonzeroOffsets[0] = entryOffsets[0] = 0;
+    for (int p=0; p<size; ++p) {
+      nonzeroOffsets[p+1] = nonzeroOffsets[p] + nonzeroCounts[p];
+      entryCounts[p] = 2*nonzeroCounts[p];
+      entryOffsets[p+1] = entryOffsets[p] + entryCounts[p];
+    }
+    std::vector<long long> entries(rank==0 ? entryOffsets[size] : 1);
+    std::vector<double> gatheredValues(rank==0 ? nonzeroOffsets[size] : 1);
+    MPI_Gatherv(&localEntries[0], 2*localNonzeros, MPI_LONG_LONG_INT, &entries[0], &entryCounts[0], &entryOffsets[0],
+        MPI_LONG_LONG_INT, 0, MPI_COMM_WORLD);
+    MPI_Gatherv(&localValues[0], localNonzeros, MPI_DOUBLE, &gatheredValues[0], &nonzeroCounts[0], &nonzeroOffsets[0],
+        MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+    if (rank==0) {
+      data.gatherRows = new local_int_t[totalRows];
+      data.gatherBuffer = new double[totalRows];
+      for (int p=0; p<totalRows; ++p) data.gatherRows[p] = (local_int_t)ids[p];
+      for (size_t k=0; k<gatheredValues.size(); ++k) {
+        rows.push_back((local_int_t)entries[2*k]);
+        cols.push_back((local_int_t)entries[2*k+1]);
+        values.push_back(gatheredValues[k]);
+      }
+      ierr = BuildFactor(totalRows, rows, cols, values, data);
+    }
+  }
+
+  int globalErr = 0;
+  MPI_Allreduce(&ierr, &globalErr, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+  ierr = globalErr;
+#endif
+
+  if (ierr!=0) DeleteSmootherFactor(data);
+  return(ierr);
+}
+
+/*!
+  Solves Ax = r on the coarsest grid with the Cholesky factor computed by
+  SetupCholesky.
+
+  With agglomeration the right hand side of all processes is gathered on
+  rank 0, solved there and the solution is scattered back. Otherwise each
+  process solves for its local part with the current values of x on other
+  processes moved to the right hand side.
+
+  @param[in] A the coarsest grid matrix, A.smootherData must have been set up by SetupCholesky
+  @param[in] r the input vector
+  @param[inout] x On entry, x should contain relevant values, on exit x contains the result of the direct solve with r as the RHS.
+
+  @return returns 0 upon success and non-zero otherwise
+
+  @see SetupCholesky
+*/
+int ComputeCholesky(const SparseMatrix & A, const Vector & r, Vector & x) {
+
+  assert(x.localLength==A.localNumberOfColumns); // Make sure x contain space for halo values
+  assert(A.smootherData!=0);
+
+  const SmootherData & data = *A.smootherData;
+  const local_int_t nrow = A.localNumberOfRows;
+  const double * const rv = r.values;
+  double * const xv = x.values;
+
+  if (!data.agglomerated) {
+    assert(data.factor!=0);
+    double * const work = data.factorWork;
+    for (local_int_t i=0; i<nrow; ++i) work[i] = rv[i];
+#ifndef HPCG_NOMPI
+    if (A.localNumberOfColumns>nrow) {
+      ExchangeHalo(A,x);
+      for (local_int_t i=0; i<nrow; ++i)
+        for (int j=0; j<A.nonzerosInRow[i]; ++j) {
+          local_int_t curCol = A.mtxIndL[i][j];
+          if (curCol>=nrow) work[i] -= A.matrixValues[i][j]*xv[curCol];
+        }
+    }
+#endif
+    SolveBand(data.factorRows, data.factorBandwidth, data.factor, work);
+    for (local_int_t i=0; i<nrow; ++i) xv[i] = work[i];
+  }
+#ifndef HPCG_NOMPI
+  else {
+    MPI_Gatherv(const_cast<double *>(rv), (int)nrow, MPI_DOUBLE, data.gatherBuffer, data.gatherCounts, data.gatherOffsets,
+        MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    if (A.geom->rank==0) {
+      const local_int_t n = data.factorRows;
+      for (local_int_t p=0; p<n; ++p) data.factorWork[data.gatherRows[p]] = data.gatherBuffer[p];
+      SolveBand(n, data.factorBandwidth, data.factor, data.factorWork);
+      for (local_int_t p=0; p<n; ++p) data.gatherBuffer[p] = data.factorWork[data.gatherRows[p]];
+    }
+    MPI_Scatterv(data.gatherBuffer, data.gatherCounts, data.gatherOffsets, MPI_DOUBLE, xv, (int)nrow,
+        MPI_DOUBLE, 0, MPI_COMM_WORLD);
+  }
+#endif
+
+  return(0);
+}
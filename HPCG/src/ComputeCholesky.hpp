@@ -0,0 +1,33 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+#ifndef COMPUTECHOLESKY_HPP
+#define COMPUTECHOLESKY_HPP
+
+#include "SparseMatrix.hpp"
+#include "Vector.hpp"
+
+/*!
+  Largest Cholesky factor of the coarsest grid on any process (bytes). A
+  larger factor is not built and the coarsest level keeps its smoother.
+*/
+#ifndef HPCG_CHOLESKY_MAX_FACTOR_BYTES
+#define HPCG_CHOLESKY_MAX_FACTOR_BYTES (1024.0*1024.0*1024.0)
+#endif
+
+double CholeskyFactorBytes(const SparseMatrix & A, bool agglomerate);
+int SetupCholesky(const SparseMatrix & A, SmootherData & data, bool agglomerate);
+int ComputeCholesky(const SparseMatrix & A, const Vector & r, Vector & x);
+
+#endif // COMPUTECHOLESKY_HPP
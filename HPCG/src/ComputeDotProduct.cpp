@@ -25,35 +25,17 @@
 
 #include "ComputeDotProduct.hpp"
 #include "ComputeDotProduct_ref.hpp"
+#include "Backend.hpp"
+#include "KernelCounters.hpp"
 
-/*!
-  Routine to compute the dot product of two vectors.
-
-  This routine calls the reference dot-product implementation by default, but
-  can be replaced by a custom routine that is optimized and better suited for
-  the target system.
-
-  @param[in]  n the number of vector elements (on this processor)
-  @param[in]  x, y the input vectors
-  @param[out] result a pointer to scalar value, on exit will contain the result.
-  @param[out] time_allreduce the time it took to perform the communication between processes
-  @param[out] isOptimized should be set to false if this routine uses the reference implementation (is not optimized); otherwise leave it unchanged
-
-  @return returns 0 upon success and non-zero otherwise
-
-  @see ComputeDotProduct_ref
-*/
-#if defined(HPCG_NOHPX)
-
-int ComputeDotProduct(const local_int_t n, const Vector & x, const Vector & y,
-    double & result, double & time_allreduce, bool & isOptimized) {
+#ifndef HPCG_NOMPI
+#include <mpi.h>
+#include "mytimer.hpp"
+#endif
 
-  // This line and the next two lines should be removed and your version of ComputeDotProduct should be used.
-  isOptimized = false;
-  return(ComputeDotProduct_ref(n, x, y, result, time_allreduce));
-}
+#include <cassert>
 
-#else
+#if !defined(HPCG_NOHPX)
 
 #include <hpx/include/lcos.hpp>
 #include <hpx/include/parallel_transform_reduce.hpp>
@@ -70,6 +52,16 @@ hpx::future<double> ComputeDotProduct_async(
   double * xv = x.values;
   double * yv = y.values;
 
+  if (HPCG_dotReduction!=REDUCTION_FAST) { // The blocks are summed in parallel, the tree is reduced by the calling thread
+    const bool compensated = HPCG_dotReduction==REDUCTION_COMPENSATED;
+    double sum = 0.0, correction = 0.0;
+    if (yv == xv)
+      sum = BackendBlockedSum(BACKEND_HPX, n, [xv](local_int_t i) { return xv[i]*xv[i]; }, compensated, correction);
+    else
+      sum = BackendBlockedSum(BACKEND_HPX, n, [xv, yv](local_int_t i) { return xv[i]*yv[i]; }, compensated, correction);
+    return hpx::make_ready_future(sum+correction);
+  }
+
   typedef boost::counting_iterator<local_int_t> iterator;
 
   if (yv == xv) {
@@ -93,12 +85,88 @@ hpx::future<double> ComputeDotProduct_async(
       });
 }
 
-int ComputeDotProduct(const local_int_t n, const Vector & x, const Vector & y,
+#endif
+
+/*!
+  Computes the dot product with the backend selected by HPCG_backends.dot.
+
+  @see ComputeDotProduct
+*/
+static int ComputeDotProduct_backend(const local_int_t n, const Vector & x, const Vector & y,
     double & result, double & time_allreduce, bool & isOptimized) {
 
+  const int backend = HPCG_backends.dot;
+  if (backend==BACKEND_REF) {
+    isOptimized = false;
+    return(ComputeDotProduct_ref(n, x, y, result, time_allreduce));
+  }
   isOptimized = true;
-  result = ComputeDotProduct_async(n, x, y, time_allreduce).get();
-  return 0;
-}
+#if !defined(HPCG_NOHPX)
+  if (backend==BACKEND_HPX) {
+    result = ComputeDotProduct_async(n, x, y, time_allreduce).get();
+    return 0;
+  }
+#endif
+
+  assert(x.localLength>=n); // Test vector lengths
+  assert(y.localLength>=n);
+
+  const double * const xv = x.values;
+  const double * const yv = y.values;
+  double local_result[2] = {0.0, 0.0}; // the sum and the correction of the compensated summation
+  const bool compensated = HPCG_dotReduction==REDUCTION_COMPENSATED;
+  if (HPCG_dotReduction==REDUCTION_FAST) {
+    if (yv==xv)
+      local_result[0] = BackendParallelSum(backend, n, [xv](local_int_t i) { return xv[i]*xv[i]; });
+    else
+      local_result[0] = BackendParallelSum(backend, n, [xv, yv](local_int_t i) { return xv[i]*yv[i]; });
+  } else {
+    if (yv==xv)
+      local_result[0] = BackendBlockedSum(backend, n, [xv](local_int_t i) { return xv[i]*xv[i]; }, compensated, local_result[1]);
+    else
+      local_result[0] = BackendBlockedSum(backend, n, [xv, yv](local_int_t i) { return xv[i]*yv[i]; }, compensated, local_result[1]);
+  }
 
+#ifndef HPCG_NOMPI
+  // Use MPI's reduce function to collect all partial sums, and the corrections of the compensated summation
+  double t0 = mytimer();
+  double global_result[2] = {0.0, 0.0};
+  MPI_Allreduce(local_result, global_result, compensated ? 2 : 1, MPI_DOUBLE, MPI_SUM,
+      MPI_COMM_WORLD);
+  result = global_result[0] + global_result[1];
+  time_allreduce += mytimer() - t0;
+#else
+  result = local_result[0] + local_result[1];
 #endif
+
+  return(0);
+}
+
+/*!
+  Routine to compute the dot product of two vectors.
+
+  The implementation is selected at run time by HPCG_backends.dot: the
+  reference dot product or a parallel reduction with one of the parallel
+  backends. HPCG_dotReduction selects the summation order of the parallel
+  reduction: the order of the backend, or fixed-size blocks added in a fixed
+  tree order, optionally with compensated summation, whose result does not
+  depend on the backend or the number of threads.
+
+  @param[in]  n the number of vector elements (on this processor)
+  @param[in]  x, y the input vectors
+  @param[out] result a pointer to scalar value, on exit will contain the result.
+  @param[out] time_allreduce the time it took to perform the communication between processes
+  @param[out] isOptimized should be set to false if this routine uses the reference implementation (is not optimized); otherwise leave it unchanged
+
+  @return returns 0 upon success and non-zero otherwise
+
+  @see ComputeDotProduct_ref
+*/
+int ComputeDotProduct(const local_int_t n, const Vector & x, const Vector & y,
+    double & result, double & time_allreduce, bool & isOptimized) {
+
+  const KernelCall call = StartKernelCounter(KERNEL_DOT, 0);
+  int ierr = ComputeDotProduct_backend(n, x, y, result, time_allreduce, isOptimized);
+  StopKernelCounter(KERNEL_DOT, 0, n, call);
+  return(ierr);
+}
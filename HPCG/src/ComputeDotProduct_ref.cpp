@@ -27,6 +27,7 @@
 #endif
 #include <cassert>
 #include "ComputeDotProduct_ref.hpp"
+#include "Backend.hpp"
 
 /*!
   Routine to compute the dot product of two vectors where:
@@ -34,6 +35,11 @@
   This is the reference dot-product implementation.  It _CANNOT_ be modified for the
   purposes of this benchmark.
 
+  The reference CG uses it to compute the tolerance of the optimized CG, so it
+  follows the summation order selected by HPCG_dotReduction: the OpenMP
+  reduction for REDUCTION_FAST, otherwise the fixed blocks and tree of
+  BackendBlockedSum, whose result does not depend on the number of threads.
+
   @param[in] n the number of vector elements (on this processor)
   @param[in] x, y the input vectors
   @param[in] result a pointer to scalar value, on exit will contain result.
@@ -49,9 +55,17 @@ int ComputeDotProduct_ref(const local_int_t n, const Vector & x, const Vector &
   assert(y.localLength>=n);
 
   double local_result = 0.0;
+  double correction = 0.0; // rounding errors of the compensated summation
   double * xv = x.values;
   double * yv = y.values;
-  if (yv==xv) {
+  if (HPCG_dotReduction!=REDUCTION_FAST) {
+    const int backend = HPCG_REFERENCE_BACKEND;
+    const bool compensated = HPCG_dotReduction==REDUCTION_COMPENSATED;
+    if (yv==xv)
+      local_result = BackendBlockedSum(backend, n, [xv](local_int_t i) { return xv[i]*xv[i]; }, compensated, correction);
+    else
+      local_result = BackendBlockedSum(backend, n, [xv, yv](local_int_t i) { return xv[i]*yv[i]; }, compensated, correction);
+  } else if (yv==xv) {
 #ifndef HPCG_NOOPENMP
     #pragma omp parallel for reduction (+:local_result)
 #endif
@@ -65,14 +79,16 @@ int ComputeDotProduct_ref(const local_int_t n, const Vector & x, const Vector &
 
 #ifndef HPCG_NOMPI
   // Use MPI's reduce function to collect all partial sums
+  // The corrections of the compensated summation are reduced separately, as in ComputeDotProduct
   double t0 = mytimer();
-  double global_result = 0.0;
-  MPI_Allreduce(&local_result, &global_result, 1, MPI_DOUBLE, MPI_SUM,
+  double local_results[2] = {local_result, correction};
+  double global_result[2] = {0.0, 0.0};
+  MPI_Allreduce(local_results, global_result, (HPCG_dotReduction==REDUCTION_COMPENSATED) ? 2 : 1, MPI_DOUBLE, MPI_SUM,
       MPI_COMM_WORLD);
-  result = global_result;
+  result = global_result[0] + global_result[1];
   time_allreduce += mytimer() - t0;
 #else
-  result = local_result;
+  result = local_result + correction;
 #endif
 
   return(0);
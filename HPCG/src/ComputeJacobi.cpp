@@ -0,0 +1,116 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file ComputeJacobi.cpp
+
+ HPCG routine
+ */
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/hpx_fwd.hpp>
+#endif
+
+#ifndef HPCG_NOMPI
+#include "ExchangeHalo.hpp"
+#endif
+
+#include <cassert>
+
+#include "ComputeJacobi.hpp"
+#include "Backend.hpp"
+
+/*!
+  Prepares the Jacobi smoother for a given matrix: stores the inverse of the
+  matrix diagonal and allocates the vector of the updated values.
+
+  The Jacobi smoother only uses the matrix rows, not the grid geometry, so it
+  is also the preconditioner of matrices read from a file.
+
+  @param[in]    A the known system matrix
+  @param[inout] data the smoother data of the matrix, on exit the inverse diagonal is defined
+
+  @return returns 0 upon success and non-zero otherwise (a zero diagonal entry)
+
+  @see ComputeJacobi
+*/
+int SetupJacobi(const SparseMatrix & A, SmootherData & data) {
+
+  const local_int_t nrow = A.localNumberOfRows;
+
+  DeleteSmootherWorkspace(data);
+  data.invDiagonal = new Vector;
+  data.residual = new Vector;
+  InitializeVector(*data.invDiagonal, nrow);
+  InitializeVector(*data.residual, nrow);
+
+  double * const invdv = data.invDiagonal->values;
+  for (local_int_t i=0; i<nrow; ++i) {
+    const double diagonal = *(A.matrixDiagonal[i]);
+    if (diagonal==0.0) return(-1);
+    invdv[i] = 1.0/diagonal;
+  }
+
+  return(0);
+}
+
+/*!
+  Computes one step of the Jacobi iteration:
+
+    x = x + D^{-1}(r - A*x)
+
+  All rows are updated from the values of x on entry, so the rows are
+  independent and are computed in parallel with the backend of the
+  multigrid kernels. With a zero initial guess the step is x = D^{-1}r, a
+  symmetric preconditioner.
+
+  @param[in] A the known system matrix, A.smootherData must have been set up by SetupJacobi
+  @param[in] r the input vector
+  @param[inout] x On entry, x should contain relevant values, on exit x contains the result of one Jacobi step with r as the RHS.
+
+  @return returns 0 upon success and non-zero otherwise
+
+  @see SetupJacobi
+*/
+int ComputeJacobi(const SparseMatrix & A, const Vector & r, Vector & x) {
+
+  assert(x.localLength==A.localNumberOfColumns); // Make sure x contain space for halo values
+  assert(A.smootherData!=0 && A.smootherData->invDiagonal!=0);
+
+#ifndef HPCG_NOMPI
+  ExchangeHalo(A,x);
+#endif
+
+  const SmootherData & data = *A.smootherData;
+  const double * const rv = r.values;
+  const double * const invdv = data.invDiagonal->values;
+  double * const xv = x.values;
+  double * const uv = data.residual->values;
+
+  BackendParallelFor(HPCG_backends.mg, A.localNumberOfRows, [&A, rv, invdv, xv, uv](local_int_t i) {
+    const double * const currentValues = A.matrixValues[i];
+    const local_int_t * const currentColIndices = A.mtxIndL[i];
+    const int currentNumberOfNonzeros = A.nonzerosInRow[i];
+    double sum = rv[i]; // RHS value
+
+    for (int j=0; j<currentNumberOfNonzeros; ++j)
+      sum -= currentValues[j]*xv[currentColIndices[j]];
+
+    uv[i] = xv[i] + invdv[i]*sum;
+  });
+  BackendParallelFor(HPCG_backends.mg, A.localNumberOfRows, [xv, uv](local_int_t i) { xv[i] = uv[i]; });
+
+  return(0);
+}
@@ -0,0 +1,24 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+#ifndef COMPUTEJACOBI_HPP
+#define COMPUTEJACOBI_HPP
+
+#include "SparseMatrix.hpp"
+#include "Vector.hpp"
+
+int SetupJacobi(const SparseMatrix & A, SmootherData & data);
+int ComputeJacobi(const SparseMatrix & A, const Vector & r, Vector & x);
+
+#endif // COMPUTEJACOBI_HPP
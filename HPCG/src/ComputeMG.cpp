@@ -24,75 +24,119 @@
 
 #include "ComputeMG.hpp"
 #include "ComputeMG_ref.hpp"
+#include "Backend.hpp"
+
+#include <cassert>
+
+#include "ComputeSYMGS.hpp"
+#include "ComputeSPMV.hpp"
+#include "ComputeRestriction.hpp"
+#include "ComputeProlongation.hpp"
+#include "KernelCounters.hpp"
 
 /*!
+  Applies one multigrid cycle of the given type to Ax = r, recursively.
+
+  The coarse grid correction is a V-cycle for the V-cycle, two cycles of the
+  same type for the W-cycle, and an F-cycle followed by a V-cycle for the
+  F-cycle. All but the first coarse cycle continue from the current coarse
+  grid approximation.
+
   @param[in] A the known system matrix
   @param[in] r the input vector
-  @param[inout] x On exit contains the result of the multigrid V-cycle with r as the RHS, x is the approximation to Ax = r.
+  @param[inout] x On exit contains the result of the multigrid cycle with r as the RHS
+  @param[in] cycleType the multigrid cycle, one of MGCycle
+  @param[in] zeroInitialGuess if true x is initialized to zero, otherwise x is the initial approximation
 
   @return returns 0 upon success and non-zero otherwise
-
-  @see ComputeMG_ref
 */
-#if defined(HPCG_NOHPX)
+static int ComputeMGCycle(const SparseMatrix  & A, const Vector & r, Vector & x, int cycleType, bool zeroInitialGuess) {
 
-int ComputeMG(const SparseMatrix  & A, const Vector & r, Vector & x) {
+  assert(x.localLength==A.localNumberOfColumns); // Make sure x contain space for halo values
 
-  // This line and the next two lines should be removed and your version of ComputeSYMGS should be used.
-  A.isMgOptimized = false;
-  return(ComputeMG_ref(A, r, x));
+  if (zeroInitialGuess) ZeroVector(x); // initialize x to zero
 
+  int ierr = 0;
+  if (A.mgData!=0) { // Go to next coarse level if defined
+    int numberOfPresmootherSteps = A.mgData->numberOfPresmootherSteps;
+    for (int i=0; i< numberOfPresmootherSteps; ++i) ierr += ComputeSYMGS(A, r, x);
+    if (ierr!=0) return(ierr);
+    ierr = ComputeSPMV(A, x, *A.mgData->Axf); if (ierr!=0) return(ierr);
+    // Perform restriction operation using simple injection
+    ierr = ComputeRestriction(A, r);  if (ierr!=0) return(ierr);
+    // The cycles on the coarse levels are counted by their level. The counter is stopped before an error is
+    // returned, so that the trace regions stay balanced
+    KernelCall call = StartKernelCounter(KERNEL_MG, A.Ac);
+    ierr = ComputeMGCycle(*A.Ac, *A.mgData->rc, *A.mgData->xc, cycleType, true);
+    StopKernelCounter(KERNEL_MG, A.Ac, 0, call);
+    if (ierr!=0) return(ierr);
+    if (cycleType!=MG_CYCLE_V) {
+      int secondCycleType = (cycleType==MG_CYCLE_W) ? MG_CYCLE_W : MG_CYCLE_V;
+      call = StartKernelCounter(KERNEL_MG, A.Ac);
+      ierr = ComputeMGCycle(*A.Ac, *A.mgData->rc, *A.mgData->xc, secondCycleType, false);
+      StopKernelCounter(KERNEL_MG, A.Ac, 0, call);
+      if (ierr!=0) return(ierr);
+    }
+    ierr = ComputeProlongation(A, x);  if (ierr!=0) return(ierr);
+    int numberOfPostsmootherSteps = A.mgData->numberOfPostsmootherSteps;
+    for (int i=0; i< numberOfPostsmootherSteps; ++i) ierr += ComputeSYMGS(A, r, x);
+    if (ierr!=0) return(ierr);
+  }
+  else {
+    ierr = ComputeSYMGS(A, r, x);
+    if (ierr!=0) return(ierr);
+  }
+  return(0);
 }
 
-#else
+#if !defined(HPCG_NOHPX)
 
 #include <hpx/include/lcos.hpp>
 
-#include "ComputeSYMGS.hpp"
-#include "ComputeSPMV.hpp"
-#include "ComputeRestriction.hpp"
-#include "ComputeProlongation.hpp"
-
 hpx::future<int> ComputeMG_async(const SparseMatrix  & A, const Vector & r, Vector & x) {
 
-  ZeroVector(x); // initialize x to zero
+  int cycleType = (A.mgData!=0) ? A.mgData->cycleType : MG_CYCLE_V;
+  return hpx::make_ready_future(ComputeMGCycle(A, r, x, cycleType, true));
+}
 
-  int ierr = 0;
-  if (A.mgData!=0) { // Go to next coarse level if defined
-    int numberOfPresmootherSteps = A.mgData->numberOfPresmootherSteps;
-    for (int i=0; i< numberOfPresmootherSteps; ++i)
-      ierr += ComputeSYMGS(A, r, x);
-    if (ierr!=0) hpx::make_ready_future(ierr);
+#endif
 
-    ierr = ComputeSPMV(A, x, *A.mgData->Axf);
-    if (ierr!=0) hpx::make_ready_future(ierr);
+/*!
+  Applies one multigrid cycle with the backend selected by HPCG_backends.mg.
 
-    // Perform restriction operation using simple injection
-    ierr = ComputeRestriction(A, r);
-    if (ierr!=0) hpx::make_ready_future(ierr);
+  @see ComputeMG
+*/
+static int ComputeMG_backend(const SparseMatrix  & A, const Vector & r, Vector & x) {
 
-    ierr = ComputeMG(*A.Ac,*A.mgData->rc, *A.mgData->xc);
-    if (ierr!=0) hpx::make_ready_future(ierr);
+  const int backend = HPCG_backends.mg;
+  A.isMgOptimized = backend!=BACKEND_REF;
+  int cycleType = (A.mgData!=0) ? A.mgData->cycleType : MG_CYCLE_V;
+  if (backend==BACKEND_REF && A.smootherData==0 && cycleType==MG_CYCLE_V) return(ComputeMG_ref(A, r, x));
+#if !defined(HPCG_NOHPX)
+  if (backend==BACKEND_HPX) return ComputeMG_async(A, r, x).get();
+#endif
 
-    ierr = ComputeProlongation(A, x);
-    if (ierr!=0) hpx::make_ready_future(ierr);
+  return(ComputeMGCycle(A, r, x, cycleType, true));
+}
 
-    int numberOfPostsmootherSteps = A.mgData->numberOfPostsmootherSteps;
-    for (int i=0; i< numberOfPostsmootherSteps; ++i)
-      ierr += ComputeSYMGS(A, r, x);
-  }
-  else {
-    ierr = ComputeSYMGS(A, r, x);
-  }
+/*!
+  The restriction and prolongation use the backend selected at run time by
+  HPCG_backends.mg, the smoother and the matrix-vector products use their own
+  backends. The reference backend with the reference smoother and a V-cycle
+  calls ComputeMG_ref.
 
-  return hpx::make_ready_future(ierr);
-}
+  @param[in] A the known system matrix
+  @param[in] r the input vector
+  @param[inout] x On exit contains the result of the multigrid cycle selected in A.mgData with r as the RHS, x is the approximation to Ax = r.
 
-int ComputeMG(const SparseMatrix  & A, const Vector & r, Vector & x) {
+  @return returns 0 upon success and non-zero otherwise
 
-  A.isMgOptimized = true;
-  return ComputeMG_async(A, r, x).get();
+  @see ComputeMG_ref
+*/
+int ComputeMG(const SparseMatrix  & A, const Vector & r, Vector & x) {
 
+  const KernelCall call = StartKernelCounter(KERNEL_MG, &A);
+  int ierr = ComputeMG_backend(A, r, x);
+  StopKernelCounter(KERNEL_MG, &A, 0, call);
+  return(ierr);
 }
-
-#endif
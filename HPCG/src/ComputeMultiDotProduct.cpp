@@ -0,0 +1,119 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file ComputeMultiDotProduct.cpp
+
+ HPCG routine
+ */
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/hpx_fwd.hpp>
+#endif
+
+#ifndef HPCG_NOMPI
+#include <mpi.h>
+#include "mytimer.hpp"
+#endif
+
+#include <vector>
+
+#include "ComputeMultiDotProduct.hpp"
+
+/*!
+  Adds the products of the rows [first, last) of the blocks x and y to the
+  k partial results.
+
+  @param[in]    xv, yv the interleaved values of the blocks
+  @param[in]    k the number of vectors of the blocks
+  @param[in]    first, last the range of rows
+  @param[inout] result the k partial results
+*/
+static void ComputeMultiDotProductRange(const double * const xv, const double * const yv, const int k,
+    const local_int_t first, const local_int_t last, double * result) {
+  double sum[HPCG_MAX_RHS];
+  for (int l=0; l<k; l++) sum[l] = 0.0;
+  for (local_int_t i=first; i<last; i++)
+    for (int l=0; l<k; l++) sum[l] += xv[i*k+l]*yv[i*k+l];
+  for (int l=0; l<k; l++) result[l] += sum[l];
+}
+
+/*!
+  Routine to compute the dot products of corresponding vectors of two blocks,
+  result[j] is the dot product of vector j of x and vector j of y. All k
+  results are reduced across processes in a single message.
+
+  @param[in]  n the number of vector elements (on this processor)
+  @param[in]  x, y the input blocks
+  @param[out] result an array of x.numberOfVectors values, on exit will contain the results.
+  @param[out] time_allreduce the time it took to perform the communication between processes
+
+  @return returns 0 upon success and non-zero otherwise
+
+  @see ComputeDotProduct
+*/
+int ComputeMultiDotProduct(const local_int_t n, const MultiVector & x, const MultiVector & y,
+    double * result, double & time_allreduce) {
+
+  assert(x.localLength>=n); // Test vector lengths
+  assert(y.localLength>=n);
+  assert(x.numberOfVectors==y.numberOfVectors);
+
+  const double * const xv = x.values;
+  const double * const yv = y.values;
+  const int k = x.numberOfVectors;
+  double local_result[HPCG_MAX_RHS];
+  for (int l=0; l<k; l++) local_result[l] = 0.0;
+
+  // Each chunk of rows accumulates its own k partial results, which are summed in a fixed order
+#if defined(HPCG_NOHPX)
+#ifdef HPCG_NOOPENMP
+  ComputeMultiDotProductRange(xv, yv, k, 0, n, local_result);
+#else
+  const int numberOfChunks = omp_get_max_threads();
+  std::vector<double> partial(numberOfChunks*HPCG_MAX_RHS, 0.0);
+  #pragma omp parallel for
+  for (int c=0; c<numberOfChunks; c++)
+    ComputeMultiDotProductRange(xv, yv, k, (local_int_t)(((long long)n*c)/numberOfChunks),
+        (local_int_t)(((long long)n*(c+1))/numberOfChunks), &partial[c*HPCG_MAX_RHS]);
+  for (int c=0; c<numberOfChunks; c++)
+    for (int l=0; l<k; l++) local_result[l] += partial[c*HPCG_MAX_RHS+l];
+#endif
+#else
+  typedef boost::counting_iterator<int> iterator;
+
+  const int numberOfChunks = (int)hpx::get_num_worker_threads();
+  std::vector<double> partial(numberOfChunks*HPCG_MAX_RHS, 0.0);
+  double * const partialv = &partial[0];
+  hpx::parallel::for_each(hpx::parallel::par, iterator(0), iterator(numberOfChunks),
+    [xv, yv, k, n, numberOfChunks, partialv](int c) {
+      ComputeMultiDotProductRange(xv, yv, k, (local_int_t)(((long long)n*c)/numberOfChunks),
+          (local_int_t)(((long long)n*(c+1))/numberOfChunks), partialv+c*HPCG_MAX_RHS);
+    });
+  for (int c=0; c<numberOfChunks; c++)
+    for (int l=0; l<k; l++) local_result[l] += partial[c*HPCG_MAX_RHS+l];
+#endif
+
+#ifndef HPCG_NOMPI
+  // Use MPI's reduce function to collect all partial sums
+  double t0 = mytimer();
+  MPI_Allreduce(local_result, result, k, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  time_allreduce += mytimer() - t0;
+#else
+  for (int l=0; l<k; l++) result[l] = local_result[l];
+#endif
+
+  return(0);
+}
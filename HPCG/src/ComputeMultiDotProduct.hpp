@@ -0,0 +1,22 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+#ifndef COMPUTEMULTIDOTPRODUCT_HPP
+#define COMPUTEMULTIDOTPRODUCT_HPP
+
+#include "MultiVector.hpp"
+int ComputeMultiDotProduct(const local_int_t n, const MultiVector & x, const MultiVector & y,
+    double * result, double & time_allreduce);
+#endif // COMPUTEMULTIDOTPRODUCT_HPP
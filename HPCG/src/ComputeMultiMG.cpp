@@ -0,0 +1,147 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file ComputeMultiMG.cpp
+
+ HPCG routine
+ */
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/hpx_fwd.hpp>
+#endif
+
+#include "ComputeMultiMG.hpp"
+
+#include <cassert>
+
+#include "ComputeMultiSYMGS.hpp"
+#include "ComputeSPMM.hpp"
+
+/*!
+  Computes the coarse grid residuals of all vectors of a block using simple
+  injection: rc = rf - Axf at the coarse grid points.
+
+  @param[in]    A the known system matrix
+  @param[in]    rf the block of fine grid right-hand sides
+  @param[in]    Axf the block of fine grid products of A with the current approximations
+  @param[out]   rc the block of coarse grid residuals
+*/
+static void ComputeMultiRestriction(const SparseMatrix & A, const MultiVector & rf, const MultiVector & Axf, MultiVector & rc) {
+
+  const double * const Axfv = Axf.values;
+  const double * const rfv = rf.values;
+  double * const rcv = rc.values;
+  const local_int_t * const f2c = A.mgData->f2cOperator;
+  const local_int_t nc = rc.localLength;
+  const int k = rc.numberOfVectors;
+
+#ifndef HPCG_NOOPENMP
+#pragma omp parallel for
+#endif
+  for (local_int_t i=0; i<nc; ++i)
+    for (int l=0; l<k; l++) rcv[i*k+l] = rfv[f2c[i]*k+l] - Axfv[f2c[i]*k+l];
+}
+
+/*!
+  Adds the coarse grid corrections of all vectors of a block to the fine
+  grid approximations at the coarse grid points.
+
+  @param[in]    A the known system matrix
+  @param[in]    xc the block of coarse grid corrections
+  @param[inout] xf the block of fine grid approximations
+*/
+static void ComputeMultiProlongation(const SparseMatrix & A, const MultiVector & xc, MultiVector & xf) {
+
+  double * const xfv = xf.values;
+  const double * const xcv = xc.values;
+  const local_int_t * const f2c = A.mgData->f2cOperator;
+  const local_int_t nc = A.Ac->localNumberOfRows;
+  const int k = xf.numberOfVectors;
+
+#ifndef HPCG_NOOPENMP
+#pragma omp parallel for
+#endif
+  for (local_int_t i=0; i<nc; ++i)
+    for (int l=0; l<k; l++) xfv[f2c[i]*k+l] += xcv[i*k+l]; // Safe since f2c has no repeated indices
+}
+
+/*!
+  Applies one multigrid cycle of the type selected in A.mgData to all vectors
+  of a block, recursively. The smoother is symmetric Gauss-Seidel on all
+  levels.
+
+  @param[in] A the known system matrix of the current level
+  @param[inout] data the blocks of all levels
+  @param[in] level the index of the current level, 0 is the finest
+  @param[in] r the input block
+  @param[inout] x On exit contains the result of the multigrid cycle with r as the RHS
+  @param[in] cycleType the multigrid cycle, one of MGCycle
+  @param[in] zeroInitialGuess if true x is initialized to zero, otherwise x is the initial approximation
+
+  @return returns 0 upon success and non-zero otherwise
+*/
+static int ComputeMultiMGCycle(const SparseMatrix & A, MultiCGData & data, int level, const MultiVector & r, MultiVector & x,
+    int cycleType, bool zeroInitialGuess) {
+
+  assert(x.localLength==A.localNumberOfColumns); // Make sure x contain space for halo values
+
+  if (zeroInitialGuess) ZeroMultiVector(x); // initialize x to zero
+
+  int ierr = 0;
+  if (A.mgData!=0) { // Go to next coarse level if defined
+    assert(level<data.numberOfLevels);
+    MultiVector & Axf = data.Axf[level];
+    MultiVector & rc = data.rc[level];
+    MultiVector & xc = data.xc[level];
+    int numberOfPresmootherSteps = A.mgData->numberOfPresmootherSteps;
+    for (int i=0; i< numberOfPresmootherSteps; ++i) ierr += ComputeMultiSYMGS(A, r, x);
+    if (ierr!=0) return(ierr);
+    ierr = ComputeSPMM(A, x, Axf); if (ierr!=0) return(ierr);
+    ComputeMultiRestriction(A, r, Axf, rc);
+    ierr = ComputeMultiMGCycle(*A.Ac, data, level+1, rc, xc, cycleType, true);  if (ierr!=0) return(ierr);
+    if (cycleType!=MG_CYCLE_V) {
+      int secondCycleType = (cycleType==MG_CYCLE_W) ? MG_CYCLE_W : MG_CYCLE_V;
+      ierr = ComputeMultiMGCycle(*A.Ac, data, level+1, rc, xc, secondCycleType, false);  if (ierr!=0) return(ierr);
+    }
+    ComputeMultiProlongation(A, xc, x);
+    int numberOfPostsmootherSteps = A.mgData->numberOfPostsmootherSteps;
+    for (int i=0; i< numberOfPostsmootherSteps; ++i) ierr += ComputeMultiSYMGS(A, r, x);
+    if (ierr!=0) return(ierr);
+  }
+  else {
+    ierr = ComputeMultiSYMGS(A, r, x);
+    if (ierr!=0) return(ierr);
+  }
+  return(0);
+}
+
+/*!
+  Applies the multigrid preconditioner to all vectors of a block.
+
+  @param[in] A the known system matrix
+  @param[inout] data the blocks of all levels, allocated by InitializeMultiCGData
+  @param[in] r the input block
+  @param[inout] x On exit contains the result of the multigrid cycle selected in A.mgData with r as the RHS
+
+  @return returns 0 upon success and non-zero otherwise
+
+  @see ComputeMG
+*/
+int ComputeMultiMG(const SparseMatrix  & A, MultiCGData & data, const MultiVector & r, MultiVector & x) {
+
+  int cycleType = (A.mgData!=0) ? A.mgData->cycleType : MG_CYCLE_V;
+  return(ComputeMultiMGCycle(A, data, 0, r, x, cycleType, true));
+}
@@ -0,0 +1,24 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+#ifndef COMPUTEMULTIMG_HPP
+#define COMPUTEMULTIMG_HPP
+#include "SparseMatrix.hpp"
+#include "MultiVector.hpp"
+#include "MultiCGData.hpp"
+
+int ComputeMultiMG(const SparseMatrix  & A, MultiCGData & data, const MultiVector & r, MultiVector & x);
+
+#endif // COMPUTEMULTIMG_HPP
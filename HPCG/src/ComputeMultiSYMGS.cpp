@@ -0,0 +1,97 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file ComputeMultiSYMGS.cpp
+
+ HPCG routine
+ */
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/hpx_fwd.hpp>
+#endif
+
+#ifndef HPCG_NOMPI
+#include "ExchangeHalo.hpp"
+#endif
+#include "ComputeMultiSYMGS.hpp"
+#include <cassert>
+
+/*!
+  Updates row i of all vectors of the block x with one Gauss-Seidel step,
+  reading the row of the matrix once.
+
+  @param[in]    A the known system matrix
+  @param[in]    rv the interleaved values of the block of right-hand sides
+  @param[inout] xv the interleaved values of the block of approximations
+  @param[in]    k the number of vectors of the blocks
+  @param[in]    i the row
+*/
+static void ComputeMultiGSRow(const SparseMatrix & A, const double * const rv, double * const xv, const int k, const local_int_t i) {
+  const double * const currentValues = A.matrixValues[i];
+  const local_int_t * const currentColIndices = A.mtxIndL[i];
+  const int currentNumberOfNonzeros = A.nonzerosInRow[i];
+  const double  currentDiagonal = A.matrixDiagonal[i][0]; // Current diagonal value
+  double sum[HPCG_MAX_RHS];
+  for (int l=0; l<k; l++) sum[l] = rv[i*k+l]; // RHS value
+
+  for (int j=0; j< currentNumberOfNonzeros; j++) {
+    const double a = currentValues[j];
+    const double * const xcol = xv + currentColIndices[j]*k;
+    for (int l=0; l<k; l++) sum[l] -= a*xcol[l];
+  }
+  for (int l=0; l<k; l++) {
+    sum[l] += xv[i*k+l]*currentDiagonal; // Remove diagonal contribution from previous loop
+    xv[i*k+l] = sum[l]/currentDiagonal;
+  }
+}
+
+/*!
+  Computes one step of symmetric Gauss-Seidel for every vector of a block.
+
+  The sweeps visit the rows in the same order as ComputeSYMGS_ref, so each
+  vector of the result is identical to the reference result for that vector,
+  but each row of the matrix is read once for all vectors.
+
+  @param[in] A the known system matrix
+  @param[in] r the input block
+  @param[inout] x On entry, x should contain relevant values, on exit x contains the result of one symmetric GS sweep with r as the RHS.
+
+  @return returns 0 upon success and non-zero otherwise
+
+  @see ComputeSYMGS_ref
+*/
+int ComputeMultiSYMGS( const SparseMatrix & A, const MultiVector & r, MultiVector & x) {
+
+  assert(x.localLength==A.localNumberOfColumns); // Make sure x contain space for halo values
+  assert(x.numberOfVectors==r.numberOfVectors);
+
+#ifndef HPCG_NOMPI
+  ExchangeMultiHalo(A,x);
+#endif
+
+  const local_int_t nrow = A.localNumberOfRows;
+  const double * const rv = r.values;
+  double * const xv = x.values;
+  const int k = x.numberOfVectors;
+
+  for (local_int_t i=0; i< nrow; i++) ComputeMultiGSRow(A, rv, xv, k, i);
+
+  // Now the back sweep.
+
+  for (local_int_t i=nrow-1; i>=0; i--) ComputeMultiGSRow(A, rv, xv, k, i);
+
+  return(0);
+}
@@ -0,0 +1,24 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+#ifndef COMPUTEMULTISYMGS_HPP
+#define COMPUTEMULTISYMGS_HPP
+
+#include "SparseMatrix.hpp"
+#include "MultiVector.hpp"
+
+int ComputeMultiSYMGS( const SparseMatrix  & A, const MultiVector & r, MultiVector & x);
+
+#endif // COMPUTEMULTISYMGS_HPP
@@ -0,0 +1,74 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file ComputeMultiWAXPBY.cpp
+
+ HPCG routine
+ */
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/hpx_fwd.hpp>
+#endif
+
+#include "ComputeMultiWAXPBY.hpp"
+
+/*!
+  Routine to compute the update of each vector of a block with the sum of the
+  corresponding two scaled vectors: w_j = alpha[j]*x_j + beta[j]*y_j
+
+  @param[in] n the number of vector elements (on this processor)
+  @param[in] alpha, beta arrays of x.numberOfVectors scalars applied to the vectors of x and y respectively.
+  @param[in] x, y the input blocks
+  @param[out] w the output block
+
+  @return returns 0 upon success and non-zero otherwise
+
+  @see ComputeWAXPBY
+*/
+int ComputeMultiWAXPBY(const local_int_t n, const double * alpha, const MultiVector & x,
+    const double * beta, const MultiVector & y, MultiVector & w) {
+
+  assert(x.localLength>=n); // Test vector lengths
+  assert(y.localLength>=n);
+  assert(x.numberOfVectors==y.numberOfVectors && x.numberOfVectors==w.numberOfVectors);
+
+  const double * const xv = x.values;
+  const double * const yv = y.values;
+  double * const wv = w.values;
+  const int k = x.numberOfVectors;
+  double a[HPCG_MAX_RHS], b[HPCG_MAX_RHS];
+  for (int l=0; l<k; l++) {
+    a[l] = alpha[l];
+    b[l] = beta[l];
+  }
+
+#if defined(HPCG_NOHPX)
+#ifndef HPCG_NOOPENMP
+  #pragma omp parallel for
+#endif
+  for (local_int_t i=0; i<n; i++)
+    for (int l=0; l<k; l++) wv[i*k+l] = a[l]*xv[i*k+l] + b[l]*yv[i*k+l];
+#else
+  typedef boost::counting_iterator<local_int_t> iterator;
+
+  hpx::parallel::for_each(hpx::parallel::par, iterator(0), iterator(n),
+    [xv, yv, wv, k, &a, &b](local_int_t i) {
+      for (int l=0; l<k; l++) wv[i*k+l] = a[l]*xv[i*k+l] + b[l]*yv[i*k+l];
+    });
+#endif
+
+  return(0);
+}
@@ -0,0 +1,21 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+#ifndef COMPUTEMULTIWAXPBY_HPP
+#define COMPUTEMULTIWAXPBY_HPP
+#include "MultiVector.hpp"
+int ComputeMultiWAXPBY(const local_int_t n, const double * alpha, const MultiVector & x,
+    const double * beta, const MultiVector & y, MultiVector & w);
+#endif // COMPUTEMULTIWAXPBY_HPP
@@ -0,0 +1,158 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file ComputeMulticolorSYMGS.cpp
+
+ HPCG routine
+ */
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/hpx_fwd.hpp>
+#endif
+
+#ifndef HPCG_NOMPI
+#include "ExchangeHalo.hpp"
+#endif
+
+#include <cassert>
+
+#include "ComputeMulticolorSYMGS.hpp"
+#include "Backend.hpp"
+
+/*!
+  Prepares the multicolor smoother for a given matrix: colors the local grid
+  points by the parity of their coordinates and orders the rows by color.
+
+  Two grid points of the same color differ by at least two in one
+  coordinate, so they are not coupled by the 27-point stencil and all rows of
+  a color can be updated concurrently.
+
+  @param[in]    A the known system matrix
+  @param[inout] data the smoother data of the matrix, on exit the colors are defined
+
+  @return returns 0 upon success and non-zero otherwise
+
+  @see ComputeMulticolorSYMGS
+*/
+int SetupMulticolorSYMGS(const SparseMatrix & A, SmootherData & data) {
+
+  const local_int_t nrow = A.localNumberOfRows;
+  const int nx = A.geom->nx;
+  const int ny = A.geom->ny;
+  const int nz = A.geom->nz;
+  assert(nrow==((local_int_t)nx)*ny*nz);
+
+  DeleteSmootherWorkspace(data);
+  const int numberOfColors = 8;
+  data.numberOfColors = numberOfColors;
+  data.colorStart = new local_int_t[numberOfColors+1];
+  data.colorRows = new local_int_t[nrow];
+
+  // Rows of each color in the natural (lexicographic) order of the grid points
+  local_int_t * const colorStart = data.colorStart;
+  for (int color=0; color<=numberOfColors; ++color) colorStart[color] = 0;
+  for (int iz=0; iz<nz; ++iz)
+    for (int iy=0; iy<ny; ++iy)
+      for (int ix=0; ix<nx; ++ix)
+        ++colorStart[(ix%2) + 2*(iy%2) + 4*(iz%2) + 1];
+  for (int color=0; color<numberOfColors; ++color) colorStart[color+1] += colorStart[color];
+  local_int_t next[8];
+  for (int color=0; color<numberOfColors; ++color) next[color] = colorStart[color];
+  for (int iz=0; iz<nz; ++iz)
+    for (int iy=0; iy<ny; ++iy)
+      for (int ix=0; ix<nx; ++ix)
+        data.colorRows[next[(ix%2) + 2*(iy%2) + 4*(iz%2)]++] = ((local_int_t)iz)*nx*ny + ((local_int_t)iy)*nx + ix;
+  assert(colorStart[numberOfColors]==nrow);
+
+  for (local_int_t i=0; i<nrow; ++i)
+    if (*(A.matrixDiagonal[i])==0.0) return(-1);
+
+  return(0);
+}
+
+/*!
+  Computes one Gauss-Seidel update of all rows of one color with the
+  backend of the multigrid kernels.
+
+  @param[in]    A the known system matrix
+  @param[in]    data the smoother data of the matrix
+  @param[in]    color the color to update
+  @param[in]    rv the right hand side values
+  @param[inout] xv the values to be updated
+*/
+static void ComputeColorSweep(const SparseMatrix & A, const SmootherData & data, const int color,
+    const double * const rv, double * const xv) {
+
+  const local_int_t first = data.colorStart[color];
+  const local_int_t * const colorRows = data.colorRows + first;
+
+  BackendParallelFor(HPCG_backends.mg, data.colorStart[color+1]-first, [&A, colorRows, rv, xv](local_int_t k) {
+    const local_int_t i = colorRows[k];
+    const double * const currentValues = A.matrixValues[i];
+    const local_int_t * const currentColIndices = A.mtxIndL[i];
+    const int currentNumberOfNonzeros = A.nonzerosInRow[i];
+    const double currentDiagonal = *(A.matrixDiagonal[i]);
+    double sum = rv[i]; // RHS value
+
+    for (int j=0; j<currentNumberOfNonzeros; ++j)
+      sum -= currentValues[j]*xv[currentColIndices[j]];
+    sum += xv[i]*currentDiagonal; // Remove diagonal contribution from previous loop
+
+    xv[i] = sum/currentDiagonal;
+  });
+  return;
+}
+
+/*!
+  Computes one step of symmetric Gauss-Seidel with the rows ordered by the
+  colors of SetupMulticolorSYMGS:
+
+  The forward sweep updates the colors in increasing order, the backward
+  sweep in decreasing order, the rows of one color are updated in parallel.
+  Since the backward sweep is the transpose of the forward sweep, the
+  multigrid preconditioner remains symmetric. The result differs from
+  ComputeSYMGS_ref only by the ordering of the rows.
+
+  @param[in] A the known system matrix, A.smootherData must have been set up by SetupMulticolorSYMGS
+  @param[in] r the input vector
+  @param[inout] x On entry, x should contain relevant values, on exit x contains the result of one symmetric sweep with r as the RHS.
+
+  @return returns 0 upon success and non-zero otherwise
+
+  @see SetupMulticolorSYMGS
+  @see ComputeSYMGS_ref
+*/
+int ComputeMulticolorSYMGS(const SparseMatrix & A, const Vector & r, Vector & x) {
+
+  assert(x.localLength==A.localNumberOfColumns); // Make sure x contain space for halo values
+  assert(A.smootherData!=0 && A.smootherData->colorStart!=0);
+
+#ifndef HPCG_NOMPI
+  ExchangeHalo(A,x);
+#endif
+
+  const SmootherData & data = *A.smootherData;
+  const int numberOfColors = data.numberOfColors;
+  const double * const rv = r.values;
+  double * const xv = x.values;
+
+  for (int color=0; color<numberOfColors; ++color)
+    ComputeColorSweep(A, data, color, rv, xv);
+  for (int color=numberOfColors-1; color>=0; --color)
+    ComputeColorSweep(A, data, color, rv, xv);
+
+  return(0);
+}
@@ -0,0 +1,25 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+#ifndef COMPUTEMULTICOLORSYMGS_HPP
+#define COMPUTEMULTICOLORSYMGS_HPP
+
+#include "SparseMatrix.hpp"
+#include "Vector.hpp"
+
+int SetupMulticolorSYMGS(const SparseMatrix & A, SmootherData & data);
+int ComputeMulticolorSYMGS(const SparseMatrix & A, const Vector & r, Vector & x);
+
+#endif // COMPUTEMULTICOLORSYMGS_HPP
@@ -28,26 +28,10 @@
 
 #include "ComputeProlongation.hpp"
 #include "ComputeProlongation_ref.hpp"
+#include "Backend.hpp"
+#include "KernelCounters.hpp"
 
-/*!
-  Routine to compute the coarse residual vector.
-
-  @param[in]  Af - Fine grid sparse matrix object containing pointers to current coarse grid correction and the f2c operator.
-  @param[inout] xf - Fine grid solution vector, update with coarse grid correction.
-
-  Note that the fine grid residual is never explicitly constructed.
-  We only compute it for the fine grid points that will be injected into corresponding coarse grid points.
-
-  @return Returns zero on success and a non-zero value otherwise.
-*/
-#if defined(HPCG_NOHPX)
-
-int ComputeProlongation(const SparseMatrix & Af, Vector & xf) {
-
-  return ComputeProlongation_ref(Af, xf);
-}
-
-#else
+#if !defined(HPCG_NOHPX)
 
 #include <hpx/include/lcos.hpp>
 #include <hpx/include/parallel_for_each.hpp>
@@ -74,9 +58,49 @@ hpx::future<void> ComputeProlongation_async(const SparseMatrix & Af, Vector & xf
     });
 }
 
-int ComputeProlongation(const SparseMatrix & Af, Vector & xf) {
+#endif
 
-  return ComputeProlongation_async(Af, xf).wait(), 0;
-}
+/*!
+  Computes the prolongation with the backend selected by HPCG_backends.mg.
+
+  @see ComputeProlongation
+*/
+static int ComputeProlongation_backend(const SparseMatrix & Af, Vector & xf) {
 
+  const int backend = HPCG_backends.mg;
+  if (backend==BACKEND_REF) return ComputeProlongation_ref(Af, xf);
+#if !defined(HPCG_NOHPX)
+  if (backend==BACKEND_HPX) return ComputeProlongation_async(Af, xf).wait(), 0;
 #endif
+
+  double * const xfv = xf.values;
+  const double * const xcv = Af.mgData->xc->values;
+  const local_int_t * const f2c = Af.mgData->f2cOperator;
+  const local_int_t nc = Af.mgData->rc->localLength;
+
+  // This loop is safe to vectorize
+  BackendParallelFor(backend, nc, [xfv, xcv, f2c](local_int_t i) { xfv[f2c[i]] += xcv[i]; });
+
+  return(0);
+}
+
+/*!
+  Routine to compute the coarse residual vector.
+
+  @param[in]  Af - Fine grid sparse matrix object containing pointers to current coarse grid correction and the f2c operator.
+  @param[inout] xf - Fine grid solution vector, update with coarse grid correction.
+
+  Note that the fine grid residual is never explicitly constructed.
+  We only compute it for the fine grid points that will be injected into corresponding coarse grid points.
+
+  The implementation is selected at run time by HPCG_backends.mg.
+
+  @return Returns zero on success and a non-zero value otherwise.
+*/
+int ComputeProlongation(const SparseMatrix & Af, Vector & xf) {
+
+  const KernelCall call = StartKernelCounter(KERNEL_PROLONGATION, &Af);
+  int ierr = ComputeProlongation_backend(Af, xf);
+  StopKernelCounter(KERNEL_PROLONGATION, &Af, 0, call);
+  return(ierr);
+}
@@ -28,27 +28,10 @@
 
 #include "ComputeRestriction.hpp"
 #include "ComputeRestriction_ref.hpp"
+#include "Backend.hpp"
+#include "KernelCounters.hpp"
 
-/*!
-  Routine to compute the coarse residual vector.
-
-  @param[inout]  A - Sparse matrix object containing pointers to mgData->Axf, the fine grid matrix-vector product and mgData->rc the coarse residual vector.
-  @param[in]    rf - Fine grid RHS.
-
-
-  Note that the fine grid residual is never explicitly constructed.
-  We only compute it for the fine grid points that will be injected into corresponding coarse grid points.
-
-  @return Returns zero on success and a non-zero value otherwise.
-*/
-#if defined(HPCG_NOHPX)
-
-int ComputeRestriction(const SparseMatrix & A, const Vector & rf) {
-
-  return ComputeRestriction_ref(A, rf);
-}
-
-#else
+#if !defined(HPCG_NOHPX)
 
 #include <hpx/include/lcos.hpp>
 #include <hpx/include/parallel_for_each.hpp>
@@ -73,9 +56,50 @@ hpx::future<void> ComputeRestriction_async(const SparseMatrix & A, const Vector
     });
 }
 
-int ComputeRestriction(const SparseMatrix & A, const Vector & rf) {
+#endif
 
-  return ComputeRestriction_async(A, rf).wait(), 0;
-}
+/*!
+  Computes the restriction with the backend selected by HPCG_backends.mg.
+
+  @see ComputeRestriction
+*/
+static int ComputeRestriction_backend(const SparseMatrix & A, const Vector & rf) {
 
+  const int backend = HPCG_backends.mg;
+  if (backend==BACKEND_REF) return ComputeRestriction_ref(A, rf);
+#if !defined(HPCG_NOHPX)
+  if (backend==BACKEND_HPX) return ComputeRestriction_async(A, rf).wait(), 0;
 #endif
+
+  const double * const Axfv = A.mgData->Axf->values;
+  const double * const rfv = rf.values;
+  double * const rcv = A.mgData->rc->values;
+  const local_int_t * const f2c = A.mgData->f2cOperator;
+  const local_int_t nc = A.mgData->rc->localLength;
+
+  BackendParallelFor(backend, nc, [rcv, rfv, Axfv, f2c](local_int_t i) { rcv[i] = rfv[f2c[i]] - Axfv[f2c[i]]; });
+
+  return(0);
+}
+
+/*!
+  Routine to compute the coarse residual vector.
+
+  @param[inout]  A - Sparse matrix object containing pointers to mgData->Axf, the fine grid matrix-vector product and mgData->rc the coarse residual vector.
+  @param[in]    rf - Fine grid RHS.
+
+
+  Note that the fine grid residual is never explicitly constructed.
+  We only compute it for the fine grid points that will be injected into corresponding coarse grid points.
+
+  The implementation is selected at run time by HPCG_backends.mg.
+
+  @return Returns zero on success and a non-zero value otherwise.
+*/
+int ComputeRestriction(const SparseMatrix & A, const Vector & rf) {
+
+  const KernelCall call = StartKernelCounter(KERNEL_RESTRICTION, &A);
+  int ierr = ComputeRestriction_backend(A, rf);
+  StopKernelCounter(KERNEL_RESTRICTION, &A, 0, call);
+  return(ierr);
+}
@@ -0,0 +1,105 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file ComputeSPMM.cpp
+
+ HPCG routine
+ */
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/hpx_fwd.hpp>
+#endif
+
+#ifndef HPCG_NOMPI
+#include "ExchangeHalo.hpp"
+#endif
+
+#include "ComputeSPMM.hpp"
+#include <cassert>
+
+/*!
+  Computes the product of the sparse matrix with the row of the block x and
+  stores it in the row of the block y. The row of the matrix is read once for
+  all vectors of the block.
+
+  @param[in]  A the known system matrix
+  @param[in]  xv the interleaved values of the block x
+  @param[out] yv the interleaved values of the block y
+  @param[in]  k the number of vectors of the blocks
+  @param[in]  i the row
+*/
+static void ComputeSPMMRow(const SparseMatrix & A, const double * const xv, double * const yv, const int k, const local_int_t i) {
+  double sum[HPCG_MAX_RHS];
+  for (int l=0; l<k; l++) sum[l] = 0.0;
+  const double * const cur_vals = A.matrixValues[i];
+  const local_int_t * const cur_inds = A.mtxIndL[i];
+  const int cur_nnz = A.nonzerosInRow[i];
+
+  for (int j=0; j< cur_nnz; j++) {
+    const double a = cur_vals[j];
+    const double * const xcol = xv + cur_inds[j]*k;
+    for (int l=0; l<k; l++) sum[l] += a*xcol[l];
+  }
+  for (int l=0; l<k; l++) yv[i*k+l] = sum[l];
+}
+
+/*!
+  Routine to compute the sparse matrix multiple vector product Y = AX, where
+  X and Y are blocks of vectors.
+
+  Precondition: First call exchange_externals to get off-processor values of x
+
+  @param[in]  A the known system matrix
+  @param[in]  x the known block of vectors
+  @param[out] y On exit contains the result: AX.
+
+  @return returns 0 upon success and non-zero otherwise
+
+  @see ComputeSPMV
+*/
+int ComputeSPMM( const SparseMatrix & A, MultiVector & x, MultiVector & y) {
+
+  assert(x.localLength>=A.localNumberOfColumns); // Test vector lengths
+  assert(y.localLength>=A.localNumberOfRows);
+  assert(x.numberOfVectors==y.numberOfVectors);
+
+#ifndef HPCG_NOMPI
+  ExchangeMultiHalo(A,x);
+#endif
+
+  const double * const xv = x.values;
+  double * const yv = y.values;
+  const int k = x.numberOfVectors;
+  const int numberOfSubdomains = A.numberOfSubdomains;
+
+  // Each thread subdomain is processed as a whole, so that a thread works on a compact part of the grid
+#if defined(HPCG_NOHPX)
+#ifndef HPCG_NOOPENMP
+  #pragma omp parallel for schedule(static,1)
+#endif
+  for (int s=0; s<numberOfSubdomains; s++)
+    for (local_int_t r=A.subdomainStart[s]; r<A.subdomainStart[s+1]; r++) ComputeSPMMRow(A, xv, yv, k, A.subdomainRows[r]);
+#else
+  typedef boost::counting_iterator<int> iterator;
+
+  hpx::parallel::for_each(hpx::parallel::par, iterator(0), iterator(numberOfSubdomains),
+    [xv, yv, k, &A](int s) {
+      for (local_int_t r=A.subdomainStart[s]; r<A.subdomainStart[s+1]; r++) ComputeSPMMRow(A, xv, yv, k, A.subdomainRows[r]);
+    });
+#endif
+
+  return(0);
+}
@@ -0,0 +1,24 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+#ifndef COMPUTESPMM_HPP
+#define COMPUTESPMM_HPP
+
+#include "SparseMatrix.hpp"
+#include "MultiVector.hpp"
+
+int ComputeSPMM( const SparseMatrix & A, MultiVector & x, MultiVector & y);
+
+#endif  // COMPUTESPMM_HPP
@@ -24,33 +24,17 @@
 
 #include "ComputeSPMV.hpp"
 #include "ComputeSPMV_ref.hpp"
+#include "Backend.hpp"
+#include "KernelCounters.hpp"
+#include "MatrixFormat.hpp"
 
-/*!
-  Routine to compute sparse matrix vector product y = Ax where:
-  Precondition: First call exchange_externals to get off-processor values of x
-
-  This routine calls the reference SpMV implementation by default, but
-  can be replaced by a custom, optimized routine suited for
-  the target system.
-
-  @param[in]  A the known system matrix
-  @param[in]  x the known vector
-  @param[out] y the On exit contains the result: Ax.
-
-  @return returns 0 upon success and non-zero otherwise
-
-  @see ComputeSPMV_ref
-*/
-#if defined(HPCG_NOHPX)
-
-int ComputeSPMV( const SparseMatrix & A, Vector & x, Vector & y) {
+#ifndef HPCG_NOMPI
+#include "ExchangeHalo.hpp"
+#endif
 
-  // This line and the next two lines should be removed and your version of ComputeSPMV should be used.
-  A.isSpmvOptimized = false;
-  return(ComputeSPMV_ref(A, x, y));
-}
+#include <cassert>
 
-#else
+#if !defined(HPCG_NOHPX)
 
 #include <hpx/include/lcos.hpp>
 #include <hpx/include/parallel_for_each.hpp>
@@ -68,28 +52,75 @@ hpx::future<void> ComputeSPMV_async( const SparseMatrix & A, /*const*/ Vector &
 
   const double * const xv = x.values;
   double * const yv = y.values;
-  const local_int_t nrow = A.localNumberOfRows;
 
-  typedef boost::counting_iterator<local_int_t> iterator;
+  typedef boost::counting_iterator<int> iterator;
 
+  // One task per thread subdomain, so that each task works on a compact part of the grid
   return hpx::parallel::for_each(
-    hpx::parallel::par(hpx::parallel::task), iterator(0), iterator(nrow),
-    [xv, yv, &A](local_int_t i) {
-      double sum = 0.0;
-      const double * const cur_vals = A.matrixValues[i];
-      const local_int_t * const cur_inds = A.mtxIndL[i];
-      const int cur_nnz = A.nonzerosInRow[i];
-
-      for (int j=0; j< cur_nnz; j++)
-        sum += cur_vals[j]*xv[cur_inds[j]];
-      yv[i] = sum;
+    hpx::parallel::par(hpx::parallel::task), iterator(0), iterator(A.numberOfSubdomains),
+    [xv, yv, &A](int s) {
+      ComputeSubdomainSPMV(A, s, xv, yv);
     });
 }
 
-int ComputeSPMV( const SparseMatrix & A, Vector & x, Vector & y) {
+#endif
 
+/*!
+  Applies the sparse matrix-vector product with the backend selected by
+  HPCG_backends.spmv.
+
+  @see ComputeSPMV
+*/
+static int ComputeSPMV_backend( const SparseMatrix & A, Vector & x, Vector & y) {
+
+  const int backend = HPCG_backends.spmv;
+  if (backend==BACKEND_REF) {
+    A.isSpmvOptimized = false;
+    return(ComputeSPMV_ref(A, x, y));
+  }
   A.isSpmvOptimized = true;
-  return ComputeSPMV_async(A, x, y).wait(), 0;
-}
+#if !defined(HPCG_NOHPX)
+  if (backend==BACKEND_HPX) return ComputeSPMV_async(A, x, y).wait(), 0;
+#endif
 
+  assert(x.localLength>=A.localNumberOfColumns); // Test vector lengths
+  assert(y.localLength>=A.localNumberOfRows);
+
+#ifndef HPCG_NOMPI
+  ExchangeHalo(A,x);
 #endif
+
+  const double * const xv = x.values;
+  double * const yv = y.values;
+
+  BackendParallelFor(backend, A.numberOfSubdomains, [xv, yv, &A](local_int_t s) {
+    ComputeSubdomainSPMV(A, s, xv, yv);
+  });
+
+  return(0);
+}
+
+/*!
+  Routine to compute sparse matrix vector product y = Ax where:
+  Precondition: First call exchange_externals to get off-processor values of x
+
+  The implementation is selected at run time by HPCG_backends.spmv: the
+  reference SpMV, or one parallel task per thread subdomain with one of the
+  parallel backends. The parallel backends use the matrix format selected
+  for the level by OptimizeProblem.
+
+  @param[in]  A the known system matrix
+  @param[in]  x the known vector
+  @param[out] y the On exit contains the result: Ax.
+
+  @return returns 0 upon success and non-zero otherwise
+
+  @see ComputeSPMV_ref
+*/
+int ComputeSPMV( const SparseMatrix & A, Vector & x, Vector & y) {
+
+  const KernelCall call = StartKernelCounter(KERNEL_SPMV, &A);
+  int ierr = ComputeSPMV_backend(A, x, y);
+  StopKernelCounter(KERNEL_SPMV, &A, 0, call);
+  return(ierr);
+}
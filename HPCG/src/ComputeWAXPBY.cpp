@@ -24,36 +24,12 @@
 
 #include "ComputeWAXPBY.hpp"
 #include "ComputeWAXPBY_ref.hpp"
+#include "Backend.hpp"
+#include "KernelCounters.hpp"
 
-/*!
-  Routine to compute the update of a vector with the sum of two
-  scaled vectors where: w = alpha*x + beta*y
-
-  This routine calls the reference WAXPBY implementation by default, but
-  can be replaced by a custom, optimized routine suited for
-  the target system.
-
-  @param[in] n the number of vector elements (on this processor)
-  @param[in] alpha, beta the scalars applied to x and y respectively.
-  @param[in] x, y the input vectors
-  @param[out] w the output vector
-  @param[out] isOptimized should be set to false if this routine uses the reference implementation (is not optimized); otherwise leave it unchanged
-
-  @return returns 0 upon success and non-zero otherwise
-
-  @see ComputeWAXPBY_ref
-*/
-#if defined(HPCG_NOHPX)
+#include <cassert>
 
-int ComputeWAXPBY(const local_int_t n, const double alpha, const Vector & x,
-    const double beta, const Vector & y, Vector & w, bool & isOptimized) {
-
-  // This line and the next two lines should be removed and your version of ComputeWAXPBY should be used.
-  isOptimized = false;
-  return(ComputeWAXPBY_ref(n, alpha, x, beta, y, w));
-}
-
-#else
+#if !defined(HPCG_NOHPX)
 
 #include <hpx/include/lcos.hpp>
 #include <hpx/include/parallel_for_each.hpp>
@@ -104,11 +80,69 @@ hpx::future<void> ComputeWAXPBY_async(
     });
 }
 
-int ComputeWAXPBY(const local_int_t n, const double alpha, const Vector & x,
+#endif
+
+/*!
+  Computes the vector update with the backend selected by
+  HPCG_backends.waxpby.
+
+  @see ComputeWAXPBY
+*/
+static int ComputeWAXPBY_backend(const local_int_t n, const double alpha, const Vector & x,
     const double beta, const Vector & y, Vector & w, bool & isOptimized) {
 
+  const int backend = HPCG_backends.waxpby;
+  if (backend==BACKEND_REF) {
+    isOptimized = false;
+    return(ComputeWAXPBY_ref(n, alpha, x, beta, y, w));
+  }
   isOptimized = true;
-  return ComputeWAXPBY_async(n, alpha, x, beta, y, w).wait(), 0;
+#if !defined(HPCG_NOHPX)
+  if (backend==BACKEND_HPX) {
+    ComputeWAXPBY_async(n, alpha, x, beta, y, w).wait();
+    return 0;
+  }
+#endif
+
+  assert(x.localLength>=n); // Test vector lengths
+  assert(y.localLength>=n);
+
+  const double * const xv = x.values;
+  const double * const yv = y.values;
+  double * const wv = w.values;
+
+  if (alpha==1.0)
+    BackendParallelFor(backend, n, [xv, yv, beta, wv](local_int_t i) { wv[i] = xv[i] + beta * yv[i]; });
+  else if (beta==1.0)
+    BackendParallelFor(backend, n, [xv, yv, alpha, wv](local_int_t i) { wv[i] = alpha * xv[i] + yv[i]; });
+  else
+    BackendParallelFor(backend, n, [xv, yv, alpha, beta, wv](local_int_t i) { wv[i] = alpha * xv[i] + beta * yv[i]; });
+
+  return(0);
 }
 
-#endif
+/*!
+  Routine to compute the update of a vector with the sum of two
+  scaled vectors where: w = alpha*x + beta*y
+
+  The implementation is selected at run time by HPCG_backends.waxpby: the
+  reference WAXPBY or a parallel loop with one of the parallel backends.
+
+  @param[in] n the number of vector elements (on this processor)
+  @param[in] alpha, beta the scalars applied to x and y respectively.
+  @param[in] x, y the input vectors
+  @param[out] w the output vector
+  @param[out] isOptimized should be set to false if this routine uses the reference implementation (is not optimized); otherwise leave it unchanged
+
+  @return returns 0 upon success and non-zero otherwise
+
+  @see ComputeWAXPBY_ref
+*/
+int ComputeWAXPBY(const local_int_t n, const double alpha, const Vector & x,
+    const double beta, const Vector & y, Vector & w, bool & isOptimized) {
+
+  const KernelCall call = StartKernelCounter(KERNEL_WAXPBY, 0);
+  int ierr = ComputeWAXPBY_backend(n, alpha, x, beta, y, w, isOptimized);
+  StopKernelCounter(KERNEL_WAXPBY, 0, n, call);
+  return(ierr);
+}
@@ -21,6 +21,6 @@ int ComputeWAXPBY(const local_int_t n, const double alpha, const Vector & x,
 #if !defined(HPCG_NOHPX)
 hpx::future<void> ComputeWAXPBY_async(
     const local_int_t n, const double alpha, const Vector & x,
-    const double beta, const Vector & y, Vector & w, bool & isOptimized);
+    const double beta, const Vector & y, Vector & w);
 #endif
 #endif // COMPUTEWAXPBY_HPP
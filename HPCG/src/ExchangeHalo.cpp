@@ -21,89 +21,227 @@
 #ifndef HPCG_NOMPI  // Compile this routine only if running in parallel
 #include <mpi.h>
 #include "Geometry.hpp"
+#include "Backend.hpp"
 #include "ExchangeHalo.hpp"
-#include <cstdlib>
+#include "KernelCounters.hpp"
+#include "hpcg.hpp"
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+#ifndef HPCG_NOOPENMP
+#include <omp.h>
+#endif
+
+#define HPCG_HALO_TAG 99 //!< tag of the messages of ExchangeHalo
+
+/*!
+  Stops all processes after a communication of a halo exchange failed,
+  since the external values of the vector are undefined.
+
+  @param[in] A    the matrix of the level whose halo was exchanged
+  @param[in] call the name of the MPI function that failed
+  @param[in] err  the error code it returned
+ */
+static void AbortHaloExchange(const SparseMatrix & A, const char * call, int err) {
+  char message[MPI_MAX_ERROR_STRING];
+  int length = 0;
+  MPI_Error_string(err, message, &length);
+  HPCG_fout << "Halo exchange on level " << A.level << " failed in " << call << ": " << message << std::endl;
+  std::cerr << "Halo exchange on level " << A.level << " failed in " << call << ": " << message << std::endl;
+  MPI_Abort(MPI_COMM_WORLD, err);
+}
+
+/*!
+  Creates the persistent requests of the halo exchange of a level: one
+  receive from each neighbor into the receive buffer and one send from the
+  send buffer to each neighbor. The requests are started by every call of
+  ExchangeHalo and freed by DeleteMatrix.
+
+  @param[inout] A The known system matrix, with the communication lists built by SetupHalo
+
+  @see ExchangeHalo
+ */
+void SetupHaloRequests(SparseMatrix & A) {
+
+  const int num_neighbors = A.numberOfSendNeighbors;
+  if (A.haloRequests!=0 || num_neighbors==0) return;
+
+  A.receiveBuffer = new double[A.numberOfExternalValues];
+  A.haloRequests = new MPI_Request[2*num_neighbors];
+
+  double * receiveBuffer = A.receiveBuffer;
+  double * sendBuffer = A.sendBuffer;
+  for (int i = 0; i < num_neighbors; i++) {
+    MPI_Recv_init(receiveBuffer, A.receiveLength[i], MPI_DOUBLE, A.neighbors[i], HPCG_HALO_TAG, MPI_COMM_WORLD, A.haloRequests+i);
+    MPI_Send_init(sendBuffer, A.sendLength[i], MPI_DOUBLE, A.neighbors[i], HPCG_HALO_TAG, MPI_COMM_WORLD, A.haloRequests+num_neighbors+i);
+    receiveBuffer += A.receiveLength[i];
+    sendBuffer += A.sendLength[i];
+  }
+  return;
+}
+
+/*!
+  Frees the persistent requests created by SetupHaloRequests, if any.
+
+  @param[inout] A The known system matrix
+ */
+void DeleteHaloRequests(SparseMatrix & A) {
+
+  if (A.haloRequests==0) return;
+  for (int i = 0; i < 2*A.numberOfSendNeighbors; i++) MPI_Request_free(A.haloRequests+i);
+  delete [] A.haloRequests;
+  A.haloRequests = 0;
+  return;
+}
 
 /*!
   Communicates data that is at the border of the part of the domain assigned to this processor.
 
+  The persistent receives are started first, then the threads pack the send
+  buffer and the persistent sends are started. The values of each neighbor
+  are copied into x as soon as its message arrives, and the call returns
+  when all sends have completed, so that the send buffer can be reused.
+
   @param[in]    A The known system matrix
   @param[inout] x On entry: the local vector entries followed by entries to be communicated; on exit: the vector with non-local entries updated by other processors
+
+  @see SetupHaloRequests
  */
 void ExchangeHalo(const SparseMatrix & A, Vector & x) {
 
   // Extract Matrix pieces
 
-  local_int_t localNumberOfRows = A.localNumberOfRows;
-  int num_neighbors = A.numberOfSendNeighbors;
-  local_int_t * receiveLength = A.receiveLength;
-  local_int_t * sendLength = A.sendLength;
-  int * neighbors = A.neighbors;
-  double * sendBuffer = A.sendBuffer;
-  local_int_t totalToBeSent = A.totalToBeSent;
-  local_int_t * elementsToSend = A.elementsToSend;
+  const local_int_t localNumberOfRows = A.localNumberOfRows;
+  const int num_neighbors = A.numberOfSendNeighbors;
+  const local_int_t * const receiveLength = A.receiveLength;
+  double * const sendBuffer = A.sendBuffer;
+  const double * const receiveBuffer = A.receiveBuffer;
+  const local_int_t totalToBeSent = A.totalToBeSent;
+  const local_int_t * const elementsToSend = A.elementsToSend;
+  MPI_Request * const receiveRequests = A.haloRequests;
+  MPI_Request * const sendRequests = A.haloRequests+num_neighbors;
 
   double * const xv = x.values;
 
-  int size, rank; // Number of MPI processes, My process ID
-  MPI_Comm_size(MPI_COMM_WORLD, &size);
-  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  if (num_neighbors==0) return;
+  assert(A.haloRequests!=0);
+
+  const KernelCall call = StartKernelCounter(KERNEL_HALO, &A);
+
+  // Post receives first, they complete while the send buffer is filled
+  MPI_Startall(num_neighbors, receiveRequests);
 
   //
-  //  first post receives, these are immediate receives
-  //  Do not wait for result to come, will do that at the
-  //  wait call below.
+  // Fill up send buffer
   //
+#ifndef HPCG_NOOPENMP
+  #pragma omp parallel for if(totalToBeSent>=HPCG_VECTOR_PARALLEL_THRESHOLD)
+#endif
+  for (local_int_t i=0; i<totalToBeSent; i++) sendBuffer[i] = xv[elementsToSend[i]];
 
-  int MPI_MY_TAG = 99;
-
-  MPI_Request * request = new MPI_Request[num_neighbors];
+  MPI_Startall(num_neighbors, sendRequests);
 
   //
-  // Externals are at end of locals
+  // Externals are at end of locals, copy the values of each neighbor in the order the messages arrive
   //
-  double * x_external = (double *) xv + localNumberOfRows;
-
-  // Post receives first
-  // TODO: Thread this loop
-  for (int i = 0; i < num_neighbors; i++) {
-    local_int_t n_recv = receiveLength[i];
-    MPI_Irecv(x_external, n_recv, MPI_DOUBLE, neighbors[i], MPI_MY_TAG, MPI_COMM_WORLD, request+i);
-    x_external += n_recv;
+  for (int count = 0; count < num_neighbors; count++) {
+    int i = 0;
+    MPI_Status status;
+    const int err = MPI_Waitany(num_neighbors, receiveRequests, &i, &status);
+    if (err!=MPI_SUCCESS) AbortHaloExchange(A, "MPI_Waitany", err);
+    local_int_t offset = 0;
+    for (int j = 0; j < i; j++) offset += receiveLength[j];
+    std::memcpy(xv+localNumberOfRows+offset, receiveBuffer+offset, receiveLength[i]*sizeof(double));
   }
 
+  const int err = MPI_Waitall(num_neighbors, sendRequests, MPI_STATUSES_IGNORE);
+  if (err!=MPI_SUCCESS) AbortHaloExchange(A, "MPI_Waitall", err);
 
-  //
-  // Fill up send buffer
-  //
+  StopKernelCounter(KERNEL_HALO, &A, 0, call);
 
-  // TODO: Thread this loop
-  for (local_int_t i=0; i<totalToBeSent; i++) sendBuffer[i] = xv[elementsToSend[i]];
+  return;
+}
+/*!
+  Allocates the send buffer and the requests of ExchangeMultiHalo for blocks
+  of up to maxNumberOfVectors vectors, unless the matrix already has large
+  enough ones. The buffers are freed by DeleteMatrix.
 
-  //
-  // Send to each neighbor
-  //
+  @param[in] A The known system matrix, with the communication lists built by SetupHalo
+  @param[in] maxNumberOfVectors the largest number of vectors of the blocks exchanged with ExchangeMultiHalo
+
+  @see ExchangeMultiHalo
+ */
+void SetupMultiHalo(const SparseMatrix & A, int maxNumberOfVectors) {
+
+  if (A.maxMultiHaloVectors>=maxNumberOfVectors) return;
+  delete [] A.multiSendBuffer;
+  A.multiSendBuffer = new double[A.totalToBeSent*maxNumberOfVectors];
+  if (A.multiHaloRequests==0) A.multiHaloRequests = new MPI_Request[2*A.numberOfSendNeighbors];
+  A.maxMultiHaloVectors = maxNumberOfVectors;
+  return;
+}
 
-  // TODO: Thread this loop
+/*!
+  Communicates the border data of all vectors of a block in one message per
+  neighbor. Since the values are interleaved, the external entries of all
+  vectors received from a neighbor are contiguous, as for a single vector.
+
+  The receives are posted directly into x, then the threads pack the send
+  buffer allocated by SetupMultiHalo and the sends are posted. The call
+  returns when all messages have completed.
+
+  @param[in]    A The known system matrix
+  @param[inout] x On entry: the local block entries followed by entries to be communicated; on exit: the block with non-local entries updated by other processors
+
+  @see SetupMultiHalo
+ */
+void ExchangeMultiHalo(const SparseMatrix & A, MultiVector & x) {
+
+  const local_int_t localNumberOfRows = A.localNumberOfRows;
+  const int num_neighbors = A.numberOfSendNeighbors;
+  const local_int_t * const receiveLength = A.receiveLength;
+  const local_int_t * const sendLength = A.sendLength;
+  const int * const neighbors = A.neighbors;
+  const local_int_t totalToBeSent = A.totalToBeSent;
+  const local_int_t * const elementsToSend = A.elementsToSend;
+  const int k = x.numberOfVectors;
+
+  if (num_neighbors==0) return;
+  if (k>A.maxMultiHaloVectors) SetupMultiHalo(A, k); // Only if the caller did not size the buffers for its blocks
+
+  double * const xv = x.values;
+  double * const sendBuffer = A.multiSendBuffer;
+  MPI_Request * const receiveRequests = A.multiHaloRequests;
+  MPI_Request * const sendRequests = A.multiHaloRequests+num_neighbors;
+
+  int MPI_MY_TAG = 98;
+
+  // Post receives first, externals are at end of locals
+  double * x_external = xv + localNumberOfRows*k;
   for (int i = 0; i < num_neighbors; i++) {
-    local_int_t n_send = sendLength[i];
-    MPI_Send(sendBuffer, n_send, MPI_DOUBLE, neighbors[i], MPI_MY_TAG, MPI_COMM_WORLD);
-    sendBuffer += n_send;
+    local_int_t n_recv = receiveLength[i]*k;
+    MPI_Irecv(x_external, n_recv, MPI_DOUBLE, neighbors[i], MPI_MY_TAG, MPI_COMM_WORLD, receiveRequests+i);
+    x_external += n_recv;
   }
 
-  //
-  // Complete the reads issued above
-  //
+  // Fill up send buffer
+  const int backend = (totalToBeSent*k>=HPCG_VECTOR_PARALLEL_THRESHOLD) ? HPCG_backends.spmv : BACKEND_REF;
+  BackendParallelFor(backend, totalToBeSent, [xv, sendBuffer, elementsToSend, k](local_int_t i) {
+    for (int j=0; j<k; j++) sendBuffer[i*k+j] = xv[elementsToSend[i]*k+j];
+  });
 
-  MPI_Status status;
-  // TODO: Thread this loop
+  // Send to each neighbor
+  double * curSendBuffer = sendBuffer;
   for (int i = 0; i < num_neighbors; i++) {
-    if ( MPI_Wait(request+i, &status) ) {
-      std::exit(-1); // TODO: have better error exit
-    }
+    local_int_t n_send = sendLength[i]*k;
+    MPI_Isend(curSendBuffer, n_send, MPI_DOUBLE, neighbors[i], MPI_MY_TAG, MPI_COMM_WORLD, sendRequests+i);
+    curSendBuffer += n_send;
   }
 
-  delete [] request;
+  // Complete the reads and sends issued above
+  const int err = MPI_Waitall(2*num_neighbors, receiveRequests, MPI_STATUSES_IGNORE);
+  if (err!=MPI_SUCCESS) AbortHaloExchange(A, "MPI_Waitall", err);
 
   return;
 }
@@ -16,5 +16,10 @@
 #define EXCHANGEHALO_HPP
 #include "SparseMatrix.hpp"
 #include "Vector.hpp"
+#include "MultiVector.hpp"
+void SetupHaloRequests(SparseMatrix & A);
+void DeleteHaloRequests(SparseMatrix & A);
 void ExchangeHalo(const SparseMatrix & A, Vector & x);
+void SetupMultiHalo(const SparseMatrix & A, int maxNumberOfVectors);
+void ExchangeMultiHalo(const SparseMatrix & A, MultiVector & x);
 #endif // EXCHANGEHALO_HPP
@@ -83,10 +83,11 @@ void GenerateCoarseProblem(const SparseMatrix & Af) {
 
   // Construct the geometry and linear system
   Geometry * geomc = new Geometry;
-  GenerateGeometry(Af.geom->size, Af.geom->rank, Af.geom->numThreads, nxc, nyc, nzc, geomc);
+  GenerateCoarseGeometry(*Af.geom, geomc);
 
   SparseMatrix * Ac = new SparseMatrix;
   InitializeSparseMatrix(*Ac, geomc);
+  Ac->level = Af.level+1;
   GenerateProblem(*Ac, 0, 0, 0);
   SetupHalo(*Ac);
   Vector *rc = new Vector;
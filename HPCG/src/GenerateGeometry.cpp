@@ -189,18 +189,14 @@ gen_min_area3(int n, int * f1, int * f2, int * f3) {
 
 /*!
   Computes the factorization of the total number of processes into a
-  3-dimensional process grid that is as close as possible to a cube. The
-  quality of the factorization depends on the prime number structure of the
-  total number of processes. It then stores this decompostion together with the
-  parallel parameters of the run in the geometry data structure.
+  3-dimensional process grid that is as close as possible to a cube and the
+  position of this process in it.
 
   @param[in]  size total number of MPI processes
   @param[in]  rank this process' rank among other MPI processes
-  @param[in]  numThreads number of OpenMP threads in this process
-  @param[in]  nx, ny, nz number of grid points for each local block in the x, y, and z dimensions, respectively
-  @param[out] geom data structure that will store the above parameters and the factoring of total number of processes into three dimensions
+  @param[out] geom data structure that receives the process grid
 */
-void GenerateGeometry(int size, int rank, int numThreads, int nx, int ny, int nz, Geometry * geom) {
+static void GenerateProcessGrid(int size, int rank, Geometry * geom) {
 
   int npx, npy, npz;
 
@@ -211,34 +207,228 @@ void GenerateGeometry(int size, int rank, int numThreads, int nx, int ny, int nz
   int ipy = (rank-ipz*npx*npy)/npx;
   int ipx = rank%npx;
 
+  geom->size = size;
+  geom->rank = rank;
+  geom->npx = npx;
+  geom->npy = npy;
+  geom->npz = npz;
+  geom->ipx = ipx;
+  geom->ipy = ipy;
+  geom->ipz = ipz;
+  return;
+}
+
+/*!
+  Splits n grid points into parts of at most one unit difference in size.
+  The unit is the largest power of two up to granularity that divides n and
+  leaves at least one unit per part, so that the parts can be coarsened as
+  often as possible. Every part gets at least one grid point.
+
+  @param[in]  n number of grid points
+  @param[in]  parts number of parts
+  @param[in]  granularity requested unit, a power of two
+  @param[out] offsets first grid point of each part, parts+1 entries ending with the number of grid points
+*/
+static void SplitDimension(int n, int parts, int granularity, std::vector<int> & offsets) {
+
+  if (n < parts) n = parts;
+  int unit = (granularity > 1) ? granularity : 1;
+  while (unit > 1 && (n%unit != 0 || n/unit < parts)) unit /= 2;
+  const long long units = n/unit;
+  offsets.resize(parts+1);
+  for (int i = 0; i <= parts; ++i)
+    offsets[i] = (int) (unit*((i*units)/parts));
+  return;
+}
+
+/*!
+  Computes the factorization of the total number of processes into a
+  3-dimensional process grid that is as close as possible to a cube. The
+  quality of the factorization depends on the prime number structure of the
+  total number of processes. It then stores this decompostion together with the
+  parallel parameters of the run in the geometry data structure.
+
+  The local subdomain is further decomposed into one subcube per thread with
+  GenerateBlockGrid, so that each thread works on a compact part of the grid.
+
+  @param[in]  size total number of MPI processes
+  @param[in]  rank this process' rank among other MPI processes
+  @param[in]  numThreads number of OpenMP threads in this process
+  @param[in]  nx, ny, nz number of grid points for each local block in the x, y, and z dimensions, respectively
+  @param[out] geom data structure that will store the above parameters and the factoring of total number of processes into three dimensions
+*/
+void GenerateGeometry(int size, int rank, int numThreads, int nx, int ny, int nz, Geometry * geom) {
+
+  GenerateProcessGrid(size, rank, geom);
+
 #ifdef HPCG_DEBUG
   if (rank==0)
     HPCG_fout   << "size = "<< size << endl
         << "nx  = " << nx << endl
         << "ny  = " << ny << endl
         << "nz  = " << nz << endl
-        << "npx = " << npx << endl
-        << "npy = " << npy << endl
-        << "npz = " << npz << endl;
+        << "npx = " << geom->npx << endl
+        << "npy = " << geom->npy << endl
+        << "npz = " << geom->npz << endl;
 
   HPCG_fout    << "For rank = " << rank << endl
-      << "ipx = " << ipx << endl
-      << "ipy = " << ipy << endl
-      << "ipz = " << ipz << endl;
+      << "ipx = " << geom->ipx << endl
+      << "ipy = " << geom->ipy << endl
+      << "ipz = " << geom->ipz << endl;
 
-  assert(size==npx*npy*npz);
+  assert(size==geom->npx*geom->npy*geom->npz);
 #endif
-  geom->size = size;
-  geom->rank = rank;
   geom->numThreads = numThreads;
   geom->nx = nx;
   geom->ny = ny;
   geom->nz = nz;
-  geom->npx = npx;
-  geom->npy = npy;
-  geom->npz = npz;
-  geom->ipx = ipx;
-  geom->ipy = ipy;
-  geom->ipz = ipz;
+  geom->gnx = nx*geom->npx;
+  geom->gny = ny*geom->npy;
+  geom->gnz = nz*geom->npz;
+  geom->strongScaling = 0;
+  geom->partx.resize(geom->npx+1);
+  geom->party.resize(geom->npy+1);
+  geom->partz.resize(geom->npz+1);
+  for (int i = 0; i <= geom->npx; ++i) geom->partx[i] = i*nx;
+  for (int i = 0; i <= geom->npy; ++i) geom->party[i] = i*ny;
+  for (int i = 0; i <= geom->npz; ++i) geom->partz[i] = i*nz;
+  GenerateBlockGrid(numThreads, nx, ny, nz, &geom->ntx, &geom->nty, &geom->ntz);
+  return;
+}
+
+/*!
+  Computes the process grid as GenerateGeometry does, but splits a global
+  grid across the processes instead of giving each process a grid of the
+  same size, for strong scaling studies. Grid dimensions that are not
+  divisible by the number of processes are split into parts that differ by
+  at most one unit, where the unit is a power of two up to granularity so
+  that the local grids can be coarsened.
+
+  @param[in]  size total number of MPI processes
+  @param[in]  rank this process' rank among other MPI processes
+  @param[in]  numThreads number of OpenMP threads in this process
+  @param[in]  gnx, gny, gnz number of grid points of the global grid in the x, y, and z dimensions, respectively
+  @param[in]  granularity the requested unit of the parts, 2^(levels-1) for a hierarchy of the given number of levels
+  @param[out] geom data structure that will store the above parameters and the local grid of this process
+*/
+void GenerateGlobalGeometry(int size, int rank, int numThreads, int gnx, int gny, int gnz, int granularity, Geometry * geom) {
+
+  GenerateProcessGrid(size, rank, geom);
+  SplitDimension(gnx, geom->npx, granularity, geom->partx);
+  SplitDimension(gny, geom->npy, granularity, geom->party);
+  SplitDimension(gnz, geom->npz, granularity, geom->partz);
+  geom->numThreads = numThreads;
+  geom->gnx = geom->partx[geom->npx];
+  geom->gny = geom->party[geom->npy];
+  geom->gnz = geom->partz[geom->npz];
+  geom->nx = geom->partx[geom->ipx+1]-geom->partx[geom->ipx];
+  geom->ny = geom->party[geom->ipy+1]-geom->party[geom->ipy];
+  geom->nz = geom->partz[geom->ipz+1]-geom->partz[geom->ipz];
+  geom->strongScaling = 1;
+  GenerateBlockGrid(numThreads, geom->nx, geom->ny, geom->nz, &geom->ntx, &geom->nty, &geom->ntz);
+  return;
+}
+
+/*!
+  Returns true if the grid can be coarsened, i.e. the local grids of all
+  processes have even dimensions. The result is the same on all processes.
+
+  @param[in] geom the geometry of the fine grid
+*/
+bool CanCoarsenGeometry(const Geometry & geom) {
+
+  for (size_t i = 0; i < geom.partx.size(); ++i) if (geom.partx[i]%2 != 0) return false;
+  for (size_t i = 0; i < geom.party.size(); ++i) if (geom.party[i]%2 != 0) return false;
+  for (size_t i = 0; i < geom.partz.size(); ++i) if (geom.partz[i]%2 != 0) return false;
+  return true;
+}
+
+/*!
+  Computes the geometry of the coarse grid of GenerateCoarseProblem, which
+  halves the local grid of every process in each dimension.
+
+  @param[in]  fine the geometry of the fine grid, CanCoarsenGeometry must be true
+  @param[out] coarse the geometry of the coarse grid
+*/
+void GenerateCoarseGeometry(const Geometry & fine, Geometry * coarse) {
+
+  *coarse = fine;
+  for (size_t i = 0; i < coarse->partx.size(); ++i) coarse->partx[i] /= 2;
+  for (size_t i = 0; i < coarse->party.size(); ++i) coarse->party[i] /= 2;
+  for (size_t i = 0; i < coarse->partz.size(); ++i) coarse->partz[i] /= 2;
+  coarse->nx = fine.nx/2;
+  coarse->ny = fine.ny/2;
+  coarse->nz = fine.nz/2;
+  coarse->gnx = fine.gnx/2;
+  coarse->gny = fine.gny/2;
+  coarse->gnz = fine.gnz/2;
+  GenerateBlockGrid(coarse->numThreads, coarse->nx, coarse->ny, coarse->nz, &coarse->ntx, &coarse->nty, &coarse->ntz);
+  return;
+}
+
+/*!
+  Computes the factorization of a number of blocks into a 3-dimensional grid of
+  subcubes of a local subdomain, using the same factorization as for the
+  processor grid. The largest factor is assigned to the largest dimension and
+  no dimension is split into more blocks than it has grid points, so the
+  actual number of blocks may be smaller than requested.
+
+  @param[in]  numberOfBlocks requested number of blocks
+  @param[in]  nx, ny, nz number of grid points of the local subdomain in the x, y, and z dimensions, respectively
+  @param[out] bx, by, bz number of blocks in the x, y, and z dimensions, respectively
+*/
+void GenerateBlockGrid(int numberOfBlocks, int nx, int ny, int nz, int * bx, int * by, int * bz) {
+
+  int f[3], n[3] = {nx, ny, nz}, order[3] = {0, 1, 2}, b[3];
+
+  if (numberOfBlocks < 1) numberOfBlocks = 1;
+  gen_min_area3( numberOfBlocks, f, f+1, f+2 );
+
+  // Sort the factors and the dimensions in descending order
+  for (int i = 0; i < 3; ++i)
+    for (int j = i+1; j < 3; ++j) {
+      if (f[j] > f[i]) { int t = f[i]; f[i] = f[j]; f[j] = t; }
+      if (n[order[j]] > n[order[i]]) { int t = order[i]; order[i] = order[j]; order[j] = t; }
+    }
+  for (int i = 0; i < 3; ++i)
+    b[order[i]] = (f[i] < n[order[i]]) ? f[i] : n[order[i]];
+
+  *bx = b[0];
+  *by = b[1];
+  *bz = b[2];
+  return;
+}
+
+/*!
+  Lists the rows of the local subdomain by subcube of a bx by by by bz grid
+  of subcubes. The rows of subcube b are blockRows[blockStart[b]] to
+  blockRows[blockStart[b+1]-1], in the natural (lexicographic) order of the
+  grid points.
+
+  @param[in]  nx, ny, nz number of grid points of the local subdomain in the x, y, and z dimensions, respectively
+  @param[in]  bx, by, bz number of subcubes in the x, y, and z dimensions, respectively
+  @param[out] blockStart array of bx*by*bz+1 offsets into blockRows
+  @param[out] blockRows array of nx*ny*nz rows
+  @param[out] rowBlock array of nx*ny*nz subcube indices of the rows, may be 0
+*/
+void GenerateBlockRows(int nx, int ny, int nz, int bx, int by, int bz, local_int_t * blockStart, local_int_t * blockRows, int * rowBlock) {
+
+  local_int_t k = 0;
+  for (int ibz=0; ibz<bz; ++ibz) {
+    for (int iby=0; iby<by; ++iby) {
+      for (int ibx=0; ibx<bx; ++ibx) {
+        const int block = ibx+iby*bx+ibz*bx*by;
+        blockStart[block] = k;
+        for (int iz=(ibz*nz)/bz; iz<((ibz+1)*nz)/bz; ++iz)
+          for (int iy=(iby*ny)/by; iy<((iby+1)*ny)/by; ++iy)
+            for (int ix=(ibx*nx)/bx; ix<((ibx+1)*nx)/bx; ++ix) {
+              local_int_t row = ((local_int_t)iz)*nx*ny+iy*nx+ix;
+              blockRows[k++] = row;
+              if (rowBlock) rowBlock[row] = block;
+            }
+      }
+    }
+  }
+  blockStart[bx*by*bz] = k;
   return;
 }
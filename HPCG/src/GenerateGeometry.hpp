@@ -16,4 +16,9 @@
 #define GENERATEGEOMETRY_HPP
 #include "Geometry.hpp"
 void GenerateGeometry(int size, int rank, int numThreads, int nx, int ny, int nz, Geometry * geom);
+void GenerateGlobalGeometry(int size, int rank, int numThreads, int gnx, int gny, int gnz, int granularity, Geometry * geom);
+bool CanCoarsenGeometry(const Geometry & geom);
+void GenerateCoarseGeometry(const Geometry & fine, Geometry * coarse);
+void GenerateBlockGrid(int numberOfBlocks, int nx, int ny, int nz, int * bx, int * by, int * bz);
+void GenerateBlockRows(int nx, int ny, int nz, int bx, int by, int bz, local_int_t * blockStart, local_int_t * blockRows, int * rowBlock);
 #endif // GENERATEGEOMETRY_HPP
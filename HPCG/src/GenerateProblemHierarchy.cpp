@@ -0,0 +1,112 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file GenerateProblemHierarchy.cpp
+
+ HPCG routine
+ */
+
+#ifndef HPCG_NOMPI
+#include <mpi.h>
+#endif
+
+#include <fstream>
+using std::endl;
+
+#include "GenerateProblemHierarchy.hpp"
+#include "GenerateGeometry.hpp"
+#include "GenerateProblem.hpp"
+#include "GenerateCoarseProblem.hpp"
+#include "SetupHalo.hpp"
+#include "ProblemCache.hpp"
+
+/*!
+  Constructs the geometry of this process, the linear system and its
+  multigrid hierarchy as selected by the parameters of the run: the grid is
+  the local grid of every process, or the global grid with --scaling=strong,
+  and each coarse level gets the smoother steps and the cycle of the
+  parameters. The hierarchy stops early if a grid cannot be coarsened on all
+  processes.
+
+  If a cache directory is given, the hierarchy is loaded from the problem
+  cache when every process has a valid cache file, and otherwise generated
+  and written to the cache.
+
+  @param[in]  params the parameters of the run
+  @param[in]  numberOfMgLevels the number of levels requested, including the finest level
+  @param[in]  cacheDirectory the directory of the problem cache, 0 or empty to always generate the problem
+  @param[out] A the matrix of the finest level, the coarse levels are in A.Ac
+  @param[out] b, x, xexact the vectors of GenerateProblem
+  @param[out] cached if not 0, set to 1 if the hierarchy was loaded from the cache and to 0 otherwise
+
+  @return returns the number of multigrid levels constructed
+
+  @see GenerateProblem
+  @see GenerateCoarseProblem
+*/
+int GenerateProblemHierarchy(const HPCG_Params & params, int numberOfMgLevels, const char * cacheDirectory,
+    SparseMatrix & A, Vector & b, Vector & x, Vector & xexact, int * cached) {
+
+  const int size = params.comm_size, rank = params.comm_rank;
+  Geometry * geom = new Geometry;
+  if (params.strongScaling)
+    GenerateGlobalGeometry(size, rank, params.numThreads, params.nx, params.ny, params.nz, 1<<(params.numberOfMgLevels-1), geom);
+  else
+    GenerateGeometry(size, rank, params.numThreads, params.nx, params.ny, params.nz, geom);
+  InitializeSparseMatrix(A, geom);
+
+  // Load the hierarchy from the problem cache if every process has a valid cache file, otherwise generate it
+  const bool useCache = cacheDirectory!=0 && cacheDirectory[0]!=0;
+  char cacheFileName[sizeof(params.problemCacheDirectory)+128];
+  ProblemCache cache;
+  int loaded = 0;
+  if (useCache) {
+    ProblemCacheFileName(cacheDirectory, *geom, numberOfMgLevels, cacheFileName, sizeof(cacheFileName));
+    loaded = OpenProblemCache(cacheFileName, *geom, numberOfMgLevels, cache)==0;
+#ifndef HPCG_NOMPI
+    int localLoaded = loaded;
+    MPI_Allreduce(&localLoaded, &loaded, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    if (!loaded) CloseProblemCache(cache);
+#endif
+  }
+
+  int levels = numberOfMgLevels;
+  if (loaded) {
+    levels = LoadProblemCache(cache, A, b, x, xexact);
+  } else {
+    GenerateProblem(A, &b, &x, &xexact);
+    SetupHalo(A);
+  }
+  SparseMatrix * curLevelMatrix = &A;
+  for (int level = 1; level< levels; ++level) {
+      if (!loaded) {
+        if (!CanCoarsenGeometry(*curLevelMatrix->geom)) { // Coarsening needs even grid dimensions on all processes
+          if (rank==0) HPCG_fout << "Grid of level " << level-1 << " cannot be coarsened, using " << level << " multigrid levels." << endl;
+          levels = level;
+          break;
+        }
+        GenerateCoarseProblem(*curLevelMatrix);
+      }
+      curLevelMatrix->mgData->numberOfPresmootherSteps = params.numberOfPresmootherSteps[level-1];
+      curLevelMatrix->mgData->numberOfPostsmootherSteps = params.numberOfPostsmootherSteps[level-1];
+      curLevelMatrix->mgData->cycleType = params.mgCycle;
+      curLevelMatrix = curLevelMatrix->Ac; // Make the just-constructed coarse grid the next level
+  }
+  if (useCache && !loaded && WriteProblemCache(cacheFileName, A, numberOfMgLevels, b, x, xexact)!=0)
+    HPCG_fout << "Problem cache file " << cacheFileName << " could not be written." << endl;
+
+  if (cached!=0) *cached = loaded;
+  return(levels);
+}
@@ -0,0 +1,22 @@
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+#ifndef GENERATEPROBLEMHIERARCHY_HPP
+#define GENERATEPROBLEMHIERARCHY_HPP
+#include "hpcg.hpp"
+#include "SparseMatrix.hpp"
+#include "Vector.hpp"
+
+int GenerateProblemHierarchy(const HPCG_Params & params, int numberOfMgLevels, const char * cacheDirectory,
+    SparseMatrix & A, Vector & b, Vector & x, Vector & xexact, int * cached);
+#endif // GENERATEPROBLEMHIERARCHY_HPP
@@ -21,13 +21,22 @@
 #ifndef GEOMETRY_HPP
 #define GEOMETRY_HPP
 
+#include <algorithm>
+#include <vector>
+
 /*!
   This defines the type for integers that have local subdomain dimension.
 
-  Define as "long long" when local problem dimension is > 2^31
+  Defined as "long long" if HPCG_LOCAL_INT64 is defined (CMake option of the
+  same name), which is needed when the local problem dimension is > 2^31.
+  The 32-bit type is the default since the column indices are a large part
+  of the memory traffic of the kernels.
 */
+#ifdef HPCG_LOCAL_INT64
+typedef long long local_int_t;
+#else
 typedef int local_int_t;
-//typedef long long local_int_t;
+#endif
 
 /*!
   This defines the type for integers that have global dimension
@@ -48,16 +57,25 @@ struct Geometry_STRUCT {
   int size; //!< Number of MPI processes
   int rank; //!< This process' rank in the range [0 to size - 1]
   int numThreads; //!< This process' number of threads
-  int nx;   //!< Number of x-direction grid points for each local subdomain
-  int ny;   //!< Number of y-direction grid points for each local subdomain
-  int nz;   //!< Number of z-direction grid points for each local subdomain
+  int nx;   //!< Number of x-direction grid points of this process' local subdomain
+  int ny;   //!< Number of y-direction grid points of this process' local subdomain
+  int nz;   //!< Number of z-direction grid points of this process' local subdomain
+  int gnx;  //!< Number of x-direction grid points of the global grid
+  int gny;  //!< Number of y-direction grid points of the global grid
+  int gnz;  //!< Number of z-direction grid points of the global grid
+  int strongScaling; //!< 1 if the global grid was given and split across the processes, 0 if each process has the given local grid
   int npx;  //!< Number of processors in x-direction
   int npy;  //!< Number of processors in y-direction
   int npz;  //!< Number of processors in z-direction
   int ipx;  //!< Current rank's x location in the npx by npy by npz processor grid
   int ipy;  //!< Current rank's y location in the npx by npy by npz processor grid
   int ipz;  //!< Current rank's z location in the npx by npy by npz processor grid
-
+  int ntx;  //!< Number of thread subdomains in x-direction of the local subdomain
+  int nty;  //!< Number of thread subdomains in y-direction of the local subdomain
+  int ntz;  //!< Number of thread subdomains in z-direction of the local subdomain
+  std::vector<int> partx; //!< First global x index of each process column, npx+1 entries ending with gnx
+  std::vector<int> party; //!< First global y index of each process row, npy+1 entries ending with gny
+  std::vector<int> partz; //!< First global z index of each process plane, npz+1 entries ending with gnz
 };
 typedef struct Geometry_STRUCT Geometry;
 
@@ -71,15 +89,16 @@ typedef struct Geometry_STRUCT Geometry;
   @return Returns the MPI rank of the process assigned the row
 */
 inline global_int_t ComputeRankOfMatrixRow(const Geometry & geom, global_int_t index) {
-  global_int_t gnx = geom.nx*geom.npx;
-  global_int_t gny = geom.ny*geom.npy;
+  global_int_t gnx = geom.gnx;
+  global_int_t gny = geom.gny;
 
   global_int_t iz = index/(gny*gnx);
   global_int_t iy = (index-iz*gny*gnx)/gnx;
   global_int_t ix = index%gnx;
-  global_int_t ipz = iz/geom.nz;
-  global_int_t ipy = iy/geom.ny;
-  global_int_t ipx = ix/geom.nx;
+  // The last process whose first index is not past the grid point
+  global_int_t ipz = std::upper_bound(geom.partz.begin(), geom.partz.end()-1, (int) iz) - geom.partz.begin() - 1;
+  global_int_t ipy = std::upper_bound(geom.party.begin(), geom.party.end()-1, (int) iy) - geom.party.begin() - 1;
+  global_int_t ipx = std::upper_bound(geom.partx.begin(), geom.partx.end()-1, (int) ix) - geom.partx.begin() - 1;
   global_int_t rank = ipx+ipy*geom.npx+ipz*geom.npy*geom.npx;
   return(rank);
 }
@@ -0,0 +1,297 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file HardwareCounters.cpp
+
+ HPCG routine
+ */
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "HardwareCounters.hpp"
+
+bool HPCG_hardwareCountersEnabled = false;
+
+std::atomic<long long> HPCG_hardwareCounts[HPCG_MAX_MG_LEVELS][HPCG_NUMBER_OF_KERNELS][HPCG_NUMBER_OF_HW_EVENTS];
+
+static std::string hardwareEventStatus[HPCG_NUMBER_OF_HW_EVENTS]; // "available" or the reason why not, empty if not requested
+
+/*!
+  The counter group of one thread of the process, read with a single system
+  call. The group counts the core events available on the calling thread of
+  InitializeHardwareCounters.
+*/
+struct ThreadCounters_STRUCT {
+  int numberOfEvents; //!< number of events in the group
+  int fds[HW_EVENT_LLC_MISSES+1]; //!< file descriptors of the events, the first one is the group leader
+  int events[HW_EVENT_LLC_MISSES+1]; //!< the event of each member, one of HardwareEvent
+};
+typedef struct ThreadCounters_STRUCT ThreadCounters;
+
+static std::vector<ThreadCounters> threadCounters;
+static std::vector<int> dramCounters; // the CAS counters of all memory controllers, one line of 64 bytes per count
+
+/*!
+  Returns the name of a hardware event as used in the report.
+
+  @param[in] event the event, one of HardwareEvent
+*/
+const char * HardwareEventName(int event) {
+  switch (event) {
+    case HW_EVENT_CYCLES: return "Cycles";
+    case HW_EVENT_INSTRUCTIONS: return "Instructions";
+    case HW_EVENT_LLC_MISSES: return "LLC misses";
+    case HW_EVENT_DRAM_BYTES: return "DRAM bytes";
+    default: return "Unknown";
+  }
+}
+
+/*!
+  Returns "available" if the event is counted, otherwise the reason why it
+  is not, or 0 if the hardware counters were not requested.
+
+  @param[in] event the event, one of HardwareEvent
+*/
+const char * HardwareEventStatus(int event) {
+  if (hardwareEventStatus[event].empty()) return(0);
+  return(hardwareEventStatus[event].c_str());
+}
+
+#if defined(__linux__)
+
+/*!
+  Opens one perf_event counter.
+
+  @return the file descriptor, negative on failure with errno set
+*/
+static int OpenCounter(perf_event_attr & attr, pid_t tid, int cpu, int groupFd) {
+  return (int) syscall(__NR_perf_event_open, &attr, tid, cpu, groupFd, 0UL);
+}
+
+/*!
+  Opens the core events on one thread as a group led by the first event that
+  can be opened. On the first thread this decides which core events are
+  available, the other threads open the same events.
+
+  @param[in] tid the thread id
+  @param[in] first true for the calling thread of InitializeHardwareCounters
+
+  @return true if at least one event was opened
+*/
+static bool OpenThreadCounters(pid_t tid, bool first) {
+  ThreadCounters counters;
+  counters.numberOfEvents = 0;
+  for (int event=HW_EVENT_CYCLES; event<=HW_EVENT_LLC_MISSES; ++event) {
+    if (!first && hardwareEventStatus[event]!="available") continue;
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = (event==HW_EVENT_CYCLES) ? PERF_COUNT_HW_CPU_CYCLES :
+        (event==HW_EVENT_INSTRUCTIONS) ? PERF_COUNT_HW_INSTRUCTIONS : PERF_COUNT_HW_CACHE_MISSES;
+    attr.exclude_kernel = 1; // Counting user space only is permitted up to perf_event_paranoid 2
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    const int fd = OpenCounter(attr, tid, -1, (counters.numberOfEvents>0) ? counters.fds[0] : -1);
+    if (fd<0) {
+      if (first) hardwareEventStatus[event] = std::string("not available: ") + strerror(errno);
+      continue;
+    }
+    if (first) hardwareEventStatus[event] = "available";
+    counters.fds[counters.numberOfEvents] = fd;
+    counters.events[counters.numberOfEvents] = event;
+    ++counters.numberOfEvents;
+  }
+  if (counters.numberOfEvents==0) return(false);
+  threadCounters.push_back(counters);
+  return(true);
+}
+
+/*!
+  Returns the perf_event config of a named event of a PMU, encoded according
+  to the format description of the PMU in sysfs.
+
+  @param[in] pmu the directory of the PMU below /sys/bus/event_source/devices
+  @param[in] name the name of the event, e.g. cas_count_read
+  @param[out] config the config value
+
+  @return true on success
+*/
+static bool UncoreEventConfig(const std::string & pmu, const char * name, unsigned long long & config) {
+  std::ifstream eventFile((pmu + "/events/" + name).c_str());
+  std::string terms, term;
+  if (!std::getline(eventFile, terms)) return(false);
+  config = 0;
+  std::istringstream termStream(terms);
+  while (std::getline(termStream, term, ',')) { // e.g. event=0x04,umask=0x03
+    const size_t equal = term.find('=');
+    const std::string field = term.substr(0, equal);
+    const unsigned long long value = (equal==std::string::npos) ? 1 : strtoull(term.c_str()+equal+1, 0, 0);
+    std::ifstream formatFile((pmu + "/format/" + field).c_str());
+    std::string format;
+    int firstBit = 0;
+    if (!std::getline(formatFile, format) || sscanf(format.c_str(), "config:%d", &firstBit)!=1) return(false);
+    config |= value << firstBit;
+  }
+  return(true);
+}
+
+/*!
+  Opens the read and write CAS counters of all memory controllers of the
+  node, found as the uncore_imc PMUs of Intel processors. Uncore counters
+  count for the whole socket and require perf_event_paranoid 0 or
+  CAP_PERFMON.
+*/
+static void OpenDramCounters() {
+  const std::string devices = "/sys/bus/event_source/devices";
+  DIR * directory = opendir(devices.c_str());
+  std::string reason = "not available: no memory controller counters found";
+  for (dirent * entry = (directory!=0) ? readdir(directory) : 0; entry!=0; entry = readdir(directory)) {
+    if (strncmp(entry->d_name, "uncore_imc", 10)!=0 || strstr(entry->d_name, "free_running")!=0) continue;
+    const std::string pmu = devices + "/" + entry->d_name;
+    std::ifstream typeFile((pmu + "/type").c_str()), cpumaskFile((pmu + "/cpumask").c_str());
+    int type = -1;
+    std::string cpumask, cpu;
+    if (!(typeFile >> type) || !std::getline(cpumaskFile, cpumask)) continue;
+    const char * names[2] = {"cas_count_read", "cas_count_write"};
+    for (int k=0; k<2; ++k) {
+      perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = type;
+      unsigned long long config;
+      if (!UncoreEventConfig(pmu, names[k], config)) continue;
+      attr.config = config;
+      std::istringstream cpus(cpumask); // One cpu per socket
+      while (std::getline(cpus, cpu, ',')) {
+        const int fd = OpenCounter(attr, -1, atoi(cpu.c_str()), -1);
+        if (fd<0) reason = std::string("not available: ") + strerror(errno);
+        else dramCounters.push_back(fd);
+      }
+    }
+  }
+  if (directory!=0) closedir(directory);
+  hardwareEventStatus[HW_EVENT_DRAM_BYTES] = dramCounters.empty() ? reason : "available";
+}
+
+#endif
+
+/*!
+  Opens the hardware counters on all threads that exist at the time of the
+  call, which should be after the worker threads of the backends were
+  started. The events that cannot be opened, e.g. because the kernel does
+  not permit them, are reported as not available and not counted.
+*/
+void InitializeHardwareCounters() {
+  ResetHardwareCounters();
+#if defined(__linux__)
+  const pid_t self = (pid_t) syscall(SYS_gettid);
+  if (OpenThreadCounters(self, true)) {
+    DIR * tasks = opendir("/proc/self/task");
+    for (dirent * entry = (tasks!=0) ? readdir(tasks) : 0; entry!=0; entry = readdir(tasks)) {
+      const pid_t tid = (pid_t) atoi(entry->d_name);
+      if (tid>0 && tid!=self) OpenThreadCounters(tid, false); // Threads that exited in the meantime are skipped
+    }
+    if (tasks!=0) closedir(tasks);
+  }
+  OpenDramCounters();
+#else
+  for (int event=0; event<HPCG_NUMBER_OF_HW_EVENTS; ++event)
+    hardwareEventStatus[event] = "not available: requires Linux perf_event";
+#endif
+  HPCG_hardwareCountersEnabled = false;
+  for (int event=0; event<HPCG_NUMBER_OF_HW_EVENTS; ++event)
+    if (hardwareEventStatus[event]=="available") HPCG_hardwareCountersEnabled = true;
+}
+
+/*!
+  Closes all hardware counters.
+*/
+void FinalizeHardwareCounters() {
+  HPCG_hardwareCountersEnabled = false;
+#if defined(__linux__)
+  for (size_t t=0; t<threadCounters.size(); ++t)
+    for (int i=0; i<threadCounters[t].numberOfEvents; ++i) close(threadCounters[t].fds[i]);
+  for (size_t i=0; i<dramCounters.size(); ++i) close(dramCounters[i]);
+#endif
+  threadCounters.clear();
+  dramCounters.clear();
+}
+
+/*!
+  Reads the current value of every event, summed over all threads and
+  memory controllers.
+
+  @param[out] values the values of the HPCG_NUMBER_OF_HW_EVENTS events
+*/
+void ReadHardwareCounters(long long * values) {
+  for (int event=0; event<HPCG_NUMBER_OF_HW_EVENTS; ++event) values[event] = 0;
+#if defined(__linux__)
+  for (size_t t=0; t<threadCounters.size(); ++t) {
+    const ThreadCounters & counters = threadCounters[t];
+    uint64_t group[1+HW_EVENT_LLC_MISSES+1]; // number of events followed by their values
+    if (read(counters.fds[0], group, sizeof(group))<=0) continue;
+    for (uint64_t i=0; i<group[0] && (int)i<counters.numberOfEvents; ++i)
+      values[counters.events[i]] += (long long) group[1+i];
+  }
+  for (size_t i=0; i<dramCounters.size(); ++i) {
+    uint64_t count;
+    if (read(dramCounters[i], &count, sizeof(count))==sizeof(count))
+      values[HW_EVENT_DRAM_BYTES] += 64*(long long) count;
+  }
+#endif
+}
+
+/*!
+  Adds the events since the start of a kernel call to the counts of the
+  kernel.
+
+  @param[in] kernel the kernel, one of BenchmarkKernel
+  @param[in] A the matrix of the level the kernel was applied on, 0 for the vector kernels on the finest level
+  @param[in] start the values read by ReadHardwareCounters at the start of the call
+*/
+void RecordHardwareCounts(int kernel, const SparseMatrix * A, const long long * start) {
+  long long values[HPCG_NUMBER_OF_HW_EVENTS];
+  ReadHardwareCounters(values);
+  const int level = (A!=0 && A->level<HPCG_MAX_MG_LEVELS) ? A->level : 0;
+  for (int event=0; event<HPCG_NUMBER_OF_HW_EVENTS; ++event)
+    HPCG_hardwareCounts[level][kernel][event] += values[event]-start[event];
+}
+
+/*!
+  Sets all hardware counts of the kernels to zero.
+*/
+void ResetHardwareCounters() {
+  for (int level=0; level<HPCG_MAX_MG_LEVELS; ++level)
+    for (int kernel=0; kernel<HPCG_NUMBER_OF_KERNELS; ++kernel)
+      for (int event=0; event<HPCG_NUMBER_OF_HW_EVENTS; ++event)
+        HPCG_hardwareCounts[level][kernel][event] = 0;
+}
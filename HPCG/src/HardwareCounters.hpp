@@ -0,0 +1,53 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file HardwareCounters.hpp
+
+ HPCG data structures for the hardware performance counters of the kernels
+ */
+
+#ifndef HARDWARECOUNTERS_HPP
+#define HARDWARECOUNTERS_HPP
+
+#include <atomic>
+
+#include "hpcg.hpp"
+#include "SparseMatrix.hpp"
+#include "BenchmarkKernels.hpp"
+
+/*!
+  The hardware events counted for each kernel.
+*/
+enum HardwareEvent_ENUM {
+  HW_EVENT_CYCLES = 0, //!< core cycles of all threads
+  HW_EVENT_INSTRUCTIONS = 1, //!< retired instructions of all threads
+  HW_EVENT_LLC_MISSES = 2, //!< last level cache misses of all threads
+  HW_EVENT_DRAM_BYTES = 3, //!< bytes read and written by the memory controllers of the node
+  HPCG_NUMBER_OF_HW_EVENTS = 4
+};
+
+extern bool HPCG_hardwareCountersEnabled; //!< true if at least one hardware event is counted, set by HPCG_Init
+extern std::atomic<long long> HPCG_hardwareCounts[HPCG_MAX_MG_LEVELS][HPCG_NUMBER_OF_KERNELS][HPCG_NUMBER_OF_HW_EVENTS]; //!< counts of each level, kernel and event
+
+extern const char * HardwareEventName(int event);
+extern const char * HardwareEventStatus(int event);
+extern void InitializeHardwareCounters();
+extern void FinalizeHardwareCounters();
+extern void ReadHardwareCounters(long long * values);
+extern void RecordHardwareCounts(int kernel, const SparseMatrix * A, const long long * start);
+extern void ResetHardwareCounters();
+
+#endif // HARDWARECOUNTERS_HPP
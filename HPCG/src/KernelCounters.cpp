@@ -0,0 +1,208 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file KernelCounters.cpp
+
+ HPCG routine
+ */
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/hpx_fwd.hpp>
+#include <hpx/include/performance_counters.hpp>
+#endif
+
+#include <sstream>
+#include <string>
+
+#include "KernelCounters.hpp"
+
+bool HPCG_kernelCountersEnabled = true;
+
+KernelCounter HPCG_kernelCounters[HPCG_MAX_MG_LEVELS][HPCG_NUMBER_OF_KERNELS];
+
+static std::atomic<long long> lastKernelTime[HPCG_NUMBER_OF_KERNELS]; //!< duration of the last call of each kernel on any level (ns)
+
+/*!
+  Returns the minimum memory traffic of one call of a kernel in bytes on this
+  process: every matrix and vector entry is moved once per sweep. The
+  multigrid cycle is not counted since its traffic is recorded by the
+  kernels it calls. The halo exchange counts the values it sends and
+  receives.
+
+  @param[in] kernel the kernel, one of BenchmarkKernel
+  @param[in] A the matrix of the level, 0 for the vector kernels
+  @param[in] n the vector length of the vector kernels
+*/
+static long long KernelBytes(int kernel, const SparseMatrix * A, local_int_t n) {
+  const long long valueBytes = sizeof(double);
+  const long long indexBytes = sizeof(local_int_t);
+  switch (kernel) {
+    case KERNEL_SPMV:
+      return A->localNumberOfNonzeros*(valueBytes+indexBytes) + ((long long)A->localNumberOfRows)*(2*valueBytes+1);
+    case KERNEL_SYMGS:
+      return 2*(A->localNumberOfNonzeros*(valueBytes+indexBytes) + ((long long)A->localNumberOfRows)*(3*valueBytes+1));
+    case KERNEL_DOT:
+      return 2*valueBytes*n;
+    case KERNEL_WAXPBY:
+      return 3*valueBytes*n;
+    case KERNEL_RESTRICTION:
+    case KERNEL_PROLONGATION:
+      return ((long long)A->Ac->localNumberOfRows)*(indexBytes+3*valueBytes);
+#ifndef HPCG_NOMPI
+    case KERNEL_HALO: // The values sent and received
+      return ((long long)A->totalToBeSent+A->numberOfExternalValues)*valueBytes;
+#endif
+  }
+  return(0);
+}
+
+/*!
+  Adds a kernel call to the counters of its level.
+
+  @param[in] kernel the kernel, one of BenchmarkKernel
+  @param[in] A the matrix of the level the kernel was applied on, 0 for the vector kernels on the finest level
+  @param[in] n the vector length of the vector kernels
+  @param[in] time the duration of the call (ns)
+*/
+void RecordKernelCall(int kernel, const SparseMatrix * A, local_int_t n, long long time) {
+  const int level = (A!=0 && A->level<HPCG_MAX_MG_LEVELS) ? A->level : 0;
+  KernelCounter & counter = HPCG_kernelCounters[level][kernel];
+  ++counter.count;
+  counter.time += time;
+  counter.lastTime = time;
+  lastKernelTime[kernel] = time;
+  counter.bytes += KernelBytes(kernel, A, n);
+}
+
+/*!
+  Sets all kernel counters to zero.
+*/
+void ResetKernelCounters() {
+  for (int level=0; level<HPCG_MAX_MG_LEVELS; ++level)
+    for (int kernel=0; kernel<HPCG_NUMBER_OF_KERNELS; ++kernel) {
+      KernelCounter & counter = HPCG_kernelCounters[level][kernel];
+      counter.count = counter.time = counter.lastTime = counter.bytes = 0;
+    }
+  for (int kernel=0; kernel<HPCG_NUMBER_OF_KERNELS; ++kernel) lastKernelTime[kernel] = 0;
+}
+
+#if !defined(HPCG_NOHPX)
+
+/*!
+  The values provided by the HPX counters of each kernel.
+*/
+enum KernelCounterMetric {
+  METRIC_COUNT = 0,
+  METRIC_TIME = 1,
+  METRIC_LAST_TIME = 2,
+  METRIC_BYTES = 3,
+  NUMBER_OF_METRICS = 4
+};
+
+/*!
+  Returns the value of one metric of a kernel for the HPX counters.
+
+  @param[in] kernel the kernel, one of BenchmarkKernel
+  @param[in] level the multigrid level, -1 for the sum over all levels
+  @param[in] metric the metric, one of KernelCounterMetric
+  @param[in] reset if true the metric is set to zero after reading it
+*/
+static boost::int64_t ReadKernelCounter(int kernel, int level, int metric, bool reset) {
+  if (metric==METRIC_LAST_TIME && level<0)
+    return reset ? lastKernelTime[kernel].exchange(0) : lastKernelTime[kernel].load();
+
+  long long value = 0;
+  for (int l=0; l<HPCG_MAX_MG_LEVELS; ++l) {
+    if (level>=0 && l!=level) continue;
+    KernelCounter & counter = HPCG_kernelCounters[l][kernel];
+    std::atomic<long long> & member = (metric==METRIC_COUNT) ? counter.count :
+        (metric==METRIC_TIME) ? counter.time : (metric==METRIC_LAST_TIME) ? counter.lastTime : counter.bytes;
+    value += reset ? member.exchange(0) : member.load();
+  }
+  return value;
+}
+
+/*!
+  Installs the HPX counter types of all kernels:
+  /hpcg/<kernel>/count, /hpcg/<kernel>/time/cumulative, /hpcg/<kernel>/time/last
+  and /hpcg/<kernel>/bytes summed over all levels, and the same below
+  /hpcg/<kernel>/level<k>/ for each multigrid level k of the kernels that
+  work on a level of the hierarchy.
+*/
+static void RegisterKernelCounterTypes() {
+  static const char * kernelNames[HPCG_NUMBER_OF_KERNELS] = {"spmv", "symgs", "ddot", "waxpby", "restriction", "prolongation", "mg", "halo"};
+  static const char * metricNames[NUMBER_OF_METRICS] = {"count", "time/cumulative", "time/last", "bytes"};
+  static const char * metricHelp[NUMBER_OF_METRICS] = {"number of calls", "cumulative duration of the calls",
+      "duration of the last call", "minimum memory traffic of the calls"};
+  static const char * metricUnits[NUMBER_OF_METRICS] = {"", "ns", "ns", "bytes"};
+
+  for (int kernel=0; kernel<HPCG_NUMBER_OF_KERNELS; ++kernel) {
+    const bool perLevel = (kernel!=KERNEL_DOT && kernel!=KERNEL_WAXPBY);
+    for (int level=-1; level<(perLevel ? HPCG_MAX_MG_LEVELS : 0); ++level) {
+      for (int metric=0; metric<NUMBER_OF_METRICS; ++metric) {
+        std::stringstream name, help;
+        name << "/hpcg/" << kernelNames[kernel];
+        help << "returns the " << metricHelp[metric] << " of the HPCG kernel " << KernelName(kernel);
+        if (level>=0) {
+          name << "/level" << level;
+          help << " on multigrid level " << level;
+        }
+        name << "/" << metricNames[metric];
+        hpx::performance_counters::install_counter_type(name.str(),
+            [kernel, level, metric](bool reset) { return ReadKernelCounter(kernel, level, metric, reset); },
+            help.str(), metricUnits[metric]);
+      }
+    }
+  }
+}
+
+/*!
+  Registers the installation of the counter types as an HPX startup function,
+  so that they exist when the counters given with --hpx:print-counter are
+  created. Must be called before the HPX runtime is started.
+*/
+void RegisterKernelCounters() {
+  hpx::register_startup_function(&RegisterKernelCounterTypes);
+}
+
+#endif
+
+/*!
+  Marks the start of a benchmark phase: resets the kernel counters, the
+  hardware counts of the kernels and the HPX counters given with
+  --hpx:print-counter.
+*/
+void BeginKernelCounterPhase() {
+  ResetKernelCounters();
+  ResetHardwareCounters();
+#if !defined(HPCG_NOHPX)
+  hpx::reset_active_counters();
+#endif
+}
+
+/*!
+  Marks the end of a benchmark phase: prints the HPX counters given with
+  --hpx:print-counter, together with the description of the phase.
+
+  @param[in] description the name of the phase
+*/
+void EndKernelCounterPhase(const char * description) {
+#if !defined(HPCG_NOHPX)
+  hpx::evaluate_active_counters(false, description);
+#else
+  (void) description;
+#endif
+}
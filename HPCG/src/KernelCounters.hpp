@@ -0,0 +1,100 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file KernelCounters.hpp
+
+ HPCG data structure for the per-kernel counters
+ */
+
+#ifndef KERNELCOUNTERS_HPP
+#define KERNELCOUNTERS_HPP
+
+#include <atomic>
+
+#include "hpcg.hpp"
+#include "SparseMatrix.hpp"
+#include "BenchmarkKernels.hpp"
+#include "Trace.hpp"
+#include "HardwareCounters.hpp"
+
+/*!
+  Statistics of the calls of one kernel on one multigrid level. The members
+  are atomic since the instances of the ensemble call the kernels
+  concurrently.
+*/
+struct KernelCounter_STRUCT {
+  std::atomic<long long> count; //!< number of calls
+  std::atomic<long long> time; //!< cumulative duration of the calls (ns)
+  std::atomic<long long> lastTime; //!< duration of the last call (ns)
+  std::atomic<long long> bytes; //!< cumulative minimum memory traffic of the calls
+};
+typedef struct KernelCounter_STRUCT KernelCounter;
+
+/*!
+  State of a kernel call between StartKernelCounter and StopKernelCounter.
+*/
+struct KernelCall_STRUCT {
+  long long start; //!< start time (ns), 0 if neither the counters nor the trace are enabled
+  TraceRegion outer; //!< the trace region enclosing the call
+  long long hardware[HPCG_NUMBER_OF_HW_EVENTS]; //!< hardware counters at the start of the call
+};
+typedef struct KernelCall_STRUCT KernelCall;
+
+extern bool HPCG_kernelCountersEnabled; //!< true if the kernels record their calls
+extern KernelCounter HPCG_kernelCounters[HPCG_MAX_MG_LEVELS][HPCG_NUMBER_OF_KERNELS]; //!< counters of each level and kernel
+
+extern void RecordKernelCall(int kernel, const SparseMatrix * A, local_int_t n, long long time);
+extern void ResetKernelCounters();
+extern void BeginKernelCounterPhase();
+extern void EndKernelCounterPhase(const char * description);
+#if !defined(HPCG_NOHPX)
+extern void RegisterKernelCounters();
+#endif
+
+/*!
+  Starts the record of a kernel call, to be completed by StopKernelCounter.
+
+  @param[in] kernel the kernel, one of BenchmarkKernel
+  @param[in] A the matrix of the level the kernel is applied on, 0 for the vector kernels
+*/
+inline KernelCall StartKernelCounter(int kernel, const SparseMatrix * A) {
+  KernelCall call = {0, {0, -1}, {}};
+  if (HPCG_traceEnabled) call.outer = EnterTraceRegion(KernelName(kernel), (A!=0) ? A->level : -1);
+  if (HPCG_kernelCountersEnabled || HPCG_traceEnabled) call.start = TraceTime();
+  if (HPCG_hardwareCountersEnabled) ReadHardwareCounters(call.hardware);
+  return(call);
+}
+
+/*!
+  Records a kernel call in the counters, the hardware counters and the trace.
+
+  @param[in] kernel the kernel, one of BenchmarkKernel
+  @param[in] A the matrix of the level the kernel was applied on, 0 for the vector kernels
+  @param[in] n the vector length of the vector kernels
+  @param[in] call the value returned by StartKernelCounter at the start of the call
+*/
+inline void StopKernelCounter(int kernel, const SparseMatrix * A, local_int_t n, const KernelCall & call) {
+  if (!HPCG_kernelCountersEnabled && !HPCG_traceEnabled) return;
+  if (HPCG_hardwareCountersEnabled) RecordHardwareCounts(kernel, A, call.hardware);
+  const long long end = TraceTime();
+  if (HPCG_kernelCountersEnabled) RecordKernelCall(kernel, A, n, end-call.start);
+  if (HPCG_traceEnabled) {
+    RecordTraceEvent("kernel", KernelName(kernel), (A!=0) ? A->level : -1, call.start, end);
+    LeaveTraceRegion(call.outer);
+  }
+}
+
+#endif // KERNELCOUNTERS_HPP
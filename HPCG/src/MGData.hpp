@@ -22,12 +22,22 @@
 #define MGDATA_HPP
 
 #include <cassert>
-#include "SparseMatrix.hpp"
 #include "Vector.hpp"
 
+/*!
+  The multigrid cycles that can be selected for the optimized preconditioner.
+*/
+enum MGCycle_ENUM {
+  MG_CYCLE_V = 0, //!< one coarse grid correction per level (the reference cycle)
+  MG_CYCLE_W = 1, //!< two coarse grid corrections per level
+  MG_CYCLE_F = 2  //!< an F-cycle followed by a V-cycle on the coarse grid
+};
+typedef enum MGCycle_ENUM MGCycle;
+
 struct MGData_STRUCT {
   int numberOfPresmootherSteps; // Call ComputeSYMGS this many times prior to coarsening
   int numberOfPostsmootherSteps; // Call ComputeSYMGS this many times after coarsening
+  int cycleType; //!< cycle used by the optimized ComputeMG, one of MGCycle; ComputeMG_ref always uses a V-cycle
   local_int_t * f2cOperator; //!< 1D array containing the fine operator local IDs that will be injected into coarse space.
   Vector * rc; // coarse grid residual vector
   Vector * xc; // coarse grid solution vector
@@ -50,6 +60,7 @@ typedef struct MGData_STRUCT MGData;
 inline void InitializeMGData(local_int_t * f2cOperator, Vector * rc, Vector * xc, Vector * Axf, MGData & data) {
   data.numberOfPresmootherSteps = 1;
   data.numberOfPostsmootherSteps = 1;
+  data.cycleType = MG_CYCLE_V;
   data.f2cOperator = f2cOperator; // Space for injection operator
   data.rc = rc;
   data.xc = xc;
@@ -57,6 +68,32 @@ inline void InitializeMGData(local_int_t * f2cOperator, Vector * rc, Vector * xc
   return;
 }
 
+/*!
+ Returns a printable name for the multigrid cycle.
+ */
+inline const char * MGCycleName(int cycleType) {
+  switch (cycleType) {
+    case MG_CYCLE_V: return "V";
+    case MG_CYCLE_W: return "W";
+    case MG_CYCLE_F: return "F";
+  }
+  return "Unknown";
+}
+
+/*!
+ Returns how often a level of the hierarchy is visited by one application of the given cycle.
+
+ @param[in] cycleType the multigrid cycle, one of MGCycle
+ @param[in] level the level, 0 is the finest level
+ */
+inline double MGCycleLevelVisits(int cycleType, int level) {
+  switch (cycleType) {
+    case MG_CYCLE_W: return (double)(1LL << level);
+    case MG_CYCLE_F: return (double)(level+1);
+  }
+  return 1.0;
+}
+
 /*!
  Destructor for the CG vectors data.
 
@@ -0,0 +1,410 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file MatrixFormat.cpp
+
+ HPCG routine
+ */
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/hpx_fwd.hpp>
+#endif
+
+#ifndef HPCG_NOMPI
+#include <mpi.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "MatrixFormat.hpp"
+#include "Backend.hpp"
+#include "ComputeSPMV.hpp"
+#include "ComputeSYMGS.hpp"
+#include "KernelCounters.hpp"
+#include "mytimer.hpp"
+
+int HPCG_matrixFormat = MATRIX_FORMAT_AUTO;
+
+/*!
+  Returns the name of a matrix format as used on the command line.
+
+  @param[in] format the format, one of MatrixFormat
+*/
+const char * MatrixFormatName(int format) {
+  switch (format) {
+    case MATRIX_FORMAT_CSR: return "csr";
+    case MATRIX_FORMAT_SELL: return "sell";
+    case MATRIX_FORMAT_AUTO: return "auto";
+    default: return "rows";
+  }
+}
+
+/*!
+  Returns the matrix format of the given name.
+
+  @param[in] name the name of the format as returned by MatrixFormatName
+
+  @return the format, or -1 if the name is unknown
+*/
+int ParseMatrixFormat(const char * name) {
+  for (int format=MATRIX_FORMAT_ROWS; format<=MATRIX_FORMAT_AUTO; ++format)
+    if (strcmp(name, MatrixFormatName(format))==0) return(format);
+  return(-1);
+}
+
+/*!
+  Returns the format of the level of A, MATRIX_FORMAT_ROWS if none was
+  selected.
+
+  @param[in] A the matrix of the level
+*/
+int LevelMatrixFormat(const SparseMatrix & A) {
+  const MatrixFormatData * const data = (const MatrixFormatData *) A.optimizationData;
+  return (data!=0) ? data->format : MATRIX_FORMAT_ROWS;
+}
+
+/*!
+  Copies the rows of A into contiguous CSR arrays, in the order of the thread
+  subdomains, and points the rows of A into them. Each subdomain is copied by
+  the thread that works on it in the SpMV, so that its pages are placed close
+  to that thread.
+
+  @param[inout] A the matrix, its rows are moved into data
+  @param[inout] data the format data receiving the CSR arrays
+*/
+static void BuildCSR(SparseMatrix & A, MatrixFormatData & data) {
+
+  const local_int_t nrow = A.localNumberOfRows;
+  data.rowStart = new local_int_t[nrow];
+  local_int_t numberOfNonzeros = 0;
+  for (local_int_t k=0; k<nrow; ++k) {
+    const local_int_t i = A.subdomainRows[k];
+    data.rowStart[i] = numberOfNonzeros;
+    numberOfNonzeros += A.nonzerosInRow[i];
+  }
+  data.columns = new local_int_t[numberOfNonzeros];
+  data.values = new double[numberOfNonzeros];
+
+  BackendParallelFor(HPCG_backends.spmv, A.numberOfSubdomains, [&A, &data](local_int_t s) {
+    for (local_int_t k=A.subdomainStart[s]; k<A.subdomainStart[s+1]; k++) {
+      const local_int_t i = A.subdomainRows[k];
+      const int cur_nnz = A.nonzerosInRow[i];
+      double * const cur_vals = data.values + data.rowStart[i];
+      local_int_t * const cur_inds = data.columns + data.rowStart[i];
+      for (int j=0; j<cur_nnz; ++j) {
+        cur_vals[j] = A.matrixValues[i][j];
+        cur_inds[j] = A.mtxIndL[i][j];
+      }
+      A.matrixDiagonal[i] = cur_vals + (A.matrixDiagonal[i] - A.matrixValues[i]);
+      A.matrixValues[i] = cur_vals;
+      A.mtxIndL[i] = cur_inds;
+    }
+  });
+  return;
+}
+
+/*!
+  Copies the values of the CSR arrays into the slices of the sliced ELLPACK
+  format, the padding of a slice gets the value zero.
+
+  @param[in]    A the matrix
+  @param[inout] data the format data with the CSR arrays and the slices
+*/
+static void FillSlices(const SparseMatrix & A, MatrixFormatData & data) {
+
+  BackendParallelFor(HPCG_backends.spmv, A.numberOfSubdomains, [&A, &data](local_int_t s) {
+    for (local_int_t slice=data.subdomainSliceStart[s]; slice<data.subdomainSliceStart[s+1]; ++slice) {
+      const local_int_t first = data.sliceStart[slice];
+      const local_int_t width = (data.sliceStart[slice+1]-first)/HPCG_SELL_SLICE_SIZE;
+      for (int r=0; r<HPCG_SELL_SLICE_SIZE; ++r) {
+        const local_int_t i = data.sliceRows[slice*HPCG_SELL_SLICE_SIZE+r];
+        const int cur_nnz = (i>=0) ? A.nonzerosInRow[i] : 0;
+        for (local_int_t j=0; j<width; ++j) {
+          const local_int_t entry = first+j*HPCG_SELL_SLICE_SIZE+r;
+          if (j<cur_nnz) {
+            data.sliceValues[entry] = data.values[data.rowStart[i]+j];
+            data.sliceColumns[entry] = data.columns[data.rowStart[i]+j];
+          } else {
+            data.sliceValues[entry] = 0.0;
+            data.sliceColumns[entry] = (i>=0) ? i : 0; // Any valid column, the value is zero
+          }
+        }
+      }
+    }
+  });
+  return;
+}
+
+/*!
+  Builds the slices of the sliced ELLPACK format from the CSR arrays. Each
+  slice holds HPCG_SELL_SLICE_SIZE consecutive rows of one thread subdomain
+  and is as wide as its longest row.
+
+  @param[in]    A the matrix
+  @param[inout] data the format data with the CSR arrays, receives the slices
+*/
+static void BuildSlices(const SparseMatrix & A, MatrixFormatData & data) {
+
+  const int numberOfSubdomains = A.numberOfSubdomains;
+  data.subdomainSliceStart = new local_int_t[numberOfSubdomains+1];
+  data.subdomainSliceStart[0] = 0;
+  for (int s=0; s<numberOfSubdomains; ++s) {
+    const local_int_t rows = A.subdomainStart[s+1]-A.subdomainStart[s];
+    data.subdomainSliceStart[s+1] = data.subdomainSliceStart[s] + (rows+HPCG_SELL_SLICE_SIZE-1)/HPCG_SELL_SLICE_SIZE;
+  }
+  const local_int_t numberOfSlices = data.subdomainSliceStart[numberOfSubdomains];
+  data.numberOfSlices = numberOfSlices;
+  data.sliceStart = new local_int_t[numberOfSlices+1];
+  data.sliceRows = new local_int_t[numberOfSlices*HPCG_SELL_SLICE_SIZE];
+
+  data.sliceStart[0] = 0;
+  for (int s=0; s<numberOfSubdomains; ++s)
+    for (local_int_t slice=data.subdomainSliceStart[s]; slice<data.subdomainSliceStart[s+1]; ++slice) {
+      int width = 0;
+      for (int r=0; r<HPCG_SELL_SLICE_SIZE; ++r) {
+        const local_int_t k = A.subdomainStart[s] + (slice-data.subdomainSliceStart[s])*HPCG_SELL_SLICE_SIZE + r;
+        const local_int_t i = (k<A.subdomainStart[s+1]) ? A.subdomainRows[k] : -1;
+        data.sliceRows[slice*HPCG_SELL_SLICE_SIZE+r] = i;
+        if (i>=0) width = std::max(width, (int) A.nonzerosInRow[i]);
+      }
+      data.sliceStart[slice+1] = data.sliceStart[slice] + width*HPCG_SELL_SLICE_SIZE;
+    }
+  data.sliceColumns = new local_int_t[data.sliceStart[numberOfSlices]];
+  data.sliceValues = new double[data.sliceStart[numberOfSlices]];
+  FillSlices(A, data);
+  return;
+}
+
+/*!
+  Deallocates the slices of the sliced ELLPACK format.
+
+  @param[inout] data the format data
+*/
+static void DeleteSlices(MatrixFormatData & data) {
+
+  if (data.subdomainSliceStart) { delete [] data.subdomainSliceStart; data.subdomainSliceStart = 0; }
+  if (data.sliceStart) { delete [] data.sliceStart; data.sliceStart = 0; }
+  if (data.sliceRows) { delete [] data.sliceRows; data.sliceRows = 0; }
+  if (data.sliceColumns) { delete [] data.sliceColumns; data.sliceColumns = 0; }
+  if (data.sliceValues) { delete [] data.sliceValues; data.sliceValues = 0; }
+  data.numberOfSlices = 0;
+  return;
+}
+
+/*!
+  Returns the average time of one call of a kernel. The kernel is called once
+  to warm up and once to estimate the number of calls that fit into
+  HPCG_FORMAT_CALIBRATION_TIME. All processes make the same number of calls,
+  since the kernels may exchange halo values.
+
+  @param[in] call the kernel call
+
+  @return the time of one call (sec)
+*/
+template <typename F>
+static double TimeCalls(const F & call) {
+
+  call();
+  double t0 = mytimer();
+  call();
+  const double once = mytimer() - t0;
+  int repetitions = (once*1000.0>HPCG_FORMAT_CALIBRATION_TIME) ? (int)(HPCG_FORMAT_CALIBRATION_TIME/once) : 1000;
+  if (repetitions<1) repetitions = 1;
+#ifndef HPCG_NOMPI
+  MPI_Allreduce(MPI_IN_PLACE, &repetitions, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+#endif
+  t0 = mytimer();
+  for (int i=0; i<repetitions; ++i) call();
+  return((mytimer() - t0)/repetitions);
+}
+
+/*!
+  Measures the SpMV and the smoother of a level in its current format.
+
+  @param[in]    A the matrix of the level
+  @param[inout] data the format data, receives the times of the current format
+*/
+static void CalibrateFormat(const SparseMatrix & A, MatrixFormatData & data) {
+
+  Vector x, r;
+  InitializeVector(x, A.localNumberOfColumns);
+  InitializeVector(r, A.localNumberOfRows);
+  for (local_int_t i=0; i<x.localLength; ++i) x.values[i] = 1.0; // Does not draw from the random numbers of the benchmark
+  data.spmvTime[data.format] = TimeCalls([&A, &x, &r]() { ComputeSPMV(A, x, r); });
+  ZeroVector(x);
+  data.smootherTime[data.format] = TimeCalls([&A, &x, &r]() { ComputeSYMGS(A, r, x); });
+  DeleteVector(x);
+  DeleteVector(r);
+  return;
+}
+
+/*!
+  Converts the matrix of one multigrid level into the given format, or into
+  the fastest format if format is MATRIX_FORMAT_AUTO.
+
+  The fastest format is selected by timing the SpMV and the smoother of the
+  level in each format for a short time and weighting them with their
+  number of calls per multigrid cycle: the smoother steps of the level, one
+  SpMV for the residual on all but the coarsest level, and one more for CG on
+  the finest level. The times are the largest over all processes, so that
+  all processes select the same format. While the formats are compared the
+  level is held in all of them at once.
+
+  Rows that are read from a memory-mapped problem cache are left in place,
+  rows that were allocated by GenerateProblem are freed once they have been
+  moved into the CSR arrays.
+
+  @param[inout] A the matrix of the level, its optimizationData receives the format data
+  @param[in]    format the requested format, one of MatrixFormat
+
+  @return the format of the level
+*/
+int SelectMatrixFormat(SparseMatrix & A, int format) {
+
+  if (A.optimizationData!=0) return(LevelMatrixFormat(A)); // Already selected
+
+  MatrixFormatData * const data = new MatrixFormatData;
+  memset(data, 0, sizeof(MatrixFormatData));
+  data->format = MATRIX_FORMAT_ROWS;
+  data->calibrated = format==MATRIX_FORMAT_AUTO;
+  A.optimizationData = data;
+
+  // The calibration calls are not part of the statistics of the kernels and smoothers
+  const bool countersEnabled = HPCG_kernelCountersEnabled;
+  HPCG_kernelCountersEnabled = false;
+  double smootherTime = 0.0;
+  int smootherCalls = 0;
+  if (A.smootherData!=0) {
+    smootherTime = A.smootherData->time;
+    smootherCalls = A.smootherData->numberOfCalls;
+  }
+
+  const local_int_t nrow = A.localNumberOfRows;
+  std::vector<double *> rowValues(A.matrixValues, A.matrixValues+nrow);
+  std::vector<local_int_t *> rowColumns(A.mtxIndL, A.mtxIndL+nrow);
+  std::vector<double *> rowDiagonal(A.matrixDiagonal, A.matrixDiagonal+nrow);
+
+  if (data->calibrated) CalibrateFormat(A, *data);
+  if (format!=MATRIX_FORMAT_ROWS) {
+    BuildCSR(A, *data);
+    data->format = MATRIX_FORMAT_CSR;
+    if (data->calibrated) CalibrateFormat(A, *data);
+    if (format!=MATRIX_FORMAT_CSR) {
+      BuildSlices(A, *data);
+      data->format = MATRIX_FORMAT_SELL;
+      if (data->calibrated) CalibrateFormat(A, *data);
+    }
+  }
+
+  int selected = data->format;
+  if (data->calibrated) {
+#ifndef HPCG_NOMPI
+    MPI_Allreduce(MPI_IN_PLACE, data->spmvTime, HPCG_NUMBER_OF_MATRIX_FORMATS, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    MPI_Allreduce(MPI_IN_PLACE, data->smootherTime, HPCG_NUMBER_OF_MATRIX_FORMATS, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+#endif
+    const double spmvCalls = (A.mgData!=0 ? 1.0 : 0.0) + (A.level==0 ? 1.0 : 0.0);
+    const double smootherSteps = (A.mgData!=0) ? A.mgData->numberOfPresmootherSteps+A.mgData->numberOfPostsmootherSteps : 1.0;
+    double fastest = 0.0;
+    for (int f=0; f<HPCG_NUMBER_OF_MATRIX_FORMATS; ++f) {
+      const double time = spmvCalls*data->spmvTime[f] + smootherSteps*data->smootherTime[f];
+      if (f==0 || time<fastest) {
+        fastest = time;
+        selected = f;
+      }
+    }
+  }
+
+  if (selected!=MATRIX_FORMAT_SELL) DeleteSlices(*data);
+  if (selected==MATRIX_FORMAT_ROWS && data->format!=MATRIX_FORMAT_ROWS) { // Back to the original rows
+    std::copy(rowValues.begin(), rowValues.end(), A.matrixValues);
+    std::copy(rowColumns.begin(), rowColumns.end(), A.mtxIndL);
+    std::copy(rowDiagonal.begin(), rowDiagonal.end(), A.matrixDiagonal);
+    delete [] data->rowStart; data->rowStart = 0;
+    delete [] data->columns; data->columns = 0;
+    delete [] data->values; data->values = 0;
+  } else if (selected!=MATRIX_FORMAT_ROWS && A.problemCacheData==0) {
+    for (local_int_t i=0; i<nrow; ++i) {
+      delete [] rowValues[i];
+      delete [] rowColumns[i];
+    }
+  }
+  data->format = selected;
+
+  HPCG_kernelCountersEnabled = countersEnabled;
+  if (A.smootherData!=0) {
+    A.smootherData->time = smootherTime;
+    A.smootherData->numberOfCalls = smootherCalls;
+  }
+  return(selected);
+}
+
+/*!
+  Returns the bytes of the CSR arrays and slices of a level, 0 in the rows
+  format.
+
+  @param[in] A the matrix of the level
+*/
+double MatrixFormatBytes(const SparseMatrix & A) {
+
+  const MatrixFormatData * const data = (const MatrixFormatData *) A.optimizationData;
+  if (data==0) return 0.0;
+  double bytes = sizeof(MatrixFormatData);
+  if (data->rowStart) bytes += ((double) A.localNumberOfRows)*sizeof(local_int_t) + ((double) A.localNumberOfNonzeros)*(sizeof(local_int_t)+sizeof(double));
+  if (data->sliceStart) bytes += (A.numberOfSubdomains+1.0+data->numberOfSlices+1.0+((double) data->numberOfSlices)*HPCG_SELL_SLICE_SIZE)*sizeof(local_int_t)
+      + ((double) data->sliceStart[data->numberOfSlices])*(sizeof(local_int_t)+sizeof(double));
+  return bytes;
+}
+
+/*!
+  Copies modified matrix values, e.g. by ReplaceMatrixDiagonal, into the
+  slices of the sliced ELLPACK format. The other formats use the rows of the
+  matrix directly.
+
+  @param[inout] A the matrix whose values were modified
+*/
+void UpdateMatrixFormat(SparseMatrix & A) {
+
+  MatrixFormatData * const data = (MatrixFormatData *) A.optimizationData;
+  if (data!=0 && data->format==MATRIX_FORMAT_SELL) FillSlices(A, *data);
+  return;
+}
+
+/*!
+  Deallocates the format data of a level. The rows of the CSR and sliced
+  ELLPACK formats are part of the format data, the row pointers of the
+  matrix are cleared so that DeleteMatrix does not free them again.
+
+  @param[inout] A the matrix whose format data is deallocated
+*/
+void DeleteMatrixFormat(SparseMatrix & A) {
+
+  MatrixFormatData * const data = (MatrixFormatData *) A.optimizationData;
+  if (data==0) return;
+  if (data->format!=MATRIX_FORMAT_ROWS)
+    for (local_int_t i=0; i<A.localNumberOfRows; ++i) {
+      A.matrixValues[i] = 0;
+      A.mtxIndL[i] = 0;
+      A.matrixDiagonal[i] = 0;
+    }
+  DeleteSlices(*data);
+  if (data->rowStart) delete [] data->rowStart;
+  if (data->columns) delete [] data->columns;
+  if (data->values) delete [] data->values;
+  delete data;
+  A.optimizationData = 0;
+  return;
+}
@@ -0,0 +1,128 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file MatrixFormat.hpp
+
+ HPCG data structures for the storage formats of the sparse matrix
+ */
+
+#ifndef MATRIXFORMAT_HPP
+#define MATRIXFORMAT_HPP
+
+#include "SparseMatrix.hpp"
+
+/*!
+  The storage formats of the matrix of a multigrid level.
+*/
+enum MatrixFormat_ENUM {
+  MATRIX_FORMAT_ROWS = 0, //!< one array of values and column indices per row, as built by GenerateProblem
+  MATRIX_FORMAT_CSR = 1, //!< compressed sparse rows, all rows in one array in the order of the thread subdomains
+  MATRIX_FORMAT_SELL = 2, //!< sliced ELLPACK for the SpMV, the rows are kept in CSR for the other kernels
+  MATRIX_FORMAT_AUTO = 3 //!< the fastest format of each level, selected by OptimizeProblem
+};
+typedef enum MatrixFormat_ENUM MatrixFormat;
+
+#define HPCG_NUMBER_OF_MATRIX_FORMATS 3 //!< number of formats that can be selected for a level
+#define HPCG_SELL_SLICE_SIZE 8 //!< number of rows of a slice of the sliced ELLPACK format
+#define HPCG_FORMAT_CALIBRATION_TIME 0.01 //!< time spent on each kernel and format of a level to select the format (sec)
+
+/*!
+  The format of a level and the times measured to select it, held in the
+  optimizationData member of the matrix. In the CSR and sliced ELLPACK
+  formats the row pointers of the matrix (matrixValues, mtxIndL and
+  matrixDiagonal) point into the CSR arrays, so that all kernels that work on
+  rows use the same storage.
+*/
+struct MatrixFormatData_STRUCT {
+  int format; //!< the format of the level, one of MatrixFormat
+  int calibrated; //!< 1 if the format was selected by timing the kernels, 0 if it was requested
+  local_int_t * rowStart; //!< offset of the first entry of each row in columns and values
+  local_int_t * columns; //!< column indices of all rows
+  double * values; //!< values of all rows
+  local_int_t numberOfSlices; //!< number of slices of the sliced ELLPACK format
+  local_int_t * subdomainSliceStart; //!< first slice of each thread subdomain, numberOfSubdomains+1 entries
+  local_int_t * sliceStart; //!< offset of each slice in sliceColumns and sliceValues, numberOfSlices+1 entries
+  local_int_t * sliceRows; //!< HPCG_SELL_SLICE_SIZE rows of each slice, -1 for padding
+  local_int_t * sliceColumns; //!< column indices of the slices, stored column by column
+  double * sliceValues; //!< values of the slices, stored column by column and padded with zeros
+  double spmvTime[HPCG_NUMBER_OF_MATRIX_FORMATS]; //!< calibrated time of one SpMV in each format (sec)
+  double smootherTime[HPCG_NUMBER_OF_MATRIX_FORMATS]; //!< calibrated time of one smoother application in each format (sec)
+};
+typedef struct MatrixFormatData_STRUCT MatrixFormatData;
+
+extern int HPCG_matrixFormat; //!< the requested format of all levels, one of MatrixFormat, set by HPCG_Init
+
+extern const char * MatrixFormatName(int format);
+extern int ParseMatrixFormat(const char * name);
+extern int LevelMatrixFormat(const SparseMatrix & A);
+extern int SelectMatrixFormat(SparseMatrix & A, int format);
+extern double MatrixFormatBytes(const SparseMatrix & A);
+
+/*!
+  Computes y = Ax for the rows of one thread subdomain of A in the format of
+  the level. The entries of each row are added in the same order in all
+  formats, so the result does not depend on the format.
+
+  @param[in]  A the known system matrix
+  @param[in]  s the thread subdomain
+  @param[in]  xv the input vector, including the halo values
+  @param[out] yv the output vector
+*/
+inline void ComputeSubdomainSPMV(const SparseMatrix & A, local_int_t s, const double * const xv, double * const yv) {
+
+  const MatrixFormatData * const data = (const MatrixFormatData *) A.optimizationData;
+  if (data!=0 && data->format==MATRIX_FORMAT_SELL) {
+    for (local_int_t slice=data->subdomainSliceStart[s]; slice<data->subdomainSliceStart[s+1]; ++slice) {
+      const local_int_t first = data->sliceStart[slice];
+      const local_int_t width = (data->sliceStart[slice+1]-first)/HPCG_SELL_SLICE_SIZE;
+      const double * const cur_vals = data->sliceValues + first;
+      const local_int_t * const cur_inds = data->sliceColumns + first;
+      double sum[HPCG_SELL_SLICE_SIZE] = {};
+      for (local_int_t j=0; j<width; ++j)
+        for (int r=0; r<HPCG_SELL_SLICE_SIZE; ++r)
+          sum[r] += cur_vals[j*HPCG_SELL_SLICE_SIZE+r]*xv[cur_inds[j*HPCG_SELL_SLICE_SIZE+r]];
+      const local_int_t * const rows = data->sliceRows + slice*HPCG_SELL_SLICE_SIZE;
+      for (int r=0; r<HPCG_SELL_SLICE_SIZE; ++r)
+        if (rows[r]>=0) yv[rows[r]] = sum[r];
+    }
+    return;
+  }
+  if (data!=0 && data->format==MATRIX_FORMAT_CSR) {
+    for (local_int_t k=A.subdomainStart[s]; k<A.subdomainStart[s+1]; k++) {
+      const local_int_t i = A.subdomainRows[k];
+      const double * const cur_vals = data->values + data->rowStart[i];
+      const local_int_t * const cur_inds = data->columns + data->rowStart[i];
+      const int cur_nnz = A.nonzerosInRow[i];
+      double sum = 0.0;
+      for (int j=0; j< cur_nnz; j++)
+        sum += cur_vals[j]*xv[cur_inds[j]];
+      yv[i] = sum;
+    }
+    return;
+  }
+  for (local_int_t k=A.subdomainStart[s]; k<A.subdomainStart[s+1]; k++) {
+    const local_int_t i = A.subdomainRows[k];
+    double sum = 0.0;
+    const double * const cur_vals = A.matrixValues[i];
+    const local_int_t * const cur_inds = A.mtxIndL[i];
+    const int cur_nnz = A.nonzerosInRow[i];
+
+    for (int j=0; j< cur_nnz; j++)
+      sum += cur_vals[j]*xv[cur_inds[j]];
+    yv[i] = sum;
+  }
+}
+
+#endif // MATRIXFORMAT_HPP
@@ -0,0 +1,278 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file MemoryUsage.cpp
+
+ HPCG routine
+ */
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/hpx_fwd.hpp>
+#endif
+
+#ifndef HPCG_NOMPI
+#include <mpi.h>
+#endif
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+#include <cmath>
+#include <cstdio>
+#include <utility>
+
+#include "MemoryUsage.hpp"
+#include "MatrixFormat.hpp"
+#include "MGData.hpp"
+#include "SmootherData.hpp"
+
+static const int allocatedNonzerosPerRow = 27; //!< GenerateProblem allocates every row for the full stencil
+static const double mapNodeBytes = sizeof(std::pair<const global_int_t, local_int_t>) + 4*sizeof(void *); //!< estimated size of one node of a std::map
+
+/*!
+  Returns the name of a memory component as used in the report.
+
+  @param[in] component the component, one of MemoryComponent
+*/
+const char * MemoryComponentName(int component) {
+  switch (component) {
+    case MEMORY_MATRIX: return "Matrix";
+    case MEMORY_MAPS: return "Index maps";
+    case MEMORY_HALO: return "Halo exchange";
+    case MEMORY_MGDATA: return "Multigrid data";
+    case MEMORY_SMOOTHER: return "Smoother data";
+    case MEMORY_CGDATA: return "CG data";
+    case MEMORY_VECTORS: return "Problem vectors";
+  }
+  return "Unknown";
+}
+
+/*!
+  Returns the bytes of the values of a vector, 0 for a missing vector.
+*/
+static double VectorBytes(const Vector * v) {
+  return (v!=0) ? ((double) v->paddedLength)*sizeof(double) : 0.0;
+}
+
+/*!
+  Adds the memory of one level of the hierarchy to the components.
+
+  @param[in]    A the matrix of the level
+  @param[inout] bytes the bytes of each component
+*/
+static void AddLevelBytes(const SparseMatrix & A, double bytes[HPCG_NUMBER_OF_MEMORY_COMPONENTS]) {
+  const double n = A.localNumberOfRows;
+
+  // The row pointers always belong to the matrix, the rows themselves may be in the format data or the mapped cache file
+  bytes[MEMORY_MATRIX] += n*(1 + 4*sizeof(double *));
+  if (A.problemCacheData!=0) {
+    bytes[MEMORY_MATRIX] += A.problemCacheSize;
+  } else {
+    bytes[MEMORY_MATRIX] += n*allocatedNonzerosPerRow*sizeof(global_int_t);
+    if (LevelMatrixFormat(A)==MATRIX_FORMAT_ROWS) bytes[MEMORY_MATRIX] += n*allocatedNonzerosPerRow*(sizeof(double)+sizeof(local_int_t));
+  }
+  bytes[MEMORY_MATRIX] += MatrixFormatBytes(A);
+
+  bytes[MEMORY_MAPS] += ((double) A.localToGlobalMap.capacity())*sizeof(global_int_t) + A.globalToLocalMap.size()*mapNodeBytes
+      + (n+A.numberOfSubdomains+1)*sizeof(local_int_t);
+
+#ifndef HPCG_NOMPI
+  bytes[MEMORY_HALO] += ((double) A.totalToBeSent)*(sizeof(local_int_t)+sizeof(double)) + ((double) A.numberOfExternalValues)*sizeof(double)
+      + ((double) A.numberOfSendNeighbors)*(sizeof(int)+2*sizeof(local_int_t)+2*sizeof(MPI_Request));
+#endif
+
+  if (A.mgData!=0) {
+    bytes[MEMORY_MGDATA] += n*sizeof(local_int_t) + VectorBytes(A.mgData->rc) + VectorBytes(A.mgData->xc) + VectorBytes(A.mgData->Axf);
+  }
+
+  const SmootherData * const s = A.smootherData;
+  if (s!=0) {
+    bytes[MEMORY_SMOOTHER] += VectorBytes(s->invDiagonal) + VectorBytes(s->residual) + VectorBytes(s->direction)
+        + VectorBytes(s->Ad) + VectorBytes(s->previous);
+    if (s->blockStart!=0) bytes[MEMORY_SMOOTHER] += (s->numberOfBlocks+1+n)*sizeof(local_int_t) + n*sizeof(int);
+    if (s->colorStart!=0) bytes[MEMORY_SMOOTHER] += (s->numberOfColors+1+n)*sizeof(local_int_t);
+    if (s->factor!=0) bytes[MEMORY_SMOOTHER] += ((double) s->factorRows)*(s->factorBandwidth+2)*sizeof(double);
+    if (s->gatherCounts!=0) bytes[MEMORY_SMOOTHER] += (2*A.geom->size+1)*sizeof(int);
+    if (s->gatherRows!=0) bytes[MEMORY_SMOOTHER] += ((double) s->factorRows)*(sizeof(local_int_t)+sizeof(double));
+  }
+}
+
+/*!
+  Returns the physical memory of this host in bytes, 0 if unknown.
+*/
+static double HostMemory() {
+#if !defined(_WIN32) && defined(_SC_PHYS_PAGES) && defined(_SC_PAGESIZE)
+  const long pages = sysconf(_SC_PHYS_PAGES), pageSize = sysconf(_SC_PAGESIZE);
+  if (pages>0 && pageSize>0) return ((double) pages)*pageSize;
+#endif
+  return 0.0;
+}
+
+/*!
+  Returns the number of NUMA nodes of this host and the memory of the
+  smallest one, as listed by Linux in /sys/devices/system/node. Without that
+  information the host is treated as a single node.
+
+  @param[out] nodeMemory the physical memory of the smallest NUMA node (bytes)
+*/
+static int NumaNodes(double & nodeMemory) {
+  int nodes = 0;
+  nodeMemory = 0.0;
+  for (int node=0; node<1024; ++node) {
+    char filename[64];
+    snprintf(filename, sizeof(filename), "/sys/devices/system/node/node%d/meminfo", node);
+    FILE * file = fopen(filename, "r");
+    if (file==0) continue; // Node numbers need not be contiguous
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+      int id = 0;
+      long long kilobytes = 0;
+      if (sscanf(line, "Node %d MemTotal: %lld kB", &id, &kilobytes)==2) {
+        const double bytes = 1024.0*kilobytes;
+        if (nodes==0 || bytes<nodeMemory) nodeMemory = bytes;
+        ++nodes;
+        break;
+      }
+    }
+    fclose(file);
+  }
+  if (nodes==0) {
+    nodeMemory = HostMemory();
+    nodes = 1;
+  }
+  return nodes;
+}
+
+/*!
+  Returns the sum of value over the processes of this host and the number of
+  these processes, the number of processes is 1 if the MPI library cannot
+  tell which processes share a host.
+
+  @param[in]  value the value of this process
+  @param[out] processes the number of processes on this host
+*/
+static double HostSum(double value, int & processes) {
+  processes = 1;
+#if !defined(HPCG_NOMPI) && MPI_VERSION>=3
+  MPI_Comm host;
+  MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &host);
+  double sum = 0.0;
+  MPI_Allreduce(&value, &sum, 1, MPI_DOUBLE, MPI_SUM, host);
+  MPI_Comm_size(host, &processes);
+  MPI_Comm_free(&host);
+  return sum;
+#else
+  return value;
+#endif
+}
+
+/*!
+  Computes the memory used by the problem on each process and checks it
+  against the memory of the hosts. The matrix rows are counted as allocated,
+  for the full stencil, and the std::map nodes are estimated, so the
+  result is close to but not exactly the size of the heap.
+
+  @param[in]  A the matrix of the finest level, with the multigrid hierarchy
+  @param[in]  data the work vectors of CG
+  @param[in]  b, x, xexact the vectors of the problem
+  @param[out] usage the memory used, the maxima and totals are the same on all processes
+*/
+void ComputeMemoryUsage(const SparseMatrix & A, const CGData & data, const Vector & b, const Vector & x, const Vector & xexact, MemoryUsage & usage) {
+
+  for (int c=0; c<HPCG_NUMBER_OF_MEMORY_COMPONENTS; ++c) usage.bytes[c] = 0.0;
+  for (const SparseMatrix * M = &A; M!=0; M = M->Ac) AddLevelBytes(*M, usage.bytes);
+  usage.bytes[MEMORY_CGDATA] = VectorBytes(&data.r) + VectorBytes(&data.z) + VectorBytes(&data.p) + VectorBytes(&data.Ap);
+  usage.bytes[MEMORY_VECTORS] = VectorBytes(&b) + VectorBytes(&x) + VectorBytes(&xexact);
+
+  double processBytes = 0.0;
+  for (int c=0; c<HPCG_NUMBER_OF_MEMORY_COMPONENTS; ++c) {
+    usage.maxBytes[c] = usage.bytes[c];
+    processBytes += usage.bytes[c];
+  }
+  usage.maxProcessBytes = usage.totalBytes = processBytes;
+  usage.maxHostBytes = HostSum(processBytes, usage.processesPerHost);
+#ifndef HPCG_NOMPI
+  MPI_Allreduce(MPI_IN_PLACE, usage.maxBytes, HPCG_NUMBER_OF_MEMORY_COMPONENTS, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  MPI_Allreduce(MPI_IN_PLACE, &usage.maxProcessBytes, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  MPI_Allreduce(MPI_IN_PLACE, &usage.totalBytes, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  MPI_Allreduce(MPI_IN_PLACE, &usage.maxHostBytes, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  MPI_Allreduce(MPI_IN_PLACE, &usage.processesPerHost, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+#endif
+
+  usage.numaNodes = NumaNodes(usage.numaNodeMemory);
+  usage.hostMemory = HostMemory();
+#ifndef HPCG_NOMPI
+  double hostInfo[2] = {usage.numaNodeMemory, usage.hostMemory};
+  MPI_Bcast(hostInfo, 2, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+  MPI_Bcast(&usage.numaNodes, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  usage.numaNodeMemory = hostInfo[0];
+  usage.hostMemory = hostInfo[1];
+#endif
+
+  // The processes of a host are assumed to be spread evenly over its NUMA nodes
+  const int processesPerNode = (usage.processesPerHost+usage.numaNodes-1)/usage.numaNodes;
+  usage.numaLocal = usage.numaNodeMemory<=0.0 || processesPerNode*usage.maxProcessBytes<=usage.numaNodeMemory;
+  usage.fitsHost = usage.hostMemory<=0.0 || usage.maxHostBytes<=usage.hostMemory;
+  return;
+}
+
+/*!
+  Returns the estimated peak memory of one row of the finest level including
+  its share of the coarse levels. The selection of the matrix format keeps
+  the rows of a level in the CSR and sliced ELLPACK formats next to the
+  original rows for a short time, which is included.
+
+  @param[in] numberOfMgLevels the number of multigrid levels
+*/
+static double EstimatedBytesPerRow(int numberOfMgLevels) {
+  const double rows = allocatedNonzerosPerRow*(sizeof(double)+sizeof(local_int_t)+sizeof(global_int_t)) + 1 + 4*sizeof(double *);
+  const double maps = sizeof(global_int_t) + mapNodeBytes + sizeof(local_int_t);
+  const double vectors = (4 + 3 + 1 + 4)*sizeof(double); // CG work vectors, problem vectors, multigrid residual, smoother work vectors
+  const double formats = 2*allocatedNonzerosPerRow*(sizeof(double)+sizeof(local_int_t));
+  double levels = 0.0, share = 1.0;
+  for (int level=0; level<numberOfMgLevels; ++level, share /= 8.0) levels += share;
+  return (rows+maps+vectors)*levels + formats;
+}
+
+/*!
+  Returns the local grid dimension nx=ny=nz for which the problem uses about
+  the given fraction of the memory of a host. The memory of the host of
+  rank 0 is shared evenly by the processes on the most populated host. The
+  dimension is a multiple of 2^(numberOfMgLevels-1) so that all levels can
+  be coarsened, and at least 16. This is a collective call.
+
+  @param[in] fraction the fraction of the host memory to fill, in (0,1]
+  @param[in] numberOfMgLevels the number of multigrid levels
+
+  @return the local grid dimension, the same on all processes
+*/
+int AutoSizeProblem(double fraction, int numberOfMgLevels) {
+  int processesPerHost = 1;
+  HostSum(0.0, processesPerHost);
+#ifndef HPCG_NOMPI
+  MPI_Allreduce(MPI_IN_PLACE, &processesPerHost, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+#endif
+  const double processMemory = fraction*HostMemory()/processesPerHost;
+  int n = (int) std::cbrt(processMemory/EstimatedBytesPerRow(numberOfMgLevels));
+  const int multiple = 1<<(numberOfMgLevels-1);
+  n = n/multiple*multiple;
+  if (n<16) n = (16+multiple-1)/multiple*multiple;
+#ifndef HPCG_NOMPI
+  MPI_Bcast(&n, 1, MPI_INT, 0, MPI_COMM_WORLD);
+#endif
+  return n;
+}
@@ -0,0 +1,67 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file MemoryUsage.hpp
+
+ HPCG data structure for the memory used by the problem
+ */
+
+#ifndef MEMORYUSAGE_HPP
+#define MEMORYUSAGE_HPP
+
+#include "SparseMatrix.hpp"
+#include "CGData.hpp"
+#include "Vector.hpp"
+
+/*!
+  The parts of the data of a process whose memory is accounted separately.
+*/
+enum MemoryComponent_ENUM {
+  MEMORY_MATRIX = 0, //!< rows of the matrices of all levels, in the format of the level or the mapped problem cache
+  MEMORY_MAPS = 1, //!< local-to-global and global-to-local maps and the thread subdomain rows
+  MEMORY_HALO = 2, //!< halo lists and send buffers
+  MEMORY_MGDATA = 3, //!< fine-to-coarse operators and the vectors of the coarse grid corrections
+  MEMORY_SMOOTHER = 4, //!< work vectors, orderings and factors of the smoothers
+  MEMORY_CGDATA = 5, //!< work vectors of CG
+  MEMORY_VECTORS = 6 //!< right-hand side, initial guess and exact solution
+};
+typedef enum MemoryComponent_ENUM MemoryComponent;
+
+#define HPCG_NUMBER_OF_MEMORY_COMPONENTS 7 //!< number of entries of MemoryComponent
+
+/*!
+  The memory used by the problem and the memory of the hosts it runs on.
+*/
+struct MemoryUsage_STRUCT {
+  double bytes[HPCG_NUMBER_OF_MEMORY_COMPONENTS]; //!< bytes of each component on this process
+  double maxBytes[HPCG_NUMBER_OF_MEMORY_COMPONENTS]; //!< largest bytes of each component on any process
+  double maxProcessBytes; //!< largest bytes of all components on any process
+  double maxHostBytes; //!< largest bytes of all processes of one host
+  double totalBytes; //!< bytes of all components on all processes
+  int processesPerHost; //!< largest number of processes on one host
+  int numaNodes; //!< number of NUMA nodes of the host of rank 0
+  double numaNodeMemory; //!< physical memory of the smallest NUMA node of the host of rank 0 (bytes)
+  double hostMemory; //!< physical memory of the host of rank 0 (bytes)
+  int numaLocal; //!< 1 if the data of the processes sharing a NUMA node fits into its memory
+  int fitsHost; //!< 1 if the data of the processes of a host fits into its memory
+};
+typedef struct MemoryUsage_STRUCT MemoryUsage;
+
+extern const char * MemoryComponentName(int component);
+extern void ComputeMemoryUsage(const SparseMatrix & A, const CGData & data, const Vector & b, const Vector & x, const Vector & xexact, MemoryUsage & usage);
+extern int AutoSizeProblem(double fraction, int numberOfMgLevels);
+
+#endif // MEMORYUSAGE_HPP
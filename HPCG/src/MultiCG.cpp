@@ -0,0 +1,156 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file MultiCG.cpp
+
+ HPCG routine
+ */
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/hpx_fwd.hpp>
+#endif
+
+#include <fstream>
+
+#include <cmath>
+
+#include "hpcg.hpp"
+
+#include "MultiCG.hpp"
+#include "mytimer.hpp"
+#include "ComputeSPMM.hpp"
+#include "ComputeMultiMG.hpp"
+#include "ComputeMultiDotProduct.hpp"
+#include "ComputeMultiWAXPBY.hpp"
+
+
+// Use TICK and TOCK to time a code section in MATLAB-like fashion
+#define TICK()  t0 = mytimer() //!< record current time in 't0'
+#define TOCK(t) t += mytimer() - t0 //!< store time difference in 't' using time in 't0'
+
+/*!
+  Routine to compute approximate solutions to AX = B for a block of
+  right-hand sides.
+
+  Each vector of the block is solved by its own CG iteration with its own
+  scalars, all iterations proceed in lockstep so that the matrix is read
+  once per kernel for all vectors. The iteration stops when all vectors meet
+  the tolerance.
+
+  @param[in]    A    The known system matrix
+  @param[inout] data The data structure with all necessary blocks preallocated
+  @param[in]    b    The known block of right hand sides
+  @param[inout] x    On entry: the initial guesses; on exit: the new approximate solutions
+  @param[in]    max_iter  The maximum number of iterations to perform, even if tolerance is not met.
+  @param[in]    tolerance The stopping criterion to assert convergence: if the scaled residual of every vector is <= to tolerance.
+  @param[out]   niters    The number of iterations actually performed.
+  @param[out]   normr     The 2-norms of the residual vectors after the last iteration.
+  @param[out]   normr0    The 2-norms of the residual vectors before the first iteration.
+  @param[out]   times     The 7-element vector of the timing information accumulated during all of the iterations.
+  @param[in]    doPreconditioning The flag to indicate whether the preconditioner should be invoked at each iteration.
+
+  @return Returns zero on success and a non-zero value otherwise.
+
+  @see CG()
+*/
+int MultiCG(const SparseMatrix & A, MultiCGData & data, const MultiVector & b, MultiVector & x,
+    const int max_iter, const double tolerance, int & niters, double * normr, double * normr0,
+    double * times, bool doPreconditioning) {
+
+  double t_begin = mytimer();  // Start timing right away
+  const int nrhs = b.numberOfVectors;
+  niters = 0;
+  double rtz[HPCG_MAX_RHS], oldrtz[HPCG_MAX_RHS], pAp[HPCG_MAX_RHS];
+  double alpha[HPCG_MAX_RHS], minusAlpha[HPCG_MAX_RHS], beta[HPCG_MAX_RHS], one[HPCG_MAX_RHS];
+  for (int l=0; l<nrhs; ++l) {
+    normr[l] = 0.0;
+    one[l] = 1.0;
+  }
+
+  double t0 = 0.0, t1 = 0.0, t2 = 0.0, t3 = 0.0, t4 = 0.0, t5 = 0.0;
+  local_int_t nrow = A.localNumberOfRows;
+  MultiVector & r = data.r; // Residual vectors
+  MultiVector & z = data.z; // Preconditioned residual vectors
+  MultiVector & p = data.p; // Direction vectors (in MPI mode ncol>=nrow)
+  MultiVector & Ap = data.Ap;
+
+  if (!doPreconditioning && A.geom->rank==0) HPCG_fout << "WARNING: PERFORMING UNPRECONDITIONED ITERATIONS" << std::endl;
+
+  // p is of length ncols, copy x to p for sparse MV operation
+  CopyMultiVector(x, p);
+  TICK(); ComputeSPMM(A, p, Ap); TOCK(t3); // Ap = A*p
+  for (int l=0; l<nrhs; ++l) minusAlpha[l] = -1.0;
+  TICK(); ComputeMultiWAXPBY(nrow, one, b, minusAlpha, Ap, r);  TOCK(t2); // r = b - Ax (x stored in p)
+  TICK(); ComputeMultiDotProduct(nrow, r, r, normr, t4); TOCK(t1);
+
+  // Record initial residuals for convergence testing
+  double maxScaledResidual = 0.0;
+  for (int l=0; l<nrhs; ++l) {
+    normr[l] = sqrt(normr[l]);
+    normr0[l] = normr[l];
+    if (normr0[l]>0.0) maxScaledResidual = 1.0;
+  }
+
+  // Start iterations
+
+  for (int k=1; k<=max_iter && maxScaledResidual > tolerance; k++ ) {
+    TICK();
+    if (doPreconditioning)
+      ComputeMultiMG(A, data, r, z); // Apply preconditioner
+    else
+      CopyMultiVector (r, z); // copy r to z (no preconditioning)
+    TOCK(t5); // Preconditioner apply time
+
+    if (k == 1) {
+      TICK(); CopyMultiVector(z, p); TOCK(t2); // Copy Mr to p
+      TICK(); ComputeMultiDotProduct (nrow, r, z, rtz, t4); TOCK(t1); // rtz = r'*z
+    } else {
+      for (int l=0; l<nrhs; ++l) oldrtz[l] = rtz[l];
+      TICK(); ComputeMultiDotProduct (nrow, r, z, rtz, t4); TOCK(t1); // rtz = r'*z
+      for (int l=0; l<nrhs; ++l) beta[l] = (oldrtz[l]!=0.0) ? rtz[l]/oldrtz[l] : 0.0;
+      TICK(); ComputeMultiWAXPBY (nrow, one, z, beta, p, p);  TOCK(t2); // p = beta*p + z
+    }
+
+    TICK(); ComputeSPMM(A, p, Ap); TOCK(t3); // Ap = A*p
+    TICK(); ComputeMultiDotProduct(nrow, p, Ap, pAp, t4); TOCK(t1); // alpha = p'*Ap
+    for (int l=0; l<nrhs; ++l) {
+      alpha[l] = (pAp[l]!=0.0) ? rtz[l]/pAp[l] : 0.0; // A vector that has converged exactly is left unchanged
+      minusAlpha[l] = -alpha[l];
+    }
+    TICK(); ComputeMultiWAXPBY(nrow, one, x, alpha, p, x);// x = x + alpha*p
+    ComputeMultiWAXPBY(nrow, one, r, minusAlpha, Ap, r);  TOCK(t2);// r = r - alpha*Ap
+    TICK(); ComputeMultiDotProduct(nrow, r, r, normr, t4); TOCK(t1);
+    maxScaledResidual = 0.0;
+    for (int l=0; l<nrhs; ++l) {
+      normr[l] = sqrt(normr[l]);
+      if (normr0[l]>0.0 && normr[l]/normr0[l] > maxScaledResidual) maxScaledResidual = normr[l]/normr0[l];
+    }
+#ifdef HPCG_DEBUG
+    if (A.geom->rank==0)
+      HPCG_fout << "Iteration = "<< k << "   Maximum Scaled Residual = "<< maxScaledResidual << std::endl;
+#endif
+    niters = k;
+  }
+
+  // Store times
+  times[1] += t1; // dot-product time
+  times[2] += t2; // WAXPBY time
+  times[3] += t3; // SPMM time
+  times[4] += t4; // AllReduce time
+  times[5] += t5; // preconditioner apply time
+  times[0] += mytimer() - t_begin;  // Total time. All done...
+  return(0);
+}
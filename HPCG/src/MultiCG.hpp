@@ -0,0 +1,39 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+#ifndef MULTICG_HPP
+#define MULTICG_HPP
+
+#include "SparseMatrix.hpp"
+#include "MultiVector.hpp"
+#include "MultiCGData.hpp"
+
+int MultiCG(const SparseMatrix & A, MultiCGData & data, const MultiVector & b, MultiVector & x,
+    const int max_iter, const double tolerance, int & niters, double * normr, double * normr0,
+    double * times, bool doPreconditioning);
+
+// this function will compute the Conjugate Gradient iterations for a block of right-hand sides.
+// A - Matrix
+// b - block of right-hand sides
+// x - block used for return value
+// max_iter - how many times we iterate
+// tolerance - Stopping tolerance, all vectors must meet it
+// niters - number of iterations performed
+// normr - computed residual norm of each vector
+// normr0 - Original residual of each vector
+// times - array of timing information
+// doPreconditioning - bool to specify whether or not the multigrid preconditioner will be applied.
+
+#endif  // MULTICG_HPP
@@ -0,0 +1,95 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file MultiCGData.hpp
+
+ HPCG data structure
+ */
+
+#ifndef MULTICGDATA_HPP
+#define MULTICGDATA_HPP
+
+#include "SparseMatrix.hpp"
+#include "MultiVector.hpp"
+
+struct MultiCGData_STRUCT {
+  MultiVector r; //!< block of residual vectors
+  MultiVector z; //!< block of preconditioned residual vectors
+  MultiVector p; //!< block of direction vectors
+  MultiVector Ap; //!< block of Krylov vectors
+  int numberOfLevels; //!< number of levels of the multigrid hierarchy that have a coarse level
+  MultiVector * Axf; //!< for each level with a coarse level, the block of fine grid residuals
+  MultiVector * rc; //!< for each level with a coarse level, the block of coarse grid residuals
+  MultiVector * xc; //!< for each level with a coarse level, the block of coarse grid solutions
+};
+typedef struct MultiCGData_STRUCT MultiCGData;
+
+/*!
+ Constructor for the data structure of blocks of CG vectors, including the
+ blocks used on the coarse levels by the multigrid preconditioner.
+
+ @param[in]  A    the data structure that describes the problem matrix and its structure, including the MG hierarchy
+ @param[in]  numberOfVectors the number of right-hand sides solved together
+ @param[out] data the data structure that will be allocated to get it ready for use in MultiCG iterations
+ */
+inline void InitializeMultiCGData(const SparseMatrix & A, int numberOfVectors, MultiCGData & data) {
+  local_int_t nrow = A.localNumberOfRows;
+  local_int_t ncol = A.localNumberOfColumns;
+  InitializeMultiVector(data.r, nrow, numberOfVectors);
+  InitializeMultiVector(data.z, ncol, numberOfVectors);
+  InitializeMultiVector(data.p, ncol, numberOfVectors);
+  InitializeMultiVector(data.Ap, nrow, numberOfVectors);
+
+  data.numberOfLevels = 0;
+  for (const SparseMatrix * curLevelMatrix = &A; curLevelMatrix->Ac; curLevelMatrix = curLevelMatrix->Ac) ++data.numberOfLevels;
+  data.Axf = new MultiVector[data.numberOfLevels];
+  data.rc = new MultiVector[data.numberOfLevels];
+  data.xc = new MultiVector[data.numberOfLevels];
+  const SparseMatrix * curLevelMatrix = &A;
+  for (int level=0; level<data.numberOfLevels; ++level) {
+    const SparseMatrix * coarseMatrix = curLevelMatrix->Ac;
+    InitializeMultiVector(data.Axf[level], curLevelMatrix->localNumberOfColumns, numberOfVectors);
+    InitializeMultiVector(data.rc[level], coarseMatrix->localNumberOfRows, numberOfVectors);
+    InitializeMultiVector(data.xc[level], coarseMatrix->localNumberOfColumns, numberOfVectors);
+    curLevelMatrix = coarseMatrix;
+  }
+  return;
+}
+
+/*!
+ Destructor for the blocks of CG vectors.
+
+ @param[inout] data the data structure whose storage is deallocated
+ */
+inline void DeleteMultiCGData(MultiCGData & data) {
+
+  DeleteMultiVector(data.r);
+  DeleteMultiVector(data.z);
+  DeleteMultiVector(data.p);
+  DeleteMultiVector(data.Ap);
+  for (int level=0; level<data.numberOfLevels; ++level) {
+    DeleteMultiVector(data.Axf[level]);
+    DeleteMultiVector(data.rc[level]);
+    DeleteMultiVector(data.xc[level]);
+  }
+  delete [] data.Axf;
+  delete [] data.rc;
+  delete [] data.xc;
+  data.numberOfLevels = 0;
+  return;
+}
+
+#endif // MULTICGDATA_HPP
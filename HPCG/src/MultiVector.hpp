@@ -0,0 +1,168 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file MultiVector.hpp
+
+ HPCG data structures for blocks of dense vectors
+ */
+
+#ifndef MULTIVECTOR_HPP
+#define MULTIVECTOR_HPP
+
+#include "Vector.hpp"
+
+/*!
+  Maximum number of vectors in a block, i.e. of right-hand sides solved
+  together by MultiCG.
+*/
+#define HPCG_MAX_RHS 16
+
+/*!
+  A block of numberOfVectors vectors of the same length. The values are
+  interleaved: value j of row i is stored at values[i*numberOfVectors+j], so
+  that a kernel reading row i of the matrix once finds the corresponding
+  values of all vectors next to each other.
+*/
+struct MultiVector_STRUCT {
+  local_int_t localLength;  //!< length of local portion of each vector
+  int numberOfVectors;      //!< number of vectors in the block, at most HPCG_MAX_RHS
+  local_int_t paddedLength; //!< allocated number of values, a multiple of HPCG_VECTOR_ALIGNMENT bytes
+  double * values;          //!< array of interleaved values, aligned to HPCG_VECTOR_ALIGNMENT bytes
+};
+typedef struct MultiVector_STRUCT MultiVector;
+
+/*!
+  Initializes a block of vectors.
+
+  @param[in] v
+  @param[in] localLength Length of local portion of each vector
+  @param[in] numberOfVectors Number of vectors in the block
+ */
+inline void InitializeMultiVector(MultiVector & v, local_int_t localLength, int numberOfVectors) {
+  assert(numberOfVectors>0 && numberOfVectors<=HPCG_MAX_RHS);
+  const local_int_t valuesPerAlignment = HPCG_VECTOR_ALIGNMENT/sizeof(double);
+  const local_int_t length = localLength*numberOfVectors;
+  v.localLength = localLength;
+  v.numberOfVectors = numberOfVectors;
+  v.paddedLength = (length+valuesPerAlignment-1)/valuesPerAlignment*valuesPerAlignment;
+  v.values = AllocateVectorValues(v.paddedLength);
+  for (local_int_t i=length; i<v.paddedLength; ++i) v.values[i] = 0.0;
+  return;
+}
+
+/*!
+  Fill all vectors of the block with zero values.
+
+  @param[inout] v - On entrance v is initialized, on exit all its values are zero.
+ */
+inline void ZeroMultiVector(MultiVector & v) {
+  const local_int_t length = v.localLength*v.numberOfVectors;
+  double * const vv = v.values;
+#if defined(HPCG_NOHPX)
+#ifndef HPCG_NOOPENMP
+  #pragma omp parallel for if(length>=HPCG_VECTOR_PARALLEL_THRESHOLD)
+#endif
+  for (local_int_t i=0; i<length; ++i) vv[i] = 0.0;
+#else
+  if (length<HPCG_VECTOR_PARALLEL_THRESHOLD) {
+    for (local_int_t i=0; i<length; ++i) vv[i] = 0.0;
+  } else {
+    typedef boost::counting_iterator<local_int_t> iterator;
+    hpx::parallel::for_each(hpx::parallel::par, iterator(0), iterator(length),
+      [vv](local_int_t i) { vv[i] = 0.0; });
+  }
+#endif
+  return;
+}
+
+/*!
+  Copy a block of vectors to another block with the same number of vectors.
+
+  @param[in] v Input block
+  @param[in] w Output block
+ */
+inline void CopyMultiVector(const MultiVector & v, MultiVector & w) {
+  assert(w.localLength >= v.localLength && w.numberOfVectors == v.numberOfVectors);
+  const local_int_t length = v.localLength*v.numberOfVectors;
+  const double * const vv = v.values;
+  double * const wv = w.values;
+#if defined(HPCG_NOHPX)
+#ifndef HPCG_NOOPENMP
+  #pragma omp parallel for if(length>=HPCG_VECTOR_PARALLEL_THRESHOLD)
+#endif
+  for (local_int_t i=0; i<length; ++i) wv[i] = vv[i];
+#else
+  if (length<HPCG_VECTOR_PARALLEL_THRESHOLD) {
+    for (local_int_t i=0; i<length; ++i) wv[i] = vv[i];
+  } else {
+    typedef boost::counting_iterator<local_int_t> iterator;
+    hpx::parallel::for_each(hpx::parallel::par, iterator(0), iterator(length),
+      [vv, wv](local_int_t i) { wv[i] = vv[i]; });
+  }
+#endif
+  return;
+}
+
+/*!
+  Copy a vector into one vector of a block.
+
+  @param[in] v Input vector
+  @param[inout] w Output block
+  @param[in] j Index of the vector of w to overwrite
+ */
+inline void SetMultiVectorColumn(const Vector & v, MultiVector & w, int j) {
+  assert(w.localLength >= v.localLength && j>=0 && j<w.numberOfVectors);
+  const local_int_t localLength = v.localLength;
+  const int k = w.numberOfVectors;
+  const double * const vv = v.values;
+  double * const wv = w.values;
+  for (local_int_t i=0; i<localLength; ++i) wv[i*k+j] = vv[i];
+  return;
+}
+
+/*!
+  Copy one vector of a block into a vector.
+
+  @param[in] v Input block
+  @param[in] j Index of the vector of v to copy
+  @param[inout] w Output vector
+ */
+inline void GetMultiVectorColumn(const MultiVector & v, int j, Vector & w) {
+  assert(w.localLength >= v.localLength && j>=0 && j<v.numberOfVectors);
+  const local_int_t localLength = v.localLength;
+  const int k = v.numberOfVectors;
+  const double * const vv = v.values;
+  double * const wv = w.values;
+  for (local_int_t i=0; i<localLength; ++i) wv[i] = vv[i*k+j];
+  return;
+}
+
+/*!
+  Deallocates the values of a block of vectors.
+
+  @param[inout] v the block whose storage is deallocated
+ */
+inline void DeleteMultiVector(MultiVector & v) {
+
+  FreeVectorValues(v.values);
+  v.values = 0;
+  v.localLength = 0;
+  v.numberOfVectors = 0;
+  v.paddedLength = 0;
+  return;
+}
+
+#endif // MULTIVECTOR_HPP
@@ -19,10 +19,15 @@
  */
 
 #include "OptimizeProblem.hpp"
+#include "MatrixFormat.hpp"
 /*!
   Optimizes the data structures used for CG iteration to increase the
   performance of the benchmark version of the preconditioned CG algorithm.
 
+  The matrix of each multigrid level is converted into the storage format
+  requested with HPCG_matrixFormat, by default the format in which the SpMV
+  and the smoother of the level are fastest.
+
   @param[inout] A      The known system matrix, also contains the MG hierarchy in attributes Ac and mgData.
   @param[inout] data   The data structure with all necessary CG vectors preallocated
   @param[inout] b      The known right hand side vector
@@ -37,7 +42,10 @@
 int OptimizeProblem(SparseMatrix & A, CGData & data, Vector & b, Vector & x, Vector & xexact) {
 
 // This function can be used to completely transform any part of the data structures.
-// Right now it does nothing, so compiling with a check for unused variables results in complaints
+// Right now it only selects the matrix format of each level, the vectors are not used
+
+  for (SparseMatrix * level = &A; level!=0; level = level->Ac)
+    SelectMatrixFormat(*level, HPCG_matrixFormat);
 
   return(0);
 }
@@ -0,0 +1,540 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file ProblemCache.cpp
+
+ HPCG routine
+ */
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/hpx_fwd.hpp>
+#endif
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "ProblemCache.hpp"
+#include "ExchangeHalo.hpp"
+#include "GenerateGeometry.hpp"
+#include "MGData.hpp"
+
+/*!
+  The first bytes of a cache file. All sections of the file, including the
+  headers, start at a multiple of 64 bytes.
+*/
+struct ProblemCacheHeader_STRUCT {
+  char magic[8]; //!< "HPCGPRB" followed by a zero byte
+  int version; //!< HPCG_PROBLEM_CACHE_VERSION of the writer
+  int localIntSize; //!< sizeof(local_int_t) of the writer
+  int globalIntSize; //!< sizeof(global_int_t) of the writer
+  int hasHalo; //!< 1 if the halo lists are stored, i.e. for MPI builds
+  int size; //!< number of processes
+  int rank; //!< rank of the process that wrote the file
+  int npx, npy, npz; //!< process grid
+  int nx, ny, nz; //!< local grid of the finest level
+  int gnx, gny, gnz; //!< global grid of the finest level, the local grids differ between processes in strong scaling runs
+  int requestedLevels; //!< number of multigrid levels requested
+  int numberOfLevels; //!< number of levels stored, less than requested if a grid could not be coarsened
+  long long fileSize; //!< size of the complete file in bytes
+};
+typedef struct ProblemCacheHeader_STRUCT ProblemCacheHeader;
+
+/*!
+  The scalars of one level, followed by the arrays of the level in the order
+  nonzeros per row, position of the diagonal in each row, values, local
+  column indices, global column indices (each concatenated over the rows),
+  local-to-global map, the halo lists, for the finest level b, x and xexact,
+  and for all but the coarsest level the fine-to-coarse operator.
+*/
+struct ProblemCacheLevel_STRUCT {
+  long long localNumberOfRows;
+  long long localNumberOfColumns;
+  long long localNumberOfNonzeros;
+  long long totalNumberOfRows;
+  long long totalNumberOfNonzeros;
+  long long numberOfExternalValues;
+  long long numberOfSendNeighbors;
+  long long totalToBeSent;
+};
+typedef struct ProblemCacheLevel_STRUCT ProblemCacheLevel;
+
+#ifndef HPCG_NOMPI
+static const int cacheHasHalo = 1;
+#else
+static const int cacheHasHalo = 0;
+#endif
+
+/*!
+  Returns the number of bytes rounded up to the alignment of the sections.
+*/
+static size_t Padded(size_t bytes) {
+  return (bytes+63)/64*64;
+}
+
+/*!
+  Returns the number of bytes of one level in the cache file, including its
+  header.
+
+  @param[in] level the scalars of the level
+  @param[in] finest true for the finest level
+  @param[in] hasCoarse true if the level has a coarser level
+*/
+static size_t LevelBytes(const ProblemCacheLevel & level, bool finest, bool hasCoarse) {
+  const size_t n = level.localNumberOfRows, nnz = level.localNumberOfNonzeros;
+  size_t bytes = Padded(sizeof(ProblemCacheLevel)) + 2*Padded(n) + Padded(nnz*sizeof(double))
+      + Padded(nnz*sizeof(local_int_t)) + Padded(nnz*sizeof(global_int_t)) + Padded(n*sizeof(global_int_t));
+  if (cacheHasHalo)
+    bytes += Padded(level.totalToBeSent*sizeof(local_int_t)) + Padded(level.numberOfSendNeighbors*sizeof(int))
+        + 2*Padded(level.numberOfSendNeighbors*sizeof(local_int_t));
+  if (finest) bytes += 3*Padded(n*sizeof(double));
+  if (hasCoarse) bytes += Padded(n*sizeof(local_int_t));
+  return bytes;
+}
+
+/*!
+  Returns the next section of the file and advances the offset past it.
+*/
+template <typename T>
+static T * NextSection(ProblemCache & cache, size_t & offset, long long count) {
+  T * section = (T *) (cache.data+offset);
+  offset += Padded(count*sizeof(T));
+  return(section);
+}
+
+/*!
+  Checks the arrays of one level of a cache file whose sections are known to
+  lie within the file: the rows add up to the number of nonzeros, every
+  column index and every entry of the halo lists and of the fine-to-coarse
+  operator is in range, and every row holds its diagonal. The kernels use
+  these arrays as indices without further checks, so a corrupted or stale
+  file must be rejected here.
+
+  @param[in] cache the mapped file
+  @param[in] offset the offset of the header of the level
+  @param[in] finest true for the finest level
+  @param[in] coarseRows the number of rows of the coarser level, 0 for the coarsest level
+  @param[in] geom the geometry of the finest level
+
+  @return true if the level is consistent
+*/
+static bool ValidLevelArrays(ProblemCache & cache, size_t offset, bool finest, local_int_t coarseRows, const Geometry & geom) {
+  const ProblemCacheLevel & level = *NextSection<ProblemCacheLevel>(cache, offset, 1);
+  const long long n = level.localNumberOfRows;
+  const long long ncol = level.localNumberOfColumns;
+  if (level.totalNumberOfRows<n || ncol<n) return(false);
+  if (ncol!=n+(cacheHasHalo ? level.numberOfExternalValues : 0)) return(false);
+
+  const char * nonzerosInRow = NextSection<char>(cache, offset, n);
+  const char * diagonalPosition = NextSection<char>(cache, offset, n);
+  NextSection<double>(cache, offset, level.localNumberOfNonzeros);
+  const local_int_t * indL = NextSection<local_int_t>(cache, offset, level.localNumberOfNonzeros);
+  const global_int_t * indG = NextSection<global_int_t>(cache, offset, level.localNumberOfNonzeros);
+  const global_int_t * localToGlobal = NextSection<global_int_t>(cache, offset, n);
+
+  long long start = 0;
+  for (long long i=0; i<n; ++i) {
+    const int rowNonzeros = nonzerosInRow[i];
+    if (rowNonzeros<=0 || diagonalPosition[i]<0 || diagonalPosition[i]>=rowNonzeros) return(false);
+    if (start+rowNonzeros>level.localNumberOfNonzeros) return(false);
+    if (indL[start+diagonalPosition[i]]!=i) return(false);
+    for (long long k=start; k<start+rowNonzeros; ++k)
+      if (indL[k]<0 || indL[k]>=ncol || indG[k]<0 || indG[k]>=level.totalNumberOfRows) return(false);
+    if (localToGlobal[i]<0 || localToGlobal[i]>=level.totalNumberOfRows) return(false);
+    start += rowNonzeros;
+  }
+  if (start!=level.localNumberOfNonzeros) return(false);
+
+  if (cacheHasHalo) {
+    const local_int_t * elementsToSend = NextSection<local_int_t>(cache, offset, level.totalToBeSent);
+    const int * neighbors = NextSection<int>(cache, offset, level.numberOfSendNeighbors);
+    const local_int_t * receiveLength = NextSection<local_int_t>(cache, offset, level.numberOfSendNeighbors);
+    const local_int_t * sendLength = NextSection<local_int_t>(cache, offset, level.numberOfSendNeighbors);
+    for (long long k=0; k<level.totalToBeSent; ++k)
+      if (elementsToSend[k]<0 || elementsToSend[k]>=n) return(false);
+    long long totalReceived = 0, totalSent = 0;
+    for (long long k=0; k<level.numberOfSendNeighbors; ++k) {
+      if (neighbors[k]<0 || neighbors[k]>=geom.size || neighbors[k]==geom.rank) return(false);
+      if (receiveLength[k]<0 || sendLength[k]<0) return(false);
+      totalReceived += receiveLength[k];
+      totalSent += sendLength[k];
+    }
+    if (totalReceived!=level.numberOfExternalValues || totalSent!=level.totalToBeSent) return(false);
+  }
+
+  if (finest) offset += 3*Padded(n*sizeof(double));
+
+  if (coarseRows>0) {
+    if (coarseRows>n) return(false);
+    const local_int_t * f2cOperator = NextSection<local_int_t>(cache, offset, n);
+    for (local_int_t i=0; i<coarseRows; ++i)
+      if (f2cOperator[i]<0 || f2cOperator[i]>=n) return(false);
+  }
+  return(true);
+}
+
+/*!
+  Returns the name of the cache file of this process for the given problem.
+
+  @param[in]  directory the directory of the cache files
+  @param[in]  geom the geometry of the finest level
+  @param[in]  numberOfMgLevels the number of multigrid levels requested
+  @param[out] filename the file name
+  @param[in]  length the size of filename
+*/
+void ProblemCacheFileName(const char * directory, const Geometry & geom, int numberOfMgLevels, char * filename, size_t length) {
+  snprintf(filename, length, "%s/hpcg_problem_%dx%dx%d_%dx%dx%d_L%d_%d.bin", directory, geom.nx, geom.ny, geom.nz,
+      geom.npx, geom.npy, geom.npz, numberOfMgLevels, geom.rank);
+}
+
+/*!
+  Maps the cache file of this process into memory and checks that it holds
+  the problem described by the arguments, so that LoadProblemCache cannot
+  fail.
+
+  @param[in]  filename the file written by WriteProblemCache
+  @param[in]  geom the geometry of the finest level
+  @param[in]  numberOfMgLevels the number of multigrid levels requested
+  @param[out] cache the mapped file
+
+  @return returns 0 if the file is valid, non-zero otherwise (then cache.data is 0)
+*/
+int OpenProblemCache(const char * filename, const Geometry & geom, int numberOfMgLevels, ProblemCache & cache) {
+  cache.data = 0;
+  cache.size = 0;
+  cache.numberOfLevels = 0;
+#if !defined(_WIN32)
+  int fd = open(filename, O_RDONLY);
+  if (fd<0) return(1);
+  struct stat status;
+  if (fstat(fd, &status)!=0 || (size_t)status.st_size<Padded(sizeof(ProblemCacheHeader))) {
+    close(fd);
+    return(1);
+  }
+  // Private writable mapping: the matrix diagonal may be replaced, the changes are not written back
+  void * data = mmap(0, status.st_size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data==MAP_FAILED) return(1);
+  cache.data = (char *) data;
+  cache.size = status.st_size;
+
+  const ProblemCacheHeader & header = *(const ProblemCacheHeader *) cache.data;
+  bool valid = memcmp(header.magic, "HPCGPRB", 8)==0 && header.version==HPCG_PROBLEM_CACHE_VERSION
+      && header.localIntSize==(int)sizeof(local_int_t) && header.globalIntSize==(int)sizeof(global_int_t)
+      && header.hasHalo==cacheHasHalo && header.size==geom.size && header.rank==geom.rank
+      && header.npx==geom.npx && header.npy==geom.npy && header.npz==geom.npz
+      && header.nx==geom.nx && header.ny==geom.ny && header.nz==geom.nz
+      && header.gnx==geom.gnx && header.gny==geom.gny && header.gnz==geom.gnz
+      && header.requestedLevels==numberOfMgLevels && header.numberOfLevels>=1 && header.numberOfLevels<=numberOfMgLevels
+      && header.fileSize==(long long)cache.size;
+
+  // Walk the levels to make sure that all arrays lie within the file and hold valid indices
+  size_t offset = Padded(sizeof(ProblemCacheHeader));
+  local_int_t nx = geom.nx, ny = geom.ny, nz = geom.nz;
+  for (int l=0; valid && l<header.numberOfLevels; ++l) {
+    if (offset+Padded(sizeof(ProblemCacheLevel))>cache.size) { valid = false; break; }
+    const ProblemCacheLevel & level = *(const ProblemCacheLevel *) (cache.data+offset);
+    const bool hasCoarse = l+1<header.numberOfLevels;
+    valid = level.localNumberOfRows==((long long)nx)*ny*nz && level.localNumberOfNonzeros>=0
+        && level.numberOfSendNeighbors>=0 && level.totalToBeSent>=0
+        && offset+LevelBytes(level, l==0, hasCoarse)<=cache.size;
+    if (!valid) break;
+    const local_int_t coarseRows = hasCoarse ? (nx/2)*(ny/2)*(nz/2) : 0;
+    valid = ValidLevelArrays(cache, offset, l==0, coarseRows, geom);
+    offset += LevelBytes(level, l==0, hasCoarse);
+    nx /= 2; ny /= 2; nz /= 2;
+  }
+  if (!valid || offset!=cache.size) {
+    CloseProblemCache(cache);
+    return(1);
+  }
+  cache.numberOfLevels = header.numberOfLevels;
+  return(0);
+#else
+  (void) filename; (void) geom; (void) numberOfMgLevels;
+  return(1); // Memory mapped cache files are only supported on POSIX systems
+#endif
+}
+
+/*!
+  Unmaps a cache file that was not loaded.
+
+  @param[inout] cache the mapped file
+*/
+void CloseProblemCache(ProblemCache & cache) {
+  if (cache.data!=0) UnmapProblemCache(cache.data, cache.size);
+  cache.data = 0;
+  cache.size = 0;
+}
+
+/*!
+  Unmaps the memory of a cache file, called by DeleteMatrix for the finest
+  level of a loaded hierarchy.
+
+  @param[in] data the start of the mapping
+  @param[in] size the size of the mapping in bytes
+*/
+void UnmapProblemCache(void * data, size_t size) {
+#if !defined(_WIN32)
+  munmap(data, size);
+#else
+  (void) data; (void) size;
+#endif
+}
+
+/*!
+  Builds the multigrid hierarchy from a cache file opened by OpenProblemCache,
+  replacing GenerateProblem, SetupHalo and GenerateCoarseProblem. The rows of
+  the matrices point into the mapped file, which is released by DeleteMatrix
+  of the finest level. The global-to-local maps are left empty, they are only
+  needed by SetupHalo.
+
+  @param[inout] cache the mapped file, owned by A on return
+  @param[inout] A the matrix of the finest level, initialized with its geometry
+  @param[out]   b, x, xexact the vectors of GenerateProblem
+
+  @return returns the number of multigrid levels loaded
+*/
+int LoadProblemCache(ProblemCache & cache, SparseMatrix & A, Vector & b, Vector & x, Vector & xexact) {
+  size_t offset = Padded(sizeof(ProblemCacheHeader));
+  SparseMatrix * M = &A;
+  std::vector<local_int_t *> f2cOperators(cache.numberOfLevels, (local_int_t *) 0);
+  for (int l=0; l<cache.numberOfLevels; ++l) {
+    const ProblemCacheLevel & level = *NextSection<ProblemCacheLevel>(cache, offset, 1);
+    const local_int_t n = level.localNumberOfRows;
+    const char * nonzerosInRow = NextSection<char>(cache, offset, n);
+    const char * diagonalPosition = NextSection<char>(cache, offset, n);
+    double * values = NextSection<double>(cache, offset, level.localNumberOfNonzeros);
+    local_int_t * indL = NextSection<local_int_t>(cache, offset, level.localNumberOfNonzeros);
+    global_int_t * indG = NextSection<global_int_t>(cache, offset, level.localNumberOfNonzeros);
+    const global_int_t * localToGlobal = NextSection<global_int_t>(cache, offset, n);
+
+    M->totalNumberOfRows = level.totalNumberOfRows;
+    M->totalNumberOfNonzeros = level.totalNumberOfNonzeros;
+    M->localNumberOfRows = n;
+    M->localNumberOfColumns = level.localNumberOfColumns;
+    M->localNumberOfNonzeros = level.localNumberOfNonzeros;
+    M->nonzerosInRow = new char[n];
+    M->mtxIndG = new global_int_t*[n];
+    M->mtxIndL = new local_int_t*[n];
+    M->matrixValues = new double*[n];
+    M->matrixDiagonal = new double*[n];
+    memcpy(M->nonzerosInRow, nonzerosInRow, n);
+    long long start = 0;
+    for (local_int_t i=0; i<n; ++i) {
+      M->matrixValues[i] = values+start;
+      M->mtxIndL[i] = indL+start;
+      M->mtxIndG[i] = indG+start;
+      M->matrixDiagonal[i] = values+start+diagonalPosition[i];
+      start += nonzerosInRow[i];
+    }
+    M->localToGlobalMap.assign(localToGlobal, localToGlobal+n);
+    M->problemCacheData = cache.data;
+    M->problemCacheSize = (l==0) ? cache.size : 0; // The finest level owns the mapping
+
+#ifndef HPCG_NOMPI
+    const int numberOfNeighbors = level.numberOfSendNeighbors;
+    const local_int_t * elementsToSend = NextSection<local_int_t>(cache, offset, level.totalToBeSent);
+    const int * neighbors = NextSection<int>(cache, offset, numberOfNeighbors);
+    const local_int_t * receiveLength = NextSection<local_int_t>(cache, offset, numberOfNeighbors);
+    const local_int_t * sendLength = NextSection<local_int_t>(cache, offset, numberOfNeighbors);
+    M->numberOfExternalValues = level.numberOfExternalValues;
+    M->numberOfSendNeighbors = numberOfNeighbors;
+    M->totalToBeSent = level.totalToBeSent;
+    M->elementsToSend = new local_int_t[level.totalToBeSent];
+    M->neighbors = new int[numberOfNeighbors];
+    M->receiveLength = new local_int_t[numberOfNeighbors];
+    M->sendLength = new local_int_t[numberOfNeighbors];
+    M->sendBuffer = new double[level.totalToBeSent];
+    memcpy(M->elementsToSend, elementsToSend, level.totalToBeSent*sizeof(local_int_t));
+    memcpy(M->neighbors, neighbors, numberOfNeighbors*sizeof(int));
+    memcpy(M->receiveLength, receiveLength, numberOfNeighbors*sizeof(local_int_t));
+    memcpy(M->sendLength, sendLength, numberOfNeighbors*sizeof(local_int_t));
+    SetupHaloRequests(*M);
+#endif
+
+    // The thread subdomains depend on the number of threads of this run, not on the cache
+    const Geometry & geom = *M->geom;
+    M->numberOfSubdomains = geom.ntx*geom.nty*geom.ntz;
+    M->subdomainStart = new local_int_t[M->numberOfSubdomains+1];
+    M->subdomainRows = new local_int_t[n];
+    GenerateBlockRows(geom.nx, geom.ny, geom.nz, geom.ntx, geom.nty, geom.ntz, M->subdomainStart, M->subdomainRows, 0);
+
+    if (l==0) {
+      const double * vectors[3];
+      for (int k=0; k<3; ++k) vectors[k] = NextSection<double>(cache, offset, n);
+      InitializeVector(b, n);
+      InitializeVector(x, n);
+      InitializeVector(xexact, n);
+      memcpy(b.values, vectors[0], n*sizeof(double));
+      memcpy(x.values, vectors[1], n*sizeof(double));
+      memcpy(xexact.values, vectors[2], n*sizeof(double));
+    }
+
+    if (l+1<cache.numberOfLevels) {
+      const local_int_t * f2cOperator = NextSection<local_int_t>(cache, offset, n);
+      f2cOperators[l] = new local_int_t[n];
+      memcpy(f2cOperators[l], f2cOperator, n*sizeof(local_int_t));
+      Geometry * geomc = new Geometry;
+      GenerateCoarseGeometry(geom, geomc);
+      M->Ac = new SparseMatrix;
+      InitializeSparseMatrix(*M->Ac, geomc);
+      M->Ac->level = M->level+1;
+      M = M->Ac;
+    }
+  }
+
+  // The transfer vectors need the sizes of both levels
+  M = &A;
+  for (int l=0; l+1<cache.numberOfLevels; ++l, M = M->Ac) {
+    Vector * rc = new Vector;
+    Vector * xc = new Vector;
+    Vector * Axf = new Vector;
+    InitializeVector(*rc, M->Ac->localNumberOfRows);
+    InitializeVector(*xc, M->Ac->localNumberOfColumns);
+    InitializeVector(*Axf, M->localNumberOfColumns);
+    M->mgData = new MGData;
+    InitializeMGData(f2cOperators[l], rc, xc, Axf, *M->mgData);
+  }
+
+  const int numberOfLevels = cache.numberOfLevels;
+  cache.data = 0; // Released by DeleteMatrix(A)
+  cache.size = 0;
+  return(numberOfLevels);
+}
+
+/*!
+  Writes zero bytes up to the alignment of the next section.
+*/
+static void WritePadding(FILE * file, size_t & offset) {
+  static const char zeros[64] = {0};
+  const size_t padding = Padded(offset)-offset;
+  if (padding>0) fwrite(zeros, 1, padding, file);
+  offset += padding;
+}
+
+/*!
+  Writes an array as one section of the file.
+*/
+static void WriteSection(FILE * file, const void * data, size_t bytes, size_t & offset) {
+  if (bytes>0) fwrite(data, 1, bytes, file);
+  offset += bytes;
+  WritePadding(file, offset);
+}
+
+/*!
+  Writes the multigrid hierarchy generated by GenerateProblem, SetupHalo and
+  GenerateCoarseProblem to the cache file of this process. The file is
+  written under a temporary name and renamed when complete, so concurrent
+  runs never read a partial file.
+
+  @param[in] filename the name of the cache file
+  @param[in] A the matrix of the finest level, before the smoother setup and OptimizeProblem
+  @param[in] numberOfMgLevels the number of multigrid levels requested
+  @param[in] b, x, xexact the vectors generated by GenerateProblem
+
+  @return returns 0 upon success and non-zero otherwise
+*/
+int WriteProblemCache(const char * filename, const SparseMatrix & A, int numberOfMgLevels, const Vector & b, const Vector & x, const Vector & xexact) {
+  std::string temporary = std::string(filename) + ".tmp";
+  FILE * file = fopen(temporary.c_str(), "wb");
+  if (file==0) return(1);
+
+  const Geometry & geom = *A.geom;
+  ProblemCacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, "HPCGPRB", 8);
+  header.version = HPCG_PROBLEM_CACHE_VERSION;
+  header.localIntSize = sizeof(local_int_t);
+  header.globalIntSize = sizeof(global_int_t);
+  header.hasHalo = cacheHasHalo;
+  header.size = geom.size;
+  header.rank = geom.rank;
+  header.npx = geom.npx; header.npy = geom.npy; header.npz = geom.npz;
+  header.nx = geom.nx; header.ny = geom.ny; header.nz = geom.nz;
+  header.gnx = geom.gnx; header.gny = geom.gny; header.gnz = geom.gnz;
+  header.requestedLevels = numberOfMgLevels;
+  for (const SparseMatrix * M = &A; M!=0; M = M->Ac) ++header.numberOfLevels;
+  header.fileSize = 0; // Written again when the size is known
+
+  size_t offset = 0;
+  WriteSection(file, &header, sizeof(header), offset);
+  for (const SparseMatrix * M = &A; M!=0; M = M->Ac) {
+    const local_int_t n = M->localNumberOfRows;
+    ProblemCacheLevel level;
+    memset(&level, 0, sizeof(level));
+    level.localNumberOfRows = n;
+    level.localNumberOfColumns = M->localNumberOfColumns;
+    level.localNumberOfNonzeros = M->localNumberOfNonzeros;
+    level.totalNumberOfRows = M->totalNumberOfRows;
+    level.totalNumberOfNonzeros = M->totalNumberOfNonzeros;
+#ifndef HPCG_NOMPI
+    level.numberOfExternalValues = M->numberOfExternalValues;
+    level.numberOfSendNeighbors = M->numberOfSendNeighbors;
+    level.totalToBeSent = M->totalToBeSent;
+#endif
+    WriteSection(file, &level, sizeof(level), offset);
+    WriteSection(file, M->nonzerosInRow, n, offset);
+    std::vector<char> diagonalPosition(n);
+    for (local_int_t i=0; i<n; ++i) diagonalPosition[i] = (char) (M->matrixDiagonal[i]-M->matrixValues[i]);
+    WriteSection(file, &diagonalPosition[0], n, offset);
+
+    // The rows are concatenated, the loader recovers the row starts from nonzerosInRow
+    for (local_int_t i=0; i<n; ++i) offset += fwrite(M->matrixValues[i], sizeof(double), M->nonzerosInRow[i], file)*sizeof(double);
+    WritePadding(file, offset);
+    for (local_int_t i=0; i<n; ++i) offset += fwrite(M->mtxIndL[i], sizeof(local_int_t), M->nonzerosInRow[i], file)*sizeof(local_int_t);
+    WritePadding(file, offset);
+    for (local_int_t i=0; i<n; ++i) offset += fwrite(M->mtxIndG[i], sizeof(global_int_t), M->nonzerosInRow[i], file)*sizeof(global_int_t);
+    WritePadding(file, offset);
+    WriteSection(file, &M->localToGlobalMap[0], n*sizeof(global_int_t), offset);
+
+#ifndef HPCG_NOMPI
+    WriteSection(file, M->elementsToSend, M->totalToBeSent*sizeof(local_int_t), offset);
+    WriteSection(file, M->neighbors, M->numberOfSendNeighbors*sizeof(int), offset);
+    WriteSection(file, M->receiveLength, M->numberOfSendNeighbors*sizeof(local_int_t), offset);
+    WriteSection(file, M->sendLength, M->numberOfSendNeighbors*sizeof(local_int_t), offset);
+#endif
+
+    if (M==&A) {
+      WriteSection(file, b.values, n*sizeof(double), offset);
+      WriteSection(file, x.values, n*sizeof(double), offset);
+      WriteSection(file, xexact.values, n*sizeof(double), offset);
+    }
+
+    if (M->Ac!=0) {
+      // Only the entries of the coarse rows are defined, the rest of the operator is written as zeros
+      std::vector<local_int_t> f2cOperator(n, 0);
+      std::copy(M->mgData->f2cOperator, M->mgData->f2cOperator+M->Ac->localNumberOfRows, f2cOperator.begin());
+      WriteSection(file, &f2cOperator[0], n*sizeof(local_int_t), offset);
+    }
+  }
+
+  header.fileSize = offset;
+  bool success = !ferror(file) && fseek(file, 0, SEEK_SET)==0 && fwrite(&header, sizeof(header), 1, file)==1;
+  success = fclose(file)==0 && success;
+  if (success) success = rename(temporary.c_str(), filename)==0;
+  if (!success) remove(temporary.c_str());
+  return(success ? 0 : 1);
+}
@@ -0,0 +1,50 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file ProblemCache.hpp
+
+ HPCG binary cache of the generated problem hierarchy
+ */
+
+#ifndef PROBLEMCACHE_HPP
+#define PROBLEMCACHE_HPP
+
+#include <cstddef>
+
+#include "Geometry.hpp"
+#include "SparseMatrix.hpp"
+#include "Vector.hpp"
+
+#define HPCG_PROBLEM_CACHE_VERSION 2 //!< version of the cache file format, increased when the layout or the generated problem changes
+
+/*!
+  A cache file of this process mapped into memory by OpenProblemCache.
+*/
+struct ProblemCache_STRUCT {
+  char * data; //!< the mapping of the file, 0 if no valid cache file exists
+  size_t size; //!< size of the file in bytes
+  int numberOfLevels; //!< number of multigrid levels stored in the file
+};
+typedef struct ProblemCache_STRUCT ProblemCache;
+
+extern void ProblemCacheFileName(const char * directory, const Geometry & geom, int numberOfMgLevels, char * filename, size_t length);
+extern int OpenProblemCache(const char * filename, const Geometry & geom, int numberOfMgLevels, ProblemCache & cache);
+extern void CloseProblemCache(ProblemCache & cache);
+extern int LoadProblemCache(ProblemCache & cache, SparseMatrix & A, Vector & b, Vector & x, Vector & xexact);
+extern int WriteProblemCache(const char * filename, const SparseMatrix & A, int numberOfMgLevels, const Vector & b, const Vector & x, const Vector & xexact);
+extern void UnmapProblemCache(void * data, size_t size);
+
+#endif // PROBLEMCACHE_HPP
@@ -19,6 +19,7 @@
 #include <cstdio>
 
 #include "ReadHpcgDat.hpp"
+#include "MGData.hpp"
 
 static int
 SkipUntilEol(FILE *stream) {
@@ -42,8 +43,21 @@ SkipUntilEol(FILE *stream) {
   return chOrEof;
 }
 
+/*!
+  Reads the hpcg.dat input file.
+
+  The optional fifth line holds the multigrid configuration: the number of
+  levels, the cycle (V, W or F) and the number of pre- and postsmoother steps.
+  The entries of mgParameters are only modified if the line is present.
+
+  @param[out] localDimensions the local problem dimensions nx, ny and nz
+  @param[out] secondsPerRun the running time of the timed portion of the benchmark
+  @param[inout] mgParameters the number of levels, the cycle (one of MGCycle), and the number of pre- and postsmoother steps
+
+  @return returns 0 upon success and non-zero otherwise
+*/
 int
-ReadHpcgDat(int *localDimensions, int *secondsPerRun) {
+ReadHpcgDat(int *localDimensions, int *secondsPerRun, int *mgParameters) {
   FILE * hpcgStream = fopen("hpcg.dat", "r");
 
   if (! hpcgStream)
@@ -62,6 +76,21 @@ ReadHpcgDat(int *localDimensions, int *secondsPerRun) {
   if (fscanf(hpcgStream, "%d", secondsPerRun) != 1 || secondsPerRun[0] < 1)
     secondsPerRun[0] = 30 * 60; // 30 minutes
 
+  SkipUntilEol( hpcgStream ); // skip the rest of the fourth line
+
+  int levels, pre, post;
+  char cycle;
+  if (fscanf(hpcgStream, "%d %c %d %d", &levels, &cycle, &pre, &post) == 4) {
+    mgParameters[0] = levels;
+    switch (cycle) {
+      case 'W': case 'w': mgParameters[1] = MG_CYCLE_W; break;
+      case 'F': case 'f': mgParameters[1] = MG_CYCLE_F; break;
+      default: mgParameters[1] = MG_CYCLE_V; break;
+    }
+    mgParameters[2] = pre;
+    mgParameters[3] = post;
+  }
+
   fclose(hpcgStream);
 
   return 0;
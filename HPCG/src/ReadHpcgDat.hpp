@@ -15,6 +15,6 @@
 #ifndef READHPCGDAT_HPP
 #define READHPCGDAT_HPP
 
-int ReadHpcgDat(int *localDimensions, int *secondsPerRun);
+int ReadHpcgDat(int *localDimensions, int *secondsPerRun, int *mgParameters);
 
 #endif // READHPCGDAT_HPP
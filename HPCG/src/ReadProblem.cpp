@@ -0,0 +1,467 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file ReadProblem.cpp
+
+ HPCG routine
+ */
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/hpx_fwd.hpp>
+#endif
+
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <fstream>
+#include <vector>
+using std::endl;
+
+#include "hpcg.hpp"
+
+#include "ReadProblem.hpp"
+#include "GenerateGeometry.hpp"
+#include "Backend.hpp"
+#include "mytimer.hpp"
+
+/*!
+  Number of bytes of text parsed by one task.
+*/
+#define HPCG_READ_CHUNK_SIZE (1<<20)
+
+/*!
+  Writes an error message about the file to the log file and returns
+  non-zero.
+*/
+static int ReadError(const char * filename, const char * message) {
+  HPCG_fout << "Cannot read matrix file " << filename << ": " << message << endl;
+  return(1);
+}
+
+/*!
+  Reads the complete file into memory, followed by a zero byte so that the
+  text parser always stops at the end of the contents.
+
+  @param[in]  filename the name of the file
+  @param[out] contents the contents of the file
+
+  @return returns 0 upon success and non-zero otherwise
+*/
+static int ReadFile(const char * filename, std::vector<char> & contents) {
+
+  FILE * file = fopen(filename, "rb");
+  if (file==0) return(1);
+  if (fseek(file, 0, SEEK_END)!=0) { fclose(file); return(1); }
+  const long size = ftell(file);
+  if (size<0 || fseek(file, 0, SEEK_SET)!=0) { fclose(file); return(1); }
+  contents.resize(size+1);
+  const size_t bytesRead = fread(&contents[0], 1, size, file);
+  fclose(file);
+  contents[size] = 0;
+  return(bytesRead==(size_t)size ? 0 : 1);
+}
+
+/*!
+  Returns the end of the line starting at p, i.e. the position of its
+  newline character or end.
+*/
+static inline const char * LineEnd(const char * p, const char * end) {
+  const char * newline = (const char *) memchr(p, '\n', end-p);
+  return(newline ? newline : end);
+}
+
+/*!
+  Returns true if the line [p, lineEnd) holds an entry, i.e. is neither
+  blank nor a comment.
+*/
+static inline bool IsEntryLine(const char * p, const char * lineEnd) {
+  while (p<lineEnd && (*p==' ' || *p=='\t' || *p=='\r')) ++p;
+  return(p<lineEnd && *p!='%');
+}
+
+/*!
+  Returns the number of entry lines in [begin, end).
+*/
+static long long CountEntries(const char * begin, const char * end) {
+  long long count = 0;
+  for (const char * p = begin; p<end; ) {
+    const char * lineEnd = LineEnd(p, end);
+    if (IsEntryLine(p, lineEnd)) ++count;
+    p = lineEnd+1;
+  }
+  return(count);
+}
+
+/*!
+  Parses the entry lines "row column value" in [begin, end), with row and
+  column counted from 1.
+
+  @param[in]  begin, end the text of the entries
+  @param[in]  n the number of rows and columns of the matrix
+  @param[out] rows, columns the row and column of each entry, counted from 0
+  @param[out] values the value of each entry
+
+  @return returns 0 upon success and non-zero if a line is malformed or out of range
+*/
+static int ParseEntries(const char * begin, const char * end, long long n, local_int_t * rows, local_int_t * columns, double * values) {
+  long long k = 0;
+  for (const char * p = begin; p<end; ) {
+    const char * lineEnd = LineEnd(p, end);
+    if (IsEntryLine(p, lineEnd)) {
+      char * next = 0;
+      const long long row = strtoll(p, &next, 10);
+      if (next==p || next>lineEnd) return(1);
+      const char * q = next;
+      const long long column = strtoll(q, &next, 10);
+      if (next==q || next>lineEnd) return(1);
+      q = next;
+      const double value = strtod(q, &next);
+      if (next==q || next>lineEnd) return(1);
+      if (row<1 || row>n || column<1 || column>n) return(1);
+      rows[k] = (local_int_t) (row-1);
+      columns[k] = (local_int_t) (column-1);
+      values[k] = value;
+      ++k;
+    }
+    p = lineEnd+1;
+  }
+  return(0);
+}
+
+/*!
+  Builds the rows of the matrix and the vectors from a matrix in compressed
+  sparse row format. The entries of each row are sorted by column, so that
+  the lower triangular entries precede the diagonal as the Gauss-Seidel
+  smoothers require, and repeated entries are added.
+
+  @param[in]    filename the name of the file, for the error messages
+  @param[in]    n the number of rows
+  @param[in]    rowStart the first entry of each row, n+1 offsets
+  @param[in]    columns, values the column (counted from 0) and value of each entry
+  @param[in]    numThreads the number of threads, used for the thread subdomains
+  @param[inout] A the matrix, on exit its rows are defined
+  @param[out]   b, x, xexact the right hand side A*xexact, the initial guess zero and the exact solution one
+
+  @return returns 0 upon success and non-zero if a row has more than 127 entries or no diagonal entry
+*/
+static int AssembleRows(const char * filename, local_int_t n, const global_int_t * rowStart, const local_int_t * columns,
+    const double * values, int numThreads, SparseMatrix & A, Vector & b, Vector & x, Vector & xexact) {
+
+  for (local_int_t i=0; i<n; ++i)
+    if (rowStart[i+1]-rowStart[i]>127) return(ReadError(filename, "a row has more than 127 entries"));
+
+  // A matrix without grid: one row per point of an n x 1 x 1 grid
+  Geometry * geom = new Geometry;
+  GenerateGeometry(1, 0, numThreads, n, 1, 1, geom);
+  A.geom = geom;
+  A.totalNumberOfRows = n;
+  A.localNumberOfRows = n;
+  A.localNumberOfColumns = n;
+  A.nonzerosInRow = new char[n];
+  A.mtxIndG = new global_int_t*[n];
+  A.mtxIndL = new local_int_t*[n];
+  A.matrixValues = new double*[n];
+  A.matrixDiagonal = new double*[n];
+
+  const double numberOfBadRows = BackendParallelSum(HPCG_backends.spmv, n, [&A, rowStart, columns, values](local_int_t i) {
+    const int count = (int) (rowStart[i+1]-rowStart[i]);
+    local_int_t * const indL = A.mtxIndL[i] = new local_int_t[count];
+    global_int_t * const indG = A.mtxIndG[i] = new global_int_t[count];
+    double * const rowValues = A.matrixValues[i] = new double[count];
+    A.matrixDiagonal[i] = rowValues;
+
+    // Insertion sort, the rows are short
+    int numberOfNonzeros = 0;
+    for (global_int_t k=rowStart[i]; k<rowStart[i+1]; ++k) {
+      int j = numberOfNonzeros;
+      while (j>0 && indL[j-1]>columns[k]) --j;
+      if (j>0 && indL[j-1]==columns[k]) { rowValues[j-1] += values[k]; continue; }
+      for (int l=numberOfNonzeros; l>j; --l) { indL[l] = indL[l-1]; rowValues[l] = rowValues[l-1]; }
+      indL[j] = columns[k];
+      rowValues[j] = values[k];
+      ++numberOfNonzeros;
+    }
+    A.nonzerosInRow[i] = (char) numberOfNonzeros;
+
+    bool hasDiagonal = false;
+    for (int j=0; j<numberOfNonzeros; ++j) {
+      indG[j] = indL[j];
+      if (indL[j]==i) { A.matrixDiagonal[i] = rowValues+j; hasDiagonal = true; }
+    }
+    return(hasDiagonal ? 0.0 : 1.0);
+  });
+
+  global_int_t numberOfNonzeros = 0;
+  for (local_int_t i=0; i<n; ++i) numberOfNonzeros += A.nonzerosInRow[i];
+  A.totalNumberOfNonzeros = numberOfNonzeros;
+  A.localNumberOfNonzeros = numberOfNonzeros;
+  A.localToGlobalMap.resize(n);
+  for (local_int_t i=0; i<n; ++i) A.localToGlobalMap[i] = i;
+
+  A.numberOfSubdomains = geom->ntx*geom->nty*geom->ntz;
+  A.subdomainStart = new local_int_t[A.numberOfSubdomains+1];
+  A.subdomainRows = new local_int_t[n];
+  GenerateBlockRows(n, 1, 1, geom->ntx, geom->nty, geom->ntz, A.subdomainStart, A.subdomainRows, 0);
+
+  if (numberOfBadRows>0.0) return(ReadError(filename, "a row has no diagonal entry"));
+
+  InitializeVector(b, n);
+  InitializeVector(x, n);
+  InitializeVector(xexact, n);
+  double * const bv = b.values;
+  double * const xv = x.values;
+  double * const xexactv = xexact.values;
+  BackendParallelFor(HPCG_backends.spmv, n, [&A, bv, xv, xexactv](local_int_t i) {
+    double sum = 0.0;
+    for (int j=0; j<A.nonzerosInRow[i]; ++j) sum += A.matrixValues[i][j];
+    bv[i] = sum;
+    xv[i] = 0.0;
+    xexactv[i] = 1.0;
+  });
+  return(0);
+}
+
+/*!
+  Converts the entries of a MatrixMarket file to compressed sparse row format.
+
+  The text after the size line is split into chunks of about
+  HPCG_READ_CHUNK_SIZE bytes at line boundaries. The entries of every chunk
+  are counted in parallel, which gives the position of the first entry of
+  each chunk, and then parsed in parallel.
+*/
+static int ParseMatrixMarket(const char * filename, const std::vector<char> & contents, ReadProblemData & data,
+    local_int_t & n, std::vector<global_int_t> & rowStart, std::vector<local_int_t> & columns, std::vector<double> & values) {
+
+  const char * const text = &contents[0];
+  const char * const end = text+contents.size()-1;
+
+  // Banner: %%MatrixMarket matrix coordinate real|integer general|symmetric
+  char banner[5][32];
+  if (sscanf(text, "%31s %31s %31s %31s %31s", banner[0], banner[1], banner[2], banner[3], banner[4])!=5)
+    return(ReadError(filename, "no MatrixMarket banner"));
+  for (int k=1; k<5; ++k)
+    for (char * c = banner[k]; *c; ++c) *c = (char) tolower(*c);
+  if (strcmp(banner[1], "matrix")!=0 || strcmp(banner[2], "coordinate")!=0)
+    return(ReadError(filename, "only sparse matrices in coordinate format are supported"));
+  if (strcmp(banner[3], "real")!=0 && strcmp(banner[3], "integer")!=0)
+    return(ReadError(filename, "only real and integer matrices are supported"));
+  if (strcmp(banner[4], "general")!=0 && strcmp(banner[4], "symmetric")!=0)
+    return(ReadError(filename, "only general and symmetric matrices are supported"));
+  const bool symmetric = strcmp(banner[4], "symmetric")==0;
+
+  // Size line after the comments
+  const char * body = LineEnd(text, end)+1;
+  while (body<end && !IsEntryLine(body, LineEnd(body, end))) body = LineEnd(body, end)+1;
+  long long numberOfRows = 0, numberOfColumns = 0, numberOfEntries = 0;
+  if (body>=end || sscanf(body, "%lld %lld %lld", &numberOfRows, &numberOfColumns, &numberOfEntries)!=3)
+    return(ReadError(filename, "no size line"));
+  if (numberOfRows!=numberOfColumns || numberOfRows<1 || numberOfEntries<1) return(ReadError(filename, "the matrix is not square"));
+  if (numberOfRows>INT_MAX) return(ReadError(filename, "too many rows")); // The grid dimensions are int
+  body = LineEnd(body, end)+1;
+  if (body>end) body = end;
+  n = (local_int_t) numberOfRows;
+
+  // Chunks start after a newline
+  const long long length = end-body;
+  const local_int_t numberOfChunks = (local_int_t) (length/HPCG_READ_CHUNK_SIZE+1);
+  std::vector<const char *> chunkStart(numberOfChunks+1);
+  chunkStart[0] = body;
+  chunkStart[numberOfChunks] = end;
+  for (local_int_t k=1; k<numberOfChunks; ++k) {
+    const char * p = body+(length*k)/numberOfChunks;
+    p = LineEnd(p-1, end)+1;
+    if (p>end) p = end;
+    chunkStart[k] = (p<chunkStart[k-1]) ? chunkStart[k-1] : p;
+  }
+
+  std::vector<long long> chunkEntries(numberOfChunks+1, 0);
+  const char * const * const chunkStartv = &chunkStart[0];
+  long long * const chunkEntriesv = &chunkEntries[0];
+  BackendParallelFor(HPCG_backends.spmv, numberOfChunks, [chunkStartv, chunkEntriesv](local_int_t k) {
+    chunkEntriesv[k+1] = CountEntries(chunkStartv[k], chunkStartv[k+1]);
+  });
+  for (local_int_t k=0; k<numberOfChunks; ++k) chunkEntries[k+1] += chunkEntries[k];
+  if (chunkEntries[numberOfChunks]!=numberOfEntries) return(ReadError(filename, "the number of entries differs from the size line"));
+
+  std::vector<local_int_t> entryRows(numberOfEntries), entryColumns(numberOfEntries);
+  std::vector<double> entryValues(numberOfEntries);
+  local_int_t * const entryRowsv = &entryRows[0];
+  local_int_t * const entryColumnsv = &entryColumns[0];
+  double * const entryValuesv = &entryValues[0];
+  const double numberOfBadChunks = BackendParallelSum(HPCG_backends.spmv, numberOfChunks,
+      [chunkStartv, chunkEntriesv, numberOfRows, entryRowsv, entryColumnsv, entryValuesv](local_int_t k) {
+    const long long first = chunkEntriesv[k];
+    return(ParseEntries(chunkStartv[k], chunkStartv[k+1], numberOfRows, entryRowsv+first, entryColumnsv+first, entryValuesv+first)==0 ? 0.0 : 1.0);
+  });
+  if (numberOfBadChunks>0.0) return(ReadError(filename, "malformed entry or index out of range"));
+
+  // Compressed sparse rows, a symmetric file stores each off-diagonal entry once
+  rowStart.assign(n+1, 0);
+  for (long long k=0; k<numberOfEntries; ++k) {
+    ++rowStart[entryRows[k]+1];
+    if (symmetric && entryRows[k]!=entryColumns[k]) ++rowStart[entryColumns[k]+1];
+  }
+  for (local_int_t i=0; i<n; ++i) rowStart[i+1] += rowStart[i];
+  columns.resize(rowStart[n]);
+  values.resize(rowStart[n]);
+  std::vector<global_int_t> next(rowStart.begin(), rowStart.end()-1);
+  for (long long k=0; k<numberOfEntries; ++k) {
+    const local_int_t i = entryRows[k], j = entryColumns[k];
+    columns[next[i]] = j;
+    values[next[i]++] = entryValues[k];
+    if (symmetric && i!=j) {
+      columns[next[j]] = i;
+      values[next[j]++] = entryValues[k];
+    }
+  }
+
+  data.symmetric = symmetric ? 1 : 0;
+  data.numberOfEntries = numberOfEntries;
+  return(0);
+}
+
+/*!
+  Converts the contents of a binary CSR file to compressed sparse row format.
+*/
+static int ParseBinaryCSR(const char * filename, const std::vector<char> & contents, ReadProblemData & data,
+    local_int_t & n, std::vector<global_int_t> & rowStart, std::vector<local_int_t> & columns, std::vector<double> & values) {
+
+  BinaryCSRHeader header;
+  memcpy(&header, &contents[0], sizeof(header));
+  const long long numberOfRows = header.numberOfRows, numberOfNonzeros = header.numberOfNonzeros;
+  if (numberOfRows<1 || numberOfRows>INT_MAX || numberOfNonzeros<1 || numberOfNonzeros>(long long)contents.size())
+    return(ReadError(filename, "invalid header"));
+  const size_t expectedSize = sizeof(header) + (numberOfRows+1)*sizeof(long long) + numberOfNonzeros*(sizeof(long long)+sizeof(double));
+  if (contents.size()-1!=expectedSize) return(ReadError(filename, "the file size does not match the header"));
+  n = (local_int_t) numberOfRows;
+
+  const char * const fileRowStart = &contents[sizeof(header)];
+  const char * const fileColumns = fileRowStart + (numberOfRows+1)*sizeof(long long);
+  const char * const fileValues = fileColumns + numberOfNonzeros*sizeof(long long);
+
+  rowStart.resize(n+1);
+  for (local_int_t i=0; i<=n; ++i) {
+    long long start;
+    memcpy(&start, fileRowStart+i*sizeof(long long), sizeof(long long));
+    rowStart[i] = start;
+    if ((i==0 && start!=0) || (i>0 && start<rowStart[i-1]) || (i==n && start!=numberOfNonzeros))
+      return(ReadError(filename, "invalid row offsets"));
+  }
+
+  columns.resize(numberOfNonzeros);
+  values.resize(numberOfNonzeros);
+  local_int_t * const columnsv = &columns[0];
+  double * const valuesv = &values[0];
+  const global_int_t * const rowStartv = &rowStart[0];
+  const double numberOfBadRows = BackendParallelSum(HPCG_backends.spmv, n,
+      [fileColumns, fileValues, rowStartv, columnsv, valuesv, numberOfRows](local_int_t i) {
+    double bad = 0.0;
+    for (global_int_t k=rowStartv[i]; k<rowStartv[i+1]; ++k) {
+      long long column;
+      memcpy(&column, fileColumns+k*sizeof(long long), sizeof(long long));
+      memcpy(valuesv+k, fileValues+k*sizeof(double), sizeof(double));
+      if (column<0 || column>=numberOfRows) bad = 1.0;
+      columnsv[k] = (local_int_t) column;
+    }
+    return(bad);
+  });
+  if (numberOfBadRows>0.0) return(ReadError(filename, "column index out of range"));
+
+  data.symmetric = 0;
+  data.numberOfEntries = numberOfNonzeros;
+  return(0);
+}
+
+/*!
+  Returns the format WriteMatrix uses for the file name: MatrixMarket for
+  names ending in .mtx, binary CSR otherwise.
+
+  @param[in] filename the name of the file
+
+  @return one of ProblemFileFormat_ENUM
+*/
+int ProblemFileFormatOfName(const char * filename) {
+  const size_t length = strlen(filename);
+  return((length>=4 && strcmp(filename+length-4, ".mtx")==0) ? PROBLEM_FILE_MATRIX_MARKET : PROBLEM_FILE_BINARY_CSR);
+}
+
+/*!
+  Reads a symmetric positive definite matrix from a file in place of the
+  synthetic problem of GenerateProblem. The format is recognized from the
+  contents: MatrixMarket coordinate files (real or integer, general or
+  symmetric) or binary CSR files as written by WriteMatrix.
+
+  The file is read into memory with one read, the text is then parsed and
+  the rows are built in parallel with the backend of the SpMV. The matrix
+  has the geometry of an n x 1 x 1 grid on one process, so the kernels that
+  do not depend on the 27-point stencil can be applied to it; the multigrid
+  hierarchy cannot be built. Rows may have at most 127 entries and must have
+  a diagonal entry. The exact solution is one, the right hand side is A
+  times the exact solution and the initial guess is zero, as for the
+  synthetic problem.
+
+  NOTE:  THIS CODE ONLY WORKS ON SINGLE PROCESSOR RUNS
+
+  @param[in]  filename the name of the file
+  @param[in]  numThreads the number of threads, used for the thread subdomains
+  @param[out] A the matrix, initialized with InitializeSparseMatrix, on exit it also owns its geometry
+  @param[out] b, x, xexact the right hand side, the initial guess and the exact solution
+  @param[out] data the size of the file and the time of each step
+
+  @return returns 0 upon success and non-zero otherwise, the reason is written to the log file
+
+  @see WriteMatrix
+*/
+int ReadProblem(const char * filename, int numThreads, SparseMatrix & A, Vector & b, Vector & x, Vector & xexact, ReadProblemData & data) {
+
+  data.format = PROBLEM_FILE_MATRIX_MARKET;
+  data.symmetric = 0;
+  data.fileSize = 0.0;
+  data.numberOfEntries = 0;
+  data.readTime = data.parseTime = data.assembleTime = 0.0;
+
+  double t0 = mytimer();
+  std::vector<char> contents;
+  if (ReadFile(filename, contents)!=0) return(ReadError(filename, "the file cannot be read"));
+  data.fileSize = contents.size()-1;
+  data.readTime = mytimer() - t0;
+
+  t0 = mytimer();
+  local_int_t n = 0;
+  std::vector<global_int_t> rowStart;
+  std::vector<local_int_t> columns;
+  std::vector<double> values;
+  int ierr = 0;
+  if (contents.size()>strlen("%%MatrixMarket") && strncmp(&contents[0], "%%MatrixMarket", strlen("%%MatrixMarket"))==0) {
+    data.format = PROBLEM_FILE_MATRIX_MARKET;
+    ierr = ParseMatrixMarket(filename, contents, data, n, rowStart, columns, values);
+  } else if (contents.size()>sizeof(BinaryCSRHeader) && memcmp(&contents[0], "HPCGCSR", 8)==0) {
+    data.format = PROBLEM_FILE_BINARY_CSR;
+    ierr = ParseBinaryCSR(filename, contents, data, n, rowStart, columns, values);
+  } else {
+    ierr = ReadError(filename, "neither a MatrixMarket nor a binary CSR file");
+  }
+  if (ierr!=0) return(ierr);
+  std::vector<char>().swap(contents); // Release the text before the rows are allocated
+  data.parseTime = mytimer() - t0;
+
+  t0 = mytimer();
+  ierr = AssembleRows(filename, n, &rowStart[0], &columns[0], &values[0], numThreads, A, b, x, xexact);
+  data.assembleTime = mytimer() - t0;
+  return(ierr);
+}
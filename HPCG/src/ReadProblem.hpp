@@ -0,0 +1,65 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file ReadProblem.hpp
+
+ HPCG routines to read a matrix from a file
+ */
+
+#ifndef READPROBLEM_HPP
+#define READPROBLEM_HPP
+
+#include "SparseMatrix.hpp"
+#include "Vector.hpp"
+
+/*!
+  The file formats of ReadProblem and WriteMatrix.
+*/
+enum ProblemFileFormat_ENUM {
+  PROBLEM_FILE_MATRIX_MARKET = 0, //!< MatrixMarket coordinate format, real or integer, general or symmetric
+  PROBLEM_FILE_BINARY_CSR = 1 //!< raw binary compressed sparse row format, see ReadProblem.cpp
+};
+
+/*!
+  The header of a binary CSR file. It is followed by numberOfRows+1 row
+  offsets, numberOfNonzeros column indices (all long long, counted from 0)
+  and numberOfNonzeros values (double), in the byte order of the machine.
+  All entries of the matrix are stored, not only one triangle.
+*/
+struct BinaryCSRHeader_STRUCT {
+  char magic[8]; //!< "HPCGCSR" followed by a zero byte
+  long long numberOfRows; //!< number of rows and columns of the matrix
+  long long numberOfNonzeros; //!< number of stored entries
+};
+typedef struct BinaryCSRHeader_STRUCT BinaryCSRHeader;
+
+/*!
+  Statistics of reading a matrix file.
+*/
+struct ReadProblemData_STRUCT {
+  int format; //!< format of the file, one of ProblemFileFormat_ENUM
+  int symmetric; //!< 1 if the file stores only one triangle of the matrix
+  double fileSize; //!< size of the file in bytes
+  global_int_t numberOfEntries; //!< number of entries stored in the file
+  double readTime; //!< time to read the file into memory
+  double parseTime; //!< time to convert the contents of the file into matrix entries
+  double assembleTime; //!< time to build the matrix rows from the entries
+};
+typedef struct ReadProblemData_STRUCT ReadProblemData;
+
+int ReadProblem(const char * filename, int numThreads, SparseMatrix & A, Vector & b, Vector & x, Vector & xexact, ReadProblemData & data);
+int ProblemFileFormatOfName(const char * filename);
+
+#endif // READPROBLEM_HPP
@@ -0,0 +1,162 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file ReferenceCache.cpp
+
+ HPCG routine
+ */
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/hpx_fwd.hpp>
+#endif
+
+#ifndef HPCG_NOMPI
+#include <mpi.h>
+#endif
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "ReferenceCache.hpp"
+#include "Backend.hpp"
+#include "MGData.hpp"
+#include "hpcg.hpp"
+
+/*!
+  Everything the reference phases depend on. A cache file is only used if its
+  key equals the key of the current run.
+*/
+struct ReferenceCacheKey_STRUCT {
+  char magic[8]; //!< "HPCGREF" followed by a zero byte
+  int version; //!< HPCG_REFERENCE_CACHE_VERSION of the writer
+  int localIntSize; //!< sizeof(local_int_t) of the writer
+  int globalIntSize; //!< sizeof(global_int_t) of the writer
+  int size; //!< number of processes
+  int npx, npy, npz; //!< process grid
+  int nx, ny, nz; //!< local grid of the finest level on rank 0
+  int gnx, gny, gnz; //!< global grid of the finest level
+  int numThreads; //!< number of threads of each process, the timings depend on it
+  int dotReduction; //!< HPCG_dotReduction, the summation order of the reference dot product
+  int referenceBackend; //!< HPCG_REFERENCE_BACKEND, the backend of the deterministic sums of the reference dot product
+  int numberOfLevels; //!< number of multigrid levels of the hierarchy
+  int numberOfPresmootherSteps[HPCG_MAX_MG_LEVELS]; //!< presmoother steps of the reference MG on each level
+  int numberOfPostsmootherSteps[HPCG_MAX_MG_LEVELS]; //!< postsmoother steps of the reference MG on each level
+  int refMaxIters; //!< number of iterations of the reference CG
+};
+typedef struct ReferenceCacheKey_STRUCT ReferenceCacheKey;
+
+/*!
+  Returns the key of the reference phases of the problem A.
+
+  @param[in]  A the matrix of the finest level, with the multigrid hierarchy
+  @param[in]  refMaxIters the number of iterations of the reference CG
+  @param[out] key the key
+*/
+static void MakeKey(const SparseMatrix & A, int refMaxIters, ReferenceCacheKey & key) {
+  const Geometry & geom = *A.geom;
+  memset(&key, 0, sizeof(key)); // Also clears the padding, the keys are compared with memcmp
+  memcpy(key.magic, "HPCGREF", 8);
+  key.version = HPCG_REFERENCE_CACHE_VERSION;
+  key.localIntSize = sizeof(local_int_t);
+  key.globalIntSize = sizeof(global_int_t);
+  key.size = geom.size;
+  key.npx = geom.npx; key.npy = geom.npy; key.npz = geom.npz;
+  key.nx = geom.nx; key.ny = geom.ny; key.nz = geom.nz;
+  key.gnx = geom.gnx; key.gny = geom.gny; key.gnz = geom.gnz;
+  key.numThreads = geom.numThreads;
+  key.dotReduction = HPCG_dotReduction;
+  key.referenceBackend = HPCG_REFERENCE_BACKEND;
+  for (const SparseMatrix * M = &A; M!=0 && key.numberOfLevels<HPCG_MAX_MG_LEVELS; M = M->Ac) {
+    if (M->mgData!=0) {
+      key.numberOfPresmootherSteps[key.numberOfLevels] = M->mgData->numberOfPresmootherSteps;
+      key.numberOfPostsmootherSteps[key.numberOfLevels] = M->mgData->numberOfPostsmootherSteps;
+    }
+    ++key.numberOfLevels;
+  }
+  key.refMaxIters = refMaxIters;
+}
+
+/*!
+  Returns the name of the reference cache file of the given problem. The
+  name holds the global grid and the process grid, the file is shared by all
+  processes.
+
+  @param[in]  directory the directory of the cache files
+  @param[in]  geom the geometry of the finest level
+  @param[out] filename the file name
+  @param[in]  length the size of filename
+*/
+void ReferenceCacheFileName(const char * directory, const Geometry & geom, char * filename, size_t length) {
+  snprintf(filename, length, "%s/hpcg_reference_%dx%dx%d_%dx%dx%d.bin", directory, geom.gnx, geom.gny, geom.gnz,
+      geom.npx, geom.npy, geom.npz);
+}
+
+/*!
+  Reads the results of the reference phases from the cache file. Rank 0 reads
+  the file and broadcasts the results, so all processes use the same values.
+
+  @param[in]  filename the file written by WriteReferenceCache
+  @param[in]  A the matrix of the finest level, with the multigrid hierarchy
+  @param[in]  refMaxIters the number of iterations of the reference CG
+  @param[out] results the cached results
+
+  @return returns 0 on all processes if the file holds the results of this problem, non-zero otherwise
+*/
+int ReadReferenceCache(const char * filename, const SparseMatrix & A, int refMaxIters, ReferenceResults & results) {
+  int valid = 0;
+  if (A.geom->rank==0) {
+    ReferenceCacheKey key, fileKey;
+    MakeKey(A, refMaxIters, key);
+    FILE * file = fopen(filename, "rb");
+    if (file!=0) {
+      valid = fread(&fileKey, sizeof(fileKey), 1, file)==1 && memcmp(&key, &fileKey, sizeof(key))==0
+          && fread(&results, sizeof(results), 1, file)==1;
+      fclose(file);
+    }
+  }
+#ifndef HPCG_NOMPI
+  MPI_Bcast(&valid, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  if (valid) MPI_Bcast(&results, sizeof(results), MPI_BYTE, 0, MPI_COMM_WORLD);
+#endif
+  return(valid ? 0 : 1);
+}
+
+/*!
+  Writes the results of the reference phases to the cache file. Only rank 0
+  writes; the file is written under a temporary name and renamed when
+  complete, so concurrent runs never read a partial file.
+
+  @param[in] filename the name of the cache file
+  @param[in] A the matrix of the finest level, with the multigrid hierarchy
+  @param[in] refMaxIters the number of iterations of the reference CG
+  @param[in] results the results of the reference phases on rank 0
+
+  @return returns 0 upon success and non-zero otherwise, on rank 0 only
+*/
+int WriteReferenceCache(const char * filename, const SparseMatrix & A, int refMaxIters, const ReferenceResults & results) {
+  if (A.geom->rank!=0) return(0);
+  ReferenceCacheKey key;
+  MakeKey(A, refMaxIters, key);
+  std::string temporary = std::string(filename) + ".tmp";
+  FILE * file = fopen(temporary.c_str(), "wb");
+  if (file==0) return(1);
+  bool success = fwrite(&key, sizeof(key), 1, file)==1 && fwrite(&results, sizeof(results), 1, file)==1;
+  success = fclose(file)==0 && success;
+  if (success) success = rename(temporary.c_str(), filename)==0;
+  if (!success) remove(temporary.c_str());
+  return(success ? 0 : 1);
+}
@@ -0,0 +1,48 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file ReferenceCache.hpp
+
+ HPCG cache of the results of the reference timing phases
+ */
+
+#ifndef REFERENCECACHE_HPP
+#define REFERENCECACHE_HPP
+
+#include <cstddef>
+
+#include "Geometry.hpp"
+#include "SparseMatrix.hpp"
+
+#define HPCG_REFERENCE_CACHE_VERSION 4 //!< version of the cache file format, increased when the layout or the reference kernels change
+
+/*!
+  The results of the reference SpMV+MG and reference CG timing phases that
+  the rest of the benchmark depends on.
+*/
+struct ReferenceResults_STRUCT {
+  double tolerance; //!< residual reduction of the reference CG after refMaxIters iterations, the tolerance of the optimized CG
+  double spmvMgTime; //!< time of one reference SpMV followed by one reference MG (sec)
+  double cgTime; //!< time of the reference CG (sec)
+  int cgIterations; //!< iterations of the reference CG
+};
+typedef struct ReferenceResults_STRUCT ReferenceResults;
+
+extern void ReferenceCacheFileName(const char * directory, const Geometry & geom, char * filename, size_t length);
+extern int ReadReferenceCache(const char * filename, const SparseMatrix & A, int refMaxIters, ReferenceResults & results);
+extern int WriteReferenceCache(const char * filename, const SparseMatrix & A, int refMaxIters, const ReferenceResults & results);
+
+#endif // REFERENCECACHE_HPP
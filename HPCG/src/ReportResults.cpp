@@ -22,9 +22,18 @@
 #include <mpi.h> // If this routine is not compiled with HPCG_NOMPI
 #endif
 
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
 #include "ReportResults.hpp"
 #include "YAML_Element.hpp"
 #include "YAML_Doc.hpp"
+#include "Backend.hpp"
+#include "CG.hpp"
+#include "ComputeCholesky.hpp"
+#include "KernelCounters.hpp"
+#include "MatrixFormat.hpp"
 
 #ifdef HPCG_DEBUG
 #include <fstream>
@@ -33,6 +42,71 @@ using std::endl;
 #include "hpcg.hpp"
 #endif
 
+/*!
+ Returns the number of floating point operations of one application of the
+ smoother selected for the level of the given matrix. This count is only
+ reported for information, the rating uses that of the reference smoother.
+
+  @param[in] A The matrix of the multigrid level
+*/
+static double SmootherFlops(const SparseMatrix & A) {
+  double fnnz = (double)A.totalNumberOfNonzeros;
+  double fnrow = (double)A.totalNumberOfRows;
+  if (A.smootherData!=0 && A.smootherData->type==SMOOTHER_CHEBYSHEV) {
+    double fdegree = A.smootherData->degree;
+    // degree SpMVs and residual updates, plus the fused direction and solution updates
+    return fdegree*(2.0*fnnz+2.0*fnrow) + 3.0*fnrow + (fdegree-1.0)*5.0*fnrow;
+  }
+  return 4.0*fnnz; // One symmetric GS sweep
+}
+
+/*!
+  Statistics of the calls of one kernel on one multigrid level over all
+  processes.
+*/
+struct KernelStatistics_STRUCT {
+  long long calls; //!< number of calls on this process
+  double timeMin; //!< smallest cumulative time of the calls on any process (sec)
+  double timeMean; //!< mean cumulative time of the calls over all processes (sec)
+  double timeMax; //!< largest cumulative time of the calls on any process (sec)
+  double bytes; //!< minimum memory traffic of the calls summed over all processes
+};
+typedef struct KernelStatistics_STRUCT KernelStatistics;
+
+/*!
+ Combines the kernel counters of the benchmark phase of all processes.
+
+  @param[in]  size the number of processes
+  @param[out] statistics the statistics of each level and kernel
+*/
+static void GatherKernelStatistics(int size, KernelStatistics statistics[HPCG_MAX_MG_LEVELS][HPCG_NUMBER_OF_KERNELS]) {
+  const int n = HPCG_MAX_MG_LEVELS*HPCG_NUMBER_OF_KERNELS;
+  double local[2*n], minimum[2*n], maximum[2*n], sum[2*n]; // times followed by the traffic of each level and kernel
+  for (int level=0; level<HPCG_MAX_MG_LEVELS; ++level)
+    for (int kernel=0; kernel<HPCG_NUMBER_OF_KERNELS; ++kernel) {
+      local[level*HPCG_NUMBER_OF_KERNELS+kernel] = HPCG_kernelCounters[level][kernel].time*1.0E-9;
+      local[n+level*HPCG_NUMBER_OF_KERNELS+kernel] = (double) HPCG_kernelCounters[level][kernel].bytes;
+    }
+#ifndef HPCG_NOMPI
+  MPI_Allreduce(local, minimum, 2*n, MPI_DOUBLE, MPI_MIN, MPI_COMM_WORLD);
+  MPI_Allreduce(local, maximum, 2*n, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  MPI_Allreduce(local, sum, 2*n, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+#else
+  size = 1; // Without MPI the statistics are those of this locality
+  for (int i=0; i<2*n; ++i) minimum[i] = maximum[i] = sum[i] = local[i];
+#endif
+  for (int level=0; level<HPCG_MAX_MG_LEVELS; ++level)
+    for (int kernel=0; kernel<HPCG_NUMBER_OF_KERNELS; ++kernel) {
+      const int i = level*HPCG_NUMBER_OF_KERNELS+kernel;
+      KernelStatistics & entry = statistics[level][kernel];
+      entry.calls = HPCG_kernelCounters[level][kernel].count;
+      entry.timeMin = minimum[i];
+      entry.timeMean = sum[i]/size;
+      entry.timeMax = maximum[i];
+      entry.bytes = sum[n+i];
+    }
+}
+
 /*!
  Creates a YAML file and writes the information about the HPCG run, its results, and validity.
 
@@ -45,12 +119,18 @@ using std::endl;
   @param[in] testcg_data    the data structure with the results of the CG-correctness test including pass/fail information
   @param[in] testsymmetry_data the data structure with the results of the CG symmetry test including pass/fail information
   @param[in] testnorms_data the data structure with the results of the CG norm test including pass/fail information
+  @param[in] coarse_data the data structure with the comparison of the coarse grid solvers
+  @param[in] multicg_data the data structure with the throughput of the multiple right-hand-side solver
+  @param[in] ensemble_data the data structure with the times of the ensemble of independent problems
+  @param[in] memory_data the memory used by the problem on each process
   @param[in] global_failure indicates whether a failure occured during the correctness tests of CG
 
   @see YAML_Doc
 */
 void ReportResults(const SparseMatrix & A, int numberOfMgLevels, int numberOfCgSets, int refMaxIters,int optMaxIters, double times[],
-        const TestCGData & testcg_data, const TestSymmetryData & testsymmetry_data, const TestNormsData & testnorms_data, int global_failure) {
+        const TestCGData & testcg_data, const TestSymmetryData & testsymmetry_data, const TestNormsData & testnorms_data,
+        const CoarseSolverComparisonData & coarse_data, const MultiCGBenchmarkData & multicg_data, const EnsembleData & ensemble_data,
+        const MemoryUsage & memory_data, int global_failure) {
 
   double minOfficialTime = 3600; // Any official benchmark result much run at least this many seconds
 
@@ -65,6 +145,9 @@ void ReportResults(const SparseMatrix & A, int numberOfMgLevels, int numberOfCgS
   t4avg = t4avg/((double) A.geom->size);
 #endif
 
+  KernelStatistics kernel_statistics[HPCG_MAX_MG_LEVELS][HPCG_NUMBER_OF_KERNELS];
+  GatherKernelStatistics(A.geom->size, kernel_statistics);
+
   // initialize YAML doc
 
   if (A.geom->rank==0) { // Only PE 0 needs to compute and report timing results
@@ -78,9 +161,12 @@ void ReportResults(const SparseMatrix & A, int numberOfMgLevels, int numberOfCgS
     double fnops_ddot = (3.0*fniters+fNumberOfCgSets)*2.0*fnrow; // 3 ddots with nrow adds and nrow mults
     double fnops_waxpby = (3.0*fniters+fNumberOfCgSets)*2.0*fnrow; // 3 WAXPBYs with nrow adds and nrow mults
     double fnops_sparsemv = (fniters+fNumberOfCgSets)*2.0*fnnz; // 1 SpMV with nnz adds and nnz mults
-    // Op counts from the multigrid preconditioners
+    // Op counts from the multigrid preconditioners. The official count is that of the reference V-cycle
+    // with one symmetric GS sweep per smoother step, so the rating does not depend on the selected smoother or cycle
     double fnops_precond = 0.0;
+    double fnops_precond_selected = 0.0; // the same count for the selected smoother and cycle, for information only
     const SparseMatrix * Af = &A;
+    int cycleType = (A.mgData!=0) ? A.mgData->cycleType : MG_CYCLE_V;
     for (int i=1; i<numberOfMgLevels; ++i) {
         double fnnz_Af = (double)Af->totalNumberOfNonzeros;
         double fnumberOfPresmootherSteps = Af->mgData->numberOfPresmootherSteps;
@@ -88,10 +174,20 @@ void ReportResults(const SparseMatrix & A, int numberOfMgLevels, int numberOfCgS
         fnops_precond += fnumberOfPresmootherSteps*fniters*4.0*fnnz_Af; // number of presmoother flops
         fnops_precond += fniters*2.0*fnnz_Af; // cost of fine grid residual calculation
         fnops_precond += fnumberOfPostsmootherSteps*fniters*4.0*fnnz_Af;  // number of postsmoother flops
+        double fvisits = MGCycleLevelVisits(cycleType, i-1); // number of times the level is visited per selected cycle
+        fnops_precond_selected += fvisits*(fnumberOfPresmootherSteps+fnumberOfPostsmootherSteps)*fniters*SmootherFlops(*Af);
+        fnops_precond_selected += fvisits*fniters*2.0*fnnz_Af;
         Af = Af->Ac; // Go to next coarse level
     }
 
-    fnops_precond += fniters*4.0*((double) Af->totalNumberOfNonzeros); // One symmetric GS sweep at the coarsest level
+    fnops_precond += fniters*4.0*((double)Af->totalNumberOfNonzeros); // One symmetric GS sweep at the coarsest level
+    double fnops_coarse_solve = 0.0; // the direct solve replacing the coarsest level smoother, for information only
+    if (Af->smootherData!=0 && Af->smootherData->type==SMOOTHER_CHOLESKY) {
+      double fbandwidth = Af->smootherData->factorBandwidth;
+      double fcoarseRows = (double)Af->totalNumberOfRows;
+      fnops_coarse_solve = MGCycleLevelVisits(cycleType, numberOfMgLevels-1)*fniters*fcoarseRows*(4.0*fbandwidth+2.0); // Forward and backward substitution with the banded factor
+    } else
+      fnops_precond_selected += MGCycleLevelVisits(cycleType, numberOfMgLevels-1)*fniters*SmootherFlops(*Af);
     double fnops = fnops_ddot+fnops_waxpby+fnops_sparsemv+fnops_precond;
     double reffnops = fnops * ((double) refMaxIters)/((double) optMaxIters);
 
@@ -103,9 +199,10 @@ void ReportResults(const SparseMatrix & A, int numberOfMgLevels, int numberOfCgS
     doc.get("Machine Summary")->add("Threads per processes",A.geom->numThreads);
 
     doc.add("Global Problem Dimensions","");
-    doc.get("Global Problem Dimensions")->add("Global nx",A.geom->npx*A.geom->nx);
-    doc.get("Global Problem Dimensions")->add("Global ny",A.geom->npy*A.geom->ny);
-    doc.get("Global Problem Dimensions")->add("Global nz",A.geom->npz*A.geom->nz);
+    doc.get("Global Problem Dimensions")->add("Global nx",A.geom->gnx);
+    doc.get("Global Problem Dimensions")->add("Global ny",A.geom->gny);
+    doc.get("Global Problem Dimensions")->add("Global nz",A.geom->gnz);
+    doc.get("Global Problem Dimensions")->add("Scaling",(A.geom->strongScaling ? "strong" : "weak"));
 
     doc.add("Processor Dimensions","");
     doc.get("Processor Dimensions")->add("npx",A.geom->npx);
@@ -116,26 +213,188 @@ void ReportResults(const SparseMatrix & A, int numberOfMgLevels, int numberOfCgS
     doc.get("Local Domain Dimensions")->add("nx",A.geom->nx);
     doc.get("Local Domain Dimensions")->add("ny",A.geom->ny);
     doc.get("Local Domain Dimensions")->add("nz",A.geom->nz);
+    if (A.geom->strongScaling) { // The local grids of the processes differ, the dimensions above are those of rank 0
+      int largest[3] = {0, 0, 0};
+      for (int i=0; i<A.geom->npx; ++i) largest[0] = std::max(largest[0], A.geom->partx[i+1]-A.geom->partx[i]);
+      for (int i=0; i<A.geom->npy; ++i) largest[1] = std::max(largest[1], A.geom->party[i+1]-A.geom->party[i]);
+      for (int i=0; i<A.geom->npz; ++i) largest[2] = std::max(largest[2], A.geom->partz[i+1]-A.geom->partz[i]);
+      doc.get("Local Domain Dimensions")->add("Largest nx",largest[0]);
+      doc.get("Local Domain Dimensions")->add("Largest ny",largest[1]);
+      doc.get("Local Domain Dimensions")->add("Largest nz",largest[2]);
+    }
+
+    doc.add("Thread Subdomain Dimensions","");
+    doc.get("Thread Subdomain Dimensions")->add("ntx",A.geom->ntx);
+    doc.get("Thread Subdomain Dimensions")->add("nty",A.geom->nty);
+    doc.get("Thread Subdomain Dimensions")->add("ntz",A.geom->ntz);
+
+    doc.add("Kernel Backends","");
+    doc.get("Kernel Backends")->add("SpMV",BackendName(HPCG_backends.spmv));
+    doc.get("Kernel Backends")->add("DDOT",BackendName(HPCG_backends.dot));
+    doc.get("Kernel Backends")->add("DDOT reduction",ReductionName(HPCG_dotReduction));
+    doc.get("Kernel Backends")->add("CG",HPCG_cgDataflow ? "dataflow" : "synchronous");
+    doc.get("Kernel Backends")->add("WAXPBY",BackendName(HPCG_backends.waxpby));
+    doc.get("Kernel Backends")->add("MG",BackendName(HPCG_backends.mg));
+    doc.get("Kernel Backends")->add("Thread pool size",ThreadPoolSize());
 
     doc.add("********** Problem Summary  ***********","");
 
     doc.add("Linear System Information","");
     doc.get("Linear System Information")->add("Number of Equations",A.totalNumberOfRows);
     doc.get("Linear System Information")->add("Number of Nonzero Terms",A.totalNumberOfNonzeros);
+    doc.get("Linear System Information")->add("Local index size (bytes)",(int)sizeof(local_int_t));
+    doc.get("Linear System Information")->add("Global index size (bytes)",(int)sizeof(global_int_t));
 
     doc.add("Multigrid Information","");
     doc.get("Multigrid Information")->add("Number of coarse grid levels", numberOfMgLevels-1);
+    doc.get("Multigrid Information")->add("Cycle", MGCycleName((A.mgData!=0) ? A.mgData->cycleType : MG_CYCLE_V));
+    if (A.mgData!=0) {
+      doc.get("Multigrid Information")->add("Fine Grid","");
+      doc.get("Multigrid Information")->get("Fine Grid")->add("Number of Presmoother Steps",A.mgData->numberOfPresmootherSteps);
+      doc.get("Multigrid Information")->get("Fine Grid")->add("Number of Postsmoother Steps",A.mgData->numberOfPostsmootherSteps);
+    }
     Af = &A;
     doc.get("Multigrid Information")->add("Coarse Grids","");
     for (int i=1; i<numberOfMgLevels; ++i) {
         doc.get("Multigrid Information")->get("Coarse Grids")->add("Grid Level",i);
         doc.get("Multigrid Information")->get("Coarse Grids")->add("Number of Equations",Af->Ac->totalNumberOfRows);
         doc.get("Multigrid Information")->get("Coarse Grids")->add("Number of Nonzero Terms",Af->Ac->totalNumberOfNonzeros);
-        doc.get("Multigrid Information")->get("Coarse Grids")->add("Number of Presmoother Steps",Af->mgData->numberOfPresmootherSteps);
-        doc.get("Multigrid Information")->get("Coarse Grids")->add("Number of Postsmoother Steps",Af->mgData->numberOfPostsmootherSteps);
+        doc.get("Multigrid Information")->get("Coarse Grids")->add("Visits per cycle (not rated)",MGCycleLevelVisits(cycleType, i));
+        if (Af->Ac->mgData!=0) {
+          doc.get("Multigrid Information")->get("Coarse Grids")->add("Number of Presmoother Steps",Af->Ac->mgData->numberOfPresmootherSteps);
+          doc.get("Multigrid Information")->get("Coarse Grids")->add("Number of Postsmoother Steps",Af->Ac->mgData->numberOfPostsmootherSteps);
+        } else { // The coarsest grid is only smoothed once per visit
+          doc.get("Multigrid Information")->get("Coarse Grids")->add("Number of Smoother Steps",1);
+        }
         Af = Af->Ac;
     }
 
+    doc.add("Smoother Information","");
+    if (A.smootherData==0)
+      doc.get("Smoother Information")->add("Smoother", SmootherName(SMOOTHER_SYMGS));
+    else
+      doc.get("Smoother Information")->add("Smoother", SmootherName(A.smootherData->type));
+    if (A.smootherData!=0 && A.smootherData->type==SMOOTHER_CHEBYSHEV)
+      doc.get("Smoother Information")->add("Polynomial degree", A.smootherData->degree);
+    doc.get("Smoother Information")->add("Reference CG iterations per set", refMaxIters);
+    doc.get("Smoother Information")->add("Optimized CG iterations per set", optMaxIters);
+    Af = &A;
+    for (int i=0; i<numberOfMgLevels && Af!=0; ++i, Af = Af->Ac) {
+      if (Af->smootherData==0) continue;
+      std::ostringstream level;
+      level << "Level " << i;
+      doc.get("Smoother Information")->add(level.str(),"");
+      YAML_Element * levelElement = doc.get("Smoother Information")->get(level.str());
+      if (Af->smootherData->type==SMOOTHER_CHEBYSHEV) {
+        levelElement->add("Eigenvalue upper bound", Af->smootherData->lambdaMax);
+        levelElement->add("Eigenvalue lower bound", Af->smootherData->lambdaMin);
+      }
+      if (Af->smootherData->type==SMOOTHER_BLOCK_L1) {
+        levelElement->add("Number of blocks", Af->smootherData->numberOfBlocks);
+        levelElement->add("Blocks in x", Af->smootherData->blocksX);
+        levelElement->add("Blocks in y", Af->smootherData->blocksY);
+        levelElement->add("Blocks in z", Af->smootherData->blocksZ);
+      }
+      levelElement->add("Number of calls", Af->smootherData->numberOfCalls);
+      levelElement->add("Time (sec)", Af->smootherData->time);
+      if (Af->smootherData->numberOfCalls>0)
+        levelElement->add("Time per call (sec)", Af->smootherData->time/Af->smootherData->numberOfCalls);
+    }
+
+    doc.add("Matrix Format Information","");
+    doc.get("Matrix Format Information")->add("Requested format", MatrixFormatName(HPCG_matrixFormat));
+    Af = &A;
+    for (int i=0; i<numberOfMgLevels && Af!=0; ++i, Af = Af->Ac) {
+      std::ostringstream level;
+      level << "Level " << i;
+      doc.get("Matrix Format Information")->add(level.str(),"");
+      YAML_Element * levelElement = doc.get("Matrix Format Information")->get(level.str());
+      levelElement->add("Format", MatrixFormatName(LevelMatrixFormat(*Af)));
+      const MatrixFormatData * formatData = (const MatrixFormatData *) Af->optimizationData;
+      if (formatData==0 || !formatData->calibrated) continue;
+      for (int format=0; format<HPCG_NUMBER_OF_MATRIX_FORMATS; ++format) {
+        levelElement->add(std::string("SpMV time per call ") + MatrixFormatName(format) + " (sec)", formatData->spmvTime[format]);
+        levelElement->add(std::string("Smoother time per call ") + MatrixFormatName(format) + " (sec)", formatData->smootherTime[format]);
+      }
+    }
+
+    doc.add("Coarse Grid Solver","");
+    Af = &A;
+    while (Af->Ac) Af = Af->Ac;
+    if (Af->smootherData!=0 && Af->smootherData->type==SMOOTHER_CHOLESKY) {
+      doc.get("Coarse Grid Solver")->add("Solver", SmootherName(SMOOTHER_CHOLESKY));
+      doc.get("Coarse Grid Solver")->add("Factor bandwidth", Af->smootherData->factorBandwidth);
+      doc.get("Coarse Grid Solver")->add("Agglomerated", (Af->smootherData->agglomerated ? "yes" : "no"));
+    } else {
+      doc.get("Coarse Grid Solver")->add("Solver", "Smoother");
+      if (Af->smootherData!=0 && Af->smootherData->factorTooLarge) {
+        doc.get("Coarse Grid Solver")->add("Direct solver fallback", "factor exceeds the size limit");
+        doc.get("Coarse Grid Solver")->add("Requested factor size (GB)", Af->smootherData->factorBytes/1.0E9);
+        doc.get("Coarse Grid Solver")->add("Factor size limit (GB)", HPCG_CHOLESKY_MAX_FACTOR_BYTES/1.0E9);
+      }
+    }
+    if (coarse_data.enabled) {
+      const char * variants[2] = {"Smoother", "Direct Solver"};
+      for (int k=0; k<2; ++k) {
+        doc.get("Coarse Grid Solver")->add(variants[k],"");
+        doc.get("Coarse Grid Solver")->get(variants[k])->add("CG iterations to reference tolerance", coarse_data.niters[k]);
+        doc.get("Coarse Grid Solver")->get(variants[k])->add("Scaled residual", coarse_data.scaledResidual[k]);
+        doc.get("Coarse Grid Solver")->get(variants[k])->add("Time (sec)", coarse_data.time[k]);
+      }
+    }
+
+    if (multicg_data.maxNumberOfVectors>0) {
+      doc.add("Multiple Right-Hand Sides","");
+      doc.get("Multiple Right-Hand Sides")->add("Iterations per solve", multicg_data.niters);
+      for (int k=1; k<=multicg_data.maxNumberOfVectors; ++k) {
+        std::ostringstream name;
+        name << "Right-hand sides " << k;
+        doc.get("Multiple Right-Hand Sides")->add(name.str(),"");
+        YAML_Element * rhsElement = doc.get("Multiple Right-Hand Sides")->get(name.str());
+        rhsElement->add("Time (sec)", multicg_data.time[k-1]);
+        rhsElement->add("Solves per second", multicg_data.solvesPerSecond[k-1]);
+        if (multicg_data.solvesPerSecond[0]>0.0)
+          rhsElement->add("Speedup over one right-hand side", multicg_data.solvesPerSecond[k-1]/multicg_data.solvesPerSecond[0]);
+        rhsElement->add("Maximum scaled residual", multicg_data.scaledResidual[k-1]);
+      }
+    }
+
+    if (ensemble_data.numberOfInstances>0) {
+      // Every instance performs the operations of one optimized CG set
+      double fnopsPerInstance = fnops/fNumberOfCgSets*((double) ensemble_data.niters)/((double) optMaxIters);
+      doc.add("Ensemble Information","");
+      doc.get("Ensemble Information")->add("Number of instances", ensemble_data.numberOfInstances);
+      doc.get("Ensemble Information")->add("Concurrent instances", ensemble_data.numberOfConcurrentInstances);
+      doc.get("Ensemble Information")->add("Threads per instance", ensemble_data.threadsPerInstance);
+      doc.get("Ensemble Information")->add("CG iterations per instance", ensemble_data.niters);
+      doc.get("Ensemble Information")->add("Total time (sec)", ensemble_data.wallTime);
+      doc.get("Ensemble Information")->add("Total GFLOP/s", fnopsPerInstance*ensemble_data.numberOfInstances/ensemble_data.wallTime/1.0E9);
+      for (int i=0; i<ensemble_data.numberOfInstances; ++i) {
+        std::ostringstream name;
+        name << "Instance " << i;
+        doc.get("Ensemble Information")->add(name.str(),"");
+        YAML_Element * instanceElement = doc.get("Ensemble Information")->get(name.str());
+        instanceElement->add("Time (sec)", ensemble_data.time[i]);
+        instanceElement->add("GFLOP/s", fnopsPerInstance/ensemble_data.time[i]/1.0E9);
+        instanceElement->add("Scaled residual", ensemble_data.scaledResidual[i]);
+      }
+    }
+
+    doc.add("Memory Use Information","");
+    YAML_Element * memoryElement = doc.get("Memory Use Information");
+    memoryElement->add("Total memory used for data (bytes)", (long long) memory_data.totalBytes);
+    memoryElement->add("Largest memory used by a process (bytes)", (long long) memory_data.maxProcessBytes);
+    memoryElement->add("Bytes per process","");
+    for (int c=0; c<HPCG_NUMBER_OF_MEMORY_COMPONENTS; ++c)
+      memoryElement->get("Bytes per process")->add(MemoryComponentName(c), (long long) memory_data.maxBytes[c]);
+    memoryElement->add("Processes per host", memory_data.processesPerHost);
+    memoryElement->add("Largest memory used on a host (bytes)", (long long) memory_data.maxHostBytes);
+    memoryElement->add("Host memory (bytes)", (long long) memory_data.hostMemory);
+    memoryElement->add("NUMA nodes per host", memory_data.numaNodes);
+    memoryElement->add("NUMA node memory (bytes)", (long long) memory_data.numaNodeMemory);
+    memoryElement->add("Fits in NUMA-local memory", (memory_data.numaLocal ? "yes" : "no"));
+    memoryElement->add("Fits in host memory", (memory_data.fitsHost ? "yes" : "no"));
+
     doc.add("********** Validation Testing Summary  ***********","");
     doc.add("Spectral Convergence Tests","");
     if (testcg_data.count_fail==0)
@@ -193,6 +452,8 @@ void ReportResults(const SparseMatrix & A, int numberOfMgLevels, int numberOfCgS
     doc.get("Floating Point Operations Summary")->add("Raw WAXPBY",fnops_waxpby);
     doc.get("Floating Point Operations Summary")->add("Raw SpMV",fnops_sparsemv);
     doc.get("Floating Point Operations Summary")->add("Raw MG",fnops_precond);
+    doc.get("Floating Point Operations Summary")->add("Raw MG with selected smoother and cycle (not rated)",fnops_precond_selected);
+    doc.get("Floating Point Operations Summary")->add("Raw coarse direct solve (not rated)",fnops_coarse_solve);
     doc.get("Floating Point Operations Summary")->add("Total",fnops);
     doc.get("Floating Point Operations Summary")->add("Total with convergence overhead",reffnops);
 
@@ -201,6 +462,7 @@ void ReportResults(const SparseMatrix & A, int numberOfMgLevels, int numberOfCgS
     doc.get("GFLOP/s Summary")->add("Raw WAXPBY",fnops_waxpby/times[2]/1.0E9);
     doc.get("GFLOP/s Summary")->add("Raw SpMV",fnops_sparsemv/(times[3])/1.0E9);
     doc.get("GFLOP/s Summary")->add("Raw MG",fnops_precond/(times[5])/1.0E9);
+    doc.get("GFLOP/s Summary")->add("Raw MG with selected smoother and cycle (not rated)",fnops_precond_selected/(times[5])/1.0E9);
     doc.get("GFLOP/s Summary")->add("Raw Total",fnops/times[0]/1.0E9);
     doc.get("GFLOP/s Summary")->add("Total with convergence overhead",reffnops/times[0]/1.0E9);
     // This final GFLOP/s rating includes the overhead of optimizing the data structures vs ten sets of 50 iterations of CG
@@ -222,9 +484,93 @@ void ReportResults(const SparseMatrix & A, int numberOfMgLevels, int numberOfCgS
     doc.get("DDOT Timing Variations")->add("Max DDOT MPI_Allreduce time",t4max);
     doc.get("DDOT Timing Variations")->add("Avg DDOT MPI_Allreduce time",t4avg);
 
-    //doc.get("Sparse Operations Overheads")->add("Halo exchange time (sec)", (times[6]));
-    //doc.get("Sparse Operations Overheads")->add("Halo exchange as percentage of SpMV time", (times[6])/totalSparseMVTime*100.0);
+    // The halo exchanges of all levels, recorded by the kernel counters during the optimized CG timing phase
+    long long haloCalls = 0;
+    double haloTimeMean = 0.0, haloTimeMax = 0.0;
+    for (int i=0; i<numberOfMgLevels && i<HPCG_MAX_MG_LEVELS; ++i) {
+      haloCalls += kernel_statistics[i][KERNEL_HALO].calls;
+      haloTimeMean += kernel_statistics[i][KERNEL_HALO].timeMean;
+      haloTimeMax += kernel_statistics[i][KERNEL_HALO].timeMax;
+    }
+    if (haloCalls>0) {
+      doc.add("Halo Exchange Timing","");
+      doc.get("Halo Exchange Timing")->add("Exchanges on rank 0",haloCalls);
+      doc.get("Halo Exchange Timing")->add("Avg halo exchange time",haloTimeMean);
+      doc.get("Halo Exchange Timing")->add("Max halo exchange time",haloTimeMax);
+      doc.get("Halo Exchange Timing")->add("Max halo exchange time per CG iteration",haloTimeMax/fniters);
+      doc.get("Halo Exchange Timing")->add("Max halo exchange as percentage of total time",haloTimeMax/times[0]*100.0);
+    }
+#endif
+    doc.add("Kernel Performance Details","");
+    YAML_Element * detailsElement = doc.get("Kernel Performance Details");
+    detailsElement->add("Phase","optimized CG timing phase");
+#ifndef HPCG_NOMPI
+    detailsElement->add("Processes",A.geom->size);
+#else
+    detailsElement->add("Processes",1);
 #endif
+    Af = &A;
+    for (int i=0; i<numberOfMgLevels && Af!=0; ++i, Af = Af->Ac) {
+      std::ostringstream level;
+      level << "Level " << i;
+      detailsElement->add(level.str(),"");
+      YAML_Element * levelElement = detailsElement->get(level.str());
+      levelElement->add("Number of Equations",Af->totalNumberOfRows);
+      const KernelStatistics & cycle = kernel_statistics[i][KERNEL_MG];
+      if (cycle.calls>0) { // The cycles on a level include those on the coarser levels
+        const double coarserTime = (i+1<numberOfMgLevels) ? kernel_statistics[i+1][KERNEL_MG].timeMean : 0.0;
+        levelElement->add("MG cycle time (sec)", cycle.timeMean);
+        levelElement->add("MG time on this level (sec)", cycle.timeMean-coarserTime);
+      }
+      for (int kernel=0; kernel<HPCG_NUMBER_OF_KERNELS; ++kernel) {
+        const KernelStatistics & entry = kernel_statistics[i][kernel];
+        if (entry.calls==0) continue;
+        levelElement->add(KernelName(kernel),"");
+        YAML_Element * kernelElement = levelElement->get(KernelName(kernel));
+        kernelElement->add("Calls", entry.calls);
+        kernelElement->add("Min time (sec)", entry.timeMin);
+        kernelElement->add("Mean time (sec)", entry.timeMean);
+        kernelElement->add("Max time (sec)", entry.timeMax);
+        kernelElement->add("Time per call (sec)", entry.timeMax/entry.calls);
+        if (entry.bytes>0.0 && entry.timeMax>0.0)
+          kernelElement->add("Bandwidth (GB/s)", entry.bytes/entry.timeMax/1.0E9);
+      }
+    }
+
+    if (HardwareEventStatus(HW_EVENT_CYCLES)!=0) { // Hardware counters requested with --hw-counters
+      doc.add("Hardware Counters","");
+      YAML_Element * hardwareElement = doc.get("Hardware Counters");
+      hardwareElement->add("Scope","rank 0, all threads, optimized CG timing phase");
+      for (int event=0; event<HPCG_NUMBER_OF_HW_EVENTS; ++event)
+        hardwareElement->add(HardwareEventName(event), HardwareEventStatus(event));
+      Af = &A;
+      for (int i=0; i<numberOfMgLevels && Af!=0 && HPCG_hardwareCountersEnabled; ++i, Af = Af->Ac) {
+        std::ostringstream level;
+        level << "Level " << i;
+        hardwareElement->add(level.str(),"");
+        YAML_Element * levelElement = hardwareElement->get(level.str());
+        for (int kernel=0; kernel<HPCG_NUMBER_OF_KERNELS; ++kernel) {
+          const long long calls = HPCG_kernelCounters[i][kernel].count;
+          if (calls==0) continue;
+          const double time = HPCG_kernelCounters[i][kernel].time*1.0E-9;
+          long long counts[HPCG_NUMBER_OF_HW_EVENTS];
+          for (int event=0; event<HPCG_NUMBER_OF_HW_EVENTS; ++event) counts[event] = HPCG_hardwareCounts[i][kernel][event];
+          levelElement->add(KernelName(kernel),"");
+          YAML_Element * kernelElement = levelElement->get(KernelName(kernel));
+          kernelElement->add("Calls", calls);
+          kernelElement->add("Time (sec)", time);
+          for (int event=0; event<HPCG_NUMBER_OF_HW_EVENTS; ++event)
+            if (strcmp(HardwareEventStatus(event), "available")==0) kernelElement->add(HardwareEventName(event), counts[event]);
+          if (counts[HW_EVENT_CYCLES]>0)
+            kernelElement->add("Instructions per cycle", ((double) counts[HW_EVENT_INSTRUCTIONS])/counts[HW_EVENT_CYCLES]);
+          if (strcmp(HardwareEventStatus(HW_EVENT_LLC_MISSES), "available")==0)
+            kernelElement->add("LLC misses per row", ((double) counts[HW_EVENT_LLC_MISSES])/calls/Af->localNumberOfRows);
+          if (strcmp(HardwareEventStatus(HW_EVENT_DRAM_BYTES), "available")==0 && time>0.0)
+            kernelElement->add("DRAM GB/s", counts[HW_EVENT_DRAM_BYTES]/time/1.0E9);
+        }
+      }
+    }
+
     doc.add("********** Final Summary **********","");
     bool isValidRun = (testcg_data.count_fail==0) && (testsymmetry_data.count_fail==0) && (testnorms_data.pass) && (!global_failure);
     if (isValidRun) {
@@ -258,6 +604,7 @@ void ReportResults(const SparseMatrix & A, int numberOfMgLevels, int numberOfCgS
     }
 
     std::string yaml = doc.generateYAML();
+    doc.generateJSON();
 #ifdef HPCG_DEBUG
     HPCG_fout << yaml;
 #endif
@@ -18,8 +18,14 @@
 #include "TestCG.hpp"
 #include "TestSymmetry.hpp"
 #include "TestNorms.hpp"
+#include "CompareCoarseSolvers.hpp"
+#include "BenchmarkMultiCG.hpp"
+#include "BenchmarkEnsemble.hpp"
+#include "MemoryUsage.hpp"
 
 void ReportResults(const SparseMatrix & A, int numberOfMgLevels, int numberOfCgSets, int refMaxIters, int optMaxIters, double times[],
-    const TestCGData & testcg_data, const TestSymmetryData & testsymmetry_data, const TestNormsData & testnorms_data, int global_failure);
+    const TestCGData & testcg_data, const TestSymmetryData & testsymmetry_data, const TestNormsData & testnorms_data,
+    const CoarseSolverComparisonData & coarse_data, const MultiCGBenchmarkData & multicg_data, const EnsembleData & ensemble_data,
+    const MemoryUsage & memory_data, int global_failure);
 
 #endif // REPORTRESULTS_HPP
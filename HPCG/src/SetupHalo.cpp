@@ -36,6 +36,7 @@ using std::endl;
 #endif
 
 #include "SetupHalo.hpp"
+#include "ExchangeHalo.hpp"
 #include "mytimer.hpp"
 
 /*!
@@ -165,6 +166,7 @@ void SetupHalo(SparseMatrix & A) {
   A.receiveLength = receiveLength;
   A.sendLength = sendLength;
   A.sendBuffer = sendBuffer;
+  SetupHaloRequests(A); // The requests of all later exchanges are created once here
 
 #ifdef HPCG_DETAILED_DEBUG
   HPCG_fout << " For rank " << A.geom->rank << " of " << A.geom->size << ", number of neighbors = " << A.numberOfSendNeighbors << endl;
@@ -0,0 +1,160 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file SetupSmoother.cpp
+
+ HPCG routine
+ */
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/hpx_fwd.hpp>
+#endif
+
+#include <fstream>
+using std::endl;
+
+#include "hpcg.hpp"
+
+#include "SetupSmoother.hpp"
+#include "ComputeChebyshev.hpp"
+#include "ComputeBlockSYMGS.hpp"
+#include "ComputeCholesky.hpp"
+#include "ComputeMulticolorSYMGS.hpp"
+#include "ComputeJacobi.hpp"
+
+/*!
+  Selects the smoother used by the optimized multigrid preconditioner on all
+  levels of the matrix hierarchy and prepares its data.
+
+  Must be called after the complete multigrid hierarchy has been generated.
+
+  @param[inout] A the known system matrix, also contains the MG hierarchy in attributes Ac and mgData.
+  @param[in]    smootherType the smoother to use, one of SmootherType
+  @param[in]    smootherDegree the polynomial degree of the Chebyshev smoother
+  @param[in]    smootherBlocks the number of blocks of the block smoother on each level
+
+  @return returns 0 upon success and non-zero otherwise
+
+  @see ComputeSYMGS
+*/
+int SetupSmoother(const SparseMatrix & A, int smootherType, int smootherDegree, int smootherBlocks) {
+
+  int ierr = 0;
+  for (const SparseMatrix * curLevelMatrix = &A; curLevelMatrix; curLevelMatrix = curLevelMatrix->Ac) {
+    if (curLevelMatrix->smootherData==0) curLevelMatrix->smootherData = new SmootherData;
+    else DeleteSmootherData(*curLevelMatrix->smootherData);
+    InitializeSmootherData(smootherType, smootherDegree, smootherBlocks, *curLevelMatrix->smootherData);
+
+    int err = 0;
+    if (smootherType==SMOOTHER_CHEBYSHEV)
+      err = SetupChebyshev(*curLevelMatrix, *curLevelMatrix->smootherData);
+    else if (smootherType==SMOOTHER_BLOCK_L1)
+      err = SetupBlockSYMGS(*curLevelMatrix, *curLevelMatrix->smootherData);
+    else if (smootherType==SMOOTHER_MULTICOLOR)
+      err = SetupMulticolorSYMGS(*curLevelMatrix, *curLevelMatrix->smootherData);
+    else if (smootherType==SMOOTHER_JACOBI)
+      err = SetupJacobi(*curLevelMatrix, *curLevelMatrix->smootherData);
+    if (err!=0) {
+      if (A.geom->rank==0) HPCG_fout << SmootherName(smootherType) << " setup failed, using symmetric Gauss-Seidel instead." << endl;
+      DeleteSmootherData(*curLevelMatrix->smootherData);
+      InitializeSmootherData(SMOOTHER_SYMGS, smootherDegree, smootherBlocks, *curLevelMatrix->smootherData);
+      ++ierr;
+    }
+  }
+  return(ierr);
+}
+
+/*!
+  Selects the direct solver for the coarsest level of the multigrid
+  hierarchy. The smoother of the level is kept, so that it can be restored
+  by changing the type of the smoother data back to its baseType.
+
+  Must be called after SetupSmoother.
+
+  @param[inout] A the known system matrix, also contains the MG hierarchy in attributes Ac and mgData.
+  @param[in]    directSolve if true the coarsest grid problem is solved with a banded Cholesky factorization
+  @param[in]    agglomerate if true the coarsest grid problem of all processes is solved on rank 0
+
+  @return returns 0 upon success and non-zero otherwise
+
+  @see SetupCholesky
+*/
+int SetupCoarseSolver(const SparseMatrix & A, bool directSolve, bool agglomerate) {
+
+  if (!directSolve) return(0);
+
+  const SparseMatrix * coarsestMatrix = &A;
+  while (coarsestMatrix->Ac) coarsestMatrix = coarsestMatrix->Ac;
+  if (coarsestMatrix->smootherData==0) return(-1); // SetupSmoother was not called
+
+  SmootherData & data = *coarsestMatrix->smootherData;
+  data.factorBytes = CholeskyFactorBytes(*coarsestMatrix, agglomerate);
+  if (data.factorBytes>HPCG_CHOLESKY_MAX_FACTOR_BYTES) {
+    data.factorTooLarge = 1;
+    if (A.geom->rank==0) HPCG_fout << "Warning: the Cholesky factor of the coarsest grid would need " << data.factorBytes/1.0E9
+        << " GB, more than the limit of " << HPCG_CHOLESKY_MAX_FACTOR_BYTES/1.0E9 << " GB, using the smoother instead." << endl;
+    return(-1);
+  }
+  if (SetupCholesky(*coarsestMatrix, data, agglomerate)!=0) {
+    if (A.geom->rank==0) HPCG_fout << "Cholesky factorization of the coarsest grid failed, using the smoother instead." << endl;
+    return(-1);
+  }
+  data.type = SMOOTHER_CHOLESKY;
+  return(0);
+}
+
+/*!
+  Resets the per-level smoother timings and call counts.
+
+  @param[inout] A the known system matrix, also contains the MG hierarchy in attributes Ac and mgData.
+*/
+void ResetSmootherStatistics(const SparseMatrix & A) {
+
+  for (const SparseMatrix * curLevelMatrix = &A; curLevelMatrix; curLevelMatrix = curLevelMatrix->Ac) {
+    if (curLevelMatrix->smootherData==0) continue;
+    curLevelMatrix->smootherData->time = 0.0;
+    curLevelMatrix->smootherData->numberOfCalls = 0;
+  }
+}
+
+/*!
+  Recomputes the matrix dependent parts of the smoothers, must be called after
+  the matrix values have been modified, e.g. by ReplaceMatrixDiagonal.
+
+  @param[inout] A the known system matrix, also contains the MG hierarchy in attributes Ac and mgData.
+
+  @return returns 0 upon success and non-zero otherwise
+
+  @see SetupSmoother
+*/
+int UpdateSmoother(const SparseMatrix & A) {
+
+  int ierr = 0;
+  for (const SparseMatrix * curLevelMatrix = &A; curLevelMatrix; curLevelMatrix = curLevelMatrix->Ac) {
+    if (curLevelMatrix->smootherData==0) continue;
+    SmootherData & data = *curLevelMatrix->smootherData;
+    if (data.baseType==SMOOTHER_CHEBYSHEV)
+      ierr += SetupChebyshev(*curLevelMatrix, data);
+    else if (data.baseType==SMOOTHER_BLOCK_L1)
+      ierr += SetupBlockSYMGS(*curLevelMatrix, data);
+    else if (data.baseType==SMOOTHER_MULTICOLOR)
+      ierr += SetupMulticolorSYMGS(*curLevelMatrix, data);
+    else if (data.baseType==SMOOTHER_JACOBI)
+      ierr += SetupJacobi(*curLevelMatrix, data);
+    if (data.type==SMOOTHER_CHOLESKY)
+      ierr += SetupCholesky(*curLevelMatrix, data, data.agglomerated!=0);
+  }
+  return(ierr);
+}
@@ -0,0 +1,25 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+#ifndef SETUPSMOOTHER_HPP
+#define SETUPSMOOTHER_HPP
+
+#include "SparseMatrix.hpp"
+
+int SetupSmoother(const SparseMatrix & A, int smootherType, int smootherDegree, int smootherBlocks);
+int SetupCoarseSolver(const SparseMatrix & A, bool directSolve, bool agglomerate);
+void ResetSmootherStatistics(const SparseMatrix & A);
+int UpdateSmoother(const SparseMatrix & A);
+
+#endif // SETUPSMOOTHER_HPP
@@ -0,0 +1,185 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+/*!
+ @file SmootherData.hpp
+
+ HPCG data structure for the smoother applied on each multigrid level
+ */
+
+#ifndef SMOOTHERDATA_HPP
+#define SMOOTHERDATA_HPP
+
+#include "Vector.hpp"
+
+/*!
+  The smoothers that can be selected for the multigrid levels.
+*/
+enum SmootherType_ENUM {
+  SMOOTHER_SYMGS = 0,    //!< symmetric Gauss-Seidel (the reference smoother)
+  SMOOTHER_CHEBYSHEV = 1, //!< Jacobi preconditioned Chebyshev polynomial
+  SMOOTHER_BLOCK_L1 = 2, //!< Gauss-Seidel inside subcube blocks, L1-Jacobi across block boundaries
+  SMOOTHER_CHOLESKY = 3, //!< direct solve with a banded Cholesky factorization, only on the coarsest level
+  SMOOTHER_MULTICOLOR = 4, //!< symmetric Gauss-Seidel in the order of an eight-coloring of the grid points
+  SMOOTHER_JACOBI = 5 //!< Jacobi iteration, does not depend on the grid geometry
+};
+typedef enum SmootherType_ENUM SmootherType;
+
+struct SmootherData_STRUCT {
+  int type; //!< smoother applied on this level, one of SmootherType
+  int degree; //!< polynomial degree of the Chebyshev smoother
+  double lambdaMax; //!< upper bound of the eigenvalues of D^{-1}A used by the Chebyshev smoother
+  double lambdaMin; //!< lower bound of the eigenvalues of D^{-1}A that are targeted by the Chebyshev smoother
+  Vector * invDiagonal; //!< inverse of the matrix diagonal, L1 corrected for the block smoother
+  Vector * residual; //!< residual work vector
+  Vector * direction; //!< update direction, has space for halo values
+  Vector * Ad; //!< matrix times update direction
+  int numberOfBlocks; //!< requested number of blocks of the block smoother, on exit of the setup the actual number
+  int blocksX; //!< number of blocks of the block smoother in the x-direction
+  int blocksY; //!< number of blocks of the block smoother in the y-direction
+  int blocksZ; //!< number of blocks of the block smoother in the z-direction
+  local_int_t * blockStart; //!< first entry of each block in blockRows, numberOfBlocks+1 entries
+  local_int_t * blockRows; //!< local rows ordered by block
+  int * rowBlock; //!< block of each local row
+  Vector * previous; //!< values at the start of a sweep, used across block boundaries, has space for halo values
+  int numberOfColors; //!< number of colors of the multicolor smoother
+  local_int_t * colorStart; //!< first entry of each color in colorRows, numberOfColors+1 entries
+  local_int_t * colorRows; //!< local rows ordered by color
+  int baseType; //!< smoother of the level before the direct solver was selected
+  int agglomerated; //!< 1 if the factor holds the coarse grid matrix of all processes (on rank 0), 0 if only the local part
+  local_int_t factorRows; //!< number of rows of the Cholesky factor
+  local_int_t factorBandwidth; //!< number of subdiagonals of the Cholesky factor
+  double * factor; //!< banded Cholesky factor, factorBandwidth+1 entries per row ending with the diagonal
+  double * factorWork; //!< right hand side and solution in the ordering of the factor
+  int * gatherCounts; //!< number of rows of each process, only used if agglomerated
+  int * gatherOffsets; //!< offset of the rows of each process in the gathered vector, only used if agglomerated
+  local_int_t * gatherRows; //!< row of the factor of each gathered entry (on rank 0), only used if agglomerated
+  double * gatherBuffer; //!< gathered right hand side and solution in process order (on rank 0), only used if agglomerated
+  double factorBytes; //!< size of the factor of the direct solver requested by SetupCoarseSolver (bytes), 0 if none was requested
+  int factorTooLarge; //!< 1 if the direct solver was not set up since factorBytes exceeds HPCG_CHOLESKY_MAX_FACTOR_BYTES
+  double time; //!< cumulative time spent in this smoother
+  int numberOfCalls; //!< number of smoother applications performed
+};
+typedef struct SmootherData_STRUCT SmootherData;
+
+/*!
+ Constructor for the smoother data structure, no work vectors are allocated.
+
+ @param[in]  type   the smoother applied on this level
+ @param[in]  degree the polynomial degree (only used by the Chebyshev smoother)
+ @param[in]  numberOfBlocks the number of blocks (only used by the block smoother)
+ @param[out] data   the smoother data structure
+ */
+inline void InitializeSmootherData(int type, int degree, int numberOfBlocks, SmootherData & data) {
+  data.type = type;
+  data.degree = degree;
+  data.lambdaMax = 0.0;
+  data.lambdaMin = 0.0;
+  data.invDiagonal = 0;
+  data.residual = 0;
+  data.direction = 0;
+  data.Ad = 0;
+  data.numberOfBlocks = numberOfBlocks;
+  data.blocksX = data.blocksY = data.blocksZ = 0;
+  data.blockStart = 0;
+  data.blockRows = 0;
+  data.rowBlock = 0;
+  data.previous = 0;
+  data.numberOfColors = 0;
+  data.colorStart = 0;
+  data.colorRows = 0;
+  data.baseType = type;
+  data.agglomerated = 0;
+  data.factorRows = 0;
+  data.factorBandwidth = 0;
+  data.factor = 0;
+  data.factorWork = 0;
+  data.gatherCounts = 0;
+  data.gatherOffsets = 0;
+  data.gatherRows = 0;
+  data.gatherBuffer = 0;
+  data.factorBytes = 0.0;
+  data.factorTooLarge = 0;
+  data.time = 0.0;
+  data.numberOfCalls = 0;
+  return;
+}
+
+/*!
+ Returns a printable name for the smoother type.
+ */
+inline const char * SmootherName(int type) {
+  switch (type) {
+    case SMOOTHER_SYMGS: return "Symmetric Gauss-Seidel";
+    case SMOOTHER_CHEBYSHEV: return "Chebyshev";
+    case SMOOTHER_BLOCK_L1: return "Block Gauss-Seidel with L1-Jacobi coupling";
+    case SMOOTHER_CHOLESKY: return "Banded Cholesky";
+    case SMOOTHER_MULTICOLOR: return "Multicolor Gauss-Seidel";
+    case SMOOTHER_JACOBI: return "Jacobi";
+  }
+  return "Unknown";
+}
+
+/*!
+ Deallocates the Cholesky factor of the direct coarse grid solver.
+
+ @param[inout] data the smoother data structure whose factor is deallocated
+ */
+inline void DeleteSmootherFactor(SmootherData & data) {
+
+  if (data.factor) { delete [] data.factor; data.factor = 0; }
+  if (data.factorWork) { delete [] data.factorWork; data.factorWork = 0; }
+  if (data.gatherCounts) { delete [] data.gatherCounts; data.gatherCounts = 0; }
+  if (data.gatherOffsets) { delete [] data.gatherOffsets; data.gatherOffsets = 0; }
+  if (data.gatherRows) { delete [] data.gatherRows; data.gatherRows = 0; }
+  if (data.gatherBuffer) { delete [] data.gatherBuffer; data.gatherBuffer = 0; }
+  data.factorRows = 0;
+  data.factorBandwidth = 0;
+  return;
+}
+
+/*!
+ Deallocates the work vectors and blocks of the smoothers, but not the Cholesky factor.
+
+ @param[inout] data the smoother data structure whose work storage is deallocated
+ */
+inline void DeleteSmootherWorkspace(SmootherData & data) {
+
+  if (data.invDiagonal) { DeleteVector(*data.invDiagonal); delete data.invDiagonal; data.invDiagonal = 0; }
+  if (data.residual) { DeleteVector(*data.residual); delete data.residual; data.residual = 0; }
+  if (data.direction) { DeleteVector(*data.direction); delete data.direction; data.direction = 0; }
+  if (data.Ad) { DeleteVector(*data.Ad); delete data.Ad; data.Ad = 0; }
+  if (data.previous) { DeleteVector(*data.previous); delete data.previous; data.previous = 0; }
+  if (data.blockStart) { delete [] data.blockStart; data.blockStart = 0; }
+  if (data.blockRows) { delete [] data.blockRows; data.blockRows = 0; }
+  if (data.rowBlock) { delete [] data.rowBlock; data.rowBlock = 0; }
+  if (data.colorStart) { delete [] data.colorStart; data.colorStart = 0; }
+  if (data.colorRows) { delete [] data.colorRows; data.colorRows = 0; }
+  data.numberOfColors = 0;
+  return;
+}
+
+/*!
+ Destructor for the smoother data.
+
+ @param[inout] data the smoother data structure whose storage is deallocated
+ */
+inline void DeleteSmootherData(SmootherData & data) {
+
+  DeleteSmootherWorkspace(data);
+  DeleteSmootherFactor(data);
+  return;
+}
+
+#endif // SMOOTHERDATA_HPP
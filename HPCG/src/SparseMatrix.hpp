@@ -24,9 +24,13 @@
 #include <map>
 #include <vector>
 #include <cassert>
+#ifndef HPCG_NOMPI
+#include <mpi.h>
+#endif
 #include "Geometry.hpp"
 #include "Vector.hpp"
 #include "MGData.hpp"
+#include "SmootherData.hpp"
 
 struct SparseMatrix_STRUCT {
   char  * title; //!< name of the sparse matrix
@@ -43,6 +47,10 @@ struct SparseMatrix_STRUCT {
   double ** matrixDiagonal; //!< values of matrix diagonal entries
   std::map< global_int_t, local_int_t > globalToLocalMap; //!< global-to-local mapping
   std::vector< global_int_t > localToGlobalMap; //!< local-to-global mapping
+  int numberOfSubdomains; //!< number of thread subdomains of the local grid, geom->ntx*geom->nty*geom->ntz
+  local_int_t * subdomainStart; //!< offsets of the rows of each thread subdomain in subdomainRows, numberOfSubdomains+1 values
+  local_int_t * subdomainRows; //!< local rows ordered by thread subdomain
+  int level; //!< level of the matrix in the multigrid hierarchy, 0 for the finest grid
   mutable bool isDotProductOptimized;
   mutable bool isSpmvOptimized;
   mutable bool isMgOptimized;
@@ -53,7 +61,10 @@ struct SparseMatrix_STRUCT {
    */
   mutable struct SparseMatrix_STRUCT * Ac; // Coarse grid matrix
   mutable MGData * mgData; // Pointer to the coarse level data for this fine matrix
-  void * optimizationData;  // pointer that can be used to store implementation-specific data
+  mutable SmootherData * smootherData; // Pointer to the smoother applied on this level, 0 for the reference smoother
+  void * optimizationData;  // pointer that can be used to store implementation-specific data, the MatrixFormatData selected by OptimizeProblem
+  void * problemCacheData; //!< mapped problem cache file holding the rows of this matrix, 0 if the rows were allocated by GenerateProblem
+  size_t problemCacheSize; //!< size of the mapping, non-zero only on the level that owns it
 
 #ifndef HPCG_NOMPI
   local_int_t numberOfExternalValues; //!< number of entries that are external to this process
@@ -64,10 +75,22 @@ struct SparseMatrix_STRUCT {
   local_int_t * receiveLength; //!< lenghts of messages received from neighboring processes
   local_int_t * sendLength; //!< lenghts of messages sent to neighboring processes
   double * sendBuffer; //!< send buffer for non-blocking sends
+  double * receiveBuffer; //!< receive buffer of the persistent receives, numberOfExternalValues entries
+  MPI_Request * haloRequests; //!< persistent receives from each neighbor followed by the persistent sends, created by SetupHaloRequests
+  mutable double * multiSendBuffer; //!< send buffer of ExchangeMultiHalo, totalToBeSent*maxMultiHaloVectors entries
+  mutable MPI_Request * multiHaloRequests; //!< receives from each neighbor followed by the sends of ExchangeMultiHalo
+  mutable int maxMultiHaloVectors; //!< number of vectors the buffers of ExchangeMultiHalo hold, 0 until SetupMultiHalo is called
 #endif
 };
 typedef struct SparseMatrix_STRUCT SparseMatrix;
 
+extern void UnmapProblemCache(void * data, size_t size); // Defined in ProblemCache.cpp
+extern void UpdateMatrixFormat(SparseMatrix & A); // Defined in MatrixFormat.cpp
+extern void DeleteMatrixFormat(SparseMatrix & A); // Defined in MatrixFormat.cpp
+#ifndef HPCG_NOMPI
+extern void DeleteHaloRequests(SparseMatrix & A); // Defined in ExchangeHalo.cpp
+#endif
+
 /*!
   Initializes the known system matrix data structure members to 0.
 
@@ -86,6 +109,10 @@ inline void InitializeSparseMatrix(SparseMatrix & A, Geometry * geom) {
   A.mtxIndL = 0;
   A.matrixValues = 0;
   A.matrixDiagonal = 0;
+  A.numberOfSubdomains = 0;
+  A.subdomainStart = 0;
+  A.subdomainRows = 0;
+  A.level = 0;
 
   // Optimization is ON by default. The code that switches it OFF is in the
   // functions that are meant to be optimized.
@@ -103,9 +130,18 @@ inline void InitializeSparseMatrix(SparseMatrix & A, Geometry * geom) {
   A.receiveLength = 0;
   A.sendLength = 0;
   A.sendBuffer = 0;
+  A.receiveBuffer = 0;
+  A.haloRequests = 0;
+  A.multiSendBuffer = 0;
+  A.multiHaloRequests = 0;
+  A.maxMultiHaloVectors = 0;
 #endif
   A.mgData = 0; // Fine-to-coarse grid transfer initially not defined.
+  A.smootherData = 0; // Reference smoother unless SetupSmoother is called
   A.Ac =0;
+  A.optimizationData = 0;
+  A.problemCacheData = 0;
+  A.problemCacheSize = 0;
   return;
 }
 
@@ -133,6 +169,7 @@ inline void ReplaceMatrixDiagonal(SparseMatrix & A, Vector & diagonal) {
     double * dv = diagonal.values;
     assert(A.localNumberOfRows==diagonal.localLength);
     for (local_int_t i=0; i<A.localNumberOfRows; ++i) *(curDiagA[i]) = dv[i];
+    UpdateMatrixFormat(A);
   return;
 }
 /*!
@@ -142,7 +179,10 @@ inline void ReplaceMatrixDiagonal(SparseMatrix & A, Vector & diagonal) {
  */
 inline void DeleteMatrix(SparseMatrix & A) {
 
-  for (local_int_t i = 0; i< A.localNumberOfRows; ++i) {
+  DeleteMatrixFormat(A); // Clears the rows that were moved into the format data
+
+  // Rows loaded from a problem cache point into the mapped file
+  for (local_int_t i = 0; A.problemCacheData==0 && i< A.localNumberOfRows; ++i) {
     delete [] A.matrixValues[i];
     delete [] A.mtxIndG[i];
     delete [] A.mtxIndL[i];
@@ -154,18 +194,26 @@ inline void DeleteMatrix(SparseMatrix & A) {
   if (A.mtxIndL) delete [] A.mtxIndL;
   if (A.matrixValues) delete [] A.matrixValues;
   if (A.matrixDiagonal)           delete [] A.matrixDiagonal;
+  if (A.subdomainStart)           delete [] A.subdomainStart;
+  if (A.subdomainRows)            delete [] A.subdomainRows;
 
 #ifndef HPCG_NOMPI
+  DeleteHaloRequests(A); // Frees the persistent requests before their buffers
+  if (A.multiSendBuffer)       delete [] A.multiSendBuffer;
+  if (A.multiHaloRequests)     delete [] A.multiHaloRequests;
   if (A.elementsToSend)       delete [] A.elementsToSend;
   if (A.neighbors)              delete [] A.neighbors;
   if (A.receiveLength)            delete [] A.receiveLength;
   if (A.sendLength)            delete [] A.sendLength;
   if (A.sendBuffer)            delete [] A.sendBuffer;
+  if (A.receiveBuffer)            delete [] A.receiveBuffer;
 #endif
 
   if (A.geom!=0) { delete A.geom; A.geom = 0;}
   if (A.Ac!=0) { DeleteMatrix(*A.Ac); delete A.Ac; A.Ac = 0;} // Delete coarse matrix
   if (A.mgData!=0) { DeleteMGData(*A.mgData); delete A.mgData; A.mgData = 0;} // Delete MG data
+  if (A.smootherData!=0) { DeleteSmootherData(*A.smootherData); delete A.smootherData; A.smootherData = 0;} // Delete smoother data
+  if (A.problemCacheSize!=0) { UnmapProblemCache(A.problemCacheData, A.problemCacheSize); A.problemCacheData = 0; A.problemCacheSize = 0;} // Unmap after the coarse levels
   return;
 }
 
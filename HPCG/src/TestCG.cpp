@@ -34,6 +34,7 @@ using std::endl;
 
 #include "TestCG.hpp"
 #include "CG.hpp"
+#include "SetupSmoother.hpp"
 
 /*!
   Test the correctness of the Preconditined CG implementation by using a system matrix with a dominant diagonal.
@@ -77,6 +78,7 @@ int TestCG(SparseMatrix & A, CGData & data, Vector & b, Vector & x, TestCGData &
     }
   }
   ReplaceMatrixDiagonal(A, exaggeratedDiagA);
+  UpdateSmoother(A);
 
   int niters = 0;
   double normr = 0.0;
@@ -112,6 +114,7 @@ int TestCG(SparseMatrix & A, CGData & data, Vector & b, Vector & x, TestCGData &
 
   // Restore matrix diagonal and RHS
   ReplaceMatrixDiagonal(A, origDiagA);
+  UpdateSmoother(A);
   CopyVector(origB, b);
   // Delete vectors
   DeleteVector(origDiagA); 
@@ -0,0 +1,166 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file Trace.cpp
+
+ HPCG routine
+ */
+
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Trace.hpp"
+
+bool HPCG_traceEnabled = false;
+
+/*!
+  The events recorded by one thread. Only the owning thread writes to the
+  buffer, when it is full the oldest events are overwritten.
+*/
+struct TraceBuffer_STRUCT {
+  std::vector<TraceEvent> events; //!< the ring buffer
+  unsigned long long count; //!< number of events recorded, the next one is stored at count modulo the capacity
+  int thread; //!< index of the thread in the order of the first event
+};
+typedef struct TraceBuffer_STRUCT TraceBuffer;
+
+static std::mutex traceMutex; // protects the members below, taken once per thread when its buffer is created
+static std::vector<TraceBuffer *> traceBuffers;
+static std::string traceFilename;
+static int traceRank = 0;
+static int traceCapacity = 0;
+static long long traceStart = 0;
+
+static thread_local TraceBuffer * threadBuffer = 0;
+static thread_local TraceRegion threadRegion = {0, -1};
+
+/*!
+  Returns the buffer of the calling thread, created on its first event.
+*/
+static TraceBuffer * ThreadTraceBuffer() {
+  if (threadBuffer==0) {
+    TraceBuffer * buffer = new TraceBuffer;
+    buffer->events.resize(traceCapacity);
+    buffer->count = 0;
+    std::lock_guard<std::mutex> lock(traceMutex);
+    buffer->thread = (int)traceBuffers.size();
+    traceBuffers.push_back(buffer);
+    threadBuffer = buffer;
+  }
+  return(threadBuffer);
+}
+
+/*!
+  Enables the trace of the kernel calls.
+
+  @param[in] filename the Chrome trace-event file written by FinalizeTrace
+  @param[in] rank the MPI rank, the process id of the events
+  @param[in] eventsPerThread the capacity of the ring buffer of each thread
+*/
+void InitializeTrace(const char * filename, int rank, int eventsPerThread) {
+  traceFilename = filename;
+  traceRank = rank;
+  traceCapacity = (eventsPerThread>0) ? eventsPerThread : 1;
+  traceStart = TraceTime();
+  HPCG_traceEnabled = true;
+}
+
+/*!
+  Appends an event to the buffer of the calling thread.
+
+  @param[in] category the category of the event, see TraceEvent
+  @param[in] name the name of the kernel, 0 for a parallel loop outside of the kernels
+  @param[in] level the multigrid level, -1 for the vector kernels
+  @param[in] begin the start time as returned by TraceTime
+  @param[in] end the end time as returned by TraceTime
+*/
+void RecordTraceEvent(const char * category, const char * name, int level, long long begin, long long end) {
+  TraceBuffer * buffer = ThreadTraceBuffer();
+  TraceEvent & event = buffer->events[buffer->count%buffer->events.size()];
+  event.category = category;
+  event.name = (name!=0) ? name : "parallel loop";
+  event.level = level;
+  event.begin = begin;
+  event.end = end;
+  ++buffer->count;
+}
+
+/*!
+  Makes a kernel call the innermost region of the calling thread.
+
+  @param[in] name the name of the kernel
+  @param[in] level the multigrid level, -1 for the vector kernels
+
+  @return the enclosing region, to be restored by LeaveTraceRegion
+*/
+TraceRegion EnterTraceRegion(const char * name, int level) {
+  TraceRegion outer = threadRegion;
+  threadRegion.name = name;
+  threadRegion.level = level;
+  return(outer);
+}
+
+/*!
+  Restores the region that enclosed the current one.
+
+  @param[in] outer the value returned by the matching EnterTraceRegion
+*/
+void LeaveTraceRegion(const TraceRegion & outer) {
+  threadRegion = outer;
+}
+
+/*!
+  Returns the innermost region of the calling thread.
+*/
+TraceRegion CurrentTraceRegion() {
+  return(threadRegion);
+}
+
+/*!
+  Writes all events in the Chrome trace-event format and releases the
+  buffers. Must be called when no thread records events anymore.
+*/
+void FinalizeTrace() {
+  if (!HPCG_traceEnabled) return;
+  HPCG_traceEnabled = false;
+
+  std::ofstream trace(traceFilename.c_str());
+  unsigned long long dropped = 0;
+  trace << std::fixed << std::setprecision(3);
+  trace << "{\"traceEvents\":[\n";
+  trace << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << traceRank << ",\"args\":{\"name\":\"HPCG rank " << traceRank << "\"}}";
+  for (size_t b=0; b<traceBuffers.size(); ++b) {
+    const TraceBuffer & buffer = *traceBuffers[b];
+    const unsigned long long capacity = buffer.events.size();
+    const unsigned long long first = (buffer.count>capacity) ? buffer.count-capacity : 0;
+    dropped += first;
+    trace << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << traceRank << ",\"tid\":" << buffer.thread
+          << ",\"args\":{\"name\":\"thread " << buffer.thread << "\"}}";
+    for (unsigned long long i=first; i<buffer.count; ++i) {
+      const TraceEvent & event = buffer.events[i%capacity];
+      trace << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category << "\",\"ph\":\"X\""
+            << ",\"ts\":" << (event.begin-traceStart)/1000.0 << ",\"dur\":" << (event.end-event.begin)/1000.0
+            << ",\"pid\":" << traceRank << ",\"tid\":" << buffer.thread
+            << ",\"args\":{\"level\":" << event.level << "}}";
+    }
+    delete traceBuffers[b];
+  }
+  trace << "\n],\n\"displayTimeUnit\":\"ns\",\n\"otherData\":{\"droppedEvents\":" << dropped << "}}\n";
+  traceBuffers.clear();
+}
@@ -0,0 +1,65 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file Trace.hpp
+
+ HPCG data structures for the timeline trace of the kernel calls
+ */
+
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <chrono>
+
+/*!
+  One interval of the timeline of a thread.
+*/
+struct TraceEvent_STRUCT {
+  const char * category; //!< "kernel" for a kernel call, "worker" for the share of a thread in a parallel loop, "cg" or "mg" for the iterations and cycles
+  const char * name; //!< name of the kernel, a string literal
+  int level; //!< multigrid level, -1 for the vector kernels
+  long long begin; //!< start time (ns)
+  long long end; //!< end time (ns)
+};
+typedef struct TraceEvent_STRUCT TraceEvent;
+
+/*!
+  The innermost kernel call of a thread, used to label the events of the
+  threads working for it.
+*/
+struct TraceRegion_STRUCT {
+  const char * name; //!< name of the kernel, 0 outside of the kernels
+  int level; //!< multigrid level, -1 for the vector kernels
+};
+typedef struct TraceRegion_STRUCT TraceRegion;
+
+extern bool HPCG_traceEnabled; //!< true if the kernel calls are traced, set by HPCG_Init
+
+extern void InitializeTrace(const char * filename, int rank, int eventsPerThread);
+extern void FinalizeTrace();
+extern void RecordTraceEvent(const char * category, const char * name, int level, long long begin, long long end);
+extern TraceRegion EnterTraceRegion(const char * name, int level);
+extern void LeaveTraceRegion(const TraceRegion & outer);
+extern TraceRegion CurrentTraceRegion();
+
+/*!
+  Returns the current time in ns, the clock of the trace and the kernel counters.
+*/
+inline long long TraceTime() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#endif // TRACE_HPP
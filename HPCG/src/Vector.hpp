@@ -20,13 +20,55 @@
 
 #ifndef VECTOR_HPP
 #define VECTOR_HPP
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/hpx_fwd.hpp>
+#endif
+
+#ifndef HPCG_NOOPENMP
+#include <omp.h>
+#endif
+
 #include <cassert>
 #include <cstdlib>
+#include <new>
+#if defined(_MSC_VER)
+#include <malloc.h>
+#endif
+#if defined(HPCG_HUGEPAGES) && !defined(_MSC_VER)
+#include <sys/mman.h>
+#endif
 #include "Geometry.hpp"
 
+#if !defined(HPCG_NOHPX)
+#include <hpx/include/parallel_for_each.hpp>
+
+#include <boost/iterator/counting_iterator.hpp>
+#endif
+
+/*!
+  Alignment in bytes of the values of all vectors, a multiple of the cache
+  line size and of the SIMD register width. The allocated length of a vector
+  is padded to a multiple of this alignment.
+*/
+#define HPCG_VECTOR_ALIGNMENT 64
+
+/*!
+  Vectors of at least this size are aligned to huge page boundaries and
+  advised to be backed by transparent huge pages if HPCG_HUGEPAGES is defined.
+*/
+#define HPCG_HUGEPAGE_SIZE (2*1024*1024)
+
+/*!
+  Vectors shorter than this are processed by a single thread in the helper
+  functions below, since the parallel overhead would dominate.
+*/
+#define HPCG_VECTOR_PARALLEL_THRESHOLD 4096
+
 struct Vector_STRUCT {
   local_int_t localLength;  //!< length of local portion of the vector
-  double * values;          //!< array of values
+  local_int_t paddedLength; //!< allocated length, a multiple of HPCG_VECTOR_ALIGNMENT bytes
+  double * values;          //!< array of values, aligned to HPCG_VECTOR_ALIGNMENT bytes
   /*!
    This is for storing optimized data structres created in OptimizeProblem and
    used inside optimized ComputeSPMV().
@@ -36,15 +78,64 @@ struct Vector_STRUCT {
 };
 typedef struct Vector_STRUCT Vector;
 
+/*!
+  Allocates aligned storage for the values of a vector.
+
+  @param[in] paddedLength the number of values, a multiple of HPCG_VECTOR_ALIGNMENT bytes
+
+  @return the aligned storage, to be released with FreeVectorValues
+ */
+inline double * AllocateVectorValues(local_int_t paddedLength) {
+  size_t bytes = ((size_t)paddedLength)*sizeof(double);
+  size_t alignment = HPCG_VECTOR_ALIGNMENT;
+#if defined(HPCG_HUGEPAGES) && !defined(_MSC_VER)
+  if (bytes >= HPCG_HUGEPAGE_SIZE) {
+    alignment = HPCG_HUGEPAGE_SIZE;
+    bytes = (bytes+HPCG_HUGEPAGE_SIZE-1)/HPCG_HUGEPAGE_SIZE*HPCG_HUGEPAGE_SIZE;
+  }
+#endif
+  void * p = 0;
+#if defined(_MSC_VER)
+  p = _aligned_malloc(bytes>0 ? bytes : alignment, alignment);
+#else
+  if (posix_memalign(&p, alignment, bytes>0 ? bytes : alignment) != 0) p = 0;
+#endif
+  if (p == 0) throw std::bad_alloc();
+#if defined(HPCG_HUGEPAGES) && !defined(_MSC_VER) && defined(MADV_HUGEPAGE)
+  if (alignment == HPCG_HUGEPAGE_SIZE) madvise(p, bytes, MADV_HUGEPAGE); // Only a hint, failure is not an error
+#endif
+  return (double *) p;
+}
+
+/*!
+  Releases storage allocated with AllocateVectorValues.
+
+  @param[in] values the storage to be released, may be 0
+ */
+inline void FreeVectorValues(double * values) {
+#if defined(_MSC_VER)
+  _aligned_free(values);
+#else
+  free(values);
+#endif
+  return;
+}
+
 /*!
   Initializes input vector.
 
+  The values are aligned to HPCG_VECTOR_ALIGNMENT bytes and the allocation is
+  padded to a multiple of it, the padding is initialized to zero.
+
   @param[in] v
   @param[in] localLength Length of local portion of input vector
  */
 inline void InitializeVector(Vector & v, local_int_t localLength) {
+  const local_int_t valuesPerAlignment = HPCG_VECTOR_ALIGNMENT/sizeof(double);
   v.localLength = localLength;
-  v.values = new double[localLength];
+  v.paddedLength = (localLength+valuesPerAlignment-1)/valuesPerAlignment*valuesPerAlignment;
+  v.values = AllocateVectorValues(v.paddedLength);
+  for (local_int_t i=localLength; i<v.paddedLength; ++i) v.values[i] = 0.0;
   v.optimizationData = 0;
   return;
 }
@@ -55,9 +146,22 @@ inline void InitializeVector(Vector & v, local_int_t localLength) {
   @param[inout] v - On entrance v is initialized, on exit all its values are zero.
  */
 inline void ZeroVector(Vector & v) {
-  local_int_t localLength = v.localLength;
-  double * vv = v.values;
-  for (int i=0; i<localLength; ++i) vv[i] = 0.0;
+  const local_int_t localLength = v.localLength;
+  double * const vv = v.values;
+#if defined(HPCG_NOHPX)
+#ifndef HPCG_NOOPENMP
+  #pragma omp parallel for if(localLength>=HPCG_VECTOR_PARALLEL_THRESHOLD)
+#endif
+  for (local_int_t i=0; i<localLength; ++i) vv[i] = 0.0;
+#else
+  if (localLength<HPCG_VECTOR_PARALLEL_THRESHOLD) {
+    for (local_int_t i=0; i<localLength; ++i) vv[i] = 0.0;
+  } else {
+    typedef boost::counting_iterator<local_int_t> iterator;
+    hpx::parallel::for_each(hpx::parallel::par, iterator(0), iterator(localLength),
+      [vv](local_int_t i) { vv[i] = 0.0; });
+  }
+#endif
   return;
 }
 /*!
@@ -73,15 +177,48 @@ inline void ScaleVectorValue(Vector & v, local_int_t index, double value) {
   vv[index] *= value;
   return;
 }
+/*!
+  Returns a pseudo-random value in [1,2) for a given seed and index.
+
+  The value only depends on its arguments, so that vectors can be filled in
+  parallel with results that are independent of the number of threads.
+
+  @param[in] seed the seed of the vector
+  @param[in] index the index of the value
+ */
+inline double RandomVectorValue(unsigned long long seed, unsigned long long index) {
+  unsigned long long z = seed + (index+1)*0x9E3779B97F4A7C15ULL; // SplitMix64
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  z = z ^ (z >> 31);
+  return (double)(z >> 11) * (1.0/9007199254740992.0) + 1.0; // 53 random bits
+}
 /*!
   Fill the input vector with pseudo-random values.
 
+  The seed of each vector is drawn from rand(), so the values are
+  reproducible with srand() as before.
+
   @param[in] v
  */
 inline void FillRandomVector(Vector & v) {
-  local_int_t localLength = v.localLength;
-  double * vv = v.values;
-  for (int i=0; i<localLength; ++i) vv[i] = rand() / (double)(RAND_MAX) + 1.0;
+  const local_int_t localLength = v.localLength;
+  double * const vv = v.values;
+  const unsigned long long seed = ((unsigned long long)rand() << 32) ^ (unsigned long long)rand();
+#if defined(HPCG_NOHPX)
+#ifndef HPCG_NOOPENMP
+  #pragma omp parallel for if(localLength>=HPCG_VECTOR_PARALLEL_THRESHOLD)
+#endif
+  for (local_int_t i=0; i<localLength; ++i) vv[i] = RandomVectorValue(seed, i);
+#else
+  if (localLength<HPCG_VECTOR_PARALLEL_THRESHOLD) {
+    for (local_int_t i=0; i<localLength; ++i) vv[i] = RandomVectorValue(seed, i);
+  } else {
+    typedef boost::counting_iterator<local_int_t> iterator;
+    hpx::parallel::for_each(hpx::parallel::par, iterator(0), iterator(localLength),
+      [vv, seed](local_int_t i) { vv[i] = RandomVectorValue(seed, i); });
+  }
+#endif
   return;
 }
 /*!
@@ -91,11 +228,24 @@ inline void FillRandomVector(Vector & v) {
   @param[in] w Output vector
  */
 inline void CopyVector(const Vector & v, Vector & w) {
-  local_int_t localLength = v.localLength;
+  const local_int_t localLength = v.localLength;
   assert(w.localLength >= localLength);
-  double * vv = v.values;
-  double * wv = w.values;
-  for (int i=0; i<localLength; ++i) wv[i] = vv[i];
+  const double * const vv = v.values;
+  double * const wv = w.values;
+#if defined(HPCG_NOHPX)
+#ifndef HPCG_NOOPENMP
+  #pragma omp parallel for if(localLength>=HPCG_VECTOR_PARALLEL_THRESHOLD)
+#endif
+  for (local_int_t i=0; i<localLength; ++i) wv[i] = vv[i];
+#else
+  if (localLength<HPCG_VECTOR_PARALLEL_THRESHOLD) {
+    for (local_int_t i=0; i<localLength; ++i) wv[i] = vv[i];
+  } else {
+    typedef boost::counting_iterator<local_int_t> iterator;
+    hpx::parallel::for_each(hpx::parallel::par, iterator(0), iterator(localLength),
+      [vv, wv](local_int_t i) { wv[i] = vv[i]; });
+  }
+#endif
   return;
 }
 
@@ -107,8 +257,10 @@ inline void CopyVector(const Vector & v, Vector & w) {
  */
 inline void DeleteVector(Vector & v) {
 
-  delete [] v.values;
+  FreeVectorValues(v.values);
+  v.values = 0;
   v.localLength = 0;
+  v.paddedLength = 0;
   return;
 }
 
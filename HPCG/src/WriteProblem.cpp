@@ -23,16 +23,112 @@
 #endif
 
 #include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
 #include "WriteProblem.hpp"
+#include "ReadProblem.hpp"
 #include "Geometry.hpp"
+#include "Backend.hpp"
 
+/*!
+  Number of rows formatted by one task, and number of such pieces formatted
+  in parallel before they are written.
+*/
+#define HPCG_WRITE_PIECE_ROWS 4096
+#define HPCG_WRITE_PIECES 64
+
+#ifdef HPCG_NO_LONG_LONG
+#define HPCG_GLOBAL_FORMAT "%d"
+#else
+#define HPCG_GLOBAL_FORMAT "%lld"
+#endif
+
+/*!
+  Appends the entries of the rows [first, last) to text, one line per entry
+  with the row and column counted from 1.
+
+  @param[in]    A the matrix
+  @param[in]    first, last the rows
+  @param[in]    format the printf format of a line, with the row, the column and the value
+  @param[inout] text the formatted lines
+*/
+static void FormatMatrixRows(const SparseMatrix & A, local_int_t first, local_int_t last, const char * format, std::string & text) {
+  char line[128];
+  for (local_int_t i=first; i<last; ++i) {
+    const double * const currentRowValues = A.matrixValues[i];
+    const global_int_t * const currentRowIndices = A.mtxIndG[i];
+    const int currentNumberOfNonzeros = A.nonzerosInRow[i];
+    for (int j=0; j< currentNumberOfNonzeros; j++) {
+      const int length = snprintf(line, sizeof(line), format, (global_int_t)(i+1), (global_int_t)(currentRowIndices[j]+1), currentRowValues[j]);
+      text.append(line, length);
+    }
+  }
+}
+
+/*!
+  Appends the values [first, last) of a vector to text, one per line.
+*/
+static void FormatVectorValues(const Vector & v, local_int_t first, local_int_t last, std::string & text) {
+  char line[64];
+  for (local_int_t i=first; i<last; ++i) {
+    const int length = snprintf(line, sizeof(line), "%22.16e\n", v.values[i]);
+    text.append(line, length);
+  }
+}
+
+/*!
+  Writes text that is formatted in pieces of HPCG_WRITE_PIECE_ROWS rows.
+  HPCG_WRITE_PIECES pieces at a time are formatted in parallel with the
+  backend of the SpMV and then written in order, so the file is identical
+  to a sequential write.
+
+  @param[in] file the file
+  @param[in] n the number of rows
+  @param[in] format the function formatting the rows [first, last) into a string
+
+  @return returns 0 upon success and non-zero otherwise
+*/
+template <typename F>
+static int WriteFormattedRows(FILE * file, local_int_t n, const F & format) {
+  std::vector<std::string> pieces(HPCG_WRITE_PIECES);
+  std::string * const piecesv = &pieces[0];
+  int ierr = 0;
+  for (local_int_t first=0; first<n; first += HPCG_WRITE_PIECES*HPCG_WRITE_PIECE_ROWS) {
+    const local_int_t numberOfRows = (n-first<HPCG_WRITE_PIECES*HPCG_WRITE_PIECE_ROWS) ? n-first : HPCG_WRITE_PIECES*HPCG_WRITE_PIECE_ROWS;
+    const local_int_t numberOfPieces = (numberOfRows+HPCG_WRITE_PIECE_ROWS-1)/HPCG_WRITE_PIECE_ROWS;
+    BackendParallelFor(HPCG_backends.spmv, numberOfPieces, [&format, piecesv, first, numberOfRows](local_int_t k) {
+      const local_int_t pieceFirst = first+k*HPCG_WRITE_PIECE_ROWS;
+      const local_int_t pieceLast = (k+1)*HPCG_WRITE_PIECE_ROWS<numberOfRows ? pieceFirst+HPCG_WRITE_PIECE_ROWS : first+numberOfRows;
+      piecesv[k].clear();
+      format(pieceFirst, pieceLast, piecesv[k]);
+    });
+    for (local_int_t k=0; k<numberOfPieces; ++k)
+      if (fwrite(pieces[k].data(), 1, pieces[k].size(), file)!=pieces[k].size()) ierr = 1;
+  }
+  return(ierr);
+}
+
+/*!
+  Writes a vector, one value per line.
+*/
+static int WriteVector(const char * filename, const Vector & v, local_int_t n) {
+  FILE * file = fopen(filename, "w");
+  if (!file) return(-1);
+  int ierr = WriteFormattedRows(file, n, [&v](local_int_t first, local_int_t last, std::string & text) {
+    FormatVectorValues(v, first, last, text);
+  });
+  if (fclose(file)!=0) ierr = -1;
+  return(ierr==0 ? 0 : -1);
+}
 
 /*!
   Routine to dump:
    - matrix in row, col, val format for analysis with MATLAB
    - x, xexact, b as simple arrays of numbers.
 
-   Writes to A.dat, x.dat, xexact.dat and b.dat, respectivly.
+   Writes to A.dat, x.dat, xexact.dat and b.dat, respectivly. The lines are
+   formatted in parallel and written in order (see WriteFormattedRows).
 
    NOTE:  THIS CODE ONLY WORKS ON SINGLE PROCESSOR RUNS
 
@@ -58,40 +154,76 @@ int WriteProblem( const Geometry & geom, const SparseMatrix & A,
     const Vector b, const Vector x, const Vector xexact) {
 
   if (geom.size!=1) return(-1); //TODO Only works on one processor.  Need better error handler
-  const global_int_t nrow = A.totalNumberOfRows;
-
-  FILE * fA = 0, * fx = 0, * fxexact = 0, * fb = 0;
-  fA = fopen("A.dat", "w");
-  fx = fopen("x.dat", "w");
-  fxexact = fopen("xexact.dat", "w");
-  fb = fopen("b.dat", "w");
-
-  if (! fA || ! fx || ! fxexact || ! fb) {
-    if (fb) fclose(fb);
-    if (fxexact) fclose(fxexact);
-    if (fx) fclose(fx);
-    if (fA) fclose(fA);
-    return -1;
-  }
+  const local_int_t nrow = A.localNumberOfRows;
+
+  FILE * fA = fopen("A.dat", "w");
+  if (! fA) return -1;
+  int ierr = WriteFormattedRows(fA, nrow, [&A](local_int_t first, local_int_t last, std::string & text) {
+    FormatMatrixRows(A, first, last, " " HPCG_GLOBAL_FORMAT " " HPCG_GLOBAL_FORMAT " %22.16e\n", text);
+  });
+  if (fclose(fA)!=0) ierr = -1;
+  if (ierr!=0) return -1;
+
+  if (WriteVector("x.dat", x, nrow)!=0) return -1;
+  if (WriteVector("xexact.dat", xexact, nrow)!=0) return -1;
+  if (WriteVector("b.dat", b, nrow)!=0) return -1;
+  return(0);
+}
 
-  for (global_int_t i=0; i< nrow; i++) {
-    const double * const currentRowValues = A.matrixValues[i];
-    const global_int_t * const currentRowIndices = A.mtxIndG[i];
-    const int currentNumberOfNonzeros = A.nonzerosInRow[i];
-    for (int j=0; j< currentNumberOfNonzeros; j++)
-#ifdef HPCG_NO_LONG_LONG
-      fprintf(fA, " %d %d %22.16e\n",i+1,(global_int_t)(currentRowIndices[j]+1),currentRowValues[j]);
-#else
-      fprintf(fA, " %lld %lld %22.16e\n",i+1,(global_int_t)(currentRowIndices[j]+1),currentRowValues[j]);
-#endif
-    fprintf(fx, "%22.16e\n",x.values[i]);
-    fprintf(fxexact, "%22.16e\n",xexact.values[i]);
-    fprintf(fb, "%22.16e\n",b.values[i]);
-  }
+/*!
+  Writes the matrix to a file that ReadProblem can read: MatrixMarket
+  coordinate format (all entries, "general") for names ending in .mtx,
+  binary CSR format (see BinaryCSRHeader) otherwise. The text is formatted
+  in parallel like the output of WriteProblem.
 
-  fclose(fA);
-  fclose(fx);
-  fclose(fxexact);
-  fclose(fb);
-  return(0);
+  NOTE:  THIS CODE ONLY WORKS ON SINGLE PROCESSOR RUNS
+
+  @param[in] filename the name of the file
+  @param[in] A the known system matrix
+
+  @return Returns with -1 if used with more than one MPI process or if the file cannot be written. Returns with 0 otherwise.
+
+  @see ReadProblem
+*/
+int WriteMatrix(const char * filename, const SparseMatrix & A) {
+
+  if (A.geom->size!=1) return(-1);
+  const local_int_t nrow = A.localNumberOfRows;
+  FILE * file = fopen(filename, "wb");
+  if (!file) return(-1);
+
+  int ierr = 0;
+  if (ProblemFileFormatOfName(filename)==PROBLEM_FILE_MATRIX_MARKET) {
+    fprintf(file, "%%%%MatrixMarket matrix coordinate real general\n");
+    fprintf(file, HPCG_GLOBAL_FORMAT " " HPCG_GLOBAL_FORMAT " " HPCG_GLOBAL_FORMAT "\n",
+        (global_int_t)nrow, (global_int_t)nrow, (global_int_t)A.localNumberOfNonzeros);
+    ierr = WriteFormattedRows(file, nrow, [&A](local_int_t first, local_int_t last, std::string & text) {
+      FormatMatrixRows(A, first, last, HPCG_GLOBAL_FORMAT " " HPCG_GLOBAL_FORMAT " %.17g\n", text);
+    });
+  } else {
+    BinaryCSRHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "HPCGCSR", 8);
+    header.numberOfRows = nrow;
+    header.numberOfNonzeros = A.localNumberOfNonzeros;
+    std::vector<long long> rowStart(nrow+1, 0);
+    for (local_int_t i=0; i<nrow; ++i) rowStart[i+1] = rowStart[i]+A.nonzerosInRow[i];
+    std::vector<long long> columns(A.localNumberOfNonzeros);
+    std::vector<double> values(A.localNumberOfNonzeros);
+    long long * const columnsv = &columns[0];
+    double * const valuesv = &values[0];
+    const long long * const rowStartv = &rowStart[0];
+    BackendParallelFor(HPCG_backends.spmv, nrow, [&A, rowStartv, columnsv, valuesv](local_int_t i) {
+      for (int j=0; j<A.nonzerosInRow[i]; ++j) {
+        columnsv[rowStartv[i]+j] = A.mtxIndG[i][j];
+        valuesv[rowStartv[i]+j] = A.matrixValues[i][j];
+      }
+    });
+    if (fwrite(&header, sizeof(header), 1, file)!=1
+        || fwrite(&rowStart[0], sizeof(long long), rowStart.size(), file)!=rowStart.size()
+        || fwrite(&columns[0], sizeof(long long), columns.size(), file)!=columns.size()
+        || fwrite(&values[0], sizeof(double), values.size(), file)!=values.size()) ierr = 1;
+  }
+  if (fclose(file)!=0) ierr = 1;
+  return(ierr==0 ? 0 : -1);
 }
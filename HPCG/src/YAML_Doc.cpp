@@ -56,31 +56,69 @@ string YAML_Doc::generateYAML() {
     yaml = yaml + children[i]->printYAML("");
   }
 
-  time_t rawtime;
-  tm * ptm;
-  time ( &rawtime );
-  ptm = localtime(&rawtime);
-  char sdate[25];
-  //use tm_mon+1 because tm_mon is 0 .. 11 instead of 1 .. 12
-  sprintf (sdate,"%04d.%02d.%02d.%02d.%02d.%02d",ptm->tm_year + 1900, ptm->tm_mon+1,
-      ptm->tm_mday, ptm->tm_hour, ptm->tm_min,ptm->tm_sec);
+  string filename = generateFileName(".yaml");
+  ofstream myfile;
+  myfile.open(filename.c_str());
+  myfile << yaml;
+  myfile.close();
+  return yaml;
+}
+
+/*!
+  Generates JSON from the elements of the document and saves it to a file
+  named like the YAML file, with the extension ".json". Elements with the same
+  key under one parent are combined into an array.
+
+  @return returns the complete JSON document as a string
+*/
+string YAML_Doc::generateJSON() {
+  string json = "{\n";
+  json = json + "  \"Name\": " + convert_string_to_json(miniAppName);
+  json = json + ",\n  \"Version\": " + convert_string_to_json(miniAppVersion);
+  string members = printJSONValue("");
+  if (members.size()>4) json = json + ",\n" + members.substr(2, members.size()-4); // Members without the braces
+  json = json + "\n}\n";
+
+  ofstream myfile;
+  myfile.open(generateFileName(".json").c_str());
+  myfile << json;
+  myfile.close();
+  return json;
+}
+
+/*!
+  Returns the name of the file of the document with the given extension.
+
+  @param[in] extension the extension of the file, ".yaml" or ".json"
+*/
+string YAML_Doc::generateFileName(const std::string & extension) {
+  bool first = (fileNameDate=="");
+  if (first) {
+    time_t rawtime;
+    tm * ptm;
+    time ( &rawtime );
+    ptm = localtime(&rawtime);
+    char sdate[25];
+    //use tm_mon+1 because tm_mon is 0 .. 11 instead of 1 .. 12
+    sprintf (sdate,"%04d.%02d.%02d.%02d.%02d.%02d",ptm->tm_year + 1900, ptm->tm_mon+1,
+        ptm->tm_mday, ptm->tm_hour, ptm->tm_min,ptm->tm_sec);
+    fileNameDate = sdate;
+  }
 
   string filename;
   if (destinationFileName=="")
     filename = miniAppName + "-" + miniAppVersion + "_";
   else
     filename = destinationFileName;
-  filename = filename + string(sdate) + ".yaml";
+  filename = filename + fileNameDate + extension;
   if (destinationDirectory!="" && destinationDirectory!=".") {
-    string mkdir_cmd = "mkdir " + destinationDirectory;
-    system(mkdir_cmd.c_str());
+    if (first) {
+      string mkdir_cmd = "mkdir " + destinationDirectory;
+      system(mkdir_cmd.c_str());
+    }
     filename = destinationDirectory + "/" + destinationFileName;
+    if (extension!=".yaml") filename = filename + extension; // The YAML file keeps the given name
   } else
     filename = "./" + filename;
-
-  ofstream myfile;
-  myfile.open(filename.c_str());
-  myfile << yaml;
-  myfile.close();
-  return yaml;
+  return filename;
 }
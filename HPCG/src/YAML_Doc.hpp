@@ -103,12 +103,17 @@ public:
   ~YAML_Doc();
   //! Generate YAML results to standard out and to a file using specified directory and filename, using current directory and miniAppName + miniAppVersion + ".yaml" by default
   std::string generateYAML();
+  //! Generate the same results as JSON to a file next to the YAML file, with the extension ".json"
+  std::string generateJSON();
 
 protected:
   std::string miniAppName; //!< the name of the application that generated the YAML output
   std::string miniAppVersion; //!< the version of the application that generated the YAML output
   std::string destinationDirectory; //!< the destination directory for the generated the YAML output
   std::string destinationFileName; //!< the filename for the generated the YAML output
+  std::string fileNameDate; //!< the date in the file names, set when the first file is generated so that the YAML and JSON files match
+private:
+  std::string generateFileName(const std::string & extension);
 };
 #endif // YAML_DOC_HPP
 
@@ -18,6 +18,7 @@
  HPCG routine
  */
 
+#include <cctype>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -153,6 +154,111 @@ string YAML_Element::printYAML(std::string space) {
   return yaml_line;
 }
 
+/*!
+  Prints an element as a member of a JSON object.
+
+  @param[in] space spacing inserted at the beginning of the line
+
+  @return Returns the member of the JSON document without a trailing comma or newline
+*/
+string YAML_Element::printJSON(std::string space) {
+  return space + convert_string_to_json(key) + ": " + printJSONValue(space);
+}
+
+/*!
+  Prints the value of an element as a JSON value: an object if the element
+  has children, otherwise a number or a string. Children with the same key,
+  e.g. the entries of each grid level, are combined into one member whose
+  value is the array of their values in the order they were added.
+
+  @param[in] space spacing of the line the value starts on
+
+  @return Returns the value without a trailing comma or newline
+*/
+string YAML_Element::printJSONValue(std::string space) {
+  if (children.size()==0) return is_json_number(value) ? value : convert_string_to_json(value);
+
+  string inner = space + "  ";
+  string json_value = "{\n";
+  std::vector<bool> printed(children.size(), false);
+  for (size_t i=0; i<children.size(); i++) {
+    if (printed[i]) continue;
+    std::vector<size_t> same;
+    for (size_t j=i; j<children.size(); j++)
+      if (children[j]->getKey()==children[i]->getKey()) {
+        same.push_back(j);
+        printed[j] = true;
+      }
+    if (i>0) json_value += ",\n";
+    if (same.size()==1) {
+      json_value += children[i]->printJSON(inner);
+    } else {
+      json_value += inner + convert_string_to_json(children[i]->getKey()) + ": [\n";
+      for (size_t k=0; k<same.size(); k++)
+        json_value += inner + "  " + children[same[k]]->printJSONValue(inner + "  ") + (k+1<same.size() ? ",\n" : "\n");
+      json_value += inner + "]";
+    }
+  }
+  return json_value + "\n" + space + "}";
+}
+
+/*!
+  Returns true if a value is a valid JSON number.
+
+  @param[in] value_arg The value to be checked.
+*/
+bool YAML_Element::is_json_number(const std::string & value_arg) {
+  size_t i = 0, n = value_arg.size();
+  if (i<n && value_arg[i]=='-') i++;
+  if (i>=n || !isdigit(value_arg[i])) return false;
+  if (value_arg[i]=='0') i++;
+  else while (i<n && isdigit(value_arg[i])) i++;
+  if (i<n && value_arg[i]=='.') {
+    i++;
+    if (i>=n || !isdigit(value_arg[i])) return false;
+    while (i<n && isdigit(value_arg[i])) i++;
+  }
+  if (i<n && (value_arg[i]=='e' || value_arg[i]=='E')) {
+    i++;
+    if (i<n && (value_arg[i]=='+' || value_arg[i]=='-')) i++;
+    if (i>=n || !isdigit(value_arg[i])) return false;
+    while (i<n && isdigit(value_arg[i])) i++;
+  }
+  return i==n;
+}
+
+/*!
+  Converts a string to a quoted JSON string. Quotes and backslashes are
+  escaped, control characters are written as their short escape sequence
+  or as \u00XX.
+
+  @param[in] value_arg The string to be converted.
+*/
+string YAML_Element::convert_string_to_json(const std::string & value_arg) {
+  static const char hex[] = "0123456789abcdef";
+  string json_string = "\"";
+  for (size_t i=0; i<value_arg.size(); i++) {
+    const unsigned char c = value_arg[i];
+    switch (c) {
+      case '"': json_string += "\\\""; break;
+      case '\\': json_string += "\\\\"; break;
+      case '\b': json_string += "\\b"; break;
+      case '\f': json_string += "\\f"; break;
+      case '\n': json_string += "\\n"; break;
+      case '\r': json_string += "\\r"; break;
+      case '\t': json_string += "\\t"; break;
+      default:
+        if (c<0x20) {
+          json_string += "\\u00";
+          json_string += hex[c>>4];
+          json_string += hex[c&0xf];
+        } else
+          json_string += value_arg[i];
+    }
+  }
+  return json_string + "\"";
+}
+
 /*!
   Converts a double precision value to a string.
 
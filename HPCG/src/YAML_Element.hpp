@@ -63,11 +63,15 @@ public:
   //! get the element in the list with the given key
   YAML_Element * get(const std::string & key_arg);
   std::string printYAML(std::string space);
+  std::string printJSON(std::string space);
+  std::string printJSONValue(std::string space);
 
 protected:
   std::string key; //!< the key under which the element is stored
   std::string value; //!< the value of the stored element
   std::vector<YAML_Element *> children; //!< children elements of this element
+  static bool is_json_number(const std::string & value_arg);
+  static std::string convert_string_to_json(const std::string & value_arg);
 
 private:
   std::string convert_double_to_string(double value_arg);
@@ -15,9 +15,14 @@
 #include <fstream>
 
 #include "hpcg.hpp"
+#include "Backend.hpp"
+#include "Trace.hpp"
+#include "HardwareCounters.hpp"
 
 /*!
-  Closes the I/O stream used for logging information throughout the HPCG run.
+  Closes the I/O stream used for logging information throughout the HPCG run,
+  writes the trace of the kernel calls if enabled, closes the hardware
+  counters and stops the thread pool of the std::thread backend.
 
   @return returns 0 upon success and non-zero otherwise
 
@@ -26,5 +31,8 @@
 int
 HPCG_Finalize(void) {
   HPCG_fout.close();
+  FinalizeTrace();
+  FinalizeHardwareCounters();
+  FinalizeThreadPool();
   return(0);
 }
@@ -29,14 +29,35 @@
 
 extern std::ofstream HPCG_fout;
 
+/*!
+  Maximum number of multigrid levels, including the finest level.
+*/
+#define HPCG_MAX_MG_LEVELS 16
+
 struct HPCG_Params_STRUCT {
   int comm_size; //!< Number of MPI processes in MPI_COMM_WORLD
   int comm_rank; //!< This process' MPI rank in the range [0 to comm_size - 1]
   int numThreads; //!< This process' number of threads
-  int nx; //!< Number of x-direction grid points for each local subdomain
-  int ny; //!< Number of y-direction grid points for each local subdomain
-  int nz; //!< Number of z-direction grid points for each local subdomain
+  int nx; //!< Number of x-direction grid points for each local subdomain, of the global grid if strongScaling is set
+  int ny; //!< Number of y-direction grid points for each local subdomain, of the global grid if strongScaling is set
+  int nz; //!< Number of z-direction grid points for each local subdomain, of the global grid if strongScaling is set
+  int strongScaling; //!< 1 if nx, ny and nz give the global grid, which is split across the processes
   int runningTime; //!< Number of seconds to run the timed portion of the benchmark
+  int smootherType; //!< Smoother used by the optimized multigrid preconditioner (see SmootherType)
+  int smootherDegree; //!< Polynomial degree of the Chebyshev smoother
+  int smootherBlocks; //!< Number of blocks per level of the block Gauss-Seidel smoother
+  int coarseDirectSolve; //!< Solve the coarsest grid problem with a Cholesky factorization instead of the smoother
+  int coarseAgglomerate; //!< Solve the coarsest grid problem of all processes on rank 0
+  int numberOfMgLevels; //!< Number of multigrid levels including the finest level
+  int mgCycle; //!< Multigrid cycle of the optimized preconditioner (see MGCycle)
+  int numberOfPresmootherSteps[HPCG_MAX_MG_LEVELS]; //!< Number of presmoother steps on each level
+  int numberOfPostsmootherSteps[HPCG_MAX_MG_LEVELS]; //!< Number of postsmoother steps on each level
+  int maxNumberOfRhs; //!< Largest number of right-hand sides solved together in the multiple right-hand-side phase, 0 to skip it
+  int numberOfInstances; //!< Number of independent problem instances solved concurrently in the ensemble phase, 0 to skip it
+  char problemCacheDirectory[256]; //!< Directory of the binary problem cache files, empty to always generate the problem
+  char referenceCacheDirectory[256]; //!< Directory of the reference phase cache file, empty to always run the reference phases
+  int recomputeReference; //!< Run the reference phases and rewrite the reference cache even if it holds this problem
+  double memoryFraction; //!< Fraction of the host memory the problem was sized to fill, 0 if the grid was given
 };
 /*!
   HPCG_Params is a shorthand for HPCG_Params_STRUCT
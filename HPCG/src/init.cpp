@@ -34,6 +34,15 @@
 #include "hpcg.hpp"
 
 #include "ReadHpcgDat.hpp"
+#include "SmootherData.hpp"
+#include "MGData.hpp"
+#include "MultiVector.hpp"
+#include "Backend.hpp"
+#include "MemoryUsage.hpp"
+#include "CG.hpp"
+#include "MatrixFormat.hpp"
+#include "Trace.hpp"
+#include "HardwareCounters.hpp"
 
 std::ofstream HPCG_fout; //!< output file stream for logging activities during HPCG run
 
@@ -45,6 +54,28 @@ startswith(const char * s, const char * prefix) {
   return 1;
 }
 
+/*!
+  Parses a comma separated list of smoother step counts, one per level. The
+  last value given is used for all remaining levels.
+
+  @param[in]  s the list of step counts
+  @param[out] steps the step counts of all HPCG_MAX_MG_LEVELS levels, unchanged on error
+*/
+static void
+parsesteplist(const char * s, int * steps) {
+  int values[HPCG_MAX_MG_LEVELS], n = 0, consumed = 0;
+
+  while (n < HPCG_MAX_MG_LEVELS && sscanf(s, "%d%n", values+n, &consumed) == 1 && values[n] >= 0) {
+    ++n;
+    s += consumed;
+    if (*s != ',') break;
+    ++s;
+  }
+  if (n == 0) return;
+  for (int i = 0; i < HPCG_MAX_MG_LEVELS; ++i)
+    steps[i] = values[i < n ? i : n-1];
+}
+
 /*!
   Initializes an HPCG run by obtaining problem parameters (from a file on
   command line) and then broadcasts them to all nodes. It also initializes
@@ -68,6 +99,18 @@ HPCG_Init(int * argc_p, char ** *argv_p, HPCG_Params & params) {
   char fname[80];
   int i = 0, j = 0, iparams[4] = {};
   char cparams[3][6] = {"--nx=", "--ny=", "--nz="};
+  int sparams[5] = {SMOOTHER_SYMGS, 2, 0, 0, 0}; // smoother type, degree, number of blocks, coarse direct solve and agglomeration
+  int dparams[4] = {4, MG_CYCLE_V, 1, 1}; // multigrid levels, cycle, pre- and postsmoother steps from hpcg.dat
+  int mparams[2+2*HPCG_MAX_MG_LEVELS]; // multigrid levels, cycle, pre- and postsmoother steps per level
+  bool mset[4] = {false, false, false, false}; // multigrid parameters given on the command line
+  int pparams[2] = {0, 0}; // additional phases: largest number of right-hand sides solved together, number of ensemble instances
+  int bparams[8] = {-1, -1, -1, -1, 0, REDUCTION_FAST, 0, MATRIX_FORMAT_AUTO}; // backends of SpMV, dot product, WAXPBY and multigrid, size of the thread pool, summation order of the dot product, CG as a dataflow graph, matrix format
+  int tparams[3] = {0, 1<<18, 0}; // trace of the kernel calls, capacity of the trace buffer of each thread, hardware counters
+  char cachedir[sizeof(params.problemCacheDirectory)] = ""; // directory of the problem cache
+  char refdir[sizeof(params.referenceCacheDirectory)] = ""; // directory of the reference cache
+  int recompute = 0; // recompute the reference phases even if the reference cache holds them
+  double mfraction = 0.0; // fraction of the host memory the problem is sized to fill, 0 to use the given grid
+  int scaling = 0; // 1 if the grid dimensions are global and split across the processes (strong scaling)
   time_t rawtime;
   tm * ptm;
 
@@ -81,10 +124,146 @@ HPCG_Init(int * argc_p, char ** *argv_p, HPCG_Params & params) {
       if (startswith(argv[i], cparams[j]))
         if (sscanf(argv[i]+strlen(cparams[j]), "%d", iparams+j) != 1 || iparams[j] < 10) iparams[j] = 0;
 
+  /* smoother selection for the optimized multigrid preconditioner */
+  for (i = 1; i < argc && argv[i]; ++i) {
+    if (startswith(argv[i], "--smoother=")) {
+      const char * name = argv[i]+strlen("--smoother=");
+      if (strcmp(name, "symgs") == 0) sparams[0] = SMOOTHER_SYMGS;
+      else if (strcmp(name, "chebyshev") == 0) sparams[0] = SMOOTHER_CHEBYSHEV;
+      else if (strcmp(name, "blockgs") == 0) sparams[0] = SMOOTHER_BLOCK_L1;
+      else if (strcmp(name, "multicolor") == 0) sparams[0] = SMOOTHER_MULTICOLOR;
+      else if (strcmp(name, "jacobi") == 0) sparams[0] = SMOOTHER_JACOBI;
+    } else if (startswith(argv[i], "--smoother-degree=")) {
+      if (sscanf(argv[i]+strlen("--smoother-degree="), "%d", sparams+1) != 1 || sparams[1] < 1) sparams[1] = 2;
+    } else if (startswith(argv[i], "--smoother-blocks=")) {
+      if (sscanf(argv[i]+strlen("--smoother-blocks="), "%d", sparams+2) != 1 || sparams[2] < 1) sparams[2] = 0;
+    } else if (startswith(argv[i], "--coarse-solver=")) {
+      const char * name = argv[i]+strlen("--coarse-solver=");
+      if (strcmp(name, "smoother") == 0) sparams[3] = 0;
+      else if (strcmp(name, "cholesky") == 0) sparams[3] = 1;
+    } else if (strcmp(argv[i], "--coarse-agglomerate") == 0) {
+      sparams[4] = 1;
+    }
+  }
+
+  /* multiple right-hand-side and ensemble phases */
+  for (i = 1; i < argc && argv[i]; ++i) {
+    if (startswith(argv[i], "--multi-rhs=")) {
+      if (sscanf(argv[i]+strlen("--multi-rhs="), "%d", pparams) != 1 || pparams[0] < 0) pparams[0] = 0;
+    } else if (startswith(argv[i], "--ensemble=")) {
+      if (sscanf(argv[i]+strlen("--ensemble="), "%d", pparams+1) != 1 || pparams[1] < 0) pparams[1] = 0;
+    }
+  }
+  if (pparams[0] > HPCG_MAX_RHS) pparams[0] = HPCG_MAX_RHS;
+
+  /* kernel backends, for all kernels or per kernel, the latter take precedence */
+  for (i = 1; i < argc && argv[i]; ++i)
+    if (startswith(argv[i], "--backend="))
+      for (j = 0; j < 4; ++j)
+        bparams[j] = ParseBackend(argv[i]+strlen("--backend="));
+  for (i = 1; i < argc && argv[i]; ++i) {
+    if (startswith(argv[i], "--backend-spmv=")) {
+      bparams[0] = ParseBackend(argv[i]+strlen("--backend-spmv="));
+    } else if (startswith(argv[i], "--backend-dot=")) {
+      bparams[1] = ParseBackend(argv[i]+strlen("--backend-dot="));
+    } else if (startswith(argv[i], "--backend-waxpby=")) {
+      bparams[2] = ParseBackend(argv[i]+strlen("--backend-waxpby="));
+    } else if (startswith(argv[i], "--backend-mg=")) {
+      bparams[3] = ParseBackend(argv[i]+strlen("--backend-mg="));
+    } else if (startswith(argv[i], "--backend-threads=")) {
+      if (sscanf(argv[i]+strlen("--backend-threads="), "%d", bparams+4) != 1 || bparams[4] < 0) bparams[4] = 0;
+    } else if (startswith(argv[i], "--dot-reduction=")) {
+      bparams[5] = ParseReduction(argv[i]+strlen("--dot-reduction="));
+      if (bparams[5] < 0) bparams[5] = REDUCTION_FAST;
+    } else if (strcmp(argv[i], "--cg-dataflow") == 0) {
+      bparams[6] = 1;
+    } else if (startswith(argv[i], "--matrix-format=")) {
+      bparams[7] = ParseMatrixFormat(argv[i]+strlen("--matrix-format="));
+      if (bparams[7] < 0) bparams[7] = MATRIX_FORMAT_AUTO;
+    }
+  }
+  for (j = 0; j < 4; ++j)
+    if (bparams[j] < 0 || ! BackendAvailable(bparams[j])) bparams[j] = DefaultBackend();
+
+  /* timeline trace and hardware counters of the kernel calls */
+  for (i = 1; i < argc && argv[i]; ++i) {
+    if (strcmp(argv[i], "--trace") == 0) {
+      tparams[0] = 1;
+    } else if (startswith(argv[i], "--trace-events=")) {
+      if (sscanf(argv[i]+strlen("--trace-events="), "%d", tparams+1) != 1 || tparams[1] < 1) tparams[1] = 1<<18;
+    } else if (strcmp(argv[i], "--hw-counters") == 0) {
+      tparams[2] = 1;
+    }
+  }
+
+  /* binary cache of the generated problem */
+  for (i = 1; i < argc && argv[i]; ++i)
+    if (startswith(argv[i], "--problem-cache=")) {
+      strncpy(cachedir, argv[i]+strlen("--problem-cache="), sizeof(cachedir)-1);
+      cachedir[sizeof(cachedir)-1] = 0;
+    }
+
+  /* cache of the reference phase results */
+  for (i = 1; i < argc && argv[i]; ++i) {
+    if (startswith(argv[i], "--reference-cache=")) {
+      strncpy(refdir, argv[i]+strlen("--reference-cache="), sizeof(refdir)-1);
+      refdir[sizeof(refdir)-1] = 0;
+    } else if (strcmp(argv[i], "--recompute-reference") == 0) {
+      recompute = 1;
+    }
+  }
+
+  /* global grid split across the processes for strong scaling studies */
+  for (i = 1; i < argc && argv[i]; ++i)
+    if (startswith(argv[i], "--scaling=")) {
+      const char * name = argv[i]+strlen("--scaling=");
+      if (strcmp(name, "strong") == 0) scaling = 1;
+      else if (strcmp(name, "weak") == 0) scaling = 0;
+    }
+
+  /* problem size from the memory of the host */
+  for (i = 1; i < argc && argv[i]; ++i)
+    if (startswith(argv[i], "--memory-fraction="))
+      if (sscanf(argv[i]+strlen("--memory-fraction="), "%lf", &mfraction) != 1 || mfraction <= 0.0 || mfraction > 1.0) mfraction = 0.0;
+
+  /* multigrid hierarchy and cycle, given per level for the smoother steps */
+  for (j = 0; j < HPCG_MAX_MG_LEVELS; ++j)
+    mparams[2+j] = mparams[2+HPCG_MAX_MG_LEVELS+j] = 1;
+  for (i = 1; i < argc && argv[i]; ++i) {
+    if (startswith(argv[i], "--mg-levels=")) {
+      mset[0] = sscanf(argv[i]+strlen("--mg-levels="), "%d", mparams) == 1;
+    } else if (startswith(argv[i], "--mg-cycle=")) {
+      const char * name = argv[i]+strlen("--mg-cycle=");
+      mset[1] = true;
+      if (strcmp(name, "v") == 0 || strcmp(name, "V") == 0) mparams[1] = MG_CYCLE_V;
+      else if (strcmp(name, "w") == 0 || strcmp(name, "W") == 0) mparams[1] = MG_CYCLE_W;
+      else if (strcmp(name, "f") == 0 || strcmp(name, "F") == 0) mparams[1] = MG_CYCLE_F;
+      else mset[1] = false;
+    } else if (startswith(argv[i], "--mg-pre-steps=")) {
+      parsesteplist(argv[i]+strlen("--mg-pre-steps="), mparams+2);
+      mset[2] = true;
+    } else if (startswith(argv[i], "--mg-post-steps=")) {
+      parsesteplist(argv[i]+strlen("--mg-post-steps="), mparams+2+HPCG_MAX_MG_LEVELS);
+      mset[3] = true;
+    }
+  }
+
   if (! iparams[0] && ! iparams[1] && ! iparams[2]) { /* no geometry arguments on the command line */
-    ReadHpcgDat(iparams, iparams+3);
+    ReadHpcgDat(iparams, iparams+3, dparams);
   }
 
+  /* command line options take precedence over hpcg.dat */
+  if (! mset[0]) mparams[0] = dparams[0];
+  if (! mset[1]) mparams[1] = dparams[1];
+  for (j = 0; j < HPCG_MAX_MG_LEVELS; ++j) {
+    if (! mset[2]) mparams[2+j] = dparams[2];
+    if (! mset[3]) mparams[2+HPCG_MAX_MG_LEVELS+j] = dparams[3];
+  }
+  if (mparams[0] < 1) mparams[0] = 1;
+  if (mparams[0] > HPCG_MAX_MG_LEVELS) mparams[0] = HPCG_MAX_MG_LEVELS;
+  for (j = 0; j < 2*HPCG_MAX_MG_LEVELS; ++j)
+    if (mparams[2+j] < 0) mparams[2+j] = 0;
+
   for (i = 0; i < 3; ++i) {
     if (iparams[i] < 16)
       for (j = 1; j <= 2; ++j)
@@ -96,14 +275,70 @@ HPCG_Init(int * argc_p, char ** *argv_p, HPCG_Params & params) {
 
 #ifndef HPCG_NOMPI
   MPI_Bcast( iparams, 4, MPI_INT, 0, MPI_COMM_WORLD );
+  MPI_Bcast( sparams, 5, MPI_INT, 0, MPI_COMM_WORLD );
+  MPI_Bcast( mparams, 2+2*HPCG_MAX_MG_LEVELS, MPI_INT, 0, MPI_COMM_WORLD );
+  MPI_Bcast( pparams, 2, MPI_INT, 0, MPI_COMM_WORLD );
+  MPI_Bcast( bparams, 8, MPI_INT, 0, MPI_COMM_WORLD );
+  MPI_Bcast( tparams, 3, MPI_INT, 0, MPI_COMM_WORLD );
+  MPI_Bcast( cachedir, sizeof(cachedir), MPI_CHAR, 0, MPI_COMM_WORLD );
+  MPI_Bcast( refdir, sizeof(refdir), MPI_CHAR, 0, MPI_COMM_WORLD );
+  MPI_Bcast( &recompute, 1, MPI_INT, 0, MPI_COMM_WORLD );
+  MPI_Bcast( &mfraction, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD );
+  MPI_Bcast( &scaling, 1, MPI_INT, 0, MPI_COMM_WORLD );
 #endif
 
+  if (mfraction > 0.0 && scaling) { // The memory fraction sizes the local grids, strong scaling fixes the global grid
+    int rank = 0;
+#ifndef HPCG_NOMPI
+    MPI_Comm_rank( MPI_COMM_WORLD, &rank );
+#endif
+    if (rank == 0) std::cerr << "HPCG: --memory-fraction sizes the local grids and cannot be combined with --scaling=strong" << std::endl;
+    return 1;
+  }
+  if (mfraction > 0.0) // The memory fraction sizes the local grids
+    iparams[0] = iparams[1] = iparams[2] = AutoSizeProblem(mfraction, mparams[0]);
+
   params.nx = iparams[0];
   params.ny = iparams[1];
   params.nz = iparams[2];
+  params.strongScaling = scaling;
 
   params.runningTime = iparams[3];
 
+  params.smootherType = sparams[0];
+  params.smootherDegree = sparams[1];
+  params.smootherBlocks = sparams[2];
+  params.coarseDirectSolve = sparams[3];
+  params.coarseAgglomerate = sparams[4];
+
+  params.numberOfMgLevels = mparams[0];
+  params.mgCycle = mparams[1];
+  for (j = 0; j < HPCG_MAX_MG_LEVELS; ++j) {
+    params.numberOfPresmootherSteps[j] = mparams[2+j];
+    params.numberOfPostsmootherSteps[j] = mparams[2+HPCG_MAX_MG_LEVELS+j];
+  }
+
+  params.maxNumberOfRhs = pparams[0];
+  params.numberOfInstances = pparams[1];
+  strcpy(params.problemCacheDirectory, cachedir);
+  strcpy(params.referenceCacheDirectory, refdir);
+  params.recomputeReference = recompute;
+  params.memoryFraction = mfraction;
+
+  HPCG_backends.spmv = bparams[0];
+  HPCG_backends.dot = bparams[1];
+  HPCG_backends.waxpby = bparams[2];
+  HPCG_backends.mg = bparams[3];
+  HPCG_dotReduction = bparams[5];
+  HPCG_matrixFormat = bparams[7];
+#if !defined(HPCG_NOHPX)
+  HPCG_cgDataflow = bparams[6]; // The asynchronous kernels are only available with HPX
+#endif
+  bool useThreadPool = false;
+  for (j = 0; j < 4; ++j)
+    if (bparams[j] == BACKEND_THREADS) useThreadPool = true;
+  if (useThreadPool) InitializeThreadPool(bparams[4]);
+
 #ifdef HPCG_NOMPI
 #ifdef HPCG_NOHPX
   params.comm_rank = 0;
@@ -117,16 +352,17 @@ HPCG_Init(int * argc_p, char ** *argv_p, HPCG_Params & params) {
   MPI_Comm_size( MPI_COMM_WORLD, &params.comm_size );
 #endif
 
-#ifdef HPCG_NOOPENMP
-#ifdef HPCG_NOHPX
-  params.numThreads = 1;
-#else
+#if !defined(HPCG_NOHPX)
   params.numThreads = (int)hpx::get_num_worker_threads();
-#endif
-#else
+#elif !defined(HPCG_NOOPENMP)
   #pragma omp parallel
   params.numThreads = omp_get_num_threads();
+#else
+  params.numThreads = 1;
 #endif
+  if (useThreadPool && ThreadPoolSize() > params.numThreads) params.numThreads = ThreadPoolSize(); // One subdomain per thread of the pool
+  if (params.smootherBlocks==0) params.smootherBlocks = params.numThreads; // One block of the block smoother per thread
+
 
   time ( &rawtime );
   ptm = localtime(&rawtime);
@@ -147,5 +383,20 @@ HPCG_Init(int * argc_p, char ** *argv_p, HPCG_Params & params) {
 #endif
   }
 
+  /* the trace of each process is written next to the log file by HPCG_Finalize */
+  if (tparams[0]) {
+    if (0 == params.comm_rank)
+      sprintf( fname, "hpcg_trace_%04d.%02d.%02d.%02d.%02d.%02d.json",
+          1900 + ptm->tm_year, ptm->tm_mon+1, ptm->tm_mday, ptm->tm_hour, ptm->tm_min, ptm->tm_sec );
+    else
+      sprintf( fname, "hpcg_trace_%d_%04d.%02d.%02d.%02d.%02d.%02d.json", params.comm_rank,
+          1900 + ptm->tm_year, ptm->tm_mon+1, ptm->tm_mday, ptm->tm_hour, ptm->tm_min, ptm->tm_sec );
+    InitializeTrace(fname, params.comm_rank, tparams[1]);
+  }
+
+  /* opened last, so that the counters of all worker threads started above are read */
+  if (tparams[2])
+    InitializeHardwareCounters();
+
   return 0;
 }
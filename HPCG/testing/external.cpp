@@ -0,0 +1,175 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file external.cpp
+
+ HPCG routine
+ */
+
+// Main routine of a program that reads a matrix from a file, or generates
+// the synthetic problem on one level, and solves it with preconditioned CG.
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/hpx_fwd.hpp>
+#include <hpx/hpx_main.hpp>
+#endif
+
+#ifndef HPCG_NOMPI
+#include <mpi.h> // If this routine is not compiled with HPCG_NOMPI
+#endif
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+using std::endl;
+
+#include "hpcg.hpp"
+
+#include "GenerateProblemHierarchy.hpp"
+#include "SetupSmoother.hpp"
+#include "ReadProblem.hpp"
+#include "WriteProblem.hpp"
+#include "BenchmarkExternal.hpp"
+#include "Geometry.hpp"
+#include "SparseMatrix.hpp"
+#include "Vector.hpp"
+#include "CGData.hpp"
+#include "mytimer.hpp"
+
+/*!
+  External problem driver: read a symmetric positive definite matrix from a
+  MatrixMarket or binary CSR file, or generate the synthetic problem of the
+  benchmark without the multigrid hierarchy, and solve it with CG.
+
+  In addition to the options of the benchmark the following are accepted:
+  --matrix=FILE (the matrix, default: the synthetic problem of size nx, ny,
+  nz), --write-matrix=FILE (write the matrix, in MatrixMarket format if the
+  name ends in .mtx and in binary CSR format otherwise),
+  --preconditioner=jacobi|symgs|chebyshev|none (default jacobi),
+  --max-iters=N (default 500) and --tolerance=X (default 1e-8).
+
+  Only one process is supported.
+
+  @param[in]  argc Standard argument count.
+  @param[in]  argv Standard argument array.
+
+  @return Returns zero on success and a non-zero value otherwise.
+*/
+int main(int argc, char * argv[]) {
+
+#ifndef HPCG_NOMPI
+  MPI_Init(&argc, &argv);
+#endif
+
+  HPCG_Params params;
+
+  if (HPCG_Init(&argc, &argv, params) != 0) { // Contradicting options, HPCG_Init printed the reason
+#ifndef HPCG_NOMPI
+    MPI_Finalize();
+#endif
+    return 1;
+  }
+
+  ExternalBenchmarkData external_data;
+  external_data.matrixFile[0] = 0;
+  external_data.writeFile[0] = 0;
+  external_data.writeSize = external_data.writeTime = 0.0;
+  external_data.preconditioner = SMOOTHER_JACOBI;
+  external_data.maxIters = 500;
+  external_data.tolerance = 1.0e-8;
+  for (int i = 1; i < argc && argv[i]; ++i) {
+    if (strncmp(argv[i], "--matrix=", strlen("--matrix=")) == 0) {
+      strncpy(external_data.matrixFile, argv[i]+strlen("--matrix="), sizeof(external_data.matrixFile)-1);
+      external_data.matrixFile[sizeof(external_data.matrixFile)-1] = 0;
+    } else if (strncmp(argv[i], "--write-matrix=", strlen("--write-matrix=")) == 0) {
+      strncpy(external_data.writeFile, argv[i]+strlen("--write-matrix="), sizeof(external_data.writeFile)-1);
+      external_data.writeFile[sizeof(external_data.writeFile)-1] = 0;
+    } else if (strncmp(argv[i], "--preconditioner=", strlen("--preconditioner=")) == 0) {
+      const char * name = argv[i]+strlen("--preconditioner=");
+      if (strcmp(name, "jacobi") == 0) external_data.preconditioner = SMOOTHER_JACOBI;
+      else if (strcmp(name, "symgs") == 0) external_data.preconditioner = SMOOTHER_SYMGS;
+      else if (strcmp(name, "chebyshev") == 0) external_data.preconditioner = SMOOTHER_CHEBYSHEV;
+      else if (strcmp(name, "none") == 0) external_data.preconditioner = -1;
+    } else if (strncmp(argv[i], "--max-iters=", strlen("--max-iters=")) == 0) {
+      sscanf(argv[i]+strlen("--max-iters="), "%d", &external_data.maxIters);
+    } else if (strncmp(argv[i], "--tolerance=", strlen("--tolerance=")) == 0) {
+      sscanf(argv[i]+strlen("--tolerance="), "%lf", &external_data.tolerance);
+    }
+  }
+
+  int size = params.comm_size, rank = params.comm_rank; // Number of MPI processes, My process ID
+  if (size!=1) {
+    if (rank==0) HPCG_fout << "The external problem driver only supports one process." << endl;
+    HPCG_Finalize();
+#ifndef HPCG_NOMPI
+    MPI_Finalize();
+#endif
+    return 1;
+  }
+
+  // Read the matrix, or construct the synthetic problem without coarse levels
+  SparseMatrix A;
+  InitializeSparseMatrix(A, 0);
+  Vector b, x, xexact;
+  int ierr = 0;
+  if (external_data.matrixFile[0]) {
+    ierr = ReadProblem(external_data.matrixFile, params.numThreads, A, b, x, xexact, external_data.read);
+  } else {
+    GenerateProblemHierarchy(params, 1, 0, A, b, x, xexact, 0);
+  }
+  if (ierr!=0) {
+    HPCG_fout << "Error in reading the matrix = " << ierr << endl;
+    DeleteMatrix(A);
+    HPCG_Finalize();
+#ifndef HPCG_NOMPI
+    MPI_Finalize();
+#endif
+    return 1;
+  }
+
+  if (external_data.writeFile[0]) {
+    double t0 = mytimer();
+    ierr = WriteMatrix(external_data.writeFile, A);
+    external_data.writeTime = mytimer() - t0;
+    std::ifstream written(external_data.writeFile, std::ios::binary | std::ios::ate);
+    external_data.writeSize = written ? (double) written.tellg() : 0.0;
+    if (ierr!=0) HPCG_fout << "Error in writing the matrix to " << external_data.writeFile << endl;
+  }
+
+  CGData data;
+  InitializeSparseCGData(A, data);
+  if (external_data.preconditioner>=0 && SetupSmoother(A, external_data.preconditioner, params.smootherDegree, params.smootherBlocks)!=0)
+    external_data.preconditioner = SMOOTHER_SYMGS; // SetupSmoother falls back to Gauss-Seidel
+
+  ierr = BenchmarkExternal(A, data, b, x, external_data);
+  if (ierr!=0) HPCG_fout << "Error in call to CG: " << ierr << ".\n" << endl;
+
+  ReportExternalBenchmark(A, external_data);
+
+  // Clean up
+  DeleteMatrix(A);
+  DeleteCGData(data);
+  DeleteVector(x);
+  DeleteVector(b);
+  DeleteVector(xexact);
+
+  HPCG_Finalize();
+
+#ifndef HPCG_NOMPI
+  MPI_Finalize();
+#endif
+  return 0 ;
+}
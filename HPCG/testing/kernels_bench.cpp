@@ -0,0 +1,142 @@
+
+//@HEADER
+// ***************************************************
+//
+// HPCG: High Performance Conjugate Gradient Benchmark
+//
+// Contact:
+// Michael A. Heroux ( maherou@sandia.gov)
+// Jack Dongarra     (dongarra@eecs.utk.edu)
+// Piotr Luszczek    (luszczek@eecs.utk.edu)
+//
+// ***************************************************
+//@HEADER
+
+
+/*!
+ @file kernels_bench.cpp
+
+ HPCG routine
+ */
+
+// Main routine of a program that generates the HPCG problem and its
+// multigrid hierarchy once and then times each kernel in isolation.
+
+#if !defined(HPCG_NOHPX)
+#include <hpx/hpx_fwd.hpp>
+#include <hpx/hpx_main.hpp>
+#endif
+
+#ifndef HPCG_NOMPI
+#include <mpi.h> // If this routine is not compiled with HPCG_NOMPI
+#endif
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+using std::endl;
+
+#include "hpcg.hpp"
+
+#include "GenerateProblemHierarchy.hpp"
+#include "OptimizeProblem.hpp"
+#include "SetupSmoother.hpp"
+#include "BenchmarkKernels.hpp"
+#include "Geometry.hpp"
+#include "SparseMatrix.hpp"
+#include "Vector.hpp"
+#include "CGData.hpp"
+
+/*!
+  Minimum length of the STREAM triad vectors on each process, large enough
+  to exceed the last level cache.
+*/
+#define HPCG_TRIAD_MIN_LENGTH (1<<22)
+
+/*!
+  Kernel benchmark driver: construct the synthetic problem and its multigrid
+  hierarchy in the same way as the benchmark, measure the STREAM triad
+  bandwidth and time each kernel on each level.
+
+  In addition to the options of the benchmark the following are accepted:
+  --bench-warmups=N (untimed applications, default 3), --bench-reps=N (timed
+  applications, default 20) and --bench-triad-length=N (length of the triad
+  vectors on each process).
+
+  @param[in]  argc Standard argument count.
+  @param[in]  argv Standard argument array.
+
+  @return Returns zero on success and a non-zero value otherwise.
+*/
+int main(int argc, char * argv[]) {
+
+#ifndef HPCG_NOMPI
+  MPI_Init(&argc, &argv);
+#endif
+
+  HPCG_Params params;
+
+  if (HPCG_Init(&argc, &argv, params) != 0) { // Contradicting options, HPCG_Init printed the reason
+#ifndef HPCG_NOMPI
+    MPI_Finalize();
+#endif
+    return 1;
+  }
+
+  int warmups = 3, repetitions = 20, triadLength = 0;
+  for (int i = 1; i < argc && argv[i]; ++i) {
+    if (strncmp(argv[i], "--bench-warmups=", strlen("--bench-warmups=")) == 0)
+      sscanf(argv[i]+strlen("--bench-warmups="), "%d", &warmups);
+    else if (strncmp(argv[i], "--bench-reps=", strlen("--bench-reps=")) == 0)
+      sscanf(argv[i]+strlen("--bench-reps="), "%d", &repetitions);
+    else if (strncmp(argv[i], "--bench-triad-length=", strlen("--bench-triad-length=")) == 0)
+      sscanf(argv[i]+strlen("--bench-triad-length="), "%d", &triadLength);
+  }
+#ifndef HPCG_NOMPI
+  int bparams[3] = {warmups, repetitions, triadLength};
+  MPI_Bcast( bparams, 3, MPI_INT, 0, MPI_COMM_WORLD );
+  warmups = bparams[0];
+  repetitions = bparams[1];
+  triadLength = bparams[2];
+#endif
+
+  int rank = params.comm_rank; // My process ID
+  int ierr = 0;  // Used to check return codes on function calls
+
+  // Construct the geometry, linear system and multigrid hierarchy as the benchmark does
+  SparseMatrix A;
+  Vector b, x, xexact;
+  GenerateProblemHierarchy(params, params.numberOfMgLevels, params.problemCacheDirectory, A, b, x, xexact, 0);
+
+  CGData data;
+  InitializeSparseCGData(A, data);
+
+  SetupSmoother(A, params.smootherType, params.smootherDegree, params.smootherBlocks);
+  SetupCoarseSolver(A, params.coarseDirectSolve!=0, params.coarseAgglomerate!=0);
+  OptimizeProblem(A, data, b, x, xexact);
+
+  // Time the kernels against the bandwidth of the STREAM triad
+  KernelBenchmarkData benchmark_data;
+  if (triadLength < A.localNumberOfRows) triadLength = A.localNumberOfRows;
+  if (triadLength < HPCG_TRIAD_MIN_LENGTH) triadLength = HPCG_TRIAD_MIN_LENGTH;
+  benchmark_data.triadLength = triadLength;
+  ierr += BenchmarkStreamTriad(triadLength, warmups, repetitions, benchmark_data.triadBandwidth);
+  ierr += BenchmarkKernels(A, warmups, repetitions, benchmark_data);
+  if (ierr!=0 && rank==0) HPCG_fout << "Error in kernel benchmark = " << ierr << endl;
+
+  ReportKernelBenchmark(A, benchmark_data);
+
+  // Clean up
+  DeleteMatrix(A); // This delete will recursively delete all coarse grid data
+  DeleteCGData(data);
+  DeleteVector(x);
+  DeleteVector(b);
+  DeleteVector(xexact);
+
+  HPCG_Finalize();
+
+#ifndef HPCG_NOMPI
+  MPI_Finalize();
+#endif
+  return 0 ;
+}
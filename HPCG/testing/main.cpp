@@ -23,7 +23,7 @@
 
 #if !defined(HPCG_NOHPX)
 #include <hpx/hpx_fwd.hpp>
-#include <hpx/hpx_main.hpp>
+#include <hpx/hpx_init.hpp>
 #endif
 
 #ifndef HPCG_NOMPI
@@ -42,12 +42,16 @@ using std::endl;
 
 #include "hpcg.hpp"
 
-#include "GenerateGeometry.hpp"
-#include "GenerateProblem.hpp"
-#include "GenerateCoarseProblem.hpp"
-#include "SetupHalo.hpp"
+#include "GenerateProblemHierarchy.hpp"
+#include "ReferenceCache.hpp"
+#include "MemoryUsage.hpp"
 #include "ExchangeHalo.hpp"
 #include "OptimizeProblem.hpp"
+#include "SetupSmoother.hpp"
+#include "CompareCoarseSolvers.hpp"
+#include "BenchmarkMultiCG.hpp"
+#include "BenchmarkEnsemble.hpp"
+#include "KernelCounters.hpp"
 #include "WriteProblem.hpp"
 #include "ReportResults.hpp"
 #include "mytimer.hpp"
@@ -70,10 +74,16 @@ using std::endl;
   @param[in]  argc Standard argument count.  Should equal 1 (no arguments passed in) or 4 (nx, ny, nz passed in)
   @param[in]  argv Standard argument array.  If argc==1, argv is unused.  If argc==4, argv[1], argv[2], argv[3] will be interpreted as nx, ny, nz, resp.
 
+  In HPX builds this is hpx_main, run by the HPX runtime started in main.
+
   @return Returns zero on success and a non-zero value otherwise.
 
 */
+#if !defined(HPCG_NOHPX)
+int hpx_main(int argc, char * argv[]) {
+#else
 int main(int argc, char * argv[]) {
+#endif
 
 
 #ifndef HPCG_NOHPX
@@ -94,12 +104,20 @@ std::cout<<"using mpi"<<endl;
 
   HPCG_Params params;
 
-  HPCG_Init(&argc, &argv, params);
+  if (HPCG_Init(&argc, &argv, params) != 0) { // Contradicting options, HPCG_Init printed the reason
+#ifndef HPCG_NOMPI
+    MPI_Finalize();
+#endif
+#if !defined(HPCG_NOHPX)
+    hpx::finalize();
+#endif
+    return 1;
+  }
 
-  int size = params.comm_size, rank = params.comm_rank; // Number of MPI processes, My process ID
+  int rank = params.comm_rank; // My process ID
 
 #ifdef HPCG_DETAILED_DEBUG
-  if (size < 100 && rank==0) HPCG_fout << "Process "<<rank<<" of "<<size<<" is alive with " << params.numThreads << " threads." <<endl;
+  if (params.comm_size < 100 && rank==0) HPCG_fout << "Process "<<rank<<" of "<<params.comm_size<<" is alive with " << params.numThreads << " threads." <<endl;
 
   if (rank==0) {
     char c;
@@ -125,22 +143,15 @@ std::cout<<"using mpi"<<endl;
   double t1 = mytimer();
 #endif
 
-  // Construct the geometry and linear system
-  Geometry * geom = new Geometry;
-  GenerateGeometry(size, rank, params.numThreads, nx, ny, nz, geom);
-
+  // Construct the geometry, linear system and multigrid hierarchy, or load them from the problem cache
   SparseMatrix A;
-  InitializeSparseMatrix(A, geom);
-
   Vector b, x, xexact;
-  GenerateProblem(A, &b, &x, &xexact);
-  SetupHalo(A);
-  int numberOfMgLevels = 4; // Number of levels including first
-  SparseMatrix * curLevelMatrix = &A;
-  for (int level = 1; level< numberOfMgLevels; ++level) {
-      GenerateCoarseProblem(*curLevelMatrix);
-      curLevelMatrix = curLevelMatrix->Ac; // Make the just-constructed coarse grid the next level
-  }
+  double tgen = mytimer();
+  int cached = 0;
+  int numberOfMgLevels = GenerateProblemHierarchy(params, params.numberOfMgLevels, params.problemCacheDirectory, A, b, x, xexact, &cached);
+  Geometry * geom = A.geom;
+  tgen = mytimer() - tgen;
+  if (rank==0) HPCG_fout << (cached ? "Problem loaded from the cache" : "Problem generated") << " in " << tgen << " seconds." << endl;
 
 
   CGData data;
@@ -150,9 +161,27 @@ std::cout<<"using mpi"<<endl;
   // Use this array for collecting timing information
   std::vector< double > times(9,0.0);
 
-  // Call user-tunable set up function.
-  double t7 = mytimer(); OptimizeProblem(A, data, b, x, xexact); t7 = mytimer() - t7;
+  // Call user-tunable set up functions, the smoother setup includes the Chebyshev eigenvalue estimation.
+  double t7 = mytimer();
+  SetupSmoother(A, params.smootherType, params.smootherDegree, params.smootherBlocks);
+  SetupCoarseSolver(A, params.coarseDirectSolve!=0, params.coarseAgglomerate!=0);
+  OptimizeProblem(A, data, b, x, xexact);
+  t7 = mytimer() - t7;
   times[7] = t7;
+
+  // Account the memory of the optimized problem and check that it stays in the memory of the NUMA nodes
+  MemoryUsage memory_data;
+  ComputeMemoryUsage(A, data, b, x, xexact, memory_data);
+  if (rank==0) {
+    if (params.memoryFraction>0.0)
+      HPCG_fout << "Local grid " << nx << "x" << ny << "x" << nz << " selected to fill " << params.memoryFraction << " of the host memory." << endl;
+    HPCG_fout << "Memory used for data: " << memory_data.maxProcessBytes << " bytes on the largest process, "
+        << memory_data.totalBytes << " bytes in total." << endl;
+    if (!memory_data.fitsHost)
+      HPCG_fout << "Warning: the processes of a host use more than its physical memory, the run may swap." << endl;
+    else if (!memory_data.numaLocal)
+      HPCG_fout << "Warning: the processes sharing a NUMA node use more than its memory, part of the data is not NUMA-local." << endl;
+  }
 #ifdef HPCG_DEBUG
   if (rank==0) HPCG_fout << "Total problem setup time in main (sec) = " << mytimer() - t1 << endl;
 #endif
@@ -190,6 +219,16 @@ std::cout<<"using mpi"<<endl;
 
   // Call Reference SpMV and MG. Compute Optimization time as ratio of times in these routines
 
+  // Skip the reference phases if the reference cache holds their results for this problem
+  int refMaxIters = 50;
+  char referenceFileName[sizeof(params.referenceCacheDirectory)+128];
+  ReferenceResults reference;
+  int referenceCached = 0;
+  if (params.referenceCacheDirectory[0]) {
+    ReferenceCacheFileName(params.referenceCacheDirectory, *geom, referenceFileName, sizeof(referenceFileName));
+    if (!params.recomputeReference) referenceCached = ReadReferenceCache(referenceFileName, A, refMaxIters, reference)==0;
+  }
+
   local_int_t nrow = A.localNumberOfRows;
   local_int_t ncol = A.localNumberOfColumns;
 
@@ -199,18 +238,22 @@ std::cout<<"using mpi"<<endl;
 
 
   // Record execution time of reference SpMV and MG kernels for reporting times
-  // First load vector with random values
+  // First load vector with random values, also with cached results so that later random vectors do not change
   FillRandomVector(x_overlap);
 
   int numberOfCalls = 10;
-  double t_begin = mytimer();
-  for (int i=0; i< numberOfCalls; ++i) {
-    ierr = ComputeSPMV_ref(A, x_overlap, b_computed); // b_computed = A*x_overlap
-    if (ierr) HPCG_fout << "Error in call to SpMV: " << ierr << ".\n" << endl;
-    ierr = ComputeMG_ref(A, b_computed, x_overlap); // b_computed = Minv*y_overlap
-    if (ierr) HPCG_fout << "Error in call to MG: " << ierr << ".\n" << endl;
+  if (referenceCached) {
+    times[8] = reference.spmvMgTime;
+  } else {
+    double t_begin = mytimer();
+    for (int i=0; i< numberOfCalls; ++i) {
+      ierr = ComputeSPMV_ref(A, x_overlap, b_computed); // b_computed = A*x_overlap
+      if (ierr) HPCG_fout << "Error in call to SpMV: " << ierr << ".\n" << endl;
+      ierr = ComputeMG_ref(A, b_computed, x_overlap); // b_computed = Minv*y_overlap
+      if (ierr) HPCG_fout << "Error in call to MG: " << ierr << ".\n" << endl;
+    }
+    times[8] = (mytimer() - t_begin)/((double) numberOfCalls);  // Total time divided by number of calls.
   }
-  times[8] = (mytimer() - t_begin)/((double) numberOfCalls);  // Total time divided by number of calls.
 #ifdef HPCG_DEBUG
   if (rank==0) HPCG_fout << "Total SpMV+MG timing phase execution time in main (sec) = " << mytimer() - t1 << endl;
 #endif
@@ -228,21 +271,36 @@ std::cout<<"using mpi"<<endl;
   int totalNiters_ref = 0;
   double normr = 0.0;
   double normr0 = 0.0;
-  int refMaxIters = 50;
   numberOfCalls = 1; // Only need to run the residual reduction analysis once
 
   // Compute the residual reduction for the natural ordering and reference kernels
   std::vector< double > ref_times(9,0.0);
   double tolerance = 0.0; // Set tolerance to zero to make all runs do maxIters iterations
   int err_count = 0;
-  for (int i=0; i< numberOfCalls; ++i) {
-    ZeroVector(x);
-    ierr = CG_ref( A, data, b, x, refMaxIters, tolerance, niters, normr, normr0, &ref_times[0], true);
-    if (ierr) ++err_count; // count the number of errors in CG
-    totalNiters_ref += niters;
+  double refTolerance = 0.0;
+  if (referenceCached) {
+    refTolerance = reference.tolerance;
+    ref_times[0] = reference.cgTime;
+    totalNiters_ref = reference.cgIterations;
+    if (rank==0) HPCG_fout << "Reference results loaded from the cache " << referenceFileName << endl;
+  } else {
+    for (int i=0; i< numberOfCalls; ++i) {
+      ZeroVector(x);
+      ierr = CG_ref( A, data, b, x, refMaxIters, tolerance, niters, normr, normr0, &ref_times[0], true);
+      if (ierr) ++err_count; // count the number of errors in CG
+      totalNiters_ref += niters;
+    }
+    if (rank == 0 && err_count) HPCG_fout << err_count << " error(s) in call(s) to reference CG." << endl;
+    refTolerance = normr / normr0;
+    if (params.referenceCacheDirectory[0] && !err_count) {
+      reference.tolerance = refTolerance;
+      reference.spmvMgTime = times[8];
+      reference.cgTime = ref_times[0];
+      reference.cgIterations = totalNiters_ref;
+      if (WriteReferenceCache(referenceFileName, A, refMaxIters, reference)!=0)
+        HPCG_fout << "Reference cache file " << referenceFileName << " could not be written." << endl;
+    }
   }
-  if (rank == 0 && err_count) HPCG_fout << err_count << " error(s) in call(s) to reference CG." << endl;
-  double refTolerance = normr / normr0;
 
   //////////////////////////////
   // Optimized CG Setup Phase //
@@ -289,6 +347,33 @@ std::cout<<"using mpi"<<endl;
       HPCG_fout << "Failed to reduce the residual " << tolerance_failures << " times." << endl;
   }
 
+  /////////////////////////////////////
+  // Coarse Grid Solver Comparison Phase //
+  /////////////////////////////////////
+
+  // Compare the iteration counts and times of the smoother and the direct solver on the coarsest grid
+  CoarseSolverComparisonData coarse_data;
+  ierr = CompareCoarseSolvers(A, data, b, x, 10*refMaxIters, refTolerance, coarse_data);
+  if (ierr) HPCG_fout << "Error in call to CG during coarse grid solver comparison: " << ierr << ".\n" << endl;
+
+  //////////////////////////////////////////
+  // Multiple Right-Hand-Side Timing Phase //
+  //////////////////////////////////////////
+
+  // Solve k = 1, ..., params.maxNumberOfRhs right-hand sides together and record the throughput
+  MultiCGBenchmarkData multicg_data;
+  ierr = BenchmarkMultiCG(A, b, params.maxNumberOfRhs, refMaxIters, multicg_data);
+  if (ierr) HPCG_fout << "Error in call to MultiCG: " << ierr << ".\n" << endl;
+
+  ////////////////////////////
+  // Ensemble Timing Phase //
+  ////////////////////////////
+
+  // Solve params.numberOfInstances independent copies of the problem concurrently
+  EnsembleData ensemble_data;
+  ierr = BenchmarkEnsemble(params, numberOfMgLevels, optNiters, ensemble_data);
+  if (ierr) HPCG_fout << "Error in call to CG during ensemble run: " << ierr << ".\n" << endl;
+
   ///////////////////////////////
   // Optimized CG Timing Phase //
   ///////////////////////////////
@@ -314,6 +399,9 @@ std::cout<<"using mpi"<<endl;
   testnorms_data.samples = numberOfCgSets;
   testnorms_data.values = new double[numberOfCgSets];
 
+  ResetSmootherStatistics(A); // Only report smoother timings of the benchmark phase
+  BeginKernelCounterPhase(); // The HPX counters sampled at the end of the phase cover only the benchmark phase
+
   for (int i=0; i< numberOfCgSets; ++i) {
     ZeroVector(x); // Zero out x
     ierr = CG( A, data, b, x, optMaxIters, optTolerance, niters, normr, normr0, &times[0], true);
@@ -322,6 +410,8 @@ std::cout<<"using mpi"<<endl;
     testnorms_data.values[i] = normr/normr0; // Record scaled residual from this run
   }
 
+  EndKernelCounterPhase("Optimized CG Timing Phase");
+
   // Compute difference between known exact solution and computed solution
   // All processors are needed here.
 #ifdef HPCG_DEBUG
@@ -339,7 +429,7 @@ std::cout<<"using mpi"<<endl;
   ////////////////////
 
   // Report results to YAML file
-  ReportResults(A, numberOfMgLevels, numberOfCgSets, refMaxIters, optMaxIters, &times[0], testcg_data, testsymmetry_data, testnorms_data, global_failure);
+  ReportResults(A, numberOfMgLevels, numberOfCgSets, refMaxIters, optMaxIters, &times[0], testcg_data, testsymmetry_data, testnorms_data, coarse_data, multicg_data, ensemble_data, memory_data, global_failure);
 
   // Clean up
   DeleteMatrix(A); // This delete will recursively delete all coarse grid data
@@ -350,6 +440,7 @@ std::cout<<"using mpi"<<endl;
   DeleteVector(x_overlap);
   DeleteVector(b_computed);
   delete [] testnorms_data.values;
+  DeleteEnsembleData(ensemble_data);
 
 
 
@@ -359,5 +450,26 @@ std::cout<<"using mpi"<<endl;
 #ifndef HPCG_NOMPI
   MPI_Finalize();
 #endif
+#if !defined(HPCG_NOHPX)
+  return hpx::finalize();
+#else
   return 0 ;
+#endif
+}
+
+#if !defined(HPCG_NOHPX)
+/*!
+  Starts the HPX runtime, which runs hpx_main. The HPCG counter types are
+  installed by a startup function registered before the runtime starts, so
+  that they can be given with --hpx:print-counter.
+
+  @param[in]  argc Standard argument count
+  @param[in]  argv Standard argument array, the --hpx options are consumed by the runtime
+
+  @return Returns the value returned by hpx_main.
+*/
+int main(int argc, char * argv[]) {
+  RegisterKernelCounters();
+  return hpx::init(argc, argv);
 }
+#endif